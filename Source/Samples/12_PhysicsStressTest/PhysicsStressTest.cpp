@@ -21,6 +21,9 @@
 //
 
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Graphics/DebugRenderer.h>
@@ -46,18 +49,50 @@
 
 #include "PhysicsStressTest.h"
 
+#include <cstdio>
+
 #include <Urho3D/DebugNew.h>
 
 URHO3D_DEFINE_APPLICATION_MAIN(PhysicsStressTest)
 
+// Number of physics steps measured in benchmark mode, 10 seconds of simulation at 60 fps
+static const unsigned BENCHMARK_STEPS = 600;
+
 PhysicsStressTest::PhysicsStressTest(Context* context) :
     Sample(context),
-    drawDebug_(false)
+    drawDebug_(false),
+    benchmark_(false)
 {
 }
 
+void PhysicsStressTest::Setup()
+{
+    // Execute base class setup
+    Sample::Setup();
+
+    // The benchmark mode only simulates the scene, without a window
+    const Vector<String>& arguments = GetArguments();
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].ToLower() == "-benchmark")
+            benchmark_ = true;
+    }
+    if (benchmark_)
+    {
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_QUIET] = true;
+    }
+}
+
 void PhysicsStressTest::Start()
 {
+    if (benchmark_)
+    {
+        RunBenchmark();
+        engine_->Exit();
+        return;
+    }
+
     // Execute base class startup
     Sample::Start();
 
@@ -319,3 +354,47 @@ void PhysicsStressTest::HandlePostRenderUpdate(StringHash eventType, VariantMap&
     if (drawDebug_)
         scene_->GetComponent<PhysicsWorld>()->DrawDebugGeometry(true);
 }
+
+void PhysicsStressTest::RunBenchmark()
+{
+    // Measure 1, 2, 4... threads and all the work queue threads with the main thread
+    const unsigned maxThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1;
+    PODVector<unsigned> threadCounts;
+    for (unsigned numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+        threadCounts.Push(numThreads);
+    threadCounts.Push(maxThreads);
+
+    PrintLine(ToString("%u physics steps, up to %u threads", BENCHMARK_STEPS, maxThreads));
+
+    for (unsigned i = 0; i < threadCounts.Size(); ++i)
+    {
+        // The same scene is simulated for each thread count. One thread uses the single threaded world
+        const unsigned numThreads = threadCounts[i];
+        PhysicsWorld::config.multiThreaded_ = numThreads > 1;
+        PhysicsWorld::config.numThreads_ = numThreads;
+        SetRandomSeed(1);
+        CreateScene();
+
+        auto* physicsWorld = scene_->GetComponent<PhysicsWorld>();
+        const float timeStep = 1.0f / physicsWorld->GetFps();
+        HiresTimer timer;
+        long long totalTime = 0;
+        long long maxStepTime = 0;
+        for (unsigned j = 0; j < BENCHMARK_STEPS; ++j)
+        {
+            physicsWorld->Update(timeStep);
+            const long long stepTime = timer.GetUSec(true);
+            totalTime += stepTime;
+            maxStepTime = Max(maxStepTime, stepTime);
+        }
+
+        char line[128];
+        sprintf(line, "%2u threads: average step %8.3f ms, slowest step %8.3f ms", numThreads,
+            totalTime / 1000.0 / BENCHMARK_STEPS, maxStepTime / 1000.0);
+        PrintLine(line);
+    }
+
+    PhysicsWorld::config.multiThreaded_ = false;
+    PhysicsWorld::config.numThreads_ = 0;
+    scene_.Reset();
+}
@@ -37,6 +37,7 @@ class Scene;
 ///     - Physics and rendering performance with a high (1000) moving object count
 ///     - Using triangle meshes for collision
 ///     - Optimizing physics simulation by leaving out collision event signaling
+///     - Measuring the physics step time against the number of threads, when run headless with the -benchmark argument
 class PhysicsStressTest : public Sample
 {
     URHO3D_OBJECT(PhysicsStressTest, Sample);
@@ -45,6 +46,8 @@ public:
     /// Construct.
     explicit PhysicsStressTest(Context* context);
 
+    /// Setup before engine initialization. Runs headless in benchmark mode.
+    void Setup() override;
     /// Setup after engine initialization and before running the main loop.
     void Start() override;
 
@@ -88,7 +91,11 @@ private:
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle the post-render update event.
     void HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Step the scene physics with 1, 2, 4... threads and print the step times.
+    void RunBenchmark();
 
     /// Flag for drawing debug geometry.
     bool drawDebug_;
+    /// Flag for the headless benchmark mode.
+    bool benchmark_;
 };
@@ -21,6 +21,8 @@
 //
 
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Graphics/AnimatedModel.h>
 #include <Urho3D/Graphics/AnimationController.h>
@@ -47,8 +49,17 @@
 
 #include "CrowdNavigation.h"
 
+#include <cstdio>
+
 #include <Urho3D/DebugNew.h>
 
+// Number of agents walking around in benchmark mode
+static const unsigned BENCHMARK_AGENTS = 2000;
+// Number of scene updates measured in benchmark mode, 10 seconds of simulation at 60 fps
+static const unsigned BENCHMARK_STEPS = 600;
+// Number of scene updates between giving the agents new targets in benchmark mode
+static const unsigned BENCHMARK_RETARGET_STEPS = 120;
+
 URHO3D_DEFINE_APPLICATION_MAIN(CrowdNavigation)
 
 CrowdNavigation::CrowdNavigation(Context* context) :
@@ -56,8 +67,34 @@ CrowdNavigation::CrowdNavigation(Context* context) :
 {
 }
 
+void CrowdNavigation::Setup()
+{
+    // Execute base class setup
+    Sample::Setup();
+
+    // The benchmark mode only simulates the scene, without a window
+    const Vector<String>& arguments = GetArguments();
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].ToLower() == "-benchmark")
+            benchmark_ = true;
+    }
+    if (benchmark_)
+    {
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_QUIET] = true;
+    }
+}
+
 void CrowdNavigation::Start()
 {
+    if (benchmark_)
+    {
+        RunBenchmark();
+        engine_->Exit();
+        return;
+    }
+
     // Execute base class startup
     Sample::Start();
 
@@ -647,3 +684,60 @@ void CrowdNavigation::HandleCrowdAgentFormation(StringHash eventType, VariantMap
         eventData[P_POSITION] = crowdManager->GetRandomPointInCircle(position, agent->GetRadius(), agent->GetQueryFilterType());
     }
 }
+
+void CrowdNavigation::RunBenchmark()
+{
+    PrintLine(ToString("%u crowd agents, %u scene updates", BENCHMARK_AGENTS, BENCHMARK_STEPS));
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        // The same scene and agents are simulated single threaded and then multithreaded
+        const bool multiThreaded = i > 0;
+        SetRandomSeed(1);
+        CreateScene();
+
+        auto* navMesh = scene_->GetComponent<DynamicNavigationMesh>();
+        auto* crowdManager = scene_->GetComponent<CrowdManager>();
+        crowdManager->SetMaxAgents(BENCHMARK_AGENTS + 512);
+        crowdManager->SetMultiThreaded(multiThreaded);
+
+        // The agents are bare crowd agents without models, spread randomly over the navigation mesh
+        Node* agentGroup = scene_->CreateChild("BenchmarkAgents");
+        PODVector<CrowdAgent*> agents;
+        for (unsigned j = 0; j < BENCHMARK_AGENTS; ++j)
+        {
+            Node* agentNode = agentGroup->CreateChild("Agent");
+            agentNode->SetPosition(navMesh->GetRandomPoint());
+            auto* agent = agentNode->CreateComponent<CrowdAgent>();
+            agent->SetHeight(2.0f);
+            agent->SetMaxSpeed(3.0f);
+            agent->SetMaxAccel(5.0f);
+            agents.Push(agent);
+        }
+
+        const float timeStep = 1.0f / 60.0f;
+        HiresTimer timer;
+        long long totalTime = 0;
+        long long maxStepTime = 0;
+        for (unsigned j = 0; j < BENCHMARK_STEPS; ++j)
+        {
+            // Setting the targets is part of the measured time, as it queues the path requests
+            if (j % BENCHMARK_RETARGET_STEPS == 0)
+            {
+                for (unsigned k = 0; k < agents.Size(); ++k)
+                    agents[k]->SetTargetPosition(navMesh->GetRandomPoint());
+            }
+            scene_->Update(timeStep);
+            const long long stepTime = timer.GetUSec(true);
+            totalTime += stepTime;
+            maxStepTime = Max(maxStepTime, stepTime);
+        }
+
+        char line[128];
+        sprintf(line, "%-16s average update %8.3f ms, slowest update %8.3f ms", multiThreaded ? "Multithreaded:" : "Single threaded:",
+            totalTime / 1000.0 / BENCHMARK_STEPS, maxStepTime / 1000.0);
+        PrintLine(line);
+    }
+
+    scene_.Reset();
+}
@@ -43,6 +43,7 @@ class Scene;
 ///     - Accessing crowd agents with the crowd manager
 ///     - Using off-mesh connections to make boxes climbable
 ///     - Using agents to simulate moving obstacles
+///     - Measuring the crowd update time of thousands of agents, when run headless with the -benchmark argument
 class CrowdNavigation : public Sample
 {
     URHO3D_OBJECT(CrowdNavigation, Sample);
@@ -51,6 +52,8 @@ public:
     /// Construct.
     explicit CrowdNavigation(Context* context);
 
+    /// Setup before engine initialization. Runs headless in benchmark mode.
+    void Setup() override;
     /// Setup after engine initialization and before running the main loop.
     void Start() override;
 
@@ -168,6 +171,8 @@ private:
     void HandleCrowdAgentReposition(StringHash eventType, VariantMap& eventData);
     /// Handle crowd agent formation.
     void HandleCrowdAgentFormation(StringHash eventType, VariantMap& eventData);
+    /// Measure the crowd update of thousands of agents single threaded and multithreaded, and print the results.
+    void RunBenchmark();
 
     /// Flag for using navigation mesh streaming.
     bool useStreaming_{};
@@ -181,4 +186,6 @@ private:
     bool drawDebug_{};
     /// Instruction text UI-element.
     Text* instructionText_{};
+    /// Flag for running the headless benchmark instead of the interactive sample.
+    bool benchmark_{};
 };
@@ -0,0 +1,341 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Input/Input.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+#include <Urho3D/UI/Font.h>
+#include <Urho3D/UI/Text.h>
+#include <Urho3D/UI/UI.h>
+#include <Urho3D/Urho2D/CollisionBox2D.h>
+#include <Urho3D/Urho2D/CollisionCircle2D.h>
+#include <Urho3D/Urho2D/Drawable2D.h>
+#include <Urho3D/Urho2D/PhysicsWorld2D.h>
+#include <Urho3D/Urho2D/RigidBody2D.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+#include <Urho3D/Urho2D/StaticSprite2D.h>
+
+#include "Urho2DPhysicsStressTest.h"
+
+#include <cstdio>
+
+#include <Urho3D/DebugNew.h>
+
+URHO3D_DEFINE_APPLICATION_MAIN(Urho2DPhysicsStressTest)
+
+// Separate piles, so that the bodies form several simulation islands
+static const unsigned NUM_PILES = 10;
+static const unsigned NUM_OBJECTS_PER_PILE = 200;
+static const unsigned PILE_WIDTH = 5;
+static const float PILE_SPACING = 3.0f;
+// Number of physics steps measured in benchmark mode, 10 seconds of simulation at 60 fps
+static const unsigned BENCHMARK_STEPS = 600;
+
+Urho2DPhysicsStressTest::Urho2DPhysicsStressTest(Context* context) :
+    Sample(context),
+    benchmark_(false)
+{
+}
+
+void Urho2DPhysicsStressTest::Setup()
+{
+    // Execute base class setup
+    Sample::Setup();
+
+    // The benchmark mode only simulates the scene, without a window
+    const Vector<String>& arguments = GetArguments();
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].ToLower() == "-benchmark")
+            benchmark_ = true;
+    }
+    if (benchmark_)
+    {
+        engineParameters_[EP_HEADLESS] = true;
+        engineParameters_[EP_LOG_QUIET] = true;
+    }
+}
+
+void Urho2DPhysicsStressTest::Start()
+{
+    if (benchmark_)
+    {
+        RunBenchmark();
+        engine_->Exit();
+        return;
+    }
+
+    // Execute base class startup
+    Sample::Start();
+
+    // Create the scene content
+    CreateScene();
+
+    // Create the UI content
+    CreateInstructions();
+
+    // Setup the viewport for displaying the scene
+    SetupViewport();
+
+    // Hook up to the frame update events
+    SubscribeToEvents();
+
+    // Set the mouse mode to use in the sample
+    Sample::InitMouseMode(MM_FREE);
+}
+
+void Urho2DPhysicsStressTest::CreateScene()
+{
+    scene_ = new Scene(context_);
+    scene_->CreateComponent<Octree>();
+    // Create camera node
+    cameraNode_ = scene_->CreateChild("Camera");
+    // Set camera's position
+    cameraNode_->SetPosition(Vector3(0.0f, 4.0f, -10.0f));
+
+    auto* camera = cameraNode_->CreateComponent<Camera>();
+    camera->SetOrthographic(true);
+
+    // There is no window in benchmark mode
+    auto* graphics = GetSubsystem<Graphics>();
+    if (graphics)
+    {
+        camera->SetOrthoSize((float)graphics->GetHeight() * PIXEL_SIZE);
+        camera->SetZoom(0.6f * Min((float)graphics->GetWidth() / 1280.0f, (float)graphics->GetHeight() / 800.0f));
+    }
+
+    // Create 2D physics world component, stepping on the work queue threads
+    auto* physicsWorld = scene_->CreateComponent<PhysicsWorld2D>();
+    physicsWorld->SetMultiThreaded(true);
+
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto* boxSprite = cache->GetResource<Sprite2D>("Urho2D/Box.png");
+    auto* ballSprite = cache->GetResource<Sprite2D>("Urho2D/Ball.png");
+
+    // Create ground.
+    Node* groundNode = scene_->CreateChild("Ground");
+    groundNode->SetPosition(Vector3(0.0f, -3.0f, 0.0f));
+    groundNode->SetScale(Vector3(200.0f, 1.0f, 0.0f));
+    groundNode->CreateComponent<RigidBody2D>();
+    auto* groundSprite = groundNode->CreateComponent<StaticSprite2D>();
+    groundSprite->SetSprite(boxSprite);
+    auto* groundShape = groundNode->CreateComponent<CollisionBox2D>();
+    groundShape->SetSize(Vector2(0.32f, 0.32f));
+    groundShape->SetFriction(0.5f);
+
+    for (unsigned pile = 0; pile < NUM_PILES; ++pile)
+    {
+        const float pileX = ((float)pile - (NUM_PILES - 1) * 0.5f) * PILE_SPACING;
+
+        // Create the walls keeping the pile apart from its neighbours
+        for (unsigned side = 0; side < 2; ++side)
+        {
+            Node* wallNode = scene_->CreateChild("Wall");
+            wallNode->SetPosition(Vector3(pileX + (side ? 1.2f : -1.2f), 0.2f, 0.0f));
+            wallNode->SetScale(Vector3(1.0f, 20.0f, 0.0f));
+            wallNode->CreateComponent<RigidBody2D>();
+            auto* wallSprite = wallNode->CreateComponent<StaticSprite2D>();
+            wallSprite->SetSprite(boxSprite);
+            auto* wallShape = wallNode->CreateComponent<CollisionBox2D>();
+            wallShape->SetSize(Vector2(0.32f, 0.32f));
+            wallShape->SetFriction(0.5f);
+        }
+
+        for (unsigned i = 0; i < NUM_OBJECTS_PER_PILE; ++i)
+        {
+            Node* node  = scene_->CreateChild("RigidBody");
+            node->SetPosition(Vector3(pileX + ((float)(i % PILE_WIDTH) - (PILE_WIDTH - 1) * 0.5f) * 0.4f + Random(-0.05f, 0.05f),
+                (float)(i / PILE_WIDTH) * 0.4f, 0.0f));
+
+            auto* body = node->CreateComponent<RigidBody2D>();
+            body->SetBodyType(BT_DYNAMIC);
+
+            auto* staticSprite = node->CreateComponent<StaticSprite2D>();
+
+            if (i % 2 == 0)
+            {
+                staticSprite->SetSprite(boxSprite);
+
+                auto* box = node->CreateComponent<CollisionBox2D>();
+                box->SetSize(Vector2(0.32f, 0.32f));
+                box->SetDensity(1.0f);
+                box->SetFriction(0.5f);
+                box->SetRestitution(0.1f);
+            }
+            else
+            {
+                staticSprite->SetSprite(ballSprite);
+
+                auto* circle = node->CreateComponent<CollisionCircle2D>();
+                circle->SetRadius(0.16f);
+                circle->SetDensity(1.0f);
+                circle->SetFriction(0.5f);
+                circle->SetRestitution(0.1f);
+            }
+        }
+    }
+}
+
+void Urho2DPhysicsStressTest::CreateInstructions()
+{
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto* ui = GetSubsystem<UI>();
+
+    // Construct new Text object, set string to display and font to use
+    instructionText_ = ui->GetRoot()->CreateChild<Text>();
+    instructionText_->SetFont(cache->GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
+    // The text has multiple rows. Center them in relation to each other
+    instructionText_->SetTextAlignment(HA_CENTER);
+
+    // Position the text at the top of the screen, above the piles
+    instructionText_->SetHorizontalAlignment(HA_CENTER);
+    instructionText_->SetVerticalAlignment(VA_TOP);
+    instructionText_->SetPosition(0, 10);
+
+    UpdateInstructions();
+}
+
+void Urho2DPhysicsStressTest::UpdateInstructions()
+{
+    const bool multiThreaded = scene_->GetComponent<PhysicsWorld2D>()->IsMultiThreaded();
+    instructionText_->SetText(
+        "Use WASD keys to move, use PageUp PageDown keys to zoom.\n"
+        "Space to toggle the multithreaded physics step, F2 to show the profiler\n" +
+        String(NUM_PILES * NUM_OBJECTS_PER_PILE) + " objects, " + (multiThreaded ? "multithreaded" : "single threaded")
+    );
+}
+
+void Urho2DPhysicsStressTest::SetupViewport()
+{
+    auto* renderer = GetSubsystem<Renderer>();
+
+    // Set up a viewport to the Renderer subsystem so that the 3D scene can be seen
+    SharedPtr<Viewport> viewport(new Viewport(context_, scene_, cameraNode_->GetComponent<Camera>()));
+    renderer->SetViewport(0, viewport);
+}
+
+void Urho2DPhysicsStressTest::MoveCamera(float timeStep)
+{
+    // Do not move if the UI has a focused element (the console)
+    if (GetSubsystem<UI>()->GetFocusElement())
+        return;
+
+    auto* input = GetSubsystem<Input>();
+
+    // Movement speed as world units per second
+    const float MOVE_SPEED = 8.0f;
+
+    // Read WASD keys and move the camera scene node to the corresponding direction if they are pressed
+    if (input->GetKeyDown(KEY_W))
+        cameraNode_->Translate(Vector3::UP * MOVE_SPEED * timeStep);
+    if (input->GetKeyDown(KEY_S))
+        cameraNode_->Translate(Vector3::DOWN * MOVE_SPEED * timeStep);
+    if (input->GetKeyDown(KEY_A))
+        cameraNode_->Translate(Vector3::LEFT * MOVE_SPEED * timeStep);
+    if (input->GetKeyDown(KEY_D))
+        cameraNode_->Translate(Vector3::RIGHT * MOVE_SPEED * timeStep);
+
+    if (input->GetKeyDown(KEY_PAGEUP))
+    {
+        auto* camera = cameraNode_->GetComponent<Camera>();
+        camera->SetZoom(camera->GetZoom() * 1.01f);
+    }
+
+    if (input->GetKeyDown(KEY_PAGEDOWN))
+    {
+        auto* camera = cameraNode_->GetComponent<Camera>();
+        camera->SetZoom(camera->GetZoom() * 0.99f);
+    }
+
+    // Toggle the multithreaded physics step with space
+    if (input->GetKeyPress(KEY_SPACE))
+    {
+        auto* physicsWorld = scene_->GetComponent<PhysicsWorld2D>();
+        physicsWorld->SetMultiThreaded(!physicsWorld->IsMultiThreaded());
+        UpdateInstructions();
+    }
+}
+
+void Urho2DPhysicsStressTest::SubscribeToEvents()
+{
+    // Subscribe HandleUpdate() function for processing update events
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(Urho2DPhysicsStressTest, HandleUpdate));
+
+    // Unsubscribe the SceneUpdate event from base class to prevent camera pitch and yaw in 2D sample
+    UnsubscribeFromEvent(E_SCENEUPDATE);
+}
+
+void Urho2DPhysicsStressTest::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+
+    // Take the frame time step, which is stored as a float
+    float timeStep = eventData[P_TIMESTEP].GetFloat();
+
+    // Move the camera, scale movement with time step
+    MoveCamera(timeStep);
+}
+
+void Urho2DPhysicsStressTest::RunBenchmark()
+{
+    PrintLine(ToString("%u objects in %u piles, %u physics steps", NUM_PILES * NUM_OBJECTS_PER_PILE, NUM_PILES, BENCHMARK_STEPS));
+
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        // The same scene is simulated single threaded, then on the work queue threads
+        const bool multiThreaded = pass == 1;
+        SetRandomSeed(1);
+        CreateScene();
+
+        auto* physicsWorld = scene_->GetComponent<PhysicsWorld2D>();
+        physicsWorld->SetMultiThreaded(multiThreaded);
+        const float timeStep = 1.0f / physicsWorld->GetFps();
+        HiresTimer timer;
+        long long totalTime = 0;
+        long long maxStepTime = 0;
+        for (unsigned i = 0; i < BENCHMARK_STEPS; ++i)
+        {
+            physicsWorld->Update(timeStep);
+            const long long stepTime = timer.GetUSec(true);
+            totalTime += stepTime;
+            maxStepTime = Max(maxStepTime, stepTime);
+        }
+
+        char line[128];
+        sprintf(line, "%-16s average step %8.3f ms, slowest step %8.3f ms", multiThreaded ? "Multithreaded:" : "Single threaded:",
+            totalTime / 1000.0 / BENCHMARK_STEPS, maxStepTime / 1000.0);
+        PrintLine(line);
+    }
+
+    scene_.Reset();
+}
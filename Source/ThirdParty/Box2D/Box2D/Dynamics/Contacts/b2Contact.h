@@ -189,6 +189,12 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// FromBones : the two halves of Update, for the parallel narrow phase.
+	// UpdateManifold only writes to this contact and returns the previous touching state,
+	// ReportUpdate wakes the bodies and calls the listener.
+	bool UpdateManifold(b2Manifold* oldManifold);
+	void ReportUpdate(b2ContactListener* listener, const b2Manifold* oldManifold, bool wasTouching);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
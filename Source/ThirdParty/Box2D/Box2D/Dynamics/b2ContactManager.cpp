@@ -21,10 +21,22 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2StackAllocator.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
+// FromBones : below this number of contacts the narrow phase is not worth splitting.
+const int32 b2_minParallelContacts = 256;
+const int32 b2_minContactsPerTask = 64;
+
+struct b2ContactUpdateTask
+{
+	b2Contact** contacts;
+	b2Manifold* oldManifolds;
+	bool* wasTouching;
+};
+
 b2ContactManager::b2ContactManager()
 {
 	m_contactList = NULL;
@@ -32,6 +44,8 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_stackAllocator = NULL;
+	m_taskExecutor = NULL;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -104,68 +118,140 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
+	// FromBones : gather the contacts to update for the task executor threads.
+	b2Contact** updates = NULL;
+	int32 updateCount = 0;
+	if (m_taskExecutor && m_contactCount >= b2_minParallelContacts && m_taskExecutor->GetThreadCount() > 1)
+	{
+		updates = (b2Contact**)m_stackAllocator->Allocate(m_contactCount * sizeof(b2Contact*));
+	}
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
 	{
-		b2Fixture* fixtureA = c->GetFixtureA();
-		b2Fixture* fixtureB = c->GetFixtureB();
-		int32 indexA = c->GetChildIndexA();
-		int32 indexB = c->GetChildIndexB();
-		b2Body* bodyA = fixtureA->GetBody();
-		b2Body* bodyB = fixtureB->GetBody();
-		 
-		// Is this contact flagged for filtering?
-		if (c->m_flags & b2Contact::e_filterFlag)
+		b2Contact* next = c->GetNext();
+
+		// The contact persists.
+		if (CheckContact(c) == e_contactPersists)
 		{
-			// Should these bodies collide?
-			if (bodyB->ShouldCollide(bodyA) == false)
+			if (updates)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
-				continue;
+				updates[updateCount++] = c;
 			}
-
-			// Check user filtering.
-			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+			else
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
-				continue;
+				c->Update(m_contactListener);
 			}
-
-			// Clear the filtering flag.
-			c->m_flags &= ~b2Contact::e_filterFlag;
 		}
+		c = next;
+	}
+
+	if (updates)
+	{
+		UpdateContacts(updates, updateCount);
+		m_stackAllocator->Free(updates);
+	}
+}
 
-		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
-		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+b2ContactManager::ContactCheck b2ContactManager::CheckContact(b2Contact* c)
+{
+	b2Fixture* fixtureA = c->GetFixtureA();
+	b2Fixture* fixtureB = c->GetFixtureB();
+	int32 indexA = c->GetChildIndexA();
+	int32 indexB = c->GetChildIndexB();
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+	 
+	// Is this contact flagged for filtering?
+	if (c->m_flags & b2Contact::e_filterFlag)
+	{
+		// Should these bodies collide?
+		if (bodyB->ShouldCollide(bodyA) == false)
+		{
+			Destroy(c);
+			return e_contactDestroyed;
+		}
 
-		// At least one body must be awake and it must be dynamic or kinematic.
-		if (activeA == false && activeB == false)
+		// Check user filtering.
+		if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 		{
-			c = c->GetNext();
-			continue;
+			Destroy(c);
+			return e_contactDestroyed;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		// Clear the filtering flag.
+		c->m_flags &= ~b2Contact::e_filterFlag;
+	}
+
+	bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+	bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
 
-		// Here we destroy contacts that cease to overlap in the broad-phase.
-		if (overlap == false)
+	// At least one body must be awake and it must be dynamic or kinematic.
+	if (activeA == false && activeB == false)
+	{
+		return e_contactInactive;
+	}
+
+	int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+	int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+	bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+
+	// Here we destroy contacts that cease to overlap in the broad-phase.
+	if (overlap == false)
+	{
+		Destroy(c);
+		return e_contactDestroyed;
+	}
+
+	return e_contactPersists;
+}
+
+void b2ContactManager::UpdateContacts(b2Contact** contacts, int32 count)
+{
+	b2ContactUpdateTask task;
+	task.contacts = contacts;
+	task.oldManifolds = (b2Manifold*)m_stackAllocator->Allocate(count * sizeof(b2Manifold));
+	task.wasTouching = (bool*)m_stackAllocator->Allocate(count * sizeof(bool));
+
+	m_taskExecutor->ParallelFor(count, b2_minContactsPerTask, UpdateManifolds, &task);
+
+	// Walk the contact list again to report the updates in the list order, like the serial loop.
+	// A report that wakes a sleeping body makes the following contacts of that body active:
+	// they were not gathered, so they are checked and updated here, as the serial loop would.
+	int32 index = 0;
+	b2Contact* c = m_contactList;
+	while (c)
+	{
+		b2Contact* next = c->GetNext();
+		if (index < count && contacts[index] == c)
+		{
+			// A listener may have flagged the contact for filtering since it was gathered.
+			if ((c->m_flags & b2Contact::e_filterFlag) == 0 || CheckContact(c) == e_contactPersists)
+			{
+				c->ReportUpdate(m_contactListener, task.oldManifolds + index, task.wasTouching[index]);
+			}
+			++index;
+		}
+		else if (CheckContact(c) == e_contactPersists)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
-			continue;
+			c->Update(m_contactListener);
 		}
+		c = next;
+	}
 
-		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+	m_stackAllocator->Free(task.wasTouching);
+	m_stackAllocator->Free(task.oldManifolds);
+}
+
+void b2ContactManager::UpdateManifolds(int32 begin, int32 end, int32 threadIndex, void* userData)
+{
+	B2_NOT_USED(threadIndex);
+
+	b2ContactUpdateTask* task = (b2ContactUpdateTask*)userData;
+	for (int32 i = begin; i < end; ++i)
+	{
+		task->wasTouching[i] = task->contacts[i]->UpdateManifold(task->oldManifolds + i);
 	}
 }
 
@@ -25,6 +25,8 @@ class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2StackAllocator;
+class b2TaskExecutor;
 
 // Delegate of b2World.
 class b2ContactManager
@@ -40,6 +42,23 @@ public:
 	void Destroy(b2Contact* c);
 
 	void Collide();
+
+	// FromBones : result of filtering a contact and testing its overlap in Collide().
+	enum ContactCheck
+	{
+		e_contactInactive,
+		e_contactDestroyed,
+		e_contactPersists
+	};
+
+	// FromBones : filter a contact and test its broad-phase overlap, destroying it when needed.
+	ContactCheck CheckContact(b2Contact* c);
+
+	// FromBones : update the manifolds of the contacts on the task executor threads,
+	// then wake the bodies and call the listener in the contact list order, updating
+	// the contacts made active by these wake-ups like the serial loop does.
+	void UpdateContacts(b2Contact** contacts, int32 count);
+	static void UpdateManifolds(int32 begin, int32 end, int32 threadIndex, void* userData);
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
@@ -47,6 +66,10 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// FromBones : parallel narrow phase
+	b2StackAllocator* m_stackAllocator;
+	b2TaskExecutor* m_taskExecutor;
 };
 
 #endif
@@ -27,6 +27,8 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2TaskExecutor;
+struct b2ContactImpulse;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -74,6 +76,13 @@ public:
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	// FromBones : island solved concurrently with the others.
+	// The static bodies are shared with the other islands : their island index is assigned
+	// while the executor is locked and their state is left untouched.
+	b2TaskExecutor* m_executor;
+	// FromBones : when set, the contact impulses are stored here instead of being reported to the listener.
+	b2ContactImpulse* m_impulses;
+
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
@@ -59,8 +59,13 @@ b2World::b2World(const b2Vec2& gravity)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_stackAllocator = &m_stackAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
+
+	m_taskExecutor = NULL;
+	m_threadStackAllocators = NULL;
+	m_threadStackAllocatorCount = 0;
 }
 
 b2World::~b2World()
@@ -82,6 +87,12 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	for (int32 i = 0; i < m_threadStackAllocatorCount; ++i)
+	{
+		m_threadStackAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadStackAllocators);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -99,6 +110,14 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	b2Assert(IsLocked() == false);
+
+	m_taskExecutor = executor;
+	m_contactManager.m_taskExecutor = executor;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	g_debugDraw = debugDraw;
@@ -389,13 +408,6 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
-
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
@@ -410,6 +422,21 @@ void b2World::Solve(const b2TimeStep& step)
 		j->m_islandFlag = false;
 	}
 
+	// FromBones : solve the islands on the task executor threads
+	if (m_taskExecutor && m_taskExecutor->GetThreadCount() > 1)
+	{
+		SolveParallel(step);
+		UpdateBroadPhase();
+		return;
+	}
+
+	// Size the island for the worst case.
+	b2Island island(m_bodyCount,
+					m_contactManager.m_contactCount,
+					m_jointCount,
+					&m_stackAllocator,
+					m_contactManager.m_contactListener);
+
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
@@ -547,30 +574,334 @@ void b2World::Solve(const b2TimeStep& step)
 
 	m_stackAllocator.Free(stack);
 
+	UpdateBroadPhase();
+}
+
+void b2World::UpdateBroadPhase()
+{
+	b2Timer timer;
+	// Synchronize fixtures, check for out of range bodies.
+	for (b2Body* b = m_bodyList; b; b = b->GetNext())
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		// If a body was not in an island then it did not move.
+		if ((b->m_flags & b2Body::e_islandFlag) == 0)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			continue;
+		}
+
+		if (b->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		// Update fixtures (for broad-phase).
+		b->SynchronizeFixtures();
+	}
+
+	// Look for new contacts.
+	m_contactManager.FindNewContacts();
+	m_profile.broadphase = timer.GetMilliseconds();
+}
+
+// FromBones : parallel island solving.
+// The islands are built on the stepping thread, solved by the executor threads,
+// then their contact impulses are reported in the island order.
+struct b2IslandRange
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+};
+
+struct b2IslandSolveTask
+{
+	b2TimeStep step;
+	b2Vec2 gravity;
+	bool allowSleep;
+	b2Body** bodies;
+	b2Contact** contacts;
+	b2Joint** joints;
+	const b2IslandRange* islands;
+	b2ContactImpulse* impulses;
+	b2Profile* profiles;
+	b2StackAllocator** allocators;
+	b2TaskExecutor* executor;
+};
+
+static void b2SolveIslands(int32 begin, int32 end, int32 threadIndex, void* userData)
+{
+	b2IslandSolveTask* task = (b2IslandSolveTask*)userData;
+	b2StackAllocator* allocator = task->allocators[threadIndex];
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2IslandRange& range = task->islands[i];
+
+		b2Island island(range.bodyCount, range.contactCount, range.jointCount, allocator, NULL);
+		island.m_executor = task->executor;
+		if (task->impulses)
+		{
+			island.m_impulses = task->impulses + range.contactStart;
+		}
+
+		memcpy(island.m_bodies, task->bodies + range.bodyStart, range.bodyCount * sizeof(b2Body*));
+		memcpy(island.m_contacts, task->contacts + range.contactStart, range.contactCount * sizeof(b2Contact*));
+		memcpy(island.m_joints, task->joints + range.jointStart, range.jointCount * sizeof(b2Joint*));
+		island.m_bodyCount = range.bodyCount;
+		island.m_contactCount = range.contactCount;
+		island.m_jointCount = range.jointCount;
+
+		island.Solve(task->profiles + i, task->step, task->gravity, task->allowSleep);
+	}
+}
+
+void b2World::SolveParallel(const b2TimeStep& step)
+{
+	int32 threadCount = m_taskExecutor->GetThreadCount();
+	if (threadCount - 1 > m_threadStackAllocatorCount)
+	{
+		for (int32 i = 0; i < m_threadStackAllocatorCount; ++i)
+		{
+			m_threadStackAllocators[i].~b2StackAllocator();
+		}
+		b2Free(m_threadStackAllocators);
+
+		m_threadStackAllocatorCount = threadCount - 1;
+		m_threadStackAllocators = (b2StackAllocator*)b2Alloc(m_threadStackAllocatorCount * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < m_threadStackAllocatorCount; ++i)
+		{
+			new (m_threadStackAllocators + i) b2StackAllocator();
+		}
+	}
+
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+
+	// A static body is added to each island it touches, through a contact or a joint.
+	int32 bodyCapacity = m_bodyCount + m_contactManager.m_contactCount + m_jointCount;
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(m_contactManager.m_contactCount * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2IslandRange* islands = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	int32 bodyCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+	int32 islandCount = 0;
+
+	// Build all the awake islands, like Solve.
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	{
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		if (seed->IsAwake() == false || seed->IsActive() == false)
+		{
+			continue;
+		}
+
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		b2IslandRange& range = islands[islandCount++];
+		range.bodyStart = bodyCount;
+		range.contactStart = contactCount;
+		range.jointStart = jointCount;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		// Perform a depth first search (DFS) on the constraint graph.
+		while (stackCount > 0)
+		{
+			// Grab the next body off the stack and add it to the island.
+			// The static bodies get their island index when their island is solved.
+			b2Body* b = stack[--stackCount];
+			b2Assert(b->IsActive() == true);
+			b2Assert(bodyCount < bodyCapacity);
+			if (b->GetType() != b2_staticBody)
 			{
-				continue;
+				b->m_islandIndex = bodyCount - range.bodyStart;
 			}
+			bodies[bodyCount++] = b;
+
+			// Make sure the body is awake.
+			b->SetAwake(true);
 
+			// To keep islands as small as possible, we don't
+			// propagate islands across static bodies.
 			if (b->GetType() == b2_staticBody)
 			{
 				continue;
 			}
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+			// Search all contacts connected to this body.
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+
+				// Has this contact already been added to an island?
+				if (contact->m_flags & b2Contact::e_islandFlag)
+				{
+					continue;
+				}
+
+				// Is this contact solid and touching?
+				if (contact->IsEnabled() == false ||
+					contact->IsTouching() == false)
+				{
+					continue;
+				}
+
+				// Skip sensors.
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
+				{
+					continue;
+				}
+
+				contacts[contactCount++] = contact;
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				b2Body* other = ce->other;
+
+				// Was the other body already added to this island?
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			// Search all joints connect to this body.
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				if (je->joint->m_islandFlag == true)
+				{
+					continue;
+				}
+
+				b2Body* other = je->other;
+
+				// Don't simulate joints connected to inactive bodies.
+				if (other->IsActive() == false)
+				{
+					continue;
+				}
+
+				joints[jointCount++] = je->joint;
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
 		}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		range.bodyCount = bodyCount - range.bodyStart;
+		range.contactCount = contactCount - range.contactStart;
+		range.jointCount = jointCount - range.jointStart;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range.bodyStart; i < bodyCount; ++i)
+		{
+			b2Body* b = bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+			}
+		}
+	}
+
+	m_stackAllocator.Free(stack);
+
+	b2ContactImpulse* impulses = NULL;
+	if (listener)
+	{
+		impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCount * sizeof(b2ContactImpulse));
+	}
+	b2Profile* profiles = (b2Profile*)m_stackAllocator.Allocate(islandCount * sizeof(b2Profile));
+	b2StackAllocator** allocators = (b2StackAllocator**)m_stackAllocator.Allocate(threadCount * sizeof(b2StackAllocator*));
+	allocators[0] = &m_stackAllocator;
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		allocators[i] = m_threadStackAllocators + i - 1;
+	}
+
+	b2IslandSolveTask task;
+	task.step = step;
+	task.gravity = m_gravity;
+	task.allowSleep = m_allowSleep;
+	task.bodies = bodies;
+	task.contacts = contacts;
+	task.joints = joints;
+	task.islands = islands;
+	task.impulses = impulses;
+	task.profiles = profiles;
+	task.allocators = allocators;
+	task.executor = m_taskExecutor;
+
+	m_taskExecutor->ParallelFor(islandCount, 1, b2SolveIslands, &task);
+
+	// The solver leaves the shared static bodies untouched: they sleep with their islands here,
+	// the last island of a static body deciding like in Solve. The seed of an island comes first.
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandRange& range = islands[i];
+		bool awake = bodies[range.bodyStart]->IsAwake();
+		for (int32 j = range.bodyStart + 1; j < range.bodyStart + range.bodyCount; ++j)
+		{
+			if (bodies[j]->GetType() == b2_staticBody)
+			{
+				bodies[j]->SetAwake(awake);
+			}
+		}
+	}
+
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		m_profile.solveInit += profiles[i].solveInit;
+		m_profile.solveVelocity += profiles[i].solveVelocity;
+		m_profile.solvePosition += profiles[i].solvePosition;
+	}
+
+	// The contacts are stored in the island order.
+	if (impulses)
+	{
+		for (int32 i = 0; i < contactCount; ++i)
+		{
+			listener->PostSolve(contacts[i], impulses + i);
+		}
+	}
+
+	m_stackAllocator.Free(allocators);
+	m_stackAllocator.Free(profiles);
+	if (impulses)
+	{
+		m_stackAllocator.Free(impulses);
 	}
+	m_stackAllocator.Free(islands);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(bodies);
 }
 
 // Find TOI contacts and solve them.
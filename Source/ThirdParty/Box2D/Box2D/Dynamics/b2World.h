@@ -61,6 +61,14 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// FromBones : register a task executor to solve the islands and update the contacts
+	/// on several threads. The executor is owned by you and must remain in scope.
+	/// The listeners are still called on the stepping thread.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
+	/// FromBones : get the task executor.
+	b2TaskExecutor* GetTaskExecutor() const { return m_taskExecutor; }
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
@@ -227,6 +235,10 @@ private:
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	// FromBones : parallel step
+	void SolveParallel(const b2TimeStep& step);
+	void UpdateBroadPhase();
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
@@ -261,6 +273,12 @@ private:
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+
+	// FromBones : parallel step. The stepping thread uses m_stackAllocator,
+	// the other executor threads have their own stack allocator.
+	b2TaskExecutor* m_taskExecutor;
+	b2StackAllocator* m_threadStackAllocators;
+	int32 m_threadStackAllocatorCount;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -152,4 +152,32 @@ public:
 									const b2Vec2& normal, float32 fraction) = 0;
 };
 
+/// FromBones : implement this class to run the island solver and the narrow phase
+/// of a time step on several threads. The tasks never call the listeners, the contact
+/// callbacks are buffered and reported afterwards on the stepping thread, in the same
+/// order whatever the number of threads.
+class b2TaskExecutor
+{
+public:
+	/// A task processing the items [begin, end). threadIndex is in [0, GetThreadCount()),
+	/// 0 being the stepping thread.
+	typedef void (*b2TaskFunction)(int32 begin, int32 end, int32 threadIndex, void* userData);
+
+	virtual ~b2TaskExecutor() {}
+
+	/// Return the number of threads running the tasks, including the stepping thread.
+	/// The step is single threaded when this is 1.
+	virtual int32 GetThreadCount() = 0;
+
+	/// Run the task on the items [0, count) split in ranges of at least minRange items,
+	/// and return when all the ranges are done.
+	virtual void ParallelFor(int32 count, int32 minRange, b2TaskFunction task, void* userData) = 0;
+
+	/// Lock the mutex shared by the tasks.
+	virtual void Lock() = 0;
+
+	/// Unlock the mutex shared by the tasks.
+	virtual void Unlock() = 0;
+};
+
 #endif
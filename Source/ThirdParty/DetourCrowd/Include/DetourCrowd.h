@@ -204,6 +204,14 @@ struct dtCrowdAgentDebugInfo
 /// Type for the update callback.
 typedef void (*dtUpdateCallback)(dtCrowdAgent* ag, float dt);
 
+class dtCrowd;
+
+// Urho3D: Add multithreaded update support
+/// Type for the callback running an update pass over the active agents, possibly in parallel.
+/// It must call dtCrowd::updateRange() with the pass for ranges covering [0, count), and return once all of them have run.
+/// The thread index given to dtCrowd::updateRange() must be unique among the ranges running at the same time. [Limits: 0 <= value < maxThreads]
+typedef void (*dtParallelForCallback)(dtCrowd* crowd, int pass, int count, void* userData);
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
@@ -234,6 +242,21 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	// Urho3D: Add multithreaded update support
+	dtParallelForCallback m_parallelFor;
+	void* m_parallelForData;
+	int m_maxThreads;
+	dtNavMeshQuery** m_threadNavqueries;
+	dtObstacleAvoidanceQuery** m_threadObstacleQueries;
+	int* m_threadSampleCounts;
+	dtCrowdAgent** m_updateAgents;
+	int m_updateAgentCount;
+	float m_updateDt;
+	dtCrowdAgentDebugInfo* m_updateDebug;
+
+	// Urho3D: Add path iteration budget support
+	int m_maxPathIters;
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
@@ -243,6 +266,33 @@ class dtCrowd
 	bool requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos);
 
 	void purge();
+
+	// Urho3D: Add multithreaded update support
+	enum UpdatePass
+	{
+		PASS_CHECK_PATH_VALIDITY = 0,
+		PASS_REQUEST_PATH,
+		PASS_UPDATE_NEIGHBOURS,
+		PASS_UPDATE_STEERING,
+		PASS_PLAN_VELOCITY,
+		PASS_INTEGRATE,
+		PASS_CALC_COLLISION_DISPLACEMENT,
+		PASS_APPLY_COLLISION_DISPLACEMENT,
+		PASS_MOVE_POSITION
+	};
+
+	bool initThreads(const int maxThreads);
+	void purgeThreads();
+	void runPass(const int pass, const int count);
+	void checkPathValidityRange(const int begin, const int end, const int threadIndex);
+	void requestPathRange(const int begin, const int end, const int threadIndex);
+	void updateNeighboursRange(const int begin, const int end, const int threadIndex);
+	void updateSteeringRange(const int begin, const int end, const int threadIndex);
+	void planVelocityRange(const int begin, const int end, const int threadIndex);
+	void integrateRange(const int begin, const int end);
+	void calcCollisionDisplacementRange(const int begin, const int end);
+	void applyCollisionDisplacementRange(const int begin, const int end);
+	void movePositionRange(const int begin, const int end, const int threadIndex);
 	
 public:
 	dtCrowd();
@@ -330,6 +380,30 @@ public:
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
 	void update(const float dt, dtCrowdAgentDebugInfo* debug);
+
+	// Urho3D: Add multithreaded update support
+	/// Sets the callback running the update passes, possibly in parallel.
+	///  @param[in]		cb			The parallel for callback, or null to run the update in the calling thread.
+	///  @param[in]		userData	The user data given to the callback.
+	///  @param[in]		maxThreads	The number of threads the callback can run ranges in, including the calling thread. [Limit: >= 1]
+	/// @return True if the per-thread queries could be allocated.
+	bool setParallelFor(dtParallelForCallback cb, void* userData, const int maxThreads);
+
+	/// Runs a range of an update pass. Called by the parallel for callback.
+	///  @param[in]		pass		The update pass given to the callback.
+	///  @param[in]		begin		The first active agent of the range.
+	///  @param[in]		end			The active agent after the last one of the range.
+	///  @param[in]		threadIndex	The index of the thread running the range. [Limits: 0 <= value < maxThreads]
+	void updateRange(const int pass, const int begin, const int end, const int threadIndex);
+
+	// Urho3D: Add path iteration budget support
+	/// Sets the maximum number of path finder iterations run by the path queue per update.
+	///  @param[in]		maxIters	The maximum number of iterations. [Limit: >= 1]
+	void setMaxPathIterations(const int maxIters) { m_maxPathIters = maxIters > 0 ? maxIters : 1; }
+
+	/// Gets the maximum number of path finder iterations run by the path queue per update.
+	/// @return The maximum number of iterations.
+	int getMaxPathIterations() const { return m_maxPathIters; }
 	
 	/// Gets the filter used by the crowd.
 	/// @return The filter used by the crowd.
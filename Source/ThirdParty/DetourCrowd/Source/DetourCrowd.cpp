@@ -343,7 +343,18 @@ dtCrowd::dtCrowd() :
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_navquery(0),
+	m_parallelFor(0), // Urho3D: Add multithreaded update support
+	m_parallelForData(0),
+	m_maxThreads(1),
+	m_threadNavqueries(0),
+	m_threadObstacleQueries(0),
+	m_threadSampleCounts(0),
+	m_updateAgents(0),
+	m_updateAgentCount(0),
+	m_updateDt(0),
+	m_updateDebug(0),
+	m_maxPathIters(MAX_ITERS_PER_UPDATE) // Urho3D: Add path iteration budget support
 {
 	// Urho3D: initialize all class members
 	memset(&m_agentPlacementHalfExtents, 0, sizeof(m_agentPlacementHalfExtents));
@@ -357,6 +368,8 @@ dtCrowd::~dtCrowd()
 
 void dtCrowd::purge()
 {
+	purgeThreads(); // Urho3D
+	
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -467,9 +480,125 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	if (dtStatusFailed(m_navquery->init(nav, MAX_COMMON_NODES)))
 		return false;
 	
+	// Urho3D: Add multithreaded update support
+	if (!initThreads(m_maxThreads))
+		return false;
+	
 	return true;
 }
 
+// Urho3D: Add multithreaded update support
+bool dtCrowd::initThreads(const int maxThreads)
+{
+	purgeThreads();
+	
+	m_maxThreads = maxThreads > 1 ? maxThreads : 1;
+	if (!m_navquery)
+		return true;
+	
+	m_threadNavqueries = (dtNavMeshQuery**)dtAlloc(sizeof(dtNavMeshQuery*)*m_maxThreads, DT_ALLOC_PERM);
+	m_threadObstacleQueries = (dtObstacleAvoidanceQuery**)dtAlloc(sizeof(dtObstacleAvoidanceQuery*)*m_maxThreads, DT_ALLOC_PERM);
+	m_threadSampleCounts = (int*)dtAlloc(sizeof(int)*m_maxThreads, DT_ALLOC_PERM);
+	if (!m_threadNavqueries || !m_threadObstacleQueries || !m_threadSampleCounts)
+		return false;
+	memset(m_threadNavqueries, 0, sizeof(dtNavMeshQuery*)*m_maxThreads);
+	memset(m_threadObstacleQueries, 0, sizeof(dtObstacleAvoidanceQuery*)*m_maxThreads);
+	memset(m_threadSampleCounts, 0, sizeof(int)*m_maxThreads);
+	
+	// The calling thread uses the crowd's own queries, the node pools of the queries can not be shared.
+	m_threadNavqueries[0] = m_navquery;
+	m_threadObstacleQueries[0] = m_obstacleQuery;
+	for (int i = 1; i < m_maxThreads; ++i)
+	{
+		m_threadNavqueries[i] = dtAllocNavMeshQuery();
+		if (!m_threadNavqueries[i])
+			return false;
+		if (dtStatusFailed(m_threadNavqueries[i]->init(m_navquery->getAttachedNavMesh(), MAX_COMMON_NODES)))
+			return false;
+		
+		m_threadObstacleQueries[i] = dtAllocObstacleAvoidanceQuery();
+		if (!m_threadObstacleQueries[i])
+			return false;
+		if (!m_threadObstacleQueries[i]->init(6, 8))
+			return false;
+	}
+	
+	return true;
+}
+
+void dtCrowd::purgeThreads()
+{
+	if (m_threadNavqueries)
+	{
+		for (int i = 1; i < m_maxThreads; ++i)
+			dtFreeNavMeshQuery(m_threadNavqueries[i]);
+		dtFree(m_threadNavqueries);
+		m_threadNavqueries = 0;
+	}
+	
+	if (m_threadObstacleQueries)
+	{
+		for (int i = 1; i < m_maxThreads; ++i)
+			dtFreeObstacleAvoidanceQuery(m_threadObstacleQueries[i]);
+		dtFree(m_threadObstacleQueries);
+		m_threadObstacleQueries = 0;
+	}
+	
+	dtFree(m_threadSampleCounts);
+	m_threadSampleCounts = 0;
+}
+
+bool dtCrowd::setParallelFor(dtParallelForCallback cb, void* userData, const int maxThreads)
+{
+	m_parallelFor = cb;
+	m_parallelForData = userData;
+	return initThreads(cb ? maxThreads : 1);
+}
+
+void dtCrowd::runPass(const int pass, const int count)
+{
+	if (m_parallelFor && m_maxThreads > 1 && count > 1)
+		(*m_parallelFor)(this, pass, count, m_parallelForData);
+	else
+		updateRange(pass, 0, count, 0);
+}
+
+void dtCrowd::updateRange(const int pass, const int begin, const int end, const int threadIndex)
+{
+	switch (pass)
+	{
+	case PASS_CHECK_PATH_VALIDITY:
+		checkPathValidityRange(begin, end, threadIndex);
+		break;
+	case PASS_REQUEST_PATH:
+		requestPathRange(begin, end, threadIndex);
+		break;
+	case PASS_UPDATE_NEIGHBOURS:
+		updateNeighboursRange(begin, end, threadIndex);
+		break;
+	case PASS_UPDATE_STEERING:
+		updateSteeringRange(begin, end, threadIndex);
+		break;
+	case PASS_PLAN_VELOCITY:
+		planVelocityRange(begin, end, threadIndex);
+		break;
+	case PASS_INTEGRATE:
+		integrateRange(begin, end);
+		break;
+	case PASS_CALC_COLLISION_DISPLACEMENT:
+		calcCollisionDisplacementRange(begin, end);
+		break;
+	case PASS_APPLY_COLLISION_DISPLACEMENT:
+		applyCollisionDisplacementRange(begin, end);
+		break;
+	case PASS_MOVE_POSITION:
+		movePositionRange(begin, end, threadIndex);
+		break;
+	default:
+		break;
+	}
+}
+
 void dtCrowd::setObstacleAvoidanceParams(const int idx, const dtObstacleAvoidanceParams* params)
 {
 	if (idx >= 0 && idx < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
@@ -686,18 +815,14 @@ int dtCrowd::getActiveAgents(dtCrowdAgent** agents, const int maxAgents)
 }
 
 
-void dtCrowd::updateMoveRequest(const float /*dt*/)
+void dtCrowd::requestPathRange(const int begin, const int end, const int threadIndex)
 {
-	const int PATH_MAX_AGENTS = 8;
-	dtCrowdAgent* queue[PATH_MAX_AGENTS];
-	int nqueue = 0;
+	// Urho3D: Add multithreaded update support
+	dtNavMeshQuery* navquery = m_threadNavqueries[threadIndex];
 	
-	// Fire off new requests.
-	for (int i = 0; i < m_maxAgents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
-		dtCrowdAgent* ag = &m_agents[i];
-		if (!ag->active)
-			continue;
+		dtCrowdAgent* ag = m_updateAgents[i];
 		if (ag->state == DT_CROWDAGENT_STATE_INVALID)
 			continue;
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
@@ -716,18 +841,18 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 
 			// Quick search towards the goal.
 			static const int MAX_ITER = 20;
-			m_navquery->initSlicedFindPath(path[0], ag->targetRef, ag->npos, ag->targetPos, &m_filters[ag->params.queryFilterType]);
-			m_navquery->updateSlicedFindPath(MAX_ITER, 0);
+			navquery->initSlicedFindPath(path[0], ag->targetRef, ag->npos, ag->targetPos, &m_filters[ag->params.queryFilterType]);
+			navquery->updateSlicedFindPath(MAX_ITER, 0);
 			dtStatus status = 0;
 			if (ag->targetReplan) // && npath > 10)
 			{
 				// Try to use existing steady path during replan if possible.
-				status = m_navquery->finalizeSlicedFindPathPartial(path, npath, reqPath, &reqPathCount, MAX_RES);
+				status = navquery->finalizeSlicedFindPathPartial(path, npath, reqPath, &reqPathCount, MAX_RES);
 			}
 			else
 			{
 				// Try to move towards target when goal changes.
-				status = m_navquery->finalizeSlicedFindPath(reqPath, &reqPathCount, MAX_RES);
+				status = navquery->finalizeSlicedFindPath(reqPath, &reqPathCount, MAX_RES);
 			}
 
 			if (!dtStatusFailed(status) && reqPathCount > 0)
@@ -736,7 +861,7 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				if (reqPath[reqPathCount-1] != ag->targetRef)
 				{
 					// Partial path, constrain target position inside the last polygon.
-					status = m_navquery->closestPointOnPoly(reqPath[reqPathCount-1], ag->targetPos, reqPos, 0);
+					status = navquery->closestPointOnPoly(reqPath[reqPathCount-1], ag->targetPos, reqPos, 0);
 					if (dtStatusFailed(status))
 						reqPathCount = 0;
 				}
@@ -773,6 +898,26 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE;
 			}
 		}
+	}
+}
+
+void dtCrowd::updateMoveRequest(const float /*dt*/)
+{
+	const int PATH_MAX_AGENTS = 8;
+	dtCrowdAgent* queue[PATH_MAX_AGENTS];
+	int nqueue = 0;
+	
+	// Fire off new requests.
+	// Urho3D: The quick searches towards the goals run in parallel, then the agents needing a full plan are queued.
+	runPass(PASS_REQUEST_PATH, m_updateAgentCount);
+	
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		dtCrowdAgent* ag = &m_agents[i];
+		if (!ag->active)
+			continue;
+		if (ag->state == DT_CROWDAGENT_STATE_INVALID)
+			continue;
 		
 		if (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE)
 		{
@@ -791,7 +936,8 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 
 	
 	// Update requests.
-	m_pathq.update(MAX_ITERS_PER_UPDATE);
+	// Urho3D: Add path iteration budget support
+	m_pathq.update(m_maxPathIters);
 
 	dtStatus status;
 
@@ -949,12 +1095,23 @@ void dtCrowd::updateTopologyOptimization(dtCrowdAgent** agents, const int nagent
 
 }
 
-void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt)
+void dtCrowd::checkPathValidity(dtCrowdAgent** /*agents*/, const int nagents, const float /*dt*/)
+{
+	// Urho3D: Add multithreaded update support
+	runPass(PASS_CHECK_PATH_VALIDITY, nagents);
+}
+
+void dtCrowd::checkPathValidityRange(const int begin, const int end, const int threadIndex)
 {
 	static const int CHECK_LOOKAHEAD = 10;
 	static const float TARGET_REPLAN_DELAY = 1.0; // seconds
 	
-	for (int i = 0; i < nagents; ++i)
+	// Urho3D: Add multithreaded update support
+	dtCrowdAgent** agents = m_updateAgents;
+	const float dt = m_updateDt;
+	dtNavMeshQuery* navquery = m_threadNavqueries[threadIndex];
+	
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
@@ -970,14 +1127,14 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 		float agentPos[3];
 		dtPolyRef agentRef = ag->corridor.getFirstPoly();
 		dtVcopy(agentPos, ag->npos);
-		if (!m_navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
+		if (!navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
 		{
 			// Current location is not valid, try to reposition.
 			// TODO: this can snap agents, how to handle that?
 			float nearest[3];
 			dtVcopy(nearest, agentPos);
 			agentRef = 0;
-			m_navquery->findNearestPoly(ag->npos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &agentRef, nearest);
+			navquery->findNearestPoly(ag->npos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &agentRef, nearest);
 			dtVcopy(agentPos, nearest);
 
 			if (!agentRef)
@@ -993,7 +1150,7 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 			// Make sure the first polygon is valid, but leave other valid
 			// polygons in the path so that replanner can adjust the path better.
 			ag->corridor.fixPathStart(agentRef, agentPos);
-//			ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filter);
+//			ag->corridor.trimInvalidPath(agentRef, agentPos, navquery, &m_filter);
 			ag->boundary.reset();
 			dtVcopy(ag->npos, agentPos);
 
@@ -1007,13 +1164,13 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 		// Try to recover move request position.
 		if (ag->targetState != DT_CROWDAGENT_TARGET_NONE && ag->targetState != DT_CROWDAGENT_TARGET_FAILED)
 		{
-			if (!m_navquery->isValidPolyRef(ag->targetRef, &m_filters[ag->params.queryFilterType]))
+			if (!navquery->isValidPolyRef(ag->targetRef, &m_filters[ag->params.queryFilterType]))
 			{
 				// Current target is not valid, try to reposition.
 				float nearest[3];
 				dtVcopy(nearest, ag->targetPos);
 				ag->targetRef = 0;
-				m_navquery->findNearestPoly(ag->targetPos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &ag->targetRef, nearest);
+				navquery->findNearestPoly(ag->targetPos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &ag->targetRef, nearest);
 				dtVcopy(ag->targetPos, nearest);
 				replan = true;
 			}
@@ -1027,10 +1184,10 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 		}
 
 		// If nearby corridor is not valid, replan.
-		if (!ag->corridor.isValid(CHECK_LOOKAHEAD, m_navquery, &m_filters[ag->params.queryFilterType]))
+		if (!ag->corridor.isValid(CHECK_LOOKAHEAD, navquery, &m_filters[ag->params.queryFilterType]))
 		{
 			// Fix current path.
-//			ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filter);
+//			ag->corridor.trimInvalidPath(agentRef, agentPos, navquery, &m_filter);
 //			ag->boundary.reset();
 			replan = true;
 		}
@@ -1055,36 +1212,14 @@ void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const
 	}
 }
 	
-void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+// Urho3D: The per-agent passes of dtCrowd::update(), split to run over a range of the active agents.
+void dtCrowd::updateNeighboursRange(const int begin, const int end, const int threadIndex)
 {
-	m_velocitySampleCount = 0;
-	
-	const int debugIdx = debug ? debug->idx : -1;
-	
-	dtCrowdAgent** agents = m_activeAgents;
-	int nagents = getActiveAgents(agents, m_maxAgents);
-
-	// Check that all agents still have valid paths.
-	checkPathValidity(agents, nagents, dt);
-	
-	// Update async move request and path finder.
-	updateMoveRequest(dt);
-
-	// Optimize path topology.
-	updateTopologyOptimization(agents, nagents, dt);
+	dtCrowdAgent** agents = m_updateAgents;
+	const int nagents = m_updateAgentCount;
+	dtNavMeshQuery* navquery = m_threadNavqueries[threadIndex];
 	
-	// Register agents to proximity grid.
-	m_grid->clear();
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		const float* p = ag->npos;
-		const float r = ag->params.radius;
-		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
-	}
-	
-	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
@@ -1094,10 +1229,10 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		// if it has become invalid.
 		const float updateThr = ag->params.collisionQueryRange*0.25f;
 		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
+			!ag->boundary.isValid(navquery, &m_filters[ag->params.queryFilterType]))
 		{
 			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
+								navquery, &m_filters[ag->params.queryFilterType]);
 		}
 		// Query neighbour agents
 		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
@@ -1106,96 +1241,84 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		for (int j = 0; j < ag->nneis; j++)
 			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
 	}
+}
+
+void dtCrowd::updateSteeringRange(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_updateAgents;
+	dtCrowdAgentDebugInfo* debug = m_updateDebug;
+	const int debugIdx = debug ? debug->idx : -1;
+	dtNavMeshQuery* navquery = m_threadNavqueries[threadIndex];
 	
-	// Find next corner to steer to.
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
 			continue;
 		
-		// Find corners for steering
-		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
-		
-		// Check to see if the corner after the next corner is directly visible,
-		// and short cut to there.
-		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
+		if (ag->targetState != DT_CROWDAGENT_TARGET_VELOCITY)
 		{
-			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
+			// Find corners for steering
+			ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
+													DT_CROWDAGENT_MAX_CORNERS, navquery, &m_filters[ag->params.queryFilterType]);
 			
-			// Copy data for debug purposes.
-			if (debugIdx == i)
+			// Check to see if the corner after the next corner is directly visible,
+			// and short cut to there.
+			if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
 			{
-				dtVcopy(debug->optStart, ag->corridor.getPos());
-				dtVcopy(debug->optEnd, target);
+				const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
+				ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, navquery, &m_filters[ag->params.queryFilterType]);
+				
+				// Copy data for debug purposes.
+				if (debugIdx == i)
+				{
+					dtVcopy(debug->optStart, ag->corridor.getPos());
+					dtVcopy(debug->optEnd, target);
+				}
 			}
-		}
-		else
-		{
-			// Copy data for debug purposes.
-			if (debugIdx == i)
+			else
 			{
-				dtVset(debug->optStart, 0,0,0);
-				dtVset(debug->optEnd, 0,0,0);
+				// Copy data for debug purposes.
+				if (debugIdx == i)
+				{
+					dtVset(debug->optStart, 0,0,0);
+					dtVset(debug->optEnd, 0,0,0);
+				}
 			}
-		}
-	}
-	
-	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
-		
-		// Check 
-		const float triggerRadius = ag->params.radius*2.25f;
-		if (overOffmeshConnection(ag, triggerRadius))
-		{
-			// Prepare to off-mesh connection.
-			const int idx = (int)(ag - m_agents);
-			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
 			
-			// Adjust the path over the off-mesh connection.
-			dtPolyRef refs[2];
-			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
-													   anim->startPos, anim->endPos, m_navquery))
+			// Trigger off-mesh connections (depends on corners).
+			const float triggerRadius = ag->params.radius*2.25f;
+			if (overOffmeshConnection(ag, triggerRadius))
 			{
-				dtVcopy(anim->initPos, ag->npos);
-				anim->polyRef = refs[1];
-				anim->active = true;
-				anim->t = 0.0f;
-				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+				// Prepare to off-mesh connection.
+				const int idx = (int)(ag - m_agents);
+				dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
 				
-				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
-				ag->ncorners = 0;
-				ag->nneis = 0;
-				continue;
-			}
-			else
-			{
-				// Path validity check will ensure that bad/blocked connections will be replanned.
+				// Adjust the path over the off-mesh connection.
+				dtPolyRef refs[2];
+				if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
+														   anim->startPos, anim->endPos, navquery))
+				{
+					dtVcopy(anim->initPos, ag->npos);
+					anim->polyRef = refs[1];
+					anim->active = true;
+					anim->t = 0.0f;
+					anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
+					
+					ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+					ag->ncorners = 0;
+					ag->nneis = 0;
+					continue;
+				}
+				else
+				{
+					// Path validity check will ensure that bad/blocked connections will be replanned.
+				}
 			}
 		}
-	}
-		
-	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
-			continue;
 		
 		float dvel[3] = {0,0,0};
 
@@ -1265,9 +1388,16 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		// Set the desired velocity.
 		dtVcopy(ag->dvel, dvel);
 	}
+}
+
+void dtCrowd::planVelocityRange(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_updateAgents;
+	dtCrowdAgentDebugInfo* debug = m_updateDebug;
+	const int debugIdx = debug ? debug->idx : -1;
+	dtObstacleAvoidanceQuery* obstacleQuery = m_threadObstacleQueries[threadIndex];
 	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		
@@ -1276,13 +1406,13 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		
 		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
 		{
-			m_obstacleQuery->reset();
+			obstacleQuery->reset();
 			
 			// Add neighbours as obstacles.
 			for (int j = 0; j < ag->nneis; ++j)
 			{
 				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
+				obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
 			}
 
 			// Append neighbour segments as obstacles.
@@ -1291,7 +1421,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				const float* s = ag->boundary.getSegment(j);
 				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
 					continue;
-				m_obstacleQuery->addSegment(s, s+3);
+				obstacleQuery->addSegment(s, s+3);
 			}
 
 			dtObstacleAvoidanceDebugData* vod = 0;
@@ -1306,15 +1436,15 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 				
 			if (adaptive)
 			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
-															 ag->vel, ag->dvel, ag->nvel, params, vod);
+				ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+														   ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
 			else
 			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
+				ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
+													   ag->vel, ag->dvel, ag->nvel, params, vod);
 			}
-			m_velocitySampleCount += ns;
+			m_threadSampleCounts[threadIndex] += ns;
 		}
 		else
 		{
@@ -1322,95 +1452,111 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			dtVcopy(ag->nvel, ag->dvel);
 		}
 	}
+}
 
-	// Integrate.
-	for (int i = 0; i < nagents; ++i)
+void dtCrowd::integrateRange(const int begin, const int end)
+{
+	dtCrowdAgent** agents = m_updateAgents;
+	
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
-		integrate(ag, dt);
+		integrate(ag, m_updateDt);
 	}
-	
-	// Handle collisions.
+}
+
+void dtCrowd::calcCollisionDisplacementRange(const int begin, const int end)
+{
 	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
 	
-	for (int iter = 0; iter < 4; ++iter)
+	dtCrowdAgent** agents = m_updateAgents;
+	
+	for (int i = begin; i < end; ++i)
 	{
-		for (int i = 0; i < nagents; ++i)
+		dtCrowdAgent* ag = agents[i];
+		const int idx0 = getAgentIndex(ag);
+		
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+
+		dtVset(ag->disp, 0,0,0);
+		
+		float w = 0;
+
+		for (int j = 0; j < ag->nneis; ++j)
 		{
-			dtCrowdAgent* ag = agents[i];
-			const int idx0 = getAgentIndex(ag);
-			
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
+			const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
+			const int idx1 = getAgentIndex(nei);
 
-			dtVset(ag->disp, 0,0,0);
+			float diff[3];
+			dtVsub(diff, ag->npos, nei->npos);
+			diff[1] = 0;
 			
-			float w = 0;
-
-			for (int j = 0; j < ag->nneis; ++j)
+			float dist = dtVlenSqr(diff);
+			if (dist > dtSqr(ag->params.radius + nei->params.radius))
+				continue;
+			dist = dtMathSqrtf(dist);
+			float pen = (ag->params.radius + nei->params.radius) - dist;
+			if (dist < 0.0001f)
 			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				const int idx1 = getAgentIndex(nei);
-
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				float dist = dtVlenSqr(diff);
-				if (dist > dtSqr(ag->params.radius + nei->params.radius))
-					continue;
-				dist = dtMathSqrtf(dist);
-				float pen = (ag->params.radius + nei->params.radius) - dist;
-				if (dist < 0.0001f)
-				{
-					// Agents on top of each other, try to choose diverging separation directions.
-					if (idx0 > idx1)
-						dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
-					else
-						dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
-					pen = 0.01f;
-				}
+				// Agents on top of each other, try to choose diverging separation directions.
+				if (idx0 > idx1)
+					dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
 				else
-				{
-					pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
-				}
-				
-				// Urho3D: Avoid tremble when another agent can not move away
-				if (ag->params.separationWeight < 0.0001f) 
-					continue;
-				
-				dtVmad(ag->disp, ag->disp, diff, pen);			
-				
-				w += 1.0f;
+					dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
+				pen = 0.01f;
 			}
-			
-			if (w > 0.0001f)
+			else
 			{
-				const float iw = 1.0f / w;
-				dtVscale(ag->disp, ag->disp, iw);
+				pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
 			}
+			
+			// Urho3D: Avoid tremble when another agent can not move away
+			if (ag->params.separationWeight < 0.0001f) 
+				continue;
+			
+			dtVmad(ag->disp, ag->disp, diff, pen);			
+			
+			w += 1.0f;
 		}
 		
-		for (int i = 0; i < nagents; ++i)
+		if (w > 0.0001f)
 		{
-			dtCrowdAgent* ag = agents[i];
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
-			
-			dtVadd(ag->npos, ag->npos, ag->disp);
+			const float iw = 1.0f / w;
+			dtVscale(ag->disp, ag->disp, iw);
 		}
 	}
+}
+
+void dtCrowd::applyCollisionDisplacementRange(const int begin, const int end)
+{
+	dtCrowdAgent** agents = m_updateAgents;
 	
-	for (int i = 0; i < nagents; ++i)
+	for (int i = begin; i < end; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+			continue;
+		
+		dtVadd(ag->npos, ag->npos, ag->disp);
+	}
+}
+
+void dtCrowd::movePositionRange(const int begin, const int end, const int threadIndex)
+{
+	dtCrowdAgent** agents = m_updateAgents;
+	dtNavMeshQuery* navquery = m_threadNavqueries[threadIndex];
+	
+	for (int i = begin; i < end; ++i)
 	{
 		dtCrowdAgent* ag = agents[i];
 		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 			continue;
 		
 		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
+		ag->corridor.movePosition(ag->npos, navquery, &m_filters[ag->params.queryFilterType]);
 		// Get valid constrained position back.
 		dtVcopy(ag->npos, ag->corridor.getPos());
 
@@ -1420,10 +1566,79 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
 			ag->partial = false;
 		}
-		
-		// Urho3D: Add update callback support
-		if (m_updateCallback)
+	}
+}
+
+void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	m_velocitySampleCount = 0;
+	
+	dtCrowdAgent** agents = m_activeAgents;
+	int nagents = getActiveAgents(agents, m_maxAgents);
+
+	// Urho3D: Add multithreaded update support
+	m_updateAgents = agents;
+	m_updateAgentCount = nagents;
+	m_updateDt = dt;
+	m_updateDebug = debug;
+	for (int i = 0; i < m_maxThreads; ++i)
+		m_threadSampleCounts[i] = 0;
+
+	// Check that all agents still have valid paths.
+	checkPathValidity(agents, nagents, dt);
+	
+	// Update async move request and path finder.
+	updateMoveRequest(dt);
+
+	// Optimize path topology.
+	updateTopologyOptimization(agents, nagents, dt);
+	
+	// Register agents to proximity grid.
+	m_grid->clear();
+	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		const float* p = ag->npos;
+		const float r = ag->params.radius;
+		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
+	}
+	
+	// Urho3D: The passes below only write to the agents of their range and to per-thread data, so they can run in parallel.
+
+	// Get nearby navmesh segments and agents to collide with.
+	runPass(PASS_UPDATE_NEIGHBOURS, nagents);
+	
+	// Find next corner to steer to, trigger off-mesh connections (depends on corners) and calculate steering.
+	runPass(PASS_UPDATE_STEERING, nagents);
+	
+	// Velocity planning.
+	runPass(PASS_PLAN_VELOCITY, nagents);
+	for (int i = 0; i < m_maxThreads; ++i)
+		m_velocitySampleCount += m_threadSampleCounts[i];
+
+	// Integrate.
+	runPass(PASS_INTEGRATE, nagents);
+	
+	// Handle collisions.
+	for (int iter = 0; iter < 4; ++iter)
+	{
+		runPass(PASS_CALC_COLLISION_DISPLACEMENT, nagents);
+		runPass(PASS_APPLY_COLLISION_DISPLACEMENT, nagents);
+	}
+	
+	// Move along navmesh.
+	runPass(PASS_MOVE_POSITION, nagents);
+	
+	// Urho3D: Add update callback support. The callbacks run in the calling thread once all the agents have moved.
+	if (m_updateCallback)
+	{
+		for (int i = 0; i < nagents; ++i)
+		{
+			dtCrowdAgent* ag = agents[i];
+			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+				continue;
 			(*m_updateCallback)(ag, dt);
+		}
 	}
 	
 	// Update agents using off-mesh connection.
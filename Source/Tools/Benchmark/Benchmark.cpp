@@ -0,0 +1,745 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/FlatHashMap.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/Compression.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#ifdef URHO3D_NETWORK
+#include <Urho3D/Network/ObjectControlBatch.h>
+#endif
+#include <Urho3D/Resource/Image.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Component.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Event sent by the events test.
+URHO3D_EVENT(E_BENCHMARKEVENT, BenchmarkEvent)
+{
+    URHO3D_PARAM(P_SENDER, Sender);                // Object pointer
+    URHO3D_PARAM(P_VALUE, Value);                  // int
+}
+
+/// Typed event sent by the events test as E_BENCHMARKEVENT.
+struct BenchmarkTypedEvent
+{
+    URHO3D_TYPEDEVENT(E_BENCHMARKEVENT)
+
+    /// Fill the event data for the VariantMap subscribers.
+    void FillEventData(VariantMap& eventData) const
+    {
+        using namespace BenchmarkEvent;
+
+        eventData[P_SENDER] = sender_;
+        eventData[P_VALUE] = value_;
+    }
+
+    /// Sender.
+    Object* sender_;
+    /// Value.
+    int value_;
+};
+
+/// Receiver of the events test, summing the received values.
+class BenchmarkReceiver : public Object
+{
+    URHO3D_OBJECT(BenchmarkReceiver, Object);
+
+public:
+    /// Construct.
+    explicit BenchmarkReceiver(Context* context) :
+        Object(context),
+        sum_(0)
+    {
+    }
+
+    /// Handle the event from a VariantMap.
+    void HandleEvent(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace BenchmarkEvent;
+
+        sum_ += eventData[P_VALUE].GetInt();
+    }
+
+    /// Handle the typed event.
+    void HandleTypedEvent(const BenchmarkTypedEvent& event)
+    {
+        sum_ += event.value_;
+    }
+
+    /// Sum of the received values.
+    long long sum_;
+};
+
+/// Component of the snapshot test, with attributes of the common value types.
+class BenchmarkComponent : public Component
+{
+    URHO3D_OBJECT(BenchmarkComponent, Component);
+
+public:
+    /// Construct.
+    explicit BenchmarkComponent(Context* context) :
+        Component(context),
+        value_(0),
+        weight_(1.0f),
+        flag_(false)
+    {
+    }
+
+    /// Register object factory and attributes.
+    static void RegisterObject(Context* context)
+    {
+        context->RegisterFactory<BenchmarkComponent>();
+
+        URHO3D_ATTRIBUTE("Value", int, value_, 0, AM_DEFAULT);
+        URHO3D_ATTRIBUTE("Weight", float, weight_, 1.0f, AM_DEFAULT);
+        URHO3D_ATTRIBUTE("Flag", bool, flag_, false, AM_DEFAULT);
+        URHO3D_ATTRIBUTE("Offset", Vector3, offset_, Vector3::ZERO, AM_DEFAULT);
+        URHO3D_ATTRIBUTE("Color", Color, color_, Color::WHITE, AM_DEFAULT);
+        URHO3D_ATTRIBUTE("Label", String, label_, String::EMPTY, AM_DEFAULT);
+    }
+
+    /// Integer value.
+    int value_;
+    /// Float value.
+    float weight_;
+    /// Boolean value.
+    bool flag_;
+    /// Vector value.
+    Vector3 offset_;
+    /// Color value.
+    Color color_;
+    /// String value.
+    String label_;
+};
+
+SharedPtr<Context> context_(new Context());
+unsigned count_ = 0;
+unsigned iterations_ = 0;
+String resourcePath_;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void PrintResult(const String& name, unsigned long long operations, long long usec, const String& unit);
+void BenchmarkControls();
+void BenchmarkEvents();
+void BenchmarkHashMap();
+void BenchmarkLoading();
+void BenchmarkImage();
+void BenchmarkSnapshot();
+template <class T> unsigned long long BenchmarkMap(const String& name, const PODVector<StringHash>& keys, unsigned numRounds);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 1)
+        ErrorExit(
+            "Usage: Benchmark <test> [options]\n"
+            "\n"
+            "Measures the throughput of engine code paths without a window or a renderer.\n"
+            "\n"
+            "Tests:\n"
+            "controls  Encode and decode ObjectControl records for a server tick (count = records)\n"
+            "events    Send events to VariantMap and typed handlers (count = receivers)\n"
+            "hashmap   Insert, find, iterate and erase with FlatHashMap and HashMap (count = keys)\n"
+            "loading   Load the images, XML and JSON files of a resource directory in the background (count = max threads)\n"
+            "image     Resize, flip, convert and premultiply an RGBA image (count = image width and height)\n"
+            "snapshot  Load a scene from the binary scene format and from a snapshot (count = nodes)\n"
+            "\n"
+            "Options:\n"
+            "-n<count>       Number of elements, the meaning depends on the test\n"
+            "-i<iterations>  Number of iterations\n"
+            "-p<path>        Resource directory of the loading test, default bin/Data\n"
+        );
+
+    const String test = arguments[0].ToLower();
+
+    for (unsigned i = 1; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() < 2 || arguments[i][0] != '-')
+            ErrorExit("Unrecognized option " + arguments[i]);
+
+        switch (arguments[i][1])
+        {
+        case 'n':
+            count_ = ToUInt(arguments[i].Substring(2));
+            break;
+        case 'i':
+            iterations_ = ToUInt(arguments[i].Substring(2));
+            break;
+        case 'p':
+            resourcePath_ = arguments[i].Substring(2);
+            break;
+        default:
+            ErrorExit("Unrecognized option " + arguments[i]);
+        }
+    }
+
+    // Initialize the high resolution timer
+    context_->RegisterSubsystem(new Time(context_));
+
+    if (test == "controls")
+        BenchmarkControls();
+    else if (test == "events")
+        BenchmarkEvents();
+    else if (test == "hashmap")
+        BenchmarkHashMap();
+    else if (test == "loading")
+        BenchmarkLoading();
+    else if (test == "image")
+        BenchmarkImage();
+    else if (test == "snapshot")
+        BenchmarkSnapshot();
+    else
+        ErrorExit("Unrecognized test " + test);
+}
+
+void PrintResult(const String& name, unsigned long long operations, long long usec, const String& unit)
+{
+    // String formatting has no field widths, use sprintf like the profiler output
+    char line[256];
+    const double seconds = Max((double)usec, 1.0) / 1000000.0;
+    sprintf(line, "%-32s %10.3f ms %14.0f %s/s", name.CString(), usec / 1000.0, operations / seconds, unit.CString());
+    PrintLine(line);
+}
+
+void BenchmarkControls()
+{
+#ifdef URHO3D_NETWORK
+    const unsigned numRecords = count_ ? Min(count_, 65535U) : 1000;
+    const unsigned numTicks = iterations_ ? iterations_ : 1000;
+    const unsigned numClients = 32;
+
+    PrintLine(ToString("%u records, %u clients, %u ticks", numRecords, numClients, numTicks));
+
+    // Every 16th record is hidden from one client, so that some connections need a filtered packet
+    PODVector<ObjectControlRecord> records(numRecords);
+    PODVector<unsigned long long> clientMasks(numRecords);
+    for (unsigned i = 0; i < numRecords; ++i)
+    {
+        ObjectControlRecord& record = records[i];
+        memset(&record, 0, sizeof record);
+        record.nodeID_ = i + 1;
+        record.buttons_ = i & 0xff;
+        record.animState_ = StringHash("Walk").Value();
+        record.position_ = Vector2((float)i, (float)(i % 100));
+        record.velocity_ = Vector2(1.0f, 0.0f);
+        record.direction_ = 1.0f;
+        clientMasks[i] = (i & 15) ? OBJECTCONTROL_ALLCLIENTS : ~(1ULL << ((i >> 4) % numClients));
+    }
+
+    ObjectControlBatch batch;
+    VectorBuffer decodeBuffer;
+    unsigned long long decodedRecords = 0;
+    unsigned long long checksum = 0;
+    long long encodeTime = 0;
+    long long decodeTime = 0;
+    HiresTimer timer;
+
+    for (unsigned tick = 0; tick < numTicks; ++tick)
+    {
+        // Shared batch : the records are encoded and compressed once per tick for all the connections
+        timer.Reset();
+        batch.Clear();
+        for (unsigned i = 0; i < numRecords; ++i)
+            batch.AddRecord(records[i], clientMasks[i]);
+        PODVector<VectorBuffer*> packets(numClients);
+        for (unsigned c = 0; c < numClients; ++c)
+            packets[c] = batch.GetPacket(c);
+        encodeTime += timer.GetUSec(true);
+
+        // Each client decompresses its packet and reads the records in place
+        for (unsigned c = 0; c < numClients; ++c)
+        {
+            if (!packets[c])
+                continue;
+
+            MemoryBuffer packet(packets[c]->GetData() + OBJECTCONTROL_PACKET_RESERVED, packets[c]->GetSize() - OBJECTCONTROL_PACKET_RESERVED);
+            decodeBuffer.Clear();
+            if (!DecompressStream(decodeBuffer, packet))
+                ErrorExit("Failed to decompress an object control packet");
+
+            unsigned numDecoded;
+            const ObjectControlRecord* decoded = ObjectControlBatch::DecodeRecords(decodeBuffer.GetData(), decodeBuffer.GetSize(), numDecoded);
+            for (unsigned i = 0; i < numDecoded; ++i)
+                checksum += decoded[i].nodeID_;
+            decodedRecords += numDecoded;
+        }
+        decodeTime += timer.GetUSec(true);
+    }
+
+    // The controls are counted once per receiving connection, for comparison with the per connection encoding
+    PrintResult("Encode, shared batch", decodedRecords, encodeTime, "controls");
+    PrintResult("Decode, per client", decodedRecords, decodeTime, "controls");
+
+    // Reference : the records encoded and compressed for each connection separately
+    VectorBuffer encodeBuffer;
+    PODVector<unsigned char> compressBuffer;
+    unsigned long long encodedRecords = 0;
+    timer.Reset();
+    for (unsigned tick = 0; tick < numTicks; ++tick)
+    {
+        for (unsigned c = 0; c < numClients; ++c)
+        {
+            unsigned numEncoded = ObjectControlBatch::EncodeRecords(encodeBuffer, records.Buffer(), clientMasks.Buffer(), numRecords, 1ULL << c);
+            compressBuffer.Resize(EstimateCompressBound(encodeBuffer.GetSize()));
+            checksum += CompressData(compressBuffer.Buffer(), encodeBuffer.GetData(), encodeBuffer.GetSize());
+            encodedRecords += numEncoded;
+        }
+    }
+    encodeTime = timer.GetUSec(false);
+
+    PrintResult("Encode, per connection", encodedRecords, encodeTime, "controls");
+    PrintLine("Checksum " + String(checksum));
+#else
+    ErrorExit("Networking is disabled in this build");
+#endif
+}
+
+void BenchmarkEvents()
+{
+    const unsigned numReceivers = count_ ? count_ : 100;
+    const unsigned numEvents = iterations_ ? iterations_ : 100000;
+
+    PrintLine(ToString("%u receivers, %u events", numReceivers, numEvents));
+
+    // One sender per variant, so that each one only reaches its own receivers
+    SharedPtr<BenchmarkReceiver> variantSender(new BenchmarkReceiver(context_));
+    SharedPtr<BenchmarkReceiver> typedSender(new BenchmarkReceiver(context_));
+    SharedPtr<BenchmarkReceiver> mixedSender(new BenchmarkReceiver(context_));
+    Vector<SharedPtr<BenchmarkReceiver> > receivers;
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        SharedPtr<BenchmarkReceiver> receiver(new BenchmarkReceiver(context_));
+        receiver->SubscribeToEvent(variantSender, E_BENCHMARKEVENT, new EventHandlerImpl<BenchmarkReceiver>(receiver, &BenchmarkReceiver::HandleEvent));
+        receivers.Push(receiver);
+
+        receiver = new BenchmarkReceiver(context_);
+        receiver->SubscribeToTypedEvent(typedSender, &BenchmarkReceiver::HandleTypedEvent);
+        receivers.Push(receiver);
+
+        receiver = new BenchmarkReceiver(context_);
+        receiver->SubscribeToEvent(mixedSender, E_BENCHMARKEVENT, new EventHandlerImpl<BenchmarkReceiver>(receiver, &BenchmarkReceiver::HandleEvent));
+        receivers.Push(receiver);
+    }
+
+    const unsigned long long numCalls = (unsigned long long)numEvents * numReceivers;
+    HiresTimer timer;
+
+    // VariantMap event sent and handled as usual
+    for (unsigned i = 0; i < numEvents; ++i)
+    {
+        using namespace BenchmarkEvent;
+
+        VariantMap& eventData = variantSender->GetEventDataMap();
+        eventData[P_SENDER] = variantSender.Get();
+        eventData[P_VALUE] = (int)i;
+        variantSender->SendEvent(E_BENCHMARKEVENT, eventData);
+    }
+    PrintResult("VariantMap send, VariantMap handler", numCalls, timer.GetUSec(true), "calls");
+
+    // Typed event handled by typed handlers, no VariantMap is filled
+    for (unsigned i = 0; i < numEvents; ++i)
+    {
+        BenchmarkTypedEvent event;
+        event.sender_ = typedSender;
+        event.value_ = (int)i;
+        typedSender->SendTypedEvent(event);
+    }
+    PrintResult("Typed send, typed handler", numCalls, timer.GetUSec(true), "calls");
+
+    // Typed event handled by VariantMap handlers, the VariantMap is filled once per send
+    for (unsigned i = 0; i < numEvents; ++i)
+    {
+        BenchmarkTypedEvent event;
+        event.sender_ = mixedSender;
+        event.value_ = (int)i;
+        mixedSender->SendTypedEvent(event);
+    }
+    PrintResult("Typed send, VariantMap handler", numCalls, timer.GetUSec(true), "calls");
+
+    long long checksum = 0;
+    for (unsigned i = 0; i < receivers.Size(); ++i)
+        checksum += receivers[i]->sum_;
+    PrintLine("Checksum " + String(checksum));
+}
+
+void BenchmarkHashMap()
+{
+    const unsigned numKeys = count_ ? count_ : 10000;
+    const unsigned numRounds = iterations_ ? iterations_ : 100;
+
+    PrintLine(ToString("%u keys, %u rounds", numKeys, numRounds));
+
+    // Hashed names like the resource and attribute keys, the second half is only used for failed lookups
+    PODVector<StringHash> keys(numKeys * 2);
+    for (unsigned i = 0; i < keys.Size(); ++i)
+        keys[i] = StringHash("Resources/Object" + String(i) + ".xml");
+
+    unsigned long long checksum = BenchmarkMap<FlatHashMap<StringHash, unsigned> >("FlatHashMap", keys, numRounds);
+    checksum += BenchmarkMap<HashMap<StringHash, unsigned> >("HashMap", keys, numRounds);
+    PrintLine("Checksum " + String(checksum));
+}
+
+template <class T> unsigned long long BenchmarkMap(const String& name, const PODVector<StringHash>& keys, unsigned numRounds)
+{
+    const unsigned numKeys = keys.Size() / 2;
+    const unsigned long long numOperations = (unsigned long long)numKeys * numRounds;
+    unsigned long long checksum = 0;
+    long long insertTime = 0;
+    long long findTime = 0;
+    long long missTime = 0;
+    long long iterateTime = 0;
+    long long eraseTime = 0;
+    HiresTimer timer;
+
+    for (unsigned round = 0; round < numRounds; ++round)
+    {
+        T map;
+
+        timer.Reset();
+        for (unsigned i = 0; i < numKeys; ++i)
+            map[keys[i]] = i;
+        insertTime += timer.GetUSec(true);
+
+        for (unsigned i = 0; i < numKeys; ++i)
+        {
+            typename T::ConstIterator it = map.Find(keys[i]);
+            if (it != map.End())
+                checksum += it->second_;
+        }
+        findTime += timer.GetUSec(true);
+
+        for (unsigned i = numKeys; i < keys.Size(); ++i)
+            checksum += map.Contains(keys[i]) ? 1 : 0;
+        missTime += timer.GetUSec(true);
+
+        for (typename T::ConstIterator it = map.Begin(); it != map.End(); ++it)
+            checksum += it->second_;
+        iterateTime += timer.GetUSec(true);
+
+        for (unsigned i = 0; i < numKeys; ++i)
+            map.Erase(keys[i]);
+        eraseTime += timer.GetUSec(true);
+    }
+
+    PrintResult(name + " insert", numOperations, insertTime, "keys");
+    PrintResult(name + " find", numOperations, findTime, "keys");
+    PrintResult(name + " find missing", numOperations, missTime, "keys");
+    PrintResult(name + " iterate", numOperations, iterateTime, "keys");
+    PrintResult(name + " erase", numOperations, eraseTime, "keys");
+    return checksum;
+}
+
+void BenchmarkLoading()
+{
+#ifdef URHO3D_THREADING
+    const unsigned maxThreads = count_ ? count_ : 4;
+    const unsigned numRounds = iterations_ ? iterations_ : 5;
+
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new ResourceCache(context_));
+    RegisterResourceLibrary(context_);
+
+    FileSystem* fileSystem = context_->GetSubsystem<FileSystem>();
+    ResourceCache* cache = context_->GetSubsystem<ResourceCache>();
+    const String resourcePath = resourcePath_.Empty() ? GetParentPath(fileSystem->GetProgramDir()) + "Data/" :
+        AddTrailingSlash(GetInternalPath(resourcePath_));
+    if (!cache->AddResourceDir(resourcePath))
+        ErrorExit("Could not open the resource directory " + resourcePath);
+
+    Vector<String> files;
+    fileSystem->ScanDir(files, resourcePath, "*.*", SCAN_FILES, true);
+    Vector<Pair<StringHash, String> > resources;
+    for (unsigned i = 0; i < files.Size(); ++i)
+    {
+        const String extension = GetExtension(files[i]);
+        if (extension == ".png" || extension == ".jpg" || extension == ".tga" || extension == ".dds" || extension == ".ktx")
+            resources.Push(MakePair(Image::GetTypeStatic(), files[i]));
+        else if (extension == ".xml")
+            resources.Push(MakePair(XMLFile::GetTypeStatic(), files[i]));
+        else if (extension == ".json")
+            resources.Push(MakePair(JSONFile::GetTypeStatic(), files[i]));
+    }
+    if (resources.Empty())
+        ErrorExit("No resources to load in " + resourcePath);
+
+    // Finish all the loaded resources on each frame
+    cache->SetFinishBackgroundResourcesMs(M_MAX_INT);
+    cache->SetReturnFailedResources(false);
+
+    PrintLine(ToString("%u resources in %s, %u rounds", resources.Size(), resourcePath.CString(), numRounds));
+
+    // Reference : the resources loaded one after another on the main thread. An extra first round warms the file cache
+    unsigned long long numLoaded = 0;
+    long long loadTime = 0;
+    HiresTimer timer;
+    for (unsigned round = 0; round <= numRounds; ++round)
+    {
+        timer.Reset();
+        for (unsigned i = 0; i < resources.Size(); ++i)
+        {
+            if (cache->GetResource(resources[i].first_, resources[i].second_, false) && round)
+                ++numLoaded;
+        }
+        if (round)
+            loadTime += timer.GetUSec(false);
+        cache->ReleaseAllResources(true);
+    }
+    PrintResult("Main thread", numLoaded, loadTime, "resources");
+
+    for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads <<= 1)
+    {
+        cache->SetNumBackgroundLoadThreads(numThreads);
+        numLoaded = 0;
+        loadTime = 0;
+
+        for (unsigned round = 0; round < numRounds; ++round)
+        {
+            timer.Reset();
+            for (unsigned i = 0; i < resources.Size(); ++i)
+                cache->BackgroundLoadResource(resources[i].first_, resources[i].second_, false);
+
+            // Run frames like the application main loop until all the resources are finished
+            while (cache->GetNumBackgroundLoadResources())
+            {
+                cache->SendEvent(E_BEGINFRAME);
+                Time::Sleep(1);
+            }
+            loadTime += timer.GetUSec(false);
+
+            for (unsigned i = 0; i < resources.Size(); ++i)
+            {
+                if (cache->GetExistingResource(resources[i].first_, resources[i].second_))
+                    ++numLoaded;
+            }
+            cache->ReleaseAllResources(true);
+        }
+
+        PrintResult(ToString("Background, %u threads", numThreads), numLoaded, loadTime, "resources");
+    }
+#else
+    ErrorExit("Threading is disabled in this build");
+#endif
+}
+
+void BenchmarkImage()
+{
+    const int size = count_ ? (int)Min(count_, 8192U) : 1024;
+    const unsigned numRounds = iterations_ ? iterations_ : 20;
+    const unsigned long long numPixels = (unsigned long long)size * size * numRounds;
+
+#ifdef URHO3D_SSE
+    PrintLine(ToString("%dx%d RGBA, %u rounds, SSE2", size, size, numRounds));
+#else
+    PrintLine(ToString("%dx%d RGBA, %u rounds, scalar", size, size, numRounds));
+#endif
+
+    // Noise with a varying alpha, so that no path can skip opaque or transparent pixels
+    PODVector<unsigned char> pixels((unsigned)(size * size * 4));
+    unsigned seed = 1;
+    for (unsigned i = 0; i < pixels.Size(); ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        pixels[i] = (unsigned char)(seed >> 24);
+    }
+
+    SharedPtr<Image> image(new Image(context_));
+    image->SetSize(size, size, 4);
+    unsigned long long checksum = 0;
+    long long resizeDownTime = 0;
+    long long resizeUpTime = 0;
+    long long flipHorizontalTime = 0;
+    long long flipVerticalTime = 0;
+    long long premultiplyTime = 0;
+    long long convertRGBTime = 0;
+    long long convertRGBATime = 0;
+    HiresTimer timer;
+
+    for (unsigned round = 0; round < numRounds; ++round)
+    {
+        // The source data is restored before each resize, outside of the timing
+        image->SetSize(size, size, 4);
+        image->SetData(pixels.Buffer());
+        timer.Reset();
+        image->Resize(size / 2, size / 2);
+        resizeDownTime += timer.GetUSec(false);
+        checksum += image->GetData()[0];
+
+        image->SetSize(size, size, 4);
+        image->SetData(pixels.Buffer());
+        timer.Reset();
+        image->Resize(size * 2, size * 2);
+        resizeUpTime += timer.GetUSec(false);
+        checksum += image->GetData()[0];
+
+        image->SetSize(size, size, 4);
+        image->SetData(pixels.Buffer());
+        timer.Reset();
+        image->FlipHorizontal();
+        flipHorizontalTime += timer.GetUSec(true);
+        image->FlipVertical();
+        flipVerticalTime += timer.GetUSec(true);
+        image->PremultiplyAlpha();
+        premultiplyTime += timer.GetUSec(true);
+        SharedPtr<Image> rgbImage = image->ConvertToRGB();
+        convertRGBTime += timer.GetUSec(true);
+        SharedPtr<Image> rgbaImage = rgbImage->ConvertToRGBA();
+        convertRGBATime += timer.GetUSec(false);
+        checksum += image->GetData()[0] + rgbImage->GetData()[0] + rgbaImage->GetData()[0];
+    }
+
+    // The throughputs count the source pixels
+    PrintResult("Resize to half size", numPixels, resizeDownTime, "pixels");
+    PrintResult("Resize to double size", numPixels, resizeUpTime, "pixels");
+    PrintResult("Flip horizontal", numPixels, flipHorizontalTime, "pixels");
+    PrintResult("Flip vertical", numPixels, flipVerticalTime, "pixels");
+    PrintResult("Premultiply alpha", numPixels, premultiplyTime, "pixels");
+    PrintResult("Convert RGBA to RGB", numPixels, convertRGBTime, "pixels");
+    PrintResult("Convert RGB to RGBA", numPixels, convertRGBATime, "pixels");
+    PrintLine("Checksum " + String(checksum));
+}
+
+void BenchmarkSnapshot()
+{
+    const unsigned numNodes = count_ ? count_ : 100000;
+    const unsigned numRounds = iterations_ ? iterations_ : 3;
+    const unsigned nodesPerGroup = 100;
+
+    context_->RegisterSubsystem(new WorkQueue(context_));
+    RegisterSceneLibrary(context_);
+    BenchmarkComponent::RegisterObject(context_);
+
+    // Groups of nodes under the root, each node with a transform, a name and one component
+    SharedPtr<Scene> scene(new Scene(context_));
+    Node* group = 0;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        if (i % nodesPerGroup == 0)
+            group = scene->CreateChild("Group");
+
+        Node* node = group->CreateChild("Node" + String(i));
+        node->SetPosition(Vector3((float)(i % 317), (float)(i % 13), (float)(i / 317)));
+        node->SetRotation(Quaternion((float)(i % 360), Vector3::UP));
+        BenchmarkComponent* component = node->CreateComponent<BenchmarkComponent>();
+        component->value_ = (int)i;
+        component->weight_ = i * 0.5f;
+        component->flag_ = (i & 1) != 0;
+        component->offset_ = Vector3(0.0f, i * 0.25f, 0.0f);
+        component->label_ = "Label" + String(i % 1000);
+    }
+
+    VectorBuffer sceneData;
+    VectorBuffer snapshotData;
+    if (!scene->Save(sceneData) || !scene->SaveSnapshot(snapshotData))
+        ErrorExit("Could not save the scene");
+    scene.Reset();
+
+    PrintLine(ToString("%u nodes, scene %u bytes, snapshot %u bytes, %u rounds", numNodes, sceneData.GetSize(),
+        snapshotData.GetSize(), numRounds));
+
+    // The snapshot must load the same scene as the binary format
+    {
+        SharedPtr<Scene> loadedScene(new Scene(context_));
+        MemoryBuffer source(snapshotData.GetData(), snapshotData.GetSize());
+        VectorBuffer resavedData;
+        if (!loadedScene->LoadSnapshot(source) || !loadedScene->Save(resavedData) || resavedData.GetSize() != sceneData.GetSize() ||
+            memcmp(resavedData.GetData(), sceneData.GetData(), sceneData.GetSize()))
+            ErrorExit("The snapshot does not load the same scene");
+    }
+
+    // Without worker threads first, then with a worker thread for each other CPU core. Each round loads into a new scene and
+    // destroys it outside of the timing
+    WorkQueue* queue = context_->GetSubsystem<WorkQueue>();
+    const unsigned numWorkerThreads = GetNumLogicalCPUs() - 1;
+    for (unsigned threaded = 0; threaded < 2; ++threaded)
+    {
+        if (threaded)
+        {
+            if (!numWorkerThreads)
+            {
+                PrintLine("No worker threads on a single CPU core");
+                break;
+            }
+            queue->CreateThreads(numWorkerThreads);
+        }
+
+        long long sceneTime = 0;
+        long long snapshotTime = 0;
+        HiresTimer timer;
+        for (unsigned round = 0; round < numRounds; ++round)
+        {
+            SharedPtr<Scene> loadedScene(new Scene(context_));
+            MemoryBuffer sceneSource(sceneData.GetData(), sceneData.GetSize());
+            timer.Reset();
+            if (!loadedScene->Load(sceneSource))
+                ErrorExit("Could not load the scene");
+            sceneTime += timer.GetUSec(false);
+
+            loadedScene = new Scene(context_);
+            MemoryBuffer snapshotSource(snapshotData.GetData(), snapshotData.GetSize());
+            timer.Reset();
+            if (!loadedScene->LoadSnapshot(snapshotSource))
+                ErrorExit("Could not load the snapshot");
+            snapshotTime += timer.GetUSec(false);
+        }
+
+        const unsigned long long numLoaded = (unsigned long long)numNodes * numRounds;
+        const String threads = ToString(", %u worker threads", threaded ? numWorkerThreads : 0);
+        PrintResult("Scene::Load" + threads, numLoaded, sceneTime, "nodes");
+        PrintResult("Scene::LoadSnapshot" + threads, numLoaded, snapshotTime, "nodes");
+    }
+}
@@ -22,10 +22,15 @@
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Container/ArrayPtr.h>
+#include <Urho3D/Container/Sort.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/Compression.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
+#include <Urho3D/IO/VectorBuffer.h>
 
 #ifdef WIN32
 #include <windows.h>
@@ -39,6 +44,17 @@
 using namespace Urho3D;
 
 static const unsigned COMPRESSED_BLOCK_SIZE = 32768;
+static const unsigned DEFAULT_ALIGNMENT = 16;
+/// Length of the sample segments picked into a compression dictionary.
+static const unsigned DICTIONARY_SEGMENT_SIZE = 64;
+/// Length of the byte sequences counted when scoring the segments.
+static const unsigned DICTIONARY_KMER_SIZE = 8;
+/// Number of bits of the byte sequence hashes.
+static const unsigned DICTIONARY_HASH_BITS = 20;
+/// Number of bytes sampled from the start of each file.
+static const unsigned DICTIONARY_SAMPLE_SIZE = 65536;
+/// Maximum number of bytes sampled from all the files.
+static const unsigned DICTIONARY_MAX_SAMPLES_SIZE = 8 * 1024 * 1024;
 
 struct FileEntry
 {
@@ -46,6 +62,15 @@ struct FileEntry
     unsigned offset_;
     unsigned size_;
     unsigned checksum_;
+    unsigned packedSize_;
+    PackageCompression compression_;
+};
+
+struct DictionarySegment
+{
+    unsigned sample_;
+    unsigned offset_;
+    unsigned score_;
 };
 
 SharedPtr<Context> context_(new Context());
@@ -55,7 +80,11 @@ Vector<FileEntry> entries_;
 unsigned checksum_ = 0;
 bool compress_ = false;
 bool quiet_ = false;
+bool version2_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
+unsigned alignment_ = DEFAULT_ALIGNMENT;
+unsigned dictionarySize_ = 0;
+PODVector<unsigned char> dictionary_;
 
 String ignoreExtensions_[] = {
     ".bak",
@@ -67,7 +96,11 @@ int main(int argc, char** argv);
 void Run(const Vector<String>& arguments);
 void ProcessFile(const String& fileName, const String& rootDir);
 void WritePackageFile(const String& fileName, const String& rootDir);
+void WritePackageFileVersion2(const String& fileName, const String& rootDir);
 void WriteHeader(File& dest);
+void WriteIndexVersion2(File& dest);
+void TrainDictionary(const String& rootDir);
+void OutputDecompressionSpeed(PackageFile* packageFile);
 
 int main(int argc, char** argv)
 {
@@ -92,6 +125,11 @@ void Run(const Vector<String>& arguments)
             "Options:\n"
             "-c      Enable package file LZ4 compression\n"
             "-q      Enable quiet mode\n"
+            "-m      Write a memory mappable version 2 package: index sorted by name hash, aligned entries and\n"
+            "        seekable per-file compression (files that do not shrink are stored uncompressed)\n"
+            "-a<n>   Alignment of the file data in a version 2 package, a power of two (default 16)\n"
+            "-d<n>   Compress with a dictionary of at most n bytes (default and maximum 65536) trained from the\n"
+            "        files, for packages of many small similar files. Implies -c and -m\n"
             "\n"
             "Basepath is an optional prefix that will be added to the file entries.\n\n"
             "Alternative output usage: PackageTool <output option> <package name>\n"
@@ -99,6 +137,7 @@ void Run(const Vector<String>& arguments)
             "-i      Output package file information\n"
             "-l      Output file names (including their paths) contained in the package\n"
             "-L      Similar to -l but also output compression ratio (compressed package file only)\n"
+            "-b      Output compression ratio and decompression speed of the whole package\n"
         );
 
     const String& dirName = arguments[0];
@@ -122,6 +161,21 @@ void Run(const Vector<String>& arguments)
                     case 'q':
                         quiet_ = true;
                         break;
+                    case 'm':
+                        version2_ = true;
+                        break;
+                    case 'a':
+                        alignment_ = ToUInt(arguments[i].Substring(2));
+                        if (!alignment_ || !IsPowerOfTwo(alignment_))
+                            ErrorExit("Alignment must be a power of two");
+                        break;
+                    case 'd':
+                        compress_ = true;
+                        version2_ = true;
+                        dictionarySize_ = arguments[i].Length() > 2 ? ToUInt(arguments[i].Substring(2)) : MAX_COMPRESSION_DICTIONARY_SIZE;
+                        if (!dictionarySize_ || dictionarySize_ > MAX_COMPRESSION_DICTIONARY_SIZE)
+                            ErrorExit("Dictionary size must be between 1 and " + String(MAX_COMPRESSION_DICTIONARY_SIZE));
+                        break;
                     default:
                         ErrorExit("Unrecognized option");
                     }
@@ -158,7 +212,13 @@ void Run(const Vector<String>& arguments)
         for (unsigned i = 0; i < fileNames.Size(); ++i)
             ProcessFile(fileNames[i], dirName);
 
-        WritePackageFile(packageName, dirName);
+        if (dictionarySize_)
+            TrainDictionary(dirName);
+
+        if (version2_)
+            WritePackageFileVersion2(packageName, dirName);
+        else
+            WritePackageFile(packageName, dirName);
     }
     else
     {
@@ -172,6 +232,11 @@ void Run(const Vector<String>& arguments)
             PrintLine("Package size: " + String(packageFile->GetTotalSize()));
             PrintLine("Checksum: " + String(packageFile->GetChecksum()));
             PrintLine("Compressed: " + String(packageFile->IsCompressed() ? "yes" : "no"));
+            PrintLine("Version: " + String(packageFile->GetVersion()));
+            PrintLine("Dictionary size: " + String(packageFile->GetDictionary().Size()));
+            break;
+        case 'b':
+            OutputDecompressionSpeed(packageFile);
             break;
         case 'L':
             if (!packageFile->IsCompressed())
@@ -187,7 +252,8 @@ void Run(const Vector<String>& arguments)
                     String fileEntry(current->first_);
                     if (outputCompressionRatio)
                     {
-                        unsigned compressedSize =
+                        // Version 2 entries are aligned and store their size, version 1 entries are contiguous
+                        unsigned compressedSize = current->second_.packedSize_ ? current->second_.packedSize_ :
                             (i == entries.End() ? packageFile->GetTotalSize() - sizeof(unsigned) : i->second_.offset_) -
                             current->second_.offset_;
                         fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", current->second_.size_, compressedSize,
@@ -217,6 +283,8 @@ void ProcessFile(const String& fileName, const String& rootDir)
     newEntry.offset_ = 0; // Offset not yet known
     newEntry.size_ = file.GetSize();
     newEntry.checksum_ = 0; // Will be calculated later
+    newEntry.packedSize_ = newEntry.size_;
+    newEntry.compression_ = PACKAGE_COMPRESSION_NONE;
     entries_.Push(newEntry);
 }
 
@@ -334,8 +402,325 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     }
 }
 
+bool CompareEntryNameHashes(const FileEntry& lhs, const FileEntry& rhs)
+{
+    return StringHash(basePath_ + lhs.name_).Value() < StringHash(basePath_ + rhs.name_).Value();
+}
+
+void WritePackageFileVersion2(const String& fileName, const String& rootDir)
+{
+    if (!quiet_)
+        PrintLine("Writing version 2 package");
+
+    File dest(context_);
+    if (!dest.Open(fileName, FILE_WRITE))
+        ErrorExit("Could not open output file " + fileName);
+
+    // Sort the index by name hash
+    Sort(entries_.Begin(), entries_.End(), CompareEntryNameHashes);
+
+    // Write header and index (correct offsets are still unknown, will be filled in later)
+    WriteHeader(dest);
+    WriteIndexVersion2(dest);
+
+    unsigned totalDataSize = 0;
+    unsigned totalPackedSize = 0;
+    VectorBuffer packedData;
+    SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
+
+    for (unsigned i = 0; i < entries_.Size(); ++i)
+    {
+        FileEntry& entry = entries_[i];
+        String fileFullPath = rootDir + "/" + entry.name_;
+
+        File srcFile(context_, fileFullPath);
+        if (!srcFile.IsOpen())
+            ErrorExit("Could not open file " + fileFullPath);
+
+        unsigned dataSize = entry.size_;
+        totalDataSize += dataSize;
+        SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
+
+        if (srcFile.Read(&buffer[0], dataSize) != dataSize)
+            ErrorExit("Could not read file " + fileFullPath);
+        srcFile.Close();
+
+        for (unsigned j = 0; j < dataSize; ++j)
+        {
+            checksum_ = SDBMHash(checksum_, buffer[j]);
+            entry.checksum_ = SDBMHash(entry.checksum_, buffer[j]);
+        }
+
+        entry.compression_ = PACKAGE_COMPRESSION_NONE;
+        entry.packedSize_ = dataSize;
+
+        if (compress_)
+        {
+            // Block table with the offsets of the blocks from the entry start, then the independently compressed blocks
+            unsigned numBlocks = (dataSize + blockSize_ - 1) / blockSize_;
+            packedData.Clear();
+            packedData.Resize((numBlocks + 1) * sizeof(unsigned));
+            packedData.Seek(packedData.GetSize());
+            unsigned* blockOffsets = reinterpret_cast<unsigned*>(packedData.GetModifiableData());
+
+            for (unsigned j = 0; j < numBlocks; ++j)
+            {
+                unsigned pos = j * blockSize_;
+                unsigned unpackedSize = Min(dataSize - pos, blockSize_);
+
+                unsigned packedSize = CompressDataWithDictionary(compressBuffer.Get(), &buffer[pos], unpackedSize,
+                    dictionary_.Buffer(), dictionary_.Size());
+                if (!packedSize)
+                    ErrorExit("LZ4 compression failed for file " + entry.name_ + " at offset " + String(pos));
+
+                blockOffsets = reinterpret_cast<unsigned*>(packedData.GetModifiableData());
+                blockOffsets[j] = packedData.GetSize();
+
+                // Store the blocks that do not shrink as is, the reader tells them apart by their size
+                if (packedSize < unpackedSize)
+                    packedData.Write(compressBuffer.Get(), packedSize);
+                else
+                    packedData.Write(&buffer[pos], unpackedSize);
+            }
+
+            blockOffsets = reinterpret_cast<unsigned*>(packedData.GetModifiableData());
+            blockOffsets[numBlocks] = packedData.GetSize();
+
+            // Files that do not shrink, such as already compressed images or sounds, are stored uncompressed so that they can be mapped
+            if (packedData.GetSize() < dataSize)
+            {
+                entry.compression_ = dictionary_.Size() ? PACKAGE_COMPRESSION_LZ4_DICTIONARY : PACKAGE_COMPRESSION_LZ4_BLOCKS;
+                entry.packedSize_ = packedData.GetSize();
+            }
+        }
+
+        // Align the file data
+        while (dest.GetSize() & (alignment_ - 1))
+            dest.WriteUByte(0);
+        entry.offset_ = dest.GetSize();
+
+        if (entry.compression_ != PACKAGE_COMPRESSION_NONE)
+            dest.Write(packedData.GetData(), entry.packedSize_);
+        else
+            dest.Write(&buffer[0], dataSize);
+        totalPackedSize += entry.packedSize_;
+
+        if (!quiet_)
+        {
+            String fileEntry(entry.name_);
+            fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", dataSize, entry.packedSize_,
+                entry.packedSize_ ? 1.f * dataSize / entry.packedSize_ : 0.f);
+            PrintLine(fileEntry);
+        }
+    }
+
+    // Write package size to the end of file to allow finding it linked to an executable file
+    unsigned currentSize = dest.GetSize();
+    dest.WriteUInt(currentSize + sizeof(unsigned));
+
+    // Write header and index again with correct offsets & checksums
+    dest.Seek(0);
+    WriteHeader(dest);
+    WriteIndexVersion2(dest);
+
+    if (!quiet_)
+    {
+        PrintLine("Number of files: " + String(entries_.Size()));
+        PrintLine("File data size: " + String(totalDataSize));
+        PrintLine("Stored data size: " + String(totalPackedSize));
+        PrintLine("Package size: " + String(dest.GetSize()));
+        PrintLine("Checksum: " + String(checksum_));
+        PrintLine("Compressed: " + String(compress_ ? "yes" : "no"));
+        PrintLine("Dictionary size: " + String(dictionary_.Size()));
+    }
+}
+
+unsigned HashDictionaryKmer(const unsigned char* data)
+{
+    unsigned long long value;
+    memcpy(&value, data, sizeof value);
+    return (unsigned)((value * 0x9E3779B97F4A7C15ULL) >> (64 - DICTIONARY_HASH_BITS));
+}
+
+unsigned ScoreDictionarySegment(const PODVector<unsigned char>& sample, unsigned offset, const PODVector<unsigned>& frequencies)
+{
+    // Byte sequences found in several samples are the ones a dictionary helps compressing
+    unsigned score = 0;
+    for (unsigned i = offset; i + DICTIONARY_KMER_SIZE <= offset + DICTIONARY_SEGMENT_SIZE; ++i)
+    {
+        unsigned frequency = frequencies[HashDictionaryKmer(&sample[i])];
+        if (frequency > 1)
+            score += frequency - 1;
+    }
+    return score;
+}
+
+bool CompareDictionarySegments(const DictionarySegment& lhs, const DictionarySegment& rhs)
+{
+    return lhs.score_ > rhs.score_;
+}
+
+void TrainDictionary(const String& rootDir)
+{
+    if (!quiet_)
+        PrintLine("Training compression dictionary");
+
+    // Sample the start of the files
+    Vector<PODVector<unsigned char> > samples;
+    unsigned samplesSize = 0;
+    for (unsigned i = 0; i < entries_.Size() && samplesSize < DICTIONARY_MAX_SAMPLES_SIZE; ++i)
+    {
+        unsigned sampleSize = Min(Min(entries_[i].size_, DICTIONARY_SAMPLE_SIZE), DICTIONARY_MAX_SAMPLES_SIZE - samplesSize);
+        if (sampleSize < DICTIONARY_SEGMENT_SIZE)
+            continue;
+
+        File srcFile(context_, rootDir + "/" + entries_[i].name_);
+        PODVector<unsigned char> sample(sampleSize);
+        if (srcFile.Read(&sample[0], sampleSize) != sampleSize)
+            ErrorExit("Could not read file " + entries_[i].name_);
+
+        samples.Push(sample);
+        samplesSize += sampleSize;
+    }
+
+    // Count in how many samples each byte sequence appears
+    PODVector<unsigned> frequencies(1u << DICTIONARY_HASH_BITS);
+    PODVector<unsigned> lastSamples(1u << DICTIONARY_HASH_BITS);
+    for (unsigned i = 0; i < frequencies.Size(); ++i)
+    {
+        frequencies[i] = 0;
+        lastSamples[i] = M_MAX_UNSIGNED;
+    }
+
+    for (unsigned i = 0; i < samples.Size(); ++i)
+    {
+        const PODVector<unsigned char>& sample = samples[i];
+        for (unsigned j = 0; j + DICTIONARY_KMER_SIZE <= sample.Size(); ++j)
+        {
+            unsigned hash = HashDictionaryKmer(&sample[j]);
+            if (lastSamples[hash] != i)
+            {
+                lastSamples[hash] = i;
+                ++frequencies[hash];
+            }
+        }
+    }
+
+    PODVector<DictionarySegment> segments;
+    for (unsigned i = 0; i < samples.Size(); ++i)
+    {
+        for (unsigned j = 0; j + DICTIONARY_SEGMENT_SIZE <= samples[i].Size(); j += DICTIONARY_SEGMENT_SIZE)
+        {
+            DictionarySegment segment;
+            segment.sample_ = i;
+            segment.offset_ = j;
+            segment.score_ = ScoreDictionarySegment(samples[i], j, frequencies);
+            if (segment.score_)
+                segments.Push(segment);
+        }
+    }
+
+    Sort(segments.Begin(), segments.End(), CompareDictionarySegments);
+
+    // Pick the best segments, skipping those mostly made of byte sequences already picked
+    PODVector<unsigned> picked;
+    for (unsigned i = 0; i < segments.Size() && (picked.Size() + 1) * DICTIONARY_SEGMENT_SIZE <= dictionarySize_; ++i)
+    {
+        const DictionarySegment& segment = segments[i];
+        const PODVector<unsigned char>& sample = samples[segment.sample_];
+        if (ScoreDictionarySegment(sample, segment.offset_, frequencies) * 2 < segment.score_)
+            continue;
+
+        picked.Push(i);
+        for (unsigned j = segment.offset_; j + DICTIONARY_KMER_SIZE <= segment.offset_ + DICTIONARY_SEGMENT_SIZE; ++j)
+            frequencies[HashDictionaryKmer(&sample[j])] = 0;
+    }
+
+    // The best segments go last, nearest to the compressed data
+    dictionary_.Clear();
+    for (unsigned i = picked.Size() - 1; i < picked.Size(); --i)
+    {
+        const DictionarySegment& segment = segments[picked[i]];
+        const unsigned char* data = &samples[segment.sample_][segment.offset_];
+        dictionary_.Insert(dictionary_.End(), data, data + DICTIONARY_SEGMENT_SIZE);
+    }
+
+    if (!quiet_)
+        PrintLine("Dictionary size " + String(dictionary_.Size()) + " from " + String(samplesSize) + " sampled bytes");
+}
+
+void OutputDecompressionSpeed(PackageFile* packageFile)
+{
+    const HashMap<String, PackageEntry>& entries = packageFile->GetEntries();
+    PODVector<unsigned char> buffer;
+    unsigned long long storedSize = 0;
+    unsigned long long dataSize = 0;
+    long long usec = 0;
+
+    // The time subsystem initializes the high-resolution timer
+    SharedPtr<Time> time(new Time(context_));
+
+    // The first pass warms up the file cache
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        HiresTimer timer;
+        for (HashMap<String, PackageEntry>::ConstIterator i = entries.Begin(); i != entries.End(); ++i)
+        {
+            File file(context_, packageFile, i->first_);
+            buffer.Resize(file.GetSize());
+            if (buffer.Size() && file.Read(&buffer[0], buffer.Size()) != buffer.Size())
+                ErrorExit("Could not read file " + i->first_);
+
+            if (pass)
+            {
+                dataSize += i->second_.size_;
+                storedSize += i->second_.packedSize_ ? i->second_.packedSize_ : i->second_.size_;
+            }
+        }
+        usec = timer.GetUSec(false);
+    }
+
+    // Version 1 compressed packages do not store the compressed size of the files
+    if (packageFile->GetVersion() < PACKAGE_VERSION2 && packageFile->IsCompressed())
+        storedSize = packageFile->GetTotalSize();
+
+    PrintLine("File data size: " + String(dataSize));
+    PrintLine("Stored data size: " + String(storedSize));
+    PrintLine("Ratio: " + String(storedSize ? (double)dataSize / storedSize : 0.0));
+    PrintLine("Read time: " + String(usec / 1000.0) + " ms");
+    PrintLine("Read speed: " + String(usec ? (double)dataSize / usec : 0.0) + " MB/s");
+}
+
+void WriteIndexVersion2(File& dest)
+{
+    for (unsigned i = 0; i < entries_.Size(); ++i)
+    {
+        const FileEntry& entry = entries_[i];
+        String name = basePath_ + entry.name_;
+        dest.WriteUInt(StringHash(name).Value());
+        dest.WriteString(name);
+        dest.WriteUInt(entry.offset_);
+        dest.WriteUInt(entry.size_);
+        dest.WriteUInt(entry.packedSize_);
+        dest.WriteUInt(entry.checksum_);
+        dest.WriteUByte((unsigned char)entry.compression_);
+    }
+}
+
 void WriteHeader(File& dest)
 {
+    if (version2_)
+    {
+        dest.WriteFileID("UPK2");
+        dest.WriteUInt(entries_.Size());
+        dest.WriteUInt(checksum_);
+        dest.WriteUInt(blockSize_);
+        dest.WriteUInt(dictionary_.Size());
+        if (dictionary_.Size())
+            dest.Write(&dictionary_[0], dictionary_.Size());
+        return;
+    }
+
     if (!compress_)
         dest.WriteFileID("UPAK");
     else
@@ -0,0 +1,552 @@
+//
+// Copyright (c) 2008-2022 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/Image.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+// Vulkan formats written to the KTX2 file
+static const unsigned VK_FORMAT_R8_UNORM = 9;
+static const unsigned VK_FORMAT_R8G8_UNORM = 16;
+static const unsigned VK_FORMAT_R8G8B8_UNORM = 23;
+static const unsigned VK_FORMAT_R8G8B8A8_UNORM = 37;
+static const unsigned VK_FORMAT_R8G8B8A8_SRGB = 43;
+static const unsigned VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const unsigned VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+static const unsigned VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static const unsigned VK_FORMAT_BC3_SRGB_BLOCK = 138;
+
+// Data format descriptor values
+static const unsigned char KHR_DF_MODEL_RGBSDA = 1;
+static const unsigned char KHR_DF_MODEL_BC1A = 128;
+static const unsigned char KHR_DF_MODEL_BC3 = 130;
+static const unsigned char KHR_DF_PRIMARIES_BT709 = 1;
+static const unsigned char KHR_DF_TRANSFER_LINEAR = 1;
+static const unsigned char KHR_DF_TRANSFER_SRGB = 2;
+static const unsigned char KHR_DF_CHANNEL_COLOR = 0;
+static const unsigned char KHR_DF_CHANNEL_ALPHA = 15;
+static const unsigned char KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+
+static const unsigned char KTX2_IDENTIFIER[] = { 0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+static const unsigned KTX2_HEADER_SIZE = 80;
+static const unsigned KTX2_LEVEL_INDEX_SIZE = 24;
+
+enum BakeFormat
+{
+    BAKE_UNCOMPRESSED = 0,
+    BAKE_DXT1,
+    BAKE_DXT5
+};
+
+struct BakedLevel
+{
+    int width_;
+    int height_;
+    PODVector<unsigned char> data_;
+};
+
+SharedPtr<Context> context_(new Context());
+BakeFormat format_ = BAKE_UNCOMPRESSED;
+bool mipmaps_ = true;
+bool sRGB_ = false;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void CompressLevel(const Image* image, BakedLevel& level);
+void CompressBlockDXT1(const unsigned char* rgba, unsigned char* dest);
+void CompressBlockDXT5Alpha(const unsigned char* rgba, unsigned char* dest);
+void WriteKTX2(const String& fileName, const Vector<BakedLevel>& levels, unsigned components);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+        ErrorExit(
+            "Usage: TextureBaker <input file> <output file> [options]\n"
+            "\n"
+            "Bakes an image to a texture file with precalculated mip levels, so that loading it skips\n"
+            "image decoding and mip level generation. The output is KTX2, or DDS when the output file\n"
+            "extension is .dds (uncompressed RGBA only).\n"
+            "\n"
+            "Options:\n"
+            "-cdxt1  Block compress to DXT1 (BC1), alpha is discarded\n"
+            "-cdxt5  Block compress to DXT5 (BC3)\n"
+            "-n      Do not precalculate the mip levels\n"
+            "-s      Mark the texture data as sRGB\n"
+        );
+
+    const String& inputName = arguments[0];
+    const String& outputName = arguments[1];
+
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() < 2 || arguments[i][0] != '-')
+            ErrorExit("Unrecognized option " + arguments[i]);
+
+        switch (arguments[i][1])
+        {
+        case 'c':
+            {
+                String format = arguments[i].Substring(2).ToLower();
+                if (format == "dxt1")
+                    format_ = BAKE_DXT1;
+                else if (format == "dxt5")
+                    format_ = BAKE_DXT5;
+                else
+                    ErrorExit("Unsupported compressed format " + format);
+            }
+            break;
+        case 'n':
+            mipmaps_ = false;
+            break;
+        case 's':
+            sRGB_ = true;
+            break;
+        default:
+            ErrorExit("Unrecognized option " + arguments[i]);
+        }
+    }
+
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new Log(context_));
+
+    // Large mip levels are calculated on the worker threads
+    WorkQueue* queue = new WorkQueue(context_);
+    context_->RegisterSubsystem(queue);
+    unsigned numThreads = GetNumLogicalCPUs();
+    if (numThreads > 1)
+        queue->CreateThreads(numThreads - 1);
+
+    File inputFile(context_, inputName);
+    if (!inputFile.IsOpen())
+        ErrorExit("Could not open input file " + inputName);
+
+    SharedPtr<Image> image(new Image(context_));
+    if (!image->Load(inputFile))
+        ErrorExit("Could not load input image " + inputName);
+    if (image->IsCompressed())
+        ErrorExit("Input image is already compressed");
+    if (image->GetDepth() > 1)
+        ErrorExit("3D images are not supported");
+
+    bool dds = GetExtension(outputName) == ".dds";
+    if (dds && format_ != BAKE_UNCOMPRESSED)
+        ErrorExit("Compressed formats are only supported in KTX2 output");
+
+    // Block compression and DDS work on RGBA
+    if ((dds || format_ != BAKE_UNCOMPRESSED) && image->GetComponents() != 4)
+        image = image->ConvertToRGBA();
+    if (!image)
+        ErrorExit("Could not convert the input image to RGBA");
+
+    if (mipmaps_)
+        image->PrecalculateLevels();
+    else
+        image->CleanupLevels();
+
+    PODVector<const Image*> images;
+    image->GetLevels(images);
+
+    if (dds)
+    {
+        if (!image->SaveDDS(outputName))
+            ErrorExit("Could not write output file " + outputName);
+    }
+    else
+    {
+        Vector<BakedLevel> levels(images.Size());
+        for (unsigned i = 0; i < images.Size(); ++i)
+        {
+            BakedLevel& level = levels[i];
+            level.width_ = images[i]->GetWidth();
+            level.height_ = images[i]->GetHeight();
+
+            if (format_ == BAKE_UNCOMPRESSED)
+            {
+                unsigned size = (unsigned)(level.width_ * level.height_) * images[i]->GetComponents();
+                level.data_.Resize(size);
+                memcpy(&level.data_[0], images[i]->GetData(), size);
+            }
+            else
+                CompressLevel(images[i], level);
+        }
+
+        WriteKTX2(outputName, levels, image->GetComponents());
+    }
+
+    PrintLine("Baked " + String(image->GetWidth()) + "x" + String(image->GetHeight()) + " texture with " + String(images.Size()) +
+        " level(s) to " + outputName);
+}
+
+void CompressLevel(const Image* image, BakedLevel& level)
+{
+    int blocksX = Max((level.width_ + 3) / 4, 1);
+    int blocksY = Max((level.height_ + 3) / 4, 1);
+    unsigned blockSize = format_ == BAKE_DXT1 ? 8 : 16;
+    level.data_.Resize(blocksX * blocksY * blockSize);
+
+    const unsigned char* pixels = image->GetData();
+    unsigned char* dest = &level.data_[0];
+    unsigned char block[64];
+
+    for (int by = 0; by < blocksY; ++by)
+    {
+        for (int bx = 0; bx < blocksX; ++bx)
+        {
+            // Gather the block, repeating the edge pixels of levels smaller than the block
+            for (int y = 0; y < 4; ++y)
+            {
+                int py = Min(by * 4 + y, level.height_ - 1);
+                for (int x = 0; x < 4; ++x)
+                {
+                    int px = Min(bx * 4 + x, level.width_ - 1);
+                    memcpy(&block[(y * 4 + x) * 4], &pixels[(py * level.width_ + px) * 4], 4);
+                }
+            }
+
+            if (format_ == BAKE_DXT5)
+            {
+                CompressBlockDXT5Alpha(block, dest);
+                dest += 8;
+            }
+            CompressBlockDXT1(block, dest);
+            dest += 8;
+        }
+    }
+}
+
+unsigned short PackColor565(int r, int g, int b)
+{
+    return (unsigned short)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+void UnpackColor565(unsigned short color, int* rgb)
+{
+    int r = (color >> 11) & 0x1f;
+    int g = (color >> 5) & 0x3f;
+    int b = color & 0x1f;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+void CompressBlockDXT1(const unsigned char* rgba, unsigned char* dest)
+{
+    // Use the inset bounding box diagonal of the block colors as the endpoints
+    int minColor[3] = { 255, 255, 255 };
+    int maxColor[3] = { 0, 0, 0 };
+    int mean[3] = { 0, 0, 0 };
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            minColor[j] = Min(minColor[j], (int)rgba[i * 4 + j]);
+            maxColor[j] = Max(maxColor[j], (int)rgba[i * 4 + j]);
+            mean[j] += rgba[i * 4 + j];
+        }
+    }
+
+    // Select the diagonal which follows the color distribution: flip green and blue when they decrease as red increases
+    int covariance[3] = { 0, 0, 0 };
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        int red = rgba[i * 4] * 16 - mean[0];
+        for (unsigned j = 1; j < 3; ++j)
+            covariance[j] += red * (rgba[i * 4 + j] * 16 - mean[j]) / 16;
+    }
+    for (unsigned j = 1; j < 3; ++j)
+    {
+        if (covariance[j] < 0)
+            Swap(minColor[j], maxColor[j]);
+    }
+
+    for (unsigned j = 0; j < 3; ++j)
+    {
+        int inset = (maxColor[j] - minColor[j]) >> 4;
+        minColor[j] += inset;
+        maxColor[j] -= inset;
+    }
+
+    unsigned short color0 = PackColor565(maxColor[0], maxColor[1], maxColor[2]);
+    unsigned short color1 = PackColor565(minColor[0], minColor[1], minColor[2]);
+    unsigned indices = 0;
+
+    // Equal endpoints would select the 3-color mode, leave all the indices at the first endpoint
+    if (color0 != color1)
+    {
+        if (color0 < color1)
+            Swap(color0, color1);
+
+        int palette[4][3];
+        UnpackColor565(color0, palette[0]);
+        UnpackColor565(color1, palette[1]);
+        for (unsigned j = 0; j < 3; ++j)
+        {
+            palette[2][j] = (2 * palette[0][j] + palette[1][j]) / 3;
+            palette[3][j] = (palette[0][j] + 2 * palette[1][j]) / 3;
+        }
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            unsigned best = 0;
+            int bestDistance = M_MAX_INT;
+            for (unsigned k = 0; k < 4; ++k)
+            {
+                int dr = rgba[i * 4] - palette[k][0];
+                int dg = rgba[i * 4 + 1] - palette[k][1];
+                int db = rgba[i * 4 + 2] - palette[k][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    best = k;
+                    bestDistance = distance;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    dest[0] = (unsigned char)(color0 & 0xff);
+    dest[1] = (unsigned char)(color0 >> 8);
+    dest[2] = (unsigned char)(color1 & 0xff);
+    dest[3] = (unsigned char)(color1 >> 8);
+    dest[4] = (unsigned char)(indices & 0xff);
+    dest[5] = (unsigned char)((indices >> 8) & 0xff);
+    dest[6] = (unsigned char)((indices >> 16) & 0xff);
+    dest[7] = (unsigned char)(indices >> 24);
+}
+
+void CompressBlockDXT5Alpha(const unsigned char* rgba, unsigned char* dest)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        minAlpha = Min(minAlpha, (int)rgba[i * 4 + 3]);
+        maxAlpha = Max(maxAlpha, (int)rgba[i * 4 + 3]);
+    }
+
+    unsigned long long indices = 0;
+
+    // Use the 8 alpha value mode, which requires the first endpoint to be larger
+    if (maxAlpha > minAlpha)
+    {
+        int palette[8];
+        palette[0] = maxAlpha;
+        palette[1] = minAlpha;
+        for (int k = 1; k < 7; ++k)
+            palette[k + 1] = ((7 - k) * maxAlpha + k * minAlpha) / 7;
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            unsigned best = 0;
+            int bestDistance = M_MAX_INT;
+            for (unsigned k = 0; k < 8; ++k)
+            {
+                int distance = Abs(rgba[i * 4 + 3] - palette[k]);
+                if (distance < bestDistance)
+                {
+                    best = k;
+                    bestDistance = distance;
+                }
+            }
+            indices |= (unsigned long long)best << (i * 3);
+        }
+    }
+
+    dest[0] = (unsigned char)maxAlpha;
+    dest[1] = (unsigned char)minAlpha;
+    for (unsigned i = 0; i < 6; ++i)
+        dest[i + 2] = (unsigned char)((indices >> (i * 8)) & 0xff);
+}
+
+void WriteDFDSample(File& dest, unsigned short bitOffset, unsigned char bitLength, unsigned char channelType, unsigned upper)
+{
+    dest.WriteUShort(bitOffset);
+    dest.WriteUByte((unsigned char)(bitLength - 1));
+    dest.WriteUByte(channelType);
+    dest.WriteUInt(0);  // Sample position
+    dest.WriteUInt(0);  // Sample lower
+    dest.WriteUInt(upper);
+}
+
+void WriteKTX2(const String& fileName, const Vector<BakedLevel>& levels, unsigned components)
+{
+    bool sRGB = sRGB_;
+    if (sRGB && format_ == BAKE_UNCOMPRESSED && components != 4)
+    {
+        PrintLine("sRGB is only supported for RGBA, writing linear data");
+        sRGB = false;
+    }
+
+    unsigned vkFormat;
+    unsigned char colorModel;
+    unsigned char blockDimension;
+    unsigned char bytesPlane;
+    unsigned numSamples;
+    unsigned alignment;
+
+    switch (format_)
+    {
+    case BAKE_DXT1:
+        vkFormat = sRGB ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        colorModel = KHR_DF_MODEL_BC1A;
+        blockDimension = 3;
+        bytesPlane = 8;
+        numSamples = 1;
+        alignment = 8;
+        break;
+
+    case BAKE_DXT5:
+        vkFormat = sRGB ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        colorModel = KHR_DF_MODEL_BC3;
+        blockDimension = 3;
+        bytesPlane = 16;
+        numSamples = 2;
+        alignment = 16;
+        break;
+
+    default:
+        {
+            static const unsigned uncompressedFormats[] = { VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM,
+                VK_FORMAT_R8G8B8A8_UNORM };
+            vkFormat = sRGB ? VK_FORMAT_R8G8B8A8_SRGB : uncompressedFormats[components - 1];
+            colorModel = KHR_DF_MODEL_RGBSDA;
+            blockDimension = 0;
+            bytesPlane = (unsigned char)components;
+            numSamples = components;
+            // Least common multiple of the texel size and 4
+            alignment = components == 3 ? 12 : 4;
+        }
+        break;
+    }
+
+    unsigned dfdOffset = KTX2_HEADER_SIZE + levels.Size() * KTX2_LEVEL_INDEX_SIZE;
+    unsigned dfdSize = 4 + 24 + numSamples * 16;
+
+    // The levels are stored from the smallest to the largest
+    PODVector<unsigned> levelOffsets(levels.Size());
+    unsigned offset = dfdOffset + dfdSize;
+    for (unsigned i = levels.Size() - 1; i < levels.Size(); --i)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelOffsets[i] = offset;
+        offset += levels[i].data_.Size();
+    }
+
+    File dest(context_, fileName, FILE_WRITE);
+    if (!dest.IsOpen())
+        ErrorExit("Could not open output file " + fileName);
+
+    dest.Write(KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+    dest.WriteUInt(vkFormat);
+    dest.WriteUInt(1);                      // Type size
+    dest.WriteUInt(levels[0].width_);
+    dest.WriteUInt(levels[0].height_);
+    dest.WriteUInt(0);                      // Depth
+    dest.WriteUInt(0);                      // Layers
+    dest.WriteUInt(1);                      // Faces
+    dest.WriteUInt(levels.Size());
+    dest.WriteUInt(0);                      // Supercompression
+    dest.WriteUInt(dfdOffset);
+    dest.WriteUInt(dfdSize);
+    dest.WriteUInt(0);                      // Key/value data offset
+    dest.WriteUInt(0);                      // Key/value data size
+    dest.WriteUInt64(0);                    // Supercompression data offset
+    dest.WriteUInt64(0);                    // Supercompression data size
+
+    for (unsigned i = 0; i < levels.Size(); ++i)
+    {
+        dest.WriteUInt64(levelOffsets[i]);
+        dest.WriteUInt64(levels[i].data_.Size());
+        dest.WriteUInt64(levels[i].data_.Size());
+    }
+
+    // Basic data format descriptor
+    dest.WriteUInt(dfdSize);
+    dest.WriteUInt(0);                      // Vendor and descriptor type
+    dest.WriteUShort(2);                    // Version
+    dest.WriteUShort((unsigned short)(dfdSize - 4));
+    dest.WriteUByte(colorModel);
+    dest.WriteUByte(KHR_DF_PRIMARIES_BT709);
+    dest.WriteUByte(sRGB ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR);
+    dest.WriteUByte(0);                     // Flags
+    for (unsigned i = 0; i < 4; ++i)
+        dest.WriteUByte(i < 2 ? blockDimension : 0);
+    dest.WriteUByte(bytesPlane);
+    for (unsigned i = 1; i < 8; ++i)
+        dest.WriteUByte(0);
+
+    switch (format_)
+    {
+    case BAKE_DXT1:
+        WriteDFDSample(dest, 0, 64, KHR_DF_CHANNEL_COLOR, M_MAX_UNSIGNED);
+        break;
+
+    case BAKE_DXT5:
+        WriteDFDSample(dest, 0, 64, KHR_DF_CHANNEL_ALPHA, M_MAX_UNSIGNED);
+        WriteDFDSample(dest, 64, 64, KHR_DF_CHANNEL_COLOR, M_MAX_UNSIGNED);
+        break;
+
+    default:
+        for (unsigned i = 0; i < components; ++i)
+        {
+            // Red, green and blue channels, or alpha which is never sRGB encoded
+            unsigned char channel = i < 3 ? (unsigned char)i : (unsigned char)(KHR_DF_CHANNEL_ALPHA | (sRGB ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0));
+            WriteDFDSample(dest, (unsigned short)(i * 8), 8, channel, 255);
+        }
+        break;
+    }
+
+    for (unsigned i = levels.Size() - 1; i < levels.Size(); --i)
+    {
+        while (dest.GetPosition() < levelOffsets[i])
+            dest.WriteUByte(0);
+        dest.Write(&levels[i].data_[0], levels[i].data_.Size());
+    }
+}
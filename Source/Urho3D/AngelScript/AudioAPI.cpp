@@ -101,6 +101,14 @@ void RegisterAudio(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Audio", "bool get_interpolation() const", asMETHOD(Audio, GetInterpolation), asCALL_THISCALL);
     engine->RegisterObjectMethod("Audio", "bool get_playing() const", asMETHOD(Audio, IsPlaying), asCALL_THISCALL);
     engine->RegisterObjectMethod("Audio", "bool get_initialized() const", asMETHOD(Audio, IsInitialized), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "void set_mixThread(bool)", asMETHOD(Audio, SetMixThread), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "bool get_mixThread() const", asMETHOD(Audio, GetMixThread), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_numUnderruns() const", asMETHOD(Audio, GetNumUnderruns), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "void set_maxVoices(uint)", asMETHOD(Audio, SetMaxVoices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_maxVoices() const", asMETHOD(Audio, GetMaxVoices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "void set_virtualGainThreshold(float)", asMETHOD(Audio, SetVirtualGainThreshold), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "float get_virtualGainThreshold() const", asMETHOD(Audio, GetVirtualGainThreshold), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_numVirtualVoices() const", asMETHOD(Audio, GetNumVirtualVoices), asCALL_THISCALL);
     engine->RegisterGlobalFunction("Audio@+ get_audio()", asFUNCTION(GetAudio), asCALL_CDECL);
 }
 
@@ -106,6 +106,10 @@ template<class T> static void RegisterNavMeshBase(asIScriptEngine* engine, const
 {
     engine->RegisterObjectMethod(name, "bool Build()", asMETHODPR(T, Build, (), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "bool Build(const BoundingBox&in)", asMETHODPR(T, Build, (const BoundingBox&), bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool BuildAsync(const BoundingBox&in)", asMETHOD(T, BuildAsync), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void CompleteAsyncBuild()", asMETHOD(T, CompleteAsyncBuild), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void CompletePathQueries()", asMETHOD(T, CompletePathQueries), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void ClearPathCache()", asMETHOD(T, ClearPathCache), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "void SetAreaCost(uint, float)", asMETHOD(T, SetAreaCost), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "float GetAreaCost(uint) const", asMETHOD(T, GetAreaCost), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "Vector3 FindNearestPoint(const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshFindNearestPoint), asCALL_CDECL_OBJLAST);
@@ -144,6 +148,11 @@ template<class T> static void RegisterNavMeshBase(asIScriptEngine* engine, const
     engine->RegisterObjectMethod(name, "void set_padding(const Vector3&in)", asMETHOD(T, SetPadding), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "const Vector3& get_padding() const", asMETHOD(T, GetPadding), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "bool get_initialized() const", asMETHOD(T, IsInitialized), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool get_buildingAsync() const", asMETHOD(T, IsBuildingAsync), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_pathCacheSize(uint)", asMETHOD(T, SetPathCacheSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_pathCacheSize() const", asMETHOD(T, GetPathCacheSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_hierarchicalPathDistance(int)", asMETHOD(T, SetHierarchicalPathDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "int get_hierarchicalPathDistance() const", asMETHOD(T, GetHierarchicalPathDistance), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "const BoundingBox& get_boundingBox() const", asMETHOD(T, GetBoundingBox), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "BoundingBox get_worldBoundingBox() const", asMETHOD(T, GetWorldBoundingBox), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "IntVector2 get_numTiles() const", asMETHOD(T, GetNumTiles), asCALL_THISCALL);
@@ -259,6 +268,12 @@ void RegisterCrowdManager(asIScriptEngine* engine)
     engine->RegisterObjectMethod("CrowdManager", "uint get_numQueryFilterTypes() const", asMETHOD(CrowdManager, GetNumQueryFilterTypes), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint get_numAreas(uint) const", asMETHOD(CrowdManager, GetNumAreas), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint get_numObstacleAvoidanceTypes() const", asMETHOD(CrowdManager, GetNumObstacleAvoidanceTypes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_multiThreaded(bool)", asMETHOD(CrowdManager, SetMultiThreaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "bool get_multiThreaded() const", asMETHOD(CrowdManager, IsMultiThreaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_pathIterations(int)", asMETHOD(CrowdManager, SetPathIterations), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "int get_pathIterations() const", asMETHOD(CrowdManager, GetPathIterations), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_pathIterationsPerAgent(float)", asMETHOD(CrowdManager, SetPathIterationsPerAgent), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "float get_pathIterationsPerAgent() const", asMETHOD(CrowdManager, GetPathIterationsPerAgent), asCALL_THISCALL);
 }
 
 void RegisterCrowdAgent(asIScriptEngine* engine)
@@ -395,6 +395,16 @@ static void RegisterPhysicsWorld2D(asIScriptEngine* engine)
     engine->RegisterObjectMethod("PhysicsWorld2D", "uint get_velocityIterations() const", asMETHOD(PhysicsWorld2D, GetVelocityIterations), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld2D", "void set_positionIterations(uint)", asMETHOD(PhysicsWorld2D, SetPositionIterations), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld2D", "uint get_positionIterations() const", asMETHOD(PhysicsWorld2D, GetPositionIterations), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "void set_multiThreaded(bool)", asMETHOD(PhysicsWorld2D, SetMultiThreaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "bool get_multiThreaded() const", asMETHOD(PhysicsWorld2D, IsMultiThreaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "void set_fps(int)", asMETHOD(PhysicsWorld2D, SetFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "int get_fps() const", asMETHOD(PhysicsWorld2D, GetFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "void set_maxSubSteps(int)", asMETHOD(PhysicsWorld2D, SetMaxSubSteps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "int get_maxSubSteps() const", asMETHOD(PhysicsWorld2D, GetMaxSubSteps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "void set_interpolation(bool)", asMETHOD(PhysicsWorld2D, SetInterpolation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "bool get_interpolation() const", asMETHOD(PhysicsWorld2D, GetInterpolation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "void set_asyncStep(bool)", asMETHOD(PhysicsWorld2D, SetAsyncStep), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld2D", "bool get_asyncStep() const", asMETHOD(PhysicsWorld2D, IsAsyncStep), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld2D", "void DrawDebugGeometry() const", asMETHODPR(PhysicsWorld2D, DrawDebugGeometry, (), void), asCALL_THISCALL);
 
     engine->RegisterObjectMethod("Scene", "PhysicsWorld2D@+ get_physicsWorld2D() const", asFUNCTION(SceneGetPhysicsWorld2D), asCALL_CDECL_OBJLAST);
@@ -30,10 +30,16 @@
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
 
 #include <SDL/SDL.h>
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 #ifdef _MSC_VER
@@ -49,13 +55,158 @@ static const int MIN_BUFFERLENGTH = 20;
 static const int MIN_MIXRATE = 11025;
 static const int MAX_MIXRATE = 48000;
 static const StringHash SOUND_MASTER_HASH("Master");
+static const float DEFAULT_VIRTUAL_GAIN_THRESHOLD = 0.001f;
 
 static void SDLAudioCallback(void* userdata, Uint8* stream, int len);
 
+/// Clip the mixed samples and convert them to signed 16-bit output.
+static void ClipToShort(const int* src, short* dest, unsigned count)
+{
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    // The signed saturating pack clamps to the 16-bit range
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packs_epi32(low, high));
+    }
+#endif
+
+    for (; i < count; ++i)
+        dest[i] = (short)Clamp(src[i], -32768, 32767);
+}
+
+/// Clip the mixed samples and convert them to float output.
+static void ClipToFloat(const int* src, float* dest, unsigned count)
+{
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+        // Clamp with the saturating pack, then sign extend back to 32 bits
+        __m128i packed = _mm_packs_epi32(low, high);
+        low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#endif
+
+    for (; i < count; ++i)
+        dest[i] = (float)Clamp(src[i], -32768, 32767) / 32768.0f;
+}
+
+/// Compare sound sources for voice ranking, higher priority first, then louder first.
+static bool CompareVoices(SoundSource* lhs, SoundSource* rhs)
+{
+    if (lhs->GetPriority() != rhs->GetPriority())
+        return lhs->GetPriority() > rhs->GetPriority();
+    return lhs->GetEffectiveGain() > rhs->GetEffectiveGain();
+}
+
+/// %Audio mixer thread. Mixes the sound sources ahead into a ring buffer, which the audio device callback reads without locking.
+class AudioMixThread : public Thread
+{
+public:
+    /// Construct with the ring buffer and fragment sizes in samples, both powers of two, and the byte size of one sample.
+    AudioMixThread(Audio* audio, unsigned bufferSize, unsigned fragmentSize, unsigned sampleSize) :
+        audio_(audio),
+        buffer_(new unsigned char[bufferSize * sampleSize]),
+        bufferSize_(bufferSize),
+        fragmentSize_(fragmentSize),
+        sampleSize_(sampleSize),
+        numUnderruns_(0)
+    {
+        SDL_AtomicSet(&readPosition_, 0);
+        SDL_AtomicSet(&writePosition_, 0);
+    }
+
+    /// Destruct. Stop the thread.
+    virtual ~AudioMixThread()
+    {
+        Stop();
+    }
+
+    /// Mix fragments while there is space for them in the ring buffer.
+    virtual void ThreadFunction()
+    {
+        while (shouldRun_)
+        {
+            unsigned write = (unsigned)SDL_AtomicGet(&writePosition_);
+            unsigned read = (unsigned)SDL_AtomicGet(&readPosition_);
+            if (bufferSize_ - (write - read) < fragmentSize_)
+            {
+                Time::Sleep(1);
+                continue;
+            }
+
+            // The fragments never wrap around the end of the ring buffer
+            {
+                MutexLock lock(audio_->GetMutex());
+                audio_->MixOutput(buffer_.Get() + (write & (bufferSize_ - 1)) * sampleSize_, fragmentSize_);
+            }
+
+            SDL_AtomicSet(&writePosition_, (int)(write + fragmentSize_));
+        }
+    }
+
+    /// Copy mixed output to the buffer, or silence if not enough has been mixed. Called from the audio device callback.
+    void Read(unsigned char* dest, unsigned samples)
+    {
+        unsigned read = (unsigned)SDL_AtomicGet(&readPosition_);
+        unsigned count = Min(samples, (unsigned)SDL_AtomicGet(&writePosition_) - read);
+
+        // Copy in two parts when wrapping around the end of the ring buffer
+        unsigned offset = read & (bufferSize_ - 1);
+        unsigned first = Min(count, bufferSize_ - offset);
+        memcpy(dest, buffer_.Get() + offset * sampleSize_, first * sampleSize_);
+        memcpy(dest + first * sampleSize_, buffer_.Get(), (count - first) * sampleSize_);
+        SDL_AtomicSet(&readPosition_, (int)(read + count));
+
+        if (count < samples)
+        {
+            memset(dest + count * sampleSize_, 0, (samples - count) * sampleSize_);
+            ++numUnderruns_;
+        }
+    }
+
+    /// Return number of underruns.
+    unsigned GetNumUnderruns() const { return numUnderruns_; }
+
+private:
+    /// Audio subsystem.
+    Audio* audio_;
+    /// Ring buffer.
+    SharedArrayPtr<unsigned char> buffer_;
+    /// Ring buffer size in samples.
+    unsigned bufferSize_;
+    /// Mixed fragment size in samples.
+    unsigned fragmentSize_;
+    /// Byte size of one sample.
+    unsigned sampleSize_;
+    /// Total samples read by the audio device callback.
+    SDL_atomic_t readPosition_;
+    /// Total samples mixed.
+    SDL_atomic_t writePosition_;
+    /// Number of underruns. Only modified by the audio device callback.
+    volatile unsigned numUnderruns_;
+};
+
 Audio::Audio(Context* context) :
     Object(context),
     deviceID_(0),
     sampleSize_(0),
+    mixAheadSize_(0),
+    mixThreadEnabled_(false),
+    maxVoices_(0),
+    virtualGainThreshold_(DEFAULT_VIRTUAL_GAIN_THRESHOLD),
+    numVirtualVoices_(0),
     playing_(false)
 {
     // Set the master to the default value
@@ -114,6 +265,8 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     mixRate_ = obtained.freq;
     interpolation_ = interpolation;
     clipBuffer_ = new int[stereo ? fragmentSize_ << 1 : fragmentSize_];
+    // Mix ahead up to one output buffer beyond the one being played
+    mixAheadSize_ = NextPowerOfTwo((unsigned)obtained.samples * 2);
 
     URHO3D_LOGINFOF("Audio Format bitsize=%u isfloat=%s issigned=%s islittleendian=%s",
                     SDL_AUDIO_BITSIZE(format_), SDL_AUDIO_ISFLOAT(format_) > 0 ? "true":"false", SDL_AUDIO_ISSIGNED(format_) > 0 ? "true":"false",
@@ -121,6 +274,9 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     URHO3D_LOGINFO("Set audio mode " + String(mixRate_) + " Hz " + (stereo_ ? "stereo" : "mono") + " " +
             (interpolation_ ? "interpolated" : ""));
 
+    if (mixThreadEnabled_)
+        StartMixThread();
+
     return Play();
 }
 
@@ -186,6 +342,31 @@ void Audio::ResumeAll()
     UpdateInternal(0.0f);
 }
 
+void Audio::SetMixThread(bool enable)
+{
+    if (enable == mixThreadEnabled_)
+        return;
+
+    mixThreadEnabled_ = enable;
+    if (!deviceID_)
+        return;
+
+    if (enable)
+        StartMixThread();
+    else
+        StopMixThread();
+}
+
+void Audio::SetMaxVoices(unsigned num)
+{
+    maxVoices_ = num;
+}
+
+void Audio::SetVirtualGainThreshold(float gain)
+{
+    virtualGainThreshold_ = Max(gain, 0.0f);
+}
+
 void Audio::SetListener(SoundListener* listener)
 {
     listener_ = listener;
@@ -220,6 +401,11 @@ SoundListener* Audio::GetListener() const
     return listener_;
 }
 
+unsigned Audio::GetNumUnderruns() const
+{
+    return mixThread_ ? mixThread_->GetNumUnderruns() : 0;
+}
+
 void Audio::AddSoundSource(SoundSource* channel)
 {
     MutexLock lock(audioMutex_);
@@ -254,9 +440,17 @@ float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
 void SDLAudioCallback(void* userdata, Uint8* stream, int len)
 {
     Audio* audio = static_cast<Audio*>(userdata);
+    audio->ReadOutput(stream, len / audio->GetSampleSize() / Audio::SAMPLE_SIZE_MUL);
+}
+
+void Audio::ReadOutput(void* dest, unsigned samples)
+{
+    if (mixThread_)
+        mixThread_->Read(static_cast<unsigned char*>(dest), samples);
+    else
     {
-        MutexLock Lock(audio->GetMutex());
-        audio->MixOutput(stream, len / audio->GetSampleSize() / Audio::SAMPLE_SIZE_MUL);
+        MutexLock lock(audioMutex_);
+        MixOutput(dest, samples);
     }
 }
 
@@ -268,9 +462,6 @@ void Audio::MixOutput(void* dest, unsigned samples)
         return;
     }
 
-    if (SDL_AUDIO_BITSIZE(format_) == 16)
-    // 16bits : assume int signed
-    {
     while (samples)
     {
         // If sample count exceeds the fragment (clip buffer) size, split the work
@@ -297,52 +488,17 @@ void Audio::MixOutput(void* dest, unsigned samples)
 
             source->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
         }
-            short* destPtr = (short*)dest;
-            while (clipSamples--)
-                *destPtr++ = (short)Clamp(*clipPtr++, -32768, 32767);
-
-            samples -= workSamples;
-            ((unsigned char*&)dest) += sampleSize_ * SAMPLE_SIZE_MUL * workSamples;
-        }
-    }
-    // 32bits : assume float signed
-    else
-    {
-        while (samples)
-        {
-            // If sample count exceeds the fragment (clip buffer) size, split the work
-            unsigned workSamples = Min(samples, fragmentSize_);
-            unsigned clipSamples = workSamples;
-            if (stereo_)
-                clipSamples <<= 1;
-
-            // Clear clip buffer
-            int* clipPtr = clipBuffer_.Get();
-            memset(clipPtr, 0, clipSamples * sizeof(int));
-
-            // Mix samples to clip buffer
-            for (PODVector<SoundSource*>::Iterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
-            {
-                SoundSource* source = *i;
-
-                // Check for pause if necessary
-                if (!pausedSoundTypes_.Empty())
-                {
-                    if (pausedSoundTypes_.Contains(source->GetSoundType()))
-                        continue;
-                }
 
-                source->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
-            }
         // Copy output from clip buffer to destination
-        float* destPtr = (float*)dest;
-        while (clipSamples--)
-            *destPtr++ = (float)Clamp(*clipPtr++, -32768, 32767) / 32768.0f;
+        // 16bits : assume int signed, 32bits : assume float signed
+        if (SDL_AUDIO_BITSIZE(format_) == 16)
+            ClipToShort(clipPtr, (short*)dest, clipSamples);
+        else
+            ClipToFloat(clipPtr, (float*)dest, clipSamples);
 
         samples -= workSamples;
         ((unsigned char*&)dest) += sampleSize_ * SAMPLE_SIZE_MUL * workSamples;
     }
-    }
     // TODO : 32bits & 16bits unsigned
 }
 
@@ -359,6 +515,7 @@ void Audio::Release()
 
     if (deviceID_)
     {
+        StopMixThread();
         SDL_CloseAudioDevice(deviceID_);
         deviceID_ = 0;
         clipBuffer_.Reset();
@@ -383,6 +540,79 @@ void Audio::UpdateInternal(float timeStep)
 
         source->Update(timeStep);
     }
+
+    UpdateVoices();
+}
+
+void Audio::UpdateVoices()
+{
+    URHO3D_PROFILE(UpdateVoices);
+
+    // Collect the audible sound sources, the others are virtual regardless of the voice limit
+    voices_.Clear();
+    numVirtualVoices_ = 0;
+    for (PODVector<SoundSource*>::Iterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+    {
+        SoundSource* source = *i;
+        if (!source->IsPlaying() || !source->IsEnabledEffective())
+        {
+            source->SetVirtual(false);
+            continue;
+        }
+
+        if (source->GetEffectiveGain() < virtualGainThreshold_)
+        {
+            source->SetVirtual(true);
+            ++numVirtualVoices_;
+        }
+        // Sources of a paused type are not mixed and do not take a voice
+        else if (pausedSoundTypes_.Empty() || !pausedSoundTypes_.Contains(source->GetSoundType()))
+            voices_.Push(source);
+        else
+            source->SetVirtual(false);
+    }
+
+    if (maxVoices_ && voices_.Size() > maxVoices_)
+        Sort(voices_.Begin(), voices_.End(), CompareVoices);
+
+    for (unsigned i = 0; i < voices_.Size(); ++i)
+    {
+        bool isVirtual = maxVoices_ && i >= maxVoices_;
+        voices_[i]->SetVirtual(isVirtual);
+        if (isVirtual)
+            ++numVirtualVoices_;
+    }
+}
+
+void Audio::StartMixThread()
+{
+    if (mixThread_)
+        return;
+
+    // Lock the device so that the callback does not mix at the same time as the thread starts
+    SDL_LockAudioDevice(deviceID_);
+    // The device buffer may not be a power of two: mix in the largest power of two fragment that fits, so that the
+    // fragments divide the ring buffer and never wrap around its end
+    unsigned mixFragmentSize = fragmentSize_;
+    while (!IsPowerOfTwo(mixFragmentSize))
+        mixFragmentSize &= mixFragmentSize - 1;
+    mixThread_ = new AudioMixThread(this, mixAheadSize_, mixFragmentSize, sampleSize_ * SAMPLE_SIZE_MUL);
+    if (!mixThread_->Run())
+    {
+        URHO3D_LOGWARNING("Could not start the audio mixer thread, mixing in the audio device callback");
+        mixThread_.Reset();
+    }
+    SDL_UnlockAudioDevice(deviceID_);
+}
+
+void Audio::StopMixThread()
+{
+    if (!mixThread_)
+        return;
+
+    SDL_LockAudioDevice(deviceID_);
+    mixThread_.Reset();
+    SDL_UnlockAudioDevice(deviceID_);
 }
 
 void RegisterAudioLibrary(Context* context)
@@ -25,6 +25,7 @@
 #include "../Audio/AudioDefs.h"
 #include "../Container/ArrayPtr.h"
 #include "../Container/HashSet.h"
+#include "../Container/Ptr.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
@@ -32,6 +33,7 @@ namespace Urho3D
 {
 
 class AudioImpl;
+class AudioMixThread;
 class Sound;
 class SoundListener;
 class SoundSource;
@@ -41,6 +43,8 @@ class URHO3D_API Audio : public Object
 {
     URHO3D_OBJECT(Audio, Object);
 
+    friend class AudioMixThread;
+
 public:
     /// Construct.
     Audio(Context* context);
@@ -67,6 +71,12 @@ public:
     void SetListener(SoundListener* listener);
     /// Stop any sound source playing a certain sound clip.
     void StopSound(Sound* sound);
+    /// FromBones : set whether to mix the sound sources ahead in a dedicated thread, instead of in the audio device callback. Adds up to one output buffer length of latency. Default false.
+    void SetMixThread(bool enable);
+    /// FromBones : set the maximum number of mixed voices. The other playing sound sources become virtual: their playback position advances without mixing them. 0 is unlimited (default).
+    void SetMaxVoices(unsigned num);
+    /// FromBones : set the effective gain below which a playing sound source is inaudible and becomes virtual. Default 0.001 (-60 dB).
+    void SetVirtualGainThreshold(float gain);
 
     /// Return byte size of one sample.
     unsigned GetSampleSize() const { return sampleSize_; }
@@ -86,6 +96,21 @@ public:
     /// Return whether an audio stream has been reserved.
     bool IsInitialized() const { return deviceID_ != 0; }
 
+    /// FromBones : return whether mixes in a dedicated thread.
+    bool GetMixThread() const { return mixThreadEnabled_; }
+
+    /// FromBones : return the maximum number of mixed voices.
+    unsigned GetMaxVoices() const { return maxVoices_; }
+
+    /// FromBones : return the effective gain below which a sound source becomes virtual.
+    float GetVirtualGainThreshold() const { return virtualGainThreshold_; }
+
+    /// FromBones : return number of playing sound sources that were virtual on the last update.
+    unsigned GetNumVirtualVoices() const { return numVirtualVoices_; }
+
+    /// FromBones : return how many times the audio device callback found less output mixed ahead than it needed, since the mixer thread was started.
+    unsigned GetNumUnderruns() const;
+
     /// Return master gain for a specific sound source type. Unknown sound types will return full gain (1).
     float GetMasterGain(const String& type) const;
 
@@ -114,6 +139,8 @@ public:
 
     /// Mix sound sources into the buffer.
     void MixOutput(void* dest, unsigned samples);
+    /// FromBones : write the output into the buffer, copying it from the mixer thread if enabled or mixing it under the audio thread mutex. Called from the audio device callback.
+    void ReadOutput(void* dest, unsigned samples);
 
     /// Final multiplier for audio byte conversion.
 #ifdef __EMSCRIPTEN__
@@ -128,6 +155,12 @@ private:
     void Release();
     /// Actually update sound sources with the specific timestep. Called internally.
     void UpdateInternal(float timeStep);
+    /// Rank the playing sound sources by priority and gain, and make the inaudible ones and those over the voice limit virtual. Called internally.
+    void UpdateVoices();
+    /// Start the mixer thread. Called internally.
+    void StartMixThread();
+    /// Stop the mixer thread. Called internally.
+    void StopMixThread();
 
     unsigned format_;
     /// Clipping buffer for mixing.
@@ -140,6 +173,20 @@ private:
     unsigned sampleSize_;
     /// Clip buffer size in samples.
     unsigned fragmentSize_;
+    /// Size of the buffer mixed ahead by the mixer thread in samples.
+    unsigned mixAheadSize_;
+    /// Mixer thread.
+    UniquePtr<AudioMixThread> mixThread_;
+    /// Mixer thread flag.
+    bool mixThreadEnabled_;
+    /// Maximum number of mixed voices, 0 for unlimited.
+    unsigned maxVoices_;
+    /// Effective gain below which a sound source becomes virtual.
+    float virtualGainThreshold_;
+    /// Number of virtual voices on the last update.
+    unsigned numVirtualVoices_;
+    /// Playing sound sources ranked on the last update.
+    PODVector<SoundSource*> voices_;
     /// Mixing rate.
     int mixRate_;
     /// Mixing interpolation flag.
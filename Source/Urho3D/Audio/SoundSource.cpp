@@ -33,6 +33,10 @@
 #include "../Scene/Node.h"
 #include "../Scene/ReplicationState.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -98,6 +102,78 @@ static const int STREAM_SAFETY_SAMPLES = 4;
 
 extern const char* AUDIO_CATEGORY;
 
+#ifdef URHO3D_SSE
+/// Divide 32-bit sample products by 256, rounding towards zero like the scalar mixing, and add them to the clipping buffer.
+static inline void AddProducts(int* dest, __m128i products)
+{
+    const __m128i bias = _mm_and_si128(_mm_srai_epi32(products, 31), _mm_set1_epi32(255));
+    __m128i* ptr = reinterpret_cast<__m128i*>(dest);
+    _mm_storeu_si128(ptr, _mm_add_epi32(_mm_loadu_si128(ptr), _mm_srai_epi32(_mm_add_epi32(products, bias), 8)));
+}
+
+/// Return whether a volume fits the 16-bit multiplies.
+static inline bool IsSIMDVolume(int vol)
+{
+    return vol >= -32768 && vol <= 32767;
+}
+#endif
+
+/// Mix 16-bit samples to the clipping buffer, using separate volumes for the even (left) and odd (right) samples.
+static void MixSamples16(int* dest, const short* src, unsigned count, int evenVol, int oddVol)
+{
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    if (IsSIMDVolume(evenVol) && IsSIMDVolume(oddVol))
+    {
+        // Multiply 8 samples at a time, the low and high halves of the products give the full 32-bit results
+        const __m128i vol = _mm_set_epi16((short)oddVol, (short)evenVol, (short)oddVol, (short)evenVol, (short)oddVol, (short)evenVol,
+            (short)oddVol, (short)evenVol);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i low = _mm_mullo_epi16(samples, vol);
+            __m128i high = _mm_mulhi_epi16(samples, vol);
+            AddProducts(dest + i, _mm_unpacklo_epi16(low, high));
+            AddProducts(dest + i + 4, _mm_unpackhi_epi16(low, high));
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+        dest[i] += (src[i] * ((i & 1) ? oddVol : evenVol)) / 256;
+}
+
+/// Mix 16-bit mono samples to a stereo clipping buffer.
+static void MixMonoToStereo16(int* dest, const short* src, unsigned count, int leftVol, int rightVol)
+{
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    if (IsSIMDVolume(leftVol) && IsSIMDVolume(rightVol))
+    {
+        // Duplicate 4 samples for the left and right channels
+        const __m128i vol = _mm_set_epi16((short)rightVol, (short)leftVol, (short)rightVol, (short)leftVol, (short)rightVol, (short)leftVol,
+            (short)rightVol, (short)leftVol);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i samples = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+            samples = _mm_unpacklo_epi16(samples, samples);
+            __m128i low = _mm_mullo_epi16(samples, vol);
+            __m128i high = _mm_mulhi_epi16(samples, vol);
+            AddProducts(dest + i * 2, _mm_unpacklo_epi16(low, high));
+            AddProducts(dest + i * 2 + 4, _mm_unpackhi_epi16(low, high));
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        dest[i * 2] += (src[i] * leftVol) / 256;
+        dest[i * 2 + 1] += (src[i] * rightVol) / 256;
+    }
+}
+
 extern const char* autoRemoveModeNames[];
 
 SoundSource::SoundSource(Context* context) :
@@ -107,12 +183,14 @@ SoundSource::SoundSource(Context* context) :
     gain_(1.0f),
     attenuation_(1.0f),
     panning_(0.0f),
+    priority_(0),
     sendFinishedEvent_(false),
     autoRemove_(REMOVE_DISABLED),
     position_(0),
     fractPosition_(0),
     timePosition_(0.0f),
-    unusedStreamSize_(0)
+    unusedStreamSize_(0),
+    virtual_(false)
 {
     audio_ = GetSubsystem<Audio>();
 
@@ -139,6 +217,7 @@ void SoundSource::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Gain", float, gain_, 1.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Attenuation", float, attenuation_, 1.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Panning", float, panning_, 0.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Priority", int, priority_, 0, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Is Playing", IsPlaying, SetPlayingAttr, bool, false, AM_DEFAULT);
     URHO3D_ENUM_ATTRIBUTE("Autoremove Mode", autoRemove_, autoRemoveModeNames, REMOVE_DISABLED, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Play Position", GetPositionAttr, SetPositionAttr, int, 0, AM_FILE);
@@ -305,6 +384,17 @@ void SoundSource::SetPanning(float panning)
     MarkNetworkUpdate();
 }
 
+void SoundSource::SetPriority(int priority)
+{
+    priority_ = priority;
+    MarkNetworkUpdate();
+}
+
+void SoundSource::SetVirtual(bool enable)
+{
+    virtual_ = enable;
+}
+
 void SoundSource::SetAutoRemoveMode(AutoRemoveMode mode)
 {
     autoRemove_ = mode;
@@ -401,8 +491,10 @@ void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, boo
     if (!sound)
         return;
 
-    // Choose the correct mixing routine
-    if (!sound->IsStereo())
+    // Choose the correct mixing routine. A virtual voice only advances its playback position
+    if (virtual_)
+        MixZeroVolume(sound, samples, mixRate);
+    else if (!sound->IsStereo())
     {
         if (interpolation)
         {
@@ -617,6 +709,13 @@ void SoundSource::MixMonoToMono(Sound* sound, int* dest, unsigned samples, int m
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // At the mixing rate the samples are contiguous, mix them in blocks
+    if (sound->IsSixteenBit() && intAdd == 1 && !fractAdd)
+    {
+        MixBlocks16(sound, dest, samples, false, vol, vol);
+        return;
+    }
+
     if (sound->IsSixteenBit())
     {
         short* pos = (short*)position_;
@@ -690,6 +789,13 @@ void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // At the mixing rate the samples are contiguous, mix them in blocks
+    if (sound->IsSixteenBit() && intAdd == 1 && !fractAdd)
+    {
+        MixBlocks16(sound, dest, samples, true, leftVol, rightVol);
+        return;
+    }
+
     if (sound->IsSixteenBit())
     {
         short* pos = (short*)position_;
@@ -771,6 +877,13 @@ void SoundSource::MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // At the mixing rate and without a fractional position the samples are not interpolated, mix them in blocks
+    if (sound->IsSixteenBit() && intAdd == 1 && !fractAdd && !fractPos)
+    {
+        MixBlocks16(sound, dest, samples, false, vol, vol);
+        return;
+    }
+
     if (sound->IsSixteenBit())
     {
         short* pos = (short*)position_;
@@ -845,6 +958,13 @@ void SoundSource::MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, i
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // At the mixing rate and without a fractional position the samples are not interpolated, mix them in blocks
+    if (sound->IsSixteenBit() && intAdd == 1 && !fractAdd && !fractPos)
+    {
+        MixBlocks16(sound, dest, samples, true, leftVol, rightVol);
+        return;
+    }
+
     if (sound->IsSixteenBit())
     {
         short* pos = (short*)position_;
@@ -1007,6 +1127,13 @@ void SoundSource::MixStereoToStereo(Sound* sound, int* dest, unsigned samples, i
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // At the mixing rate the samples are contiguous, mix them in blocks
+    if (sound->IsSixteenBit() && intAdd == 1 && !fractAdd)
+    {
+        MixBlocks16(sound, dest, samples, true, vol, vol);
+        return;
+    }
+
     if (sound->IsSixteenBit())
     {
         short* pos = (short*)position_;
@@ -1165,6 +1292,13 @@ void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples,
     int fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // At the mixing rate and without a fractional position the samples are not interpolated, mix them in blocks
+    if (sound->IsSixteenBit() && intAdd == 1 && !fractAdd && !fractPos)
+    {
+        MixBlocks16(sound, dest, samples, true, vol, vol);
+        return;
+    }
+
     if (sound->IsSixteenBit())
     {
         short* pos = (short*)position_;
@@ -1231,6 +1365,43 @@ void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples,
     fractPosition_ = fractPos;
 }
 
+void SoundSource::MixBlocks16(Sound* sound, int* dest, unsigned samples, bool stereo, int leftVol, int rightVol)
+{
+    const int srcChannels = sound->IsStereo() ? 2 : 1;
+    const int destChannels = stereo ? 2 : 1;
+    short* pos = (short*)position_;
+    short* end = (short*)sound->GetEnd();
+    short* repeat = (short*)sound->GetRepeat();
+
+    while (samples)
+    {
+        // Mix up to the end of the sound, then loop or stop
+        unsigned count = Min(samples, (unsigned)((end - pos + srcChannels - 1) / srcChannels));
+        if (srcChannels == destChannels)
+            MixSamples16(dest, pos, count * srcChannels, leftVol, rightVol);
+        else
+            MixMonoToStereo16(dest, pos, count, leftVol, rightVol);
+
+        dest += count * destChannels;
+        pos += count * srcChannels;
+        samples -= count;
+
+        if (pos >= end)
+        {
+            if (!sound->IsLooped())
+            {
+                pos = 0;
+                break;
+            }
+
+            while (pos >= end)
+                pos -= (end - repeat);
+        }
+    }
+
+    position_ = (signed char*)pos;
+}
+
 void SoundSource::MixZeroVolume(Sound* sound, unsigned samples, int mixRate)
 {
     float add = frequency_ * (float)samples / (float)mixRate;
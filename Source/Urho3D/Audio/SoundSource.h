@@ -76,6 +76,10 @@ public:
     void SetAutoRemoveMode(AutoRemoveMode mode);
     /// Set new playback position.
     void SetPlayPosition(signed char* pos);
+    /// FromBones : set voice priority. When the audio subsystem limits the number of mixed voices, the sources with a higher priority are mixed first, then the louder ones. Default 0.
+    void SetPriority(int priority);
+    /// FromBones : set whether the voice is virtual, which advances its playback position without mixing it. Called by Audio.
+    void SetVirtual(bool enable);
 
     /// Return sound.
     Sound* GetSound() const { return sound_; }
@@ -101,6 +105,15 @@ public:
     /// Return stereo panning.
     float GetPanning() const { return panning_; }
 
+    /// FromBones : return voice priority.
+    int GetPriority() const { return priority_; }
+
+    /// FromBones : return gain multiplied by the attenuation and the master gain of the sound type.
+    float GetEffectiveGain() const { return masterGain_ * attenuation_ * gain_; }
+
+    /// FromBones : return whether the voice is virtual.
+    bool IsVirtual() const { return virtual_; }
+
     /// Return automatic removal mode on sound playback completion.
     AutoRemoveMode GetAutoRemoveMode() const { return autoRemove_; }
 
@@ -142,6 +155,8 @@ protected:
     float panning_;
     /// Effective master gain.
     float masterGain_;
+    /// Voice priority.
+    int priority_;
     /// Whether finished event should be sent on playback stop.
     bool sendFinishedEvent_;
     /// Automatic removal mode.
@@ -172,6 +187,8 @@ private:
     void MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
     /// Mix stereo sample to stereo buffer interpolated.
     void MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
+    /// Mix 16-bit sample data played at the mixing rate in contiguous blocks, to a mono buffer or from mono or stereo to a stereo buffer.
+    void MixBlocks16(Sound* sound, int* dest, unsigned samples, bool stereo, int leftVol, int rightVol);
     /// Advance playback pointer without producing audible output.
     void MixZeroVolume(Sound* sound, unsigned samples, int mixRate);
     /// Advance playback pointer to simulate audio playback in headless mode.
@@ -191,6 +208,8 @@ private:
     SharedPtr<Sound> streamBuffer_;
     /// Unused stream bytes from previous frame.
     int unusedStreamSize_;
+    /// Virtual voice flag.
+    volatile bool virtual_;
 };
 
 }
@@ -27,12 +27,20 @@
 namespace Urho3D
 {
 
+static ContainerAllocations containerAllocations = { 0, 0, 0 };
+
+ContainerAllocations& GetContainerAllocations()
+{
+    return containerAllocations;
+}
+
 AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSize, unsigned capacity)
 {
     if (!capacity)
         capacity = 1;
 
     unsigned char* blockPtr = new unsigned char[sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize)];
+    URHO3D_COUNT_CONTAINER_ALLOCATION(allocatorBlocks_);
     AllocatorBlock* newBlock = reinterpret_cast<AllocatorBlock*>(blockPtr);
     newBlock->nodeSize_ = nodeSize;
     newBlock->capacity_ = capacity;
@@ -57,10 +65,10 @@ AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, unsigned nodeSi
         newNode->next_ = reinterpret_cast<AllocatorNode*>(nodePtr + sizeof(AllocatorNode) + nodeSize);
         nodePtr += sizeof(AllocatorNode) + nodeSize;
     }
-    // i == capacity - 1
+    // i == capacity - 1 : chain the free nodes remaining in the allocator
     {
         AllocatorNode* newNode = reinterpret_cast<AllocatorNode*>(nodePtr);
-        newNode->next_ = 0;
+        newNode->next_ = allocator != newBlock ? allocator->free_ : 0;
     }
 
     allocator->free_ = firstNewNode;
@@ -106,6 +114,16 @@ void* AllocatorReserve(AllocatorBlock* allocator)
     return ptr;
 }
 
+void AllocatorReserveCapacity(AllocatorBlock* allocator, unsigned capacity)
+{
+    if (!allocator || allocator->capacity_ >= capacity)
+        return;
+
+    unsigned newCapacity = capacity - allocator->capacity_;
+    AllocatorReserveBlock(allocator, allocator->nodeSize_, newCapacity);
+    allocator->capacity_ += newCapacity;
+}
+
 void AllocatorFree(AllocatorBlock* allocator, void* ptr)
 {
     if (!allocator || !ptr)
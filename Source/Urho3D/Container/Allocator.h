@@ -58,12 +58,35 @@ struct AllocatorNode
     /// Data follows.
 };
 
+/// FromBones : heap allocations made by the containers, to follow the allocations per frame.
+/// The counters are updated only when the profiling is enabled, and are not synchronized between threads.
+struct ContainerAllocations
+{
+    /// String buffers.
+    unsigned strings_;
+    /// Hash set and map bucket arrays.
+    unsigned hashBuckets_;
+    /// Allocator blocks : nodes of the hash sets, hash maps and lists.
+    unsigned allocatorBlocks_;
+};
+
+/// FromBones : return the container allocation counters since the start of the application.
+URHO3D_API ContainerAllocations& GetContainerAllocations();
+
+#ifdef URHO3D_PROFILING
+#define URHO3D_COUNT_CONTAINER_ALLOCATION(counter) ++Urho3D::GetContainerAllocations().counter
+#else
+#define URHO3D_COUNT_CONTAINER_ALLOCATION(counter)
+#endif
+
 /// Initialize a fixed-size allocator with the node size and initial capacity.
 URHO3D_API AllocatorBlock* AllocatorInitialize(unsigned nodeSize, unsigned initialCapacity = 1);
 /// Uninitialize a fixed-size allocator. Frees all blocks in the chain.
 URHO3D_API void AllocatorUninitialize(AllocatorBlock* allocator);
 /// Reserve a node. Creates a new block if necessary.
 URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
+/// FromBones : make sure that the allocator has a total capacity of nodes, used and free. Creates one block with the missing nodes if necessary.
+URHO3D_API void AllocatorReserveCapacity(AllocatorBlock* allocator, unsigned capacity);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
 
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FlatHashBase.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Slots are aligned for any element type.
+static const unsigned FLATHASH_SLOTALIGN = 16;
+
+const signed char* FlatHashBase::EmptyCtrl()
+{
+    static const signed char emptyCtrl[FlatHashGroup::SIZE] = { FLATHASH_SENTINEL };
+    return emptyCtrl;
+}
+
+unsigned FlatHashBase::CapacityForSize(unsigned size)
+{
+    unsigned capacity = MIN_CAPACITY;
+    while (size > capacity - capacity / 8)
+        capacity <<= 1;
+    return capacity;
+}
+
+void* FlatHashBase::AllocateTable(unsigned capacity, unsigned slotSize)
+{
+    void* oldTable = capacity_ ? slots_ : 0;
+
+    if (!capacity)
+    {
+        ctrl_ = const_cast<signed char*>(EmptyCtrl());
+        slots_ = 0;
+        capacity_ = 0;
+        size_ = 0;
+        growthLeft_ = 0;
+        return oldTable;
+    }
+
+    // Slots first then control bytes in the same block, so that the slots keep the alignment of operator new
+    unsigned slotsBytes = (capacity * slotSize + FLATHASH_SLOTALIGN - 1) & ~(FLATHASH_SLOTALIGN - 1);
+    unsigned char* table = new unsigned char[slotsBytes + capacity + FlatHashGroup::SIZE];
+
+    slots_ = table;
+    ctrl_ = reinterpret_cast<signed char*>(table + slotsBytes);
+    capacity_ = capacity;
+    ResetCtrl();
+
+    return oldTable;
+}
+
+void FlatHashBase::FreeTable(void* table)
+{
+    delete[] static_cast<unsigned char*>(table);
+}
+
+unsigned FlatHashBase::FindFreeSlot(unsigned hash) const
+{
+    const unsigned groupMask = NumGroups() - 1;
+    unsigned group = HashGroup(hash);
+
+    // Triangular probing over the groups visits every group when the number of groups is a power of two
+    for (unsigned step = 1; ; ++step)
+    {
+        unsigned mask = FlatHashGroup(ctrl_ + group * FlatHashGroup::SIZE).MatchEmptyOrDeleted();
+        if (mask)
+            return group * FlatHashGroup::SIZE + FlatHashLowestBit(mask);
+
+        group = (group + step) & groupMask;
+    }
+}
+
+void FlatHashBase::SetFree(unsigned index)
+{
+    const unsigned group = index & ~(FlatHashGroup::SIZE - 1);
+
+    // A group with an empty slot has never been full, so no probe sequence has gone through it
+    if (FlatHashGroup(ctrl_ + group).MatchEmpty())
+    {
+        ctrl_[index] = FLATHASH_EMPTY;
+        ++growthLeft_;
+    }
+    else
+        ctrl_[index] = FLATHASH_DELETED;
+
+    --size_;
+}
+
+void FlatHashBase::ResetCtrl()
+{
+    if (!capacity_)
+        return;
+
+    memset(ctrl_, FLATHASH_EMPTY, capacity_);
+    // The sentinel stops the iterators, the remaining bytes are never probed
+    memset(ctrl_ + capacity_, FLATHASH_SENTINEL, FlatHashGroup::SIZE);
+
+    size_ = 0;
+    growthLeft_ = capacity_ - capacity_ / 8;
+}
+
+}
@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// FromBones : control byte of an empty slot.
+static const signed char FLATHASH_EMPTY = -128;
+/// FromBones : control byte of an erased slot (tombstone).
+static const signed char FLATHASH_DELETED = -2;
+/// FromBones : control byte written after the last slot to stop the iterators.
+static const signed char FLATHASH_SENTINEL = -1;
+
+/// FromBones : return the index of the lowest set bit. The value must not be zero.
+inline unsigned FlatHashLowestBit(unsigned value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (unsigned)index;
+#elif defined(__GNUC__)
+    return (unsigned)__builtin_ctz(value);
+#else
+    unsigned index = 0;
+    while (!(value & 1))
+    {
+        value >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/// FromBones : group of 16 control bytes probed at once. Match functions return a bit mask of the matching slots in the group.
+struct FlatHashGroup
+{
+    /// Number of slots in a group.
+    static const unsigned SIZE = 16;
+
+#ifdef URHO3D_SSE
+    /// Load a group.
+    explicit FlatHashGroup(const signed char* ctrl) :
+        ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+    {
+    }
+
+    /// Return the slots whose control byte is equal to the hash tag.
+    unsigned Match(signed char tag) const { return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl_, _mm_set1_epi8(tag))); }
+
+    /// Return the empty slots.
+    unsigned MatchEmpty() const { return Match(FLATHASH_EMPTY); }
+
+    /// Return the empty or erased slots.
+    unsigned MatchEmptyOrDeleted() const { return (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(ctrl_, _mm_set1_epi8(FLATHASH_SENTINEL))); }
+
+    /// Control bytes.
+    __m128i ctrl_;
+#else
+    /// Load a group.
+    explicit FlatHashGroup(const signed char* ctrl) :
+        ctrl_(ctrl)
+    {
+    }
+
+    /// Return the slots whose control byte is equal to the hash tag.
+    unsigned Match(signed char tag) const
+    {
+        unsigned mask = 0;
+        for (unsigned i = 0; i < SIZE; ++i)
+        {
+            if (ctrl_[i] == tag)
+                mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    /// Return the empty slots.
+    unsigned MatchEmpty() const { return Match(FLATHASH_EMPTY); }
+
+    /// Return the empty or erased slots.
+    unsigned MatchEmptyOrDeleted() const
+    {
+        unsigned mask = 0;
+        for (unsigned i = 0; i < SIZE; ++i)
+        {
+            if (ctrl_[i] < FLATHASH_SENTINEL)
+                mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    /// Control bytes.
+    const signed char* ctrl_;
+#endif
+};
+
+/// FromBones : flat hash set/map iterator base class. Points to a slot index in the control bytes.
+struct FlatHashIteratorBase
+{
+    /// Construct.
+    FlatHashIteratorBase() :
+        ctrl_(0),
+        index_(0)
+    {
+    }
+
+    /// Construct with control bytes and a slot index.
+    FlatHashIteratorBase(const signed char* ctrl, unsigned index) :
+        ctrl_(ctrl),
+        index_(index)
+    {
+    }
+
+    /// Test for equality with another iterator.
+    bool operator ==(const FlatHashIteratorBase& rhs) const { return index_ == rhs.index_ && ctrl_ == rhs.ctrl_; }
+
+    /// Test for inequality with another iterator.
+    bool operator !=(const FlatHashIteratorBase& rhs) const { return index_ != rhs.index_ || ctrl_ != rhs.ctrl_; }
+
+    /// Go to the next used slot, or to the sentinel.
+    void GotoNext()
+    {
+        if (ctrl_ && ctrl_[index_] != FLATHASH_SENTINEL)
+        {
+            ++index_;
+            while (ctrl_[index_] < FLATHASH_SENTINEL)
+                ++index_;
+        }
+    }
+
+    /// Go to the previous used slot.
+    void GotoPrev()
+    {
+        if (ctrl_)
+        {
+            while (index_ > 0)
+            {
+                --index_;
+                if (ctrl_[index_] >= 0)
+                    break;
+            }
+        }
+    }
+
+    /// Control bytes.
+    const signed char* ctrl_;
+    /// Slot index.
+    unsigned index_;
+};
+
+/// FromBones : flat hash set/map base class with open addressing.
+/** The slots are stored contiguously and indexed by a parallel array of control bytes, one per slot : a 7-bit tag of the hash for the used slots,
+    or one of FLATHASH_EMPTY and FLATHASH_DELETED. Lookups probe 16 control bytes at once (SSE2 when available) and only compare the keys whose tag matches.
+    Inserting may move the elements and invalidates the iterators and the pointers to the elements. Erasing does not move the other elements.
+    Note that %FlatHashBase intentionally does not declare a virtual destructor and therefore %FlatHashBase pointers should never be used.
+  */
+class URHO3D_API FlatHashBase
+{
+public:
+    /// Minimum capacity in slots.
+    static const unsigned MIN_CAPACITY = FlatHashGroup::SIZE;
+
+    /// Construct.
+    FlatHashBase() :
+        ctrl_(const_cast<signed char*>(EmptyCtrl())),
+        slots_(0),
+        capacity_(0),
+        size_(0),
+        growthLeft_(0)
+    {
+    }
+
+    /// Swap with another flat hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        Urho3D::Swap(ctrl_, rhs.ctrl_);
+        Urho3D::Swap(slots_, rhs.slots_);
+        Urho3D::Swap(capacity_, rhs.capacity_);
+        Urho3D::Swap(size_, rhs.size_);
+        Urho3D::Swap(growthLeft_, rhs.growthLeft_);
+    }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+
+    /// Return number of slots.
+    unsigned Capacity() const { return capacity_; }
+
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Return the capacity needed to hold a number of elements under the maximum load factor (7/8).
+    static unsigned CapacityForSize(unsigned size);
+
+    /// Mix a key hash so that sequential keys spread over the groups.
+    static unsigned MixHash(unsigned hash)
+    {
+        hash *= 0x9E3779B1u;
+        return hash ^ (hash >> 15);
+    }
+
+    /// Return the control byte tag of a mixed hash.
+    static signed char HashTag(unsigned hash) { return (signed char)(hash & 0x7f); }
+
+    /// Return the first probed group of a mixed hash.
+    unsigned HashGroup(unsigned hash) const { return (hash >> 7) & (NumGroups() - 1); }
+
+    /// Return number of groups.
+    unsigned NumGroups() const { return capacity_ / FlatHashGroup::SIZE; }
+
+    /// Return the index of the first used slot, or the capacity if empty.
+    unsigned FirstSlot() const
+    {
+        unsigned index = 0;
+        while (ctrl_[index] < FLATHASH_SENTINEL)
+            ++index;
+        return index;
+    }
+
+    /// Allocate the control bytes and the slots for a capacity, which must be zero or a power of two not smaller than MIN_CAPACITY. Return the previous table to be freed with FreeTable() once the elements have been moved.
+    void* AllocateTable(unsigned capacity, unsigned slotSize);
+
+    /// Free a table returned by AllocateTable().
+    static void FreeTable(void* table);
+
+    /// Return the index of a free slot for a mixed hash. Do not call if there is no room left.
+    unsigned FindFreeSlot(unsigned hash) const;
+
+    /// Mark a free slot as used.
+    void SetUsed(unsigned index, unsigned hash)
+    {
+        if (ctrl_[index] == FLATHASH_EMPTY)
+            --growthLeft_;
+        ctrl_[index] = HashTag(hash);
+        ++size_;
+    }
+
+    /// Mark a used slot as free. The slot becomes empty if its group has never been full, otherwise it becomes a tombstone so that the probe sequences of the other keys are not broken.
+    void SetFree(unsigned index);
+
+    /// Mark all the slots as empty.
+    void ResetCtrl();
+
+    /// Return shared control bytes of a table without slots : only the sentinel.
+    static const signed char* EmptyCtrl();
+
+    /// Control bytes : capacity_ bytes followed by the sentinel.
+    signed char* ctrl_;
+    /// Slots storage.
+    void* slots_;
+    /// Number of slots.
+    unsigned capacity_;
+    /// Number of used slots.
+    unsigned size_;
+    /// Number of empty slots that can still be used before rehashing.
+    unsigned growthLeft_;
+};
+
+}
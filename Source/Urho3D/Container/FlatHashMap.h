@@ -0,0 +1,587 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Vector.h"
+
+#include <new>
+#if URHO3D_CXX11
+#include <initializer_list>
+#endif
+
+namespace Urho3D
+{
+
+/// FromBones : flat hash map template class with open addressing. Same interface as HashMap, but the pairs are stored contiguously.
+/** Prefer it to HashMap for hot lookup tables with small keys. Inserting may move the pairs : the iterators and the pointers to the values are invalidated by Insert() and operator [] on a missing key.
+    Erase() does not move the other pairs, so erasing the current pair while iterating is safe. The iteration order is unspecified.
+  */
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+
+    /// Flat hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+
+    private:
+        /// Prevent assignment.
+        KeyValue& operator =(const KeyValue& rhs);
+    };
+
+    /// Flat hash map iterator.
+    struct Iterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        Iterator() :
+            slots_(0)
+        {
+        }
+
+        /// Construct with the table and a slot index.
+        Iterator(const signed char* ctrl, KeyValue* slots, unsigned index) :
+            FlatHashIteratorBase(ctrl, index),
+            slots_(slots)
+        {
+        }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        Iterator& operator --()
+        {
+            GotoPrev();
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        Iterator operator --(int)
+        {
+            Iterator it = *this;
+            GotoPrev();
+            return it;
+        }
+
+        /// Point to the pair.
+        KeyValue* operator ->() const { return slots_ + index_; }
+
+        /// Dereference the pair.
+        KeyValue& operator *() const { return slots_[index_]; }
+
+        /// Slots.
+        KeyValue* slots_;
+    };
+
+    /// Flat hash map const iterator.
+    struct ConstIterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        ConstIterator() :
+            slots_(0)
+        {
+        }
+
+        /// Construct with the table and a slot index.
+        ConstIterator(const signed char* ctrl, const KeyValue* slots, unsigned index) :
+            FlatHashIteratorBase(ctrl, index),
+            slots_(slots)
+        {
+        }
+
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            FlatHashIteratorBase(rhs.ctrl_, rhs.index_),
+            slots_(rhs.slots_)
+        {
+        }
+
+        /// Assign from a non-const iterator.
+        ConstIterator& operator =(const Iterator& rhs)
+        {
+            ctrl_ = rhs.ctrl_;
+            index_ = rhs.index_;
+            slots_ = rhs.slots_;
+            return *this;
+        }
+
+        /// Preincrement the pointer.
+        ConstIterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        ConstIterator operator ++(int)
+        {
+            ConstIterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        ConstIterator& operator --()
+        {
+            GotoPrev();
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        ConstIterator operator --(int)
+        {
+            ConstIterator it = *this;
+            GotoPrev();
+            return it;
+        }
+
+        /// Point to the pair.
+        const KeyValue* operator ->() const { return slots_ + index_; }
+
+        /// Dereference the pair.
+        const KeyValue& operator *() const { return slots_[index_]; }
+
+        /// Slots.
+        const KeyValue* slots_;
+    };
+
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+
+    /// Construct from another flat hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        Reserve(map.Size());
+        Insert(map);
+    }
+#if URHO3D_CXX11
+    /// Aggregate initialization constructor.
+    FlatHashMap(const std::initializer_list<Pair<T, U>>& list) : FlatHashMap()
+    {
+        Reserve((unsigned)list.size());
+        for (auto it = list.begin(); it != list.end(); it++)
+        {
+            Insert(*it);
+        }
+    }
+#endif
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        DestructSlots();
+        FreeTable(AllocateTable(0, sizeof(KeyValue)));
+    }
+
+    /// Assign a flat hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a flat hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another flat hash map.
+    bool operator ==(const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another flat hash map.
+    bool operator !=(const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned index = FindIndex(key, hash);
+        if (index == capacity_)
+            index = InsertIndex(key, U(), hash);
+        return Slots()[index].second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        unsigned index = FindIndex(key, MixHash(MakeHash(key)));
+        return index != capacity_ ? &Slots()[index].second_ : 0;
+    }
+
+#if URHO3D_CXX11
+    /// Populate the map using variadic template. This handles the base case.
+    FlatHashMap& Populate(const T& key, const U& value)
+    {
+        this->operator [](key) = value;
+        return *this;
+    };
+    /// Populate the map using variadic template.
+    template <typename... Args> FlatHashMap& Populate(const T& key, const U& value, Args... args)
+    {
+        this->operator [](key) = value;
+        return Populate(args...);
+    };
+#endif
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        bool exists;
+        return Insert(pair, exists);
+    }
+
+    /// Insert a pair. Return iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const Pair<T, U>& pair, bool& exists)
+    {
+        unsigned hash = MixHash(MakeHash(pair.first_));
+        unsigned index = FindIndex(pair.first_, hash);
+        exists = index != capacity_;
+        if (exists)
+            Slots()[index].second_ = pair.second_;
+        else
+            index = InsertIndex(pair.first_, pair.second_, hash);
+        return Iterator(ctrl_, Slots(), index);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator it = map.Begin(); it != map.End(); ++it)
+            Insert(Pair<T, U>(it->first_, it->second_));
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(Pair<T, U>(it->first_, it->second_)); }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator it = start; it != end; ++it)
+            Insert(Pair<T, U>(it->first_, it->second_));
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index = FindIndex(key, MixHash(MakeHash(key)));
+        if (index == capacity_)
+            return false;
+
+        EraseIndex(index);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair.
+    Iterator Erase(const Iterator& it)
+    {
+        if (it.ctrl_ != ctrl_ || it.index_ >= capacity_ || ctrl_[it.index_] < 0)
+            return End();
+
+        Iterator next = it;
+        ++next;
+        EraseIndex(it.index_);
+        return next;
+    }
+
+    /// Clear the map. Keep the allocated slots.
+    void Clear()
+    {
+        if (size_)
+        {
+            DestructSlots();
+            ResetCtrl();
+        }
+    }
+
+    /// Reserve room for a number of pairs without rehashing.
+    void Reserve(unsigned numPairs)
+    {
+        unsigned capacity = CapacityForSize(numPairs);
+        if (capacity > capacity_)
+            Rehash(capacity);
+    }
+
+    /// Release the unused slots.
+    void Compact()
+    {
+        Rehash(size_ ? CapacityForSize(size_) : 0);
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key) { return Iterator(ctrl_, Slots(), FindIndex(key, MixHash(MakeHash(key)))); }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return ConstIterator(ctrl_, Slots(), FindIndex(key, MixHash(MakeHash(key)))); }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindIndex(key, MixHash(MakeHash(key))) != capacity_; }
+
+    /// Try to copy value to output. Return true if was found.
+    bool TryGetValue(const T& key, U& out) const
+    {
+        unsigned index = FindIndex(key, MixHash(MakeHash(key)));
+        if (index == capacity_)
+            return false;
+
+        out = Slots()[index].second_;
+        return true;
+    }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        GetValues(result);
+        return result;
+    }
+
+    /// Return all values in the entry buffer
+    void GetValues(Vector<U>& buffer) const
+    {
+        buffer.Reserve(buffer.Size() + Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            buffer.Push(i->second_);
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(ctrl_, Slots(), FirstSlot()); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(ctrl_, Slots(), FirstSlot()); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(ctrl_, Slots(), capacity_); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(ctrl_, Slots(), capacity_); }
+
+    /// Return first pair.
+    const KeyValue& Front() const { return *Begin(); }
+
+    /// Return last pair.
+    const KeyValue& Back() const { return *(--End()); }
+
+private:
+    /// Return the slots.
+    KeyValue* Slots() const { return static_cast<KeyValue*>(slots_); }
+
+    /// Return the slot index of a key, or the capacity if not found.
+    unsigned FindIndex(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return capacity_;
+
+        const signed char tag = HashTag(hash);
+        const unsigned groupMask = NumGroups() - 1;
+        const KeyValue* slots = Slots();
+        unsigned group = HashGroup(hash);
+
+        for (unsigned step = 1; step <= groupMask + 1; ++step)
+        {
+            const unsigned first = group * FlatHashGroup::SIZE;
+            FlatHashGroup ctrl(ctrl_ + first);
+
+            for (unsigned mask = ctrl.Match(tag); mask; mask &= mask - 1)
+            {
+                unsigned index = first + FlatHashLowestBit(mask);
+                if (slots[index].first_ == key)
+                    return index;
+            }
+
+            // The key would have been stored in the first group with an empty slot
+            if (ctrl.MatchEmpty())
+                break;
+
+            group = (group + step) & groupMask;
+        }
+
+        return capacity_;
+    }
+
+    /// Insert a key that is not in the map and return its slot index.
+    unsigned InsertIndex(const T& key, const U& value, unsigned hash)
+    {
+        if (!growthLeft_)
+        {
+            // The key and the value may refer to a pair of this map which is going to move
+            KeyValue pair(key, value);
+            Grow();
+            return ConstructIndex(pair.first_, pair.second_, hash);
+        }
+
+        return ConstructIndex(key, value, hash);
+    }
+
+    /// Construct a pair in a free slot and return its index.
+    unsigned ConstructIndex(const T& key, const U& value, unsigned hash)
+    {
+        unsigned index = FindFreeSlot(hash);
+        new(Slots() + index) KeyValue(key, value);
+        SetUsed(index, hash);
+        return index;
+    }
+
+    /// Destruct a pair and free its slot.
+    void EraseIndex(unsigned index)
+    {
+        (Slots() + index)->~KeyValue();
+        SetFree(index);
+    }
+
+    /// Destruct all the pairs.
+    void DestructSlots()
+    {
+        KeyValue* slots = Slots();
+        for (unsigned i = 0; i < capacity_; ++i)
+        {
+            if (ctrl_[i] >= 0)
+                (slots + i)->~KeyValue();
+        }
+    }
+
+    /// Make room for one more pair : drop the erased slots if they are numerous enough, otherwise double the capacity.
+    void Grow()
+    {
+        if (!capacity_)
+            Rehash(MIN_CAPACITY);
+        else
+            Rehash(size_ < capacity_ * 7 / 16 ? capacity_ : capacity_ << 1);
+    }
+
+    /// Move the pairs in a new table.
+    void Rehash(unsigned capacity)
+    {
+        const signed char* oldCtrl = ctrl_;
+        KeyValue* oldSlots = Slots();
+        const unsigned oldCapacity = capacity_;
+
+        void* oldTable = AllocateTable(capacity, sizeof(KeyValue));
+
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                ConstructIndex(oldSlots[i].first_, oldSlots[i].second_, MixHash(MakeHash(oldSlots[i].first_)));
+                (oldSlots + i)->~KeyValue();
+            }
+        }
+
+        FreeTable(oldTable);
+    }
+};
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator begin(const Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::ConstIterator end(const Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator begin(Urho3D::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename Urho3D::FlatHashMap<T, U>::Iterator end(Urho3D::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
@@ -0,0 +1,470 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+
+#include <new>
+#if URHO3D_CXX11
+#include <initializer_list>
+#endif
+
+namespace Urho3D
+{
+
+/// FromBones : flat hash set template class with open addressing. Same interface as HashSet, but the keys are stored contiguously.
+/** Inserting may move the keys and invalidates the iterators. Erase() does not move the other keys, so erasing the current key while iterating is safe.
+    The iteration order is unspecified.
+  */
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    /// Flat hash set iterator.
+    struct Iterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        Iterator() :
+            slots_(0)
+        {
+        }
+
+        /// Construct with the table and a slot index.
+        Iterator(const signed char* ctrl, T* slots, unsigned index) :
+            FlatHashIteratorBase(ctrl, index),
+            slots_(slots)
+        {
+        }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        Iterator& operator --()
+        {
+            GotoPrev();
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        Iterator operator --(int)
+        {
+            Iterator it = *this;
+            GotoPrev();
+            return it;
+        }
+
+        /// Point to the key.
+        const T* operator ->() const { return slots_ + index_; }
+
+        /// Dereference the key.
+        const T& operator *() const { return slots_[index_]; }
+
+        /// Slots.
+        T* slots_;
+    };
+
+    /// Flat hash set const iterator.
+    struct ConstIterator : public FlatHashIteratorBase
+    {
+        /// Construct.
+        ConstIterator() :
+            slots_(0)
+        {
+        }
+
+        /// Construct with the table and a slot index.
+        ConstIterator(const signed char* ctrl, const T* slots, unsigned index) :
+            FlatHashIteratorBase(ctrl, index),
+            slots_(slots)
+        {
+        }
+
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :
+            FlatHashIteratorBase(rhs.ctrl_, rhs.index_),
+            slots_(rhs.slots_)
+        {
+        }
+
+        /// Assign from a non-const iterator.
+        ConstIterator& operator =(const Iterator& rhs)
+        {
+            ctrl_ = rhs.ctrl_;
+            index_ = rhs.index_;
+            slots_ = rhs.slots_;
+            return *this;
+        }
+
+        /// Preincrement the pointer.
+        ConstIterator& operator ++()
+        {
+            GotoNext();
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        ConstIterator operator ++(int)
+        {
+            ConstIterator it = *this;
+            GotoNext();
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        ConstIterator& operator --()
+        {
+            GotoPrev();
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        ConstIterator operator --(int)
+        {
+            ConstIterator it = *this;
+            GotoPrev();
+            return it;
+        }
+
+        /// Point to the key.
+        const T* operator ->() const { return slots_ + index_; }
+
+        /// Dereference the key.
+        const T& operator *() const { return slots_[index_]; }
+
+        /// Slots.
+        const T* slots_;
+    };
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+    /// Construct from another flat hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        Reserve(set.Size());
+        Insert(set);
+    }
+#if URHO3D_CXX11
+    /// Aggregate initialization constructor.
+    FlatHashSet(const std::initializer_list<T>& list) : FlatHashSet()
+    {
+        Reserve((unsigned)list.size());
+        for (auto it = list.begin(); it != list.end(); it++)
+        {
+            Insert(*it);
+        }
+    }
+#endif
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        DestructSlots();
+        FreeTable(AllocateTable(0, sizeof(T)));
+    }
+
+    /// Assign a flat hash set.
+    FlatHashSet& operator =(const FlatHashSet<T>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Reserve(rhs.Size());
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Subtract-assign a value.
+    FlatHashSet& operator -=(const T& rhs)
+    {
+        Erase(rhs);
+        return *this;
+    }
+
+    /// Add-assign a flat hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another flat hash set.
+    bool operator ==(const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator it = Begin(); it != End(); ++it)
+        {
+            if (!rhs.Contains(*it))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another flat hash set.
+    bool operator !=(const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        bool exists;
+        return Insert(key, exists);
+    }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        unsigned hash = MixHash(MakeHash(key));
+        unsigned index = FindIndex(key, hash);
+        exists = index != capacity_;
+        if (!exists)
+            index = InsertIndex(key, hash);
+        return Iterator(ctrl_, Slots(), index);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        for (ConstIterator it = set.Begin(); it != set.End(); ++it)
+            Insert(*it);
+    }
+
+    /// Insert a key by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(*it); }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        unsigned index = FindIndex(key, MixHash(MakeHash(key)));
+        if (index == capacity_)
+            return false;
+
+        EraseIndex(index);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key.
+    Iterator Erase(const Iterator& it)
+    {
+        if (it.ctrl_ != ctrl_ || it.index_ >= capacity_ || ctrl_[it.index_] < 0)
+            return End();
+
+        Iterator next = it;
+        ++next;
+        EraseIndex(it.index_);
+        return next;
+    }
+
+    /// Clear the set. Keep the allocated slots.
+    void Clear()
+    {
+        if (size_)
+        {
+            DestructSlots();
+            ResetCtrl();
+        }
+    }
+
+    /// Reserve room for a number of keys without rehashing.
+    void Reserve(unsigned numKeys)
+    {
+        unsigned capacity = CapacityForSize(numKeys);
+        if (capacity > capacity_)
+            Rehash(capacity);
+    }
+
+    /// Release the unused slots.
+    void Compact()
+    {
+        Rehash(size_ ? CapacityForSize(size_) : 0);
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) { return Iterator(ctrl_, Slots(), FindIndex(key, MixHash(MakeHash(key)))); }
+
+    /// Return const iterator to the key, or end iterator if not found.
+    ConstIterator Find(const T& key) const { return ConstIterator(ctrl_, Slots(), FindIndex(key, MixHash(MakeHash(key)))); }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindIndex(key, MixHash(MakeHash(key))) != capacity_; }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(ctrl_, Slots(), FirstSlot()); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(ctrl_, Slots(), FirstSlot()); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(ctrl_, Slots(), capacity_); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(ctrl_, Slots(), capacity_); }
+
+    /// Return first key.
+    const T& Front() const { return *Begin(); }
+
+    /// Return last key.
+    const T& Back() const { return *(--End()); }
+
+private:
+    /// Return the slots.
+    T* Slots() const { return static_cast<T*>(slots_); }
+
+    /// Return the slot index of a key, or the capacity if not found.
+    unsigned FindIndex(const T& key, unsigned hash) const
+    {
+        if (!size_)
+            return capacity_;
+
+        const signed char tag = HashTag(hash);
+        const unsigned groupMask = NumGroups() - 1;
+        const T* slots = Slots();
+        unsigned group = HashGroup(hash);
+
+        for (unsigned step = 1; step <= groupMask + 1; ++step)
+        {
+            const unsigned first = group * FlatHashGroup::SIZE;
+            FlatHashGroup ctrl(ctrl_ + first);
+
+            for (unsigned mask = ctrl.Match(tag); mask; mask &= mask - 1)
+            {
+                unsigned index = first + FlatHashLowestBit(mask);
+                if (slots[index] == key)
+                    return index;
+            }
+
+            // The key would have been stored in the first group with an empty slot
+            if (ctrl.MatchEmpty())
+                break;
+
+            group = (group + step) & groupMask;
+        }
+
+        return capacity_;
+    }
+
+    /// Insert a key that is not in the set and return its slot index.
+    unsigned InsertIndex(const T& key, unsigned hash)
+    {
+        if (!growthLeft_)
+        {
+            // The key may refer to a key of this set which is going to move
+            T copy(key);
+            Grow();
+            return ConstructIndex(copy, hash);
+        }
+
+        return ConstructIndex(key, hash);
+    }
+
+    /// Construct a key in a free slot and return its index.
+    unsigned ConstructIndex(const T& key, unsigned hash)
+    {
+        unsigned index = FindFreeSlot(hash);
+        new(Slots() + index) T(key);
+        SetUsed(index, hash);
+        return index;
+    }
+
+    /// Destruct a key and free its slot.
+    void EraseIndex(unsigned index)
+    {
+        (Slots() + index)->~T();
+        SetFree(index);
+    }
+
+    /// Destruct all the keys.
+    void DestructSlots()
+    {
+        T* slots = Slots();
+        for (unsigned i = 0; i < capacity_; ++i)
+        {
+            if (ctrl_[i] >= 0)
+                (slots + i)->~T();
+        }
+    }
+
+    /// Make room for one more key : drop the erased slots if they are numerous enough, otherwise double the capacity.
+    void Grow()
+    {
+        if (!capacity_)
+            Rehash(MIN_CAPACITY);
+        else
+            Rehash(size_ < capacity_ * 7 / 16 ? capacity_ : capacity_ << 1);
+    }
+
+    /// Move the keys in a new table.
+    void Rehash(unsigned capacity)
+    {
+        const signed char* oldCtrl = ctrl_;
+        T* oldSlots = Slots();
+        const unsigned oldCapacity = capacity_;
+
+        void* oldTable = AllocateTable(capacity, sizeof(T));
+
+        for (unsigned i = 0; i < oldCapacity; ++i)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                ConstructIndex(oldSlots[i], MixHash(MakeHash(oldSlots[i])));
+                (oldSlots + i)->~T();
+            }
+        }
+
+        FreeTable(oldTable);
+    }
+};
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator begin(const Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FlatHashSet<T>::ConstIterator end(const Urho3D::FlatHashSet<T>& v) { return v.End(); }
+
+template <class T> typename Urho3D::FlatHashSet<T>::Iterator begin(Urho3D::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename Urho3D::FlatHashSet<T>::Iterator end(Urho3D::FlatHashSet<T>& v) { return v.End(); }
+
+}
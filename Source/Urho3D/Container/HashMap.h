@@ -35,6 +35,13 @@
 namespace Urho3D
 {
 
+/// FromBones : number of pairs reserved in one node block by a hash map on its first insertion.
+/// Specialized for the maps which are usually built with a few pairs, such as VariantMap, so that filling them does not grow the node allocator several times.
+template <class T, class U> struct HashMapSmallSize
+{
+    static const unsigned SIZE = 0;
+};
+
 /// Hash map template class.
 template <class T, class U> class HashMap : public HashBase
 {
@@ -665,6 +672,9 @@ private:
         {
             AllocateBuckets(Size(), MIN_BUCKETS);
             Rehash();
+            // Reserve the nodes of a small map and the tail node
+            if (HashMapSmallSize<T, U>::SIZE)
+                AllocatorReserveCapacity(allocator_, HashMapSmallSize<T, U>::SIZE + 1);
         }
 
         unsigned hashKey = Hash(key);
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Allocator.h"
 #include "../IO/Log.h"
 
 #include <cstdio>
@@ -437,34 +438,49 @@ String::Iterator String::Erase(const String::Iterator& start, const String::Iter
 
 void String::Resize(unsigned newLength)
 {
-    if (!capacity_)
+    if (buffer_ == &endZero)
     {
         // If zero length requested, do not allocate buffer yet
         if (!newLength)
             return;
 
-        // Calculate initial capacity
-        capacity_ = newLength + 1;
-        if (capacity_ < MIN_CAPACITY)
-            capacity_ = MIN_CAPACITY;
-
-        buffer_ = new char[capacity_];
+        if (newLength < INLINE_CAPACITY)
+        {
+            // Short strings use the inline buffer
+            buffer_ = inline_;
+        }
+        else
+        {
+            // Calculate initial capacity
+            unsigned capacity = newLength + 1;
+            if (capacity < MIN_CAPACITY)
+                capacity = MIN_CAPACITY;
+
+            buffer_ = new char[capacity];
+            capacity_ = capacity;
+            URHO3D_COUNT_CONTAINER_ALLOCATION(strings_);
+        }
     }
     else
     {
-        if (newLength && capacity_ < newLength + 1)
+        unsigned capacity = buffer_ == inline_ ? INLINE_CAPACITY : capacity_;
+        if (newLength && capacity < newLength + 1)
         {
             // Increase the capacity with half each time it is exceeded
-            while (capacity_ < newLength + 1)
-                capacity_ += (capacity_ + 1) >> 1;
+            while (capacity < newLength + 1)
+                capacity += (capacity + 1) >> 1;
 
-            char* newBuffer = new char[capacity_];
+            char* newBuffer = new char[capacity];
+            URHO3D_COUNT_CONTAINER_ALLOCATION(strings_);
             // Move the existing data to the new buffer, then delete the old buffer
             if (length_)
                 CopyChars(newBuffer, buffer_, length_);
-            delete[] buffer_;
+            if (IsHeapBuffer())
+                delete[] buffer_;
 
             buffer_ = newBuffer;
+            // The capacity shares its storage with the inline buffer : write it once the data has been moved
+            capacity_ = capacity;
         }
     }
 
@@ -476,13 +492,31 @@ void String::Reserve(unsigned newCapacity)
 {
     if (newCapacity < length_ + 1)
         newCapacity = length_ + 1;
-    if (newCapacity == capacity_)
+    if (newCapacity == Capacity())
         return;
 
+    const bool heapBuffer = IsHeapBuffer();
+
+    if (newCapacity <= INLINE_CAPACITY)
+    {
+        if (buffer_ == inline_)
+            return;
+
+        // Move the existing data to the inline buffer, then delete the old buffer
+        char* oldBuffer = buffer_;
+        CopyChars(inline_, oldBuffer, length_ + 1);
+        if (heapBuffer)
+            delete[] oldBuffer;
+
+        buffer_ = inline_;
+        return;
+    }
+
     char* newBuffer = new char[newCapacity];
+    URHO3D_COUNT_CONTAINER_ALLOCATION(strings_);
     // Move the existing data to the new buffer, then delete the old buffer
     CopyChars(newBuffer, buffer_, length_ + 1);
-    if (capacity_)
+    if (heapBuffer)
         delete[] buffer_;
 
     capacity_ = newCapacity;
@@ -491,7 +525,7 @@ void String::Reserve(unsigned newCapacity)
 
 void String::Compact()
 {
-    if (capacity_)
+    if (Capacity())
         Reserve(length_ + 1);
 }
 
@@ -502,9 +536,20 @@ void String::Clear()
 
 void String::Swap(String& str)
 {
+    // Swapping the inline buffers also swaps the capacities
+    char inlineBuffer[INLINE_CAPACITY];
+    memcpy(inlineBuffer, inline_, INLINE_CAPACITY);
+    memcpy(inline_, str.inline_, INLINE_CAPACITY);
+    memcpy(str.inline_, inlineBuffer, INLINE_CAPACITY);
+
     Urho3D::Swap(length_, str.length_);
-    Urho3D::Swap(capacity_, str.capacity_);
     Urho3D::Swap(buffer_, str.buffer_);
+
+    // Inline buffers stay in their string
+    if (buffer_ == str.inline_)
+        buffer_ = inline_;
+    if (str.buffer_ == inline_)
+        str.buffer_ = str.inline_;
 }
 
 String String::Substring(unsigned pos) const
@@ -158,7 +158,7 @@ public:
     /// Destruct.
     ~String()
     {
-        if (capacity_)
+        if (IsHeapBuffer())
             delete[] buffer_;
     }
 
@@ -412,7 +412,7 @@ public:
     unsigned Length() const { return length_; }
 
     /// Return buffer capacity.
-    unsigned Capacity() const { return capacity_; }
+    unsigned Capacity() const { return buffer_ == inline_ ? INLINE_CAPACITY : (buffer_ != &endZero ? capacity_ : 0); }
 
     /// Return whether the string is empty.
     bool Empty() const { return length_ == 0; }
@@ -493,10 +493,15 @@ public:
     static const unsigned NPOS = 0xffffffff;
     /// Initial dynamic allocation size.
     static const unsigned MIN_CAPACITY = 8;
+    /// FromBones : size of the inline buffer, including the end zero. Shorter strings are not allocated on the heap. The string keeps the size of 3 pointers so that it still fits in a Variant.
+    static const unsigned INLINE_CAPACITY = 2 * sizeof(void*) - sizeof(unsigned);
     /// Empty string.
     static const String EMPTY;
 
 private:
+    /// Return whether the buffer is allocated on the heap.
+    bool IsHeapBuffer() const { return buffer_ != &endZero && buffer_ != inline_; }
+
     /// Move a range of characters within the string.
     void MoveRange(unsigned dest, unsigned src, unsigned count)
     {
@@ -526,9 +531,14 @@ private:
 
     /// String length.
     unsigned length_;
-    /// Capacity, zero if buffer not allocated.
-    unsigned capacity_;
-    /// String buffer, point to &endZero if buffer is not allocated.
+    union
+    {
+        /// Capacity of a heap buffer, zero if buffer not allocated.
+        unsigned capacity_;
+        /// FromBones : inline buffer for short strings.
+        char inline_[INLINE_CAPACITY];
+    };
+    /// String buffer, point to &endZero if buffer is not allocated, or to inline_ for short strings.
     char* buffer_;
 
     /// End zero for empty strings.
@@ -99,6 +99,58 @@ void EventReceiverGroup::Remove(Object* object)
         receivers_.Remove(object);
 }
 
+void TypedEventReceiverGroup::EndSendEvent()
+{
+    assert(inSend_ > 0);
+    --inSend_;
+
+    if (inSend_ == 0 && dirty_)
+    {
+        // Keep the receiver order
+        for (unsigned i = receivers_.Size() - 1; i < receivers_.Size(); --i)
+        {
+            if (!receivers_[i].receiver_)
+                receivers_.Erase(i);
+        }
+
+        dirty_ = false;
+    }
+}
+
+void TypedEventReceiverGroup::Add(Object* receiver, Object* sender, TypedEventHandler* handler)
+{
+    TypedEventReceiver entry;
+    entry.receiver_ = receiver;
+    entry.sender_ = sender;
+    entry.handler_ = handler;
+    receivers_.Push(entry);
+
+    if (sender || (handler && handler->GetSender()))
+        ++numSpecific_;
+}
+
+void TypedEventReceiverGroup::Remove(Object* receiver, Object* sender, TypedEventHandler* handler)
+{
+    for (unsigned i = 0; i < receivers_.Size(); ++i)
+    {
+        TypedEventReceiver& entry = receivers_[i];
+        if (entry.receiver_ != receiver || entry.handler_ != handler || (!handler && entry.sender_ != sender))
+            continue;
+
+        if (sender || (handler && handler->GetSender()))
+            --numSpecific_;
+
+        if (inSend_ > 0)
+        {
+            entry.receiver_ = 0;
+            dirty_ = true;
+        }
+        else
+            receivers_.Erase(i);
+        return;
+    }
+}
+
 void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo> >& attributes, StringHash objectType, const char* name)
 {
     HashMap<StringHash, Vector<AttributeInfo> >::Iterator i = attributes.Find(objectType);
@@ -431,12 +483,29 @@ AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
 
 void Context::AddEventReceiver(Object* receiver, StringHash eventType)
 {
-    eventReceivers_[eventType].Insert(receiver);
+    bool exists;
+    eventReceivers_[eventType].Insert(receiver, exists);
+
+    // Also track the VariantMap receivers of typed events, so that typed sends reach them in subscription order
+    if (!exists && !typedEventReceivers_.Empty())
+    {
+        TypedEventReceiverGroup* group = GetTypedEventReceivers(EventNameRegistrar::GetTypedEventIndex(eventType));
+        if (group)
+            group->Add(receiver, 0, 0);
+    }
 }
 
 void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash eventType)
 {
-    specificEventReceivers_[sender][eventType].Insert(receiver);
+    bool exists;
+    specificEventReceivers_[sender][eventType].Insert(receiver, exists);
+
+    if (!exists && !typedEventReceivers_.Empty())
+    {
+        TypedEventReceiverGroup* group = GetTypedEventReceivers(EventNameRegistrar::GetTypedEventIndex(eventType));
+        if (group)
+            group->Add(receiver, sender, 0);
+    }
 }
 
 void Context::RemoveEventSender(Object* sender)
@@ -446,25 +515,113 @@ void Context::RemoveEventSender(Object* sender)
     {
         for (HashMap<StringHash, HashSet<Object*> >::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
         {
+            TypedEventReceiverGroup* group = typedEventReceivers_.Empty() ? 0 :
+                GetTypedEventReceivers(EventNameRegistrar::GetTypedEventIndex(j->first_));
             for (HashSet<Object*>::Iterator k = j->second_.Begin(); k != j->second_.End(); ++k)
+            {
+                if (group)
+                    group->Remove(*k, sender, 0);
                 (*k)->RemoveEventSender(sender);
+            }
         }
         specificEventReceivers_.Erase(i);
     }
+
+    HashMap<Object*, PODVector<TypedEventHandler*> >::Iterator t = specificTypedEventHandlers_.Find(sender);
+    if (t != specificTypedEventHandlers_.End())
+    {
+        PODVector<TypedEventHandler*> handlers = t->second_;
+        specificTypedEventHandlers_.Erase(t);
+
+        for (PODVector<TypedEventHandler*>::Iterator j = handlers.Begin(); j != handlers.End(); ++j)
+        {
+            TypedEventReceiverGroup* group = GetTypedEventReceivers((*j)->GetEventIndex());
+            if (group)
+                group->Remove((*j)->GetReceiver(), 0, *j);
+            (*j)->GetReceiver()->RemoveTypedEventHandler(*j);
+        }
+    }
 }
 
 void Context::RemoveEventReceiver(Object* receiver, StringHash eventType)
 {
     HashSet<Object*>* group = GetEventReceivers(eventType);
-    if (group)
-        group->Erase(receiver);
+    if (group && group->Erase(receiver) && !typedEventReceivers_.Empty())
+    {
+        TypedEventReceiverGroup* typedGroup = GetTypedEventReceivers(EventNameRegistrar::GetTypedEventIndex(eventType));
+        if (typedGroup)
+            typedGroup->Remove(receiver, 0, 0);
+    }
 }
 
 void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType)
 {
     HashSet<Object*>* group = GetEventReceivers(sender, eventType);
+    if (group && group->Erase(receiver) && !typedEventReceivers_.Empty())
+    {
+        TypedEventReceiverGroup* typedGroup = GetTypedEventReceivers(EventNameRegistrar::GetTypedEventIndex(eventType));
+        if (typedGroup)
+            typedGroup->Remove(receiver, sender, 0);
+    }
+}
+
+TypedEventReceiverGroup* Context::GetOrCreateTypedEventReceivers(unsigned eventIndex, StringHash eventType)
+{
+    if (eventIndex >= typedEventReceivers_.Size())
+        typedEventReceivers_.Resize(eventIndex + 1);
+
+    SharedPtr<TypedEventReceiverGroup>& group = typedEventReceivers_[eventIndex];
+    if (!group)
+    {
+        // Start with the VariantMap receivers subscribed before the event was first used as a typed event
+        group = new TypedEventReceiverGroup();
+
+        HashSet<Object*>* receivers = GetEventReceivers(eventType);
+        if (receivers)
+        {
+            for (HashSet<Object*>::Iterator i = receivers->Begin(); i != receivers->End(); ++i)
+                group->Add(*i, 0, 0);
+        }
+
+        for (HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificEventReceivers_.Begin();
+            i != specificEventReceivers_.End(); ++i)
+        {
+            HashMap<StringHash, HashSet<Object*> >::Iterator j = i->second_.Find(eventType);
+            if (j == i->second_.End())
+                continue;
+
+            for (HashSet<Object*>::Iterator k = j->second_.Begin(); k != j->second_.End(); ++k)
+                group->Add(*k, i->first_, 0);
+        }
+    }
+
+    return group;
+}
+
+void Context::AddTypedEventHandler(TypedEventHandler* handler)
+{
+    GetOrCreateTypedEventReceivers(handler->GetEventIndex(), handler->GetEventType())->Add(handler->GetReceiver(), 0, handler);
+
+    if (handler->GetSender())
+        specificTypedEventHandlers_[handler->GetSender()].Push(handler);
+}
+
+void Context::RemoveTypedEventHandler(TypedEventHandler* handler)
+{
+    TypedEventReceiverGroup* group = GetTypedEventReceivers(handler->GetEventIndex());
     if (group)
-        group->Erase(receiver);
+        group->Remove(handler->GetReceiver(), 0, handler);
+
+    if (handler->GetSender())
+    {
+        HashMap<Object*, PODVector<TypedEventHandler*> >::Iterator i = specificTypedEventHandlers_.Find(handler->GetSender());
+        if (i != specificTypedEventHandlers_.End())
+        {
+            i->second_.Remove(handler);
+            if (i->second_.Empty())
+                specificTypedEventHandlers_.Erase(i);
+        }
+    }
 }
 
 /*
@@ -62,6 +62,53 @@ private:
     bool dirty_;
 };
 
+/// FromBones : receiver entry of a typed event.
+struct TypedEventReceiver
+{
+    /// Receiver. Null if removed during send.
+    Object* receiver_;
+    /// Specific sender of a VariantMap handler. Null for non-specific and typed handlers.
+    Object* sender_;
+    /// Typed handler. Null for a VariantMap handler, which receives the typed event through OnEvent().
+    TypedEventHandler* handler_;
+};
+
+/// FromBones : tracking structure for the receivers of a typed event. Flat array of the typed and VariantMap receivers in subscription order, indexed by the typed event index so that sending needs no hashing.
+class URHO3D_API TypedEventReceiverGroup : public RefCounted
+{
+public:
+    /// Construct.
+    TypedEventReceiverGroup() :
+        numSpecific_(0),
+        inSend_(0),
+        dirty_(false)
+    {
+    }
+
+    /// Begin event send. When receivers are removed during send, group has to be cleaned up afterward.
+    void BeginSendEvent() { ++inSend_; }
+
+    /// End event send. Clean up if necessary.
+    void EndSendEvent();
+
+    /// Add a typed handler, or a VariantMap receiver when the handler is null.
+    void Add(Object* receiver, Object* sender, TypedEventHandler* handler);
+
+    /// Remove a typed handler, or a VariantMap receiver when the handler is null. Leave holes during send, which requires later cleanup.
+    void Remove(Object* receiver, Object* sender, TypedEventHandler* handler);
+
+    /// Receivers. May contain holes during sending.
+    PODVector<TypedEventReceiver> receivers_;
+    /// Number of receivers with a specific sender.
+    unsigned numSpecific_;
+
+private:
+    /// "In send" recursion counter.
+    unsigned inSend_;
+    /// Cleanup required flag.
+    bool dirty_;
+};
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class URHO3D_API Context : public RefCounted
 {
@@ -208,7 +255,19 @@ public:
         return i != eventReceivers_.End() ? &i->second_ : 0;
     }
 
+    /// Return the typed and VariantMap receivers of a typed event by its typed event index, or null if they are not tracked yet.
+    TypedEventReceiverGroup* GetTypedEventReceivers(unsigned eventIndex) const
+    {
+        return eventIndex < typedEventReceivers_.Size() ? typedEventReceivers_[eventIndex].Get() : 0;
+    }
+
 private:
+    /// Return the receivers of a typed event, creating the group with the existing VariantMap receivers if necessary.
+    TypedEventReceiverGroup* GetOrCreateTypedEventReceivers(unsigned eventIndex, StringHash eventType);
+    /// Add a typed event handler.
+    void AddTypedEventHandler(TypedEventHandler* handler);
+    /// Remove a typed event handler. Does not delete it.
+    void RemoveTypedEventHandler(TypedEventHandler* handler);
     /// Add event receiver.
     void AddEventReceiver(Object* receiver, StringHash eventType);
     /// Add event receiver for specific event.
@@ -243,6 +302,10 @@ private:
     HashMap<StringHash, HashSet<Object*> > eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > > specificEventReceivers_;
+    /// Typed event receivers by typed event index.
+    Vector<SharedPtr<TypedEventReceiverGroup> > typedEventReceivers_;
+    /// Typed event handlers by specific sender, removed when the sender is destroyed.
+    HashMap<Object*, PODVector<TypedEventHandler*> > specificTypedEventHandlers_;
     /// Event sender stack.
     PODVector<Object*> eventSenders_;
     /// Event data stack.
@@ -80,6 +80,7 @@ Object::Object(Context* context) :
 Object::~Object()
 {
     UnsubscribeFromAllEvents();
+    UnsubscribeFromAllTypedEvents();
 
     if (context_)
         context_->RemoveEventSender(this);
@@ -429,6 +430,151 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::AddTypedEventHandler(TypedEventHandler* handler)
+{
+    assert(context_);
+
+    // Remove old event handler first
+    TypedEventHandler* oldHandler = FindTypedEventHandler(handler->GetSender(), handler->GetEventType());
+    if (oldHandler)
+    {
+        context_->RemoveTypedEventHandler(oldHandler);
+        typedEventHandlers_.Remove(oldHandler);
+        delete oldHandler;
+    }
+
+    typedEventHandlers_.Push(handler);
+    context_->AddTypedEventHandler(handler);
+}
+
+void Object::RemoveTypedEventHandler(TypedEventHandler* handler)
+{
+    typedEventHandlers_.Remove(handler);
+    delete handler;
+}
+
+void Object::UnsubscribeFromTypedEvent(StringHash eventType)
+{
+    assert(context_);
+
+    for (unsigned i = typedEventHandlers_.Size() - 1; i < typedEventHandlers_.Size(); --i)
+    {
+        TypedEventHandler* handler = typedEventHandlers_[i];
+        if (handler->GetEventType() == eventType)
+        {
+            context_->RemoveTypedEventHandler(handler);
+            typedEventHandlers_.Erase(i);
+            delete handler;
+        }
+    }
+}
+
+void Object::UnsubscribeFromAllTypedEvents()
+{
+    if (typedEventHandlers_.Empty())
+        return;
+
+    assert(context_);
+
+    for (PODVector<TypedEventHandler*>::Iterator i = typedEventHandlers_.Begin(); i != typedEventHandlers_.End(); ++i)
+    {
+        context_->RemoveTypedEventHandler(*i);
+        delete *i;
+    }
+    typedEventHandlers_.Clear();
+}
+
+void Object::SendTypedEvent(unsigned eventIndex, StringHash eventType, const void* event, void (*fillEventData)(const void*, VariantMap&))
+{
+    assert(context_);
+
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+
+    // The group is created on the first send, with the VariantMap receivers subscribed so far. From then on it is found by index
+    Context* context = context_;
+    SharedPtr<TypedEventReceiverGroup> group(context->GetTypedEventReceivers(eventIndex));
+    if (!group)
+        group = context->GetOrCreateTypedEventReceivers(eventIndex, eventType);
+    if (group->receivers_.Empty())
+        return;
+
+    // Make a weak pointer to self to check for destruction during event handling
+    WeakPtr<Object> self(this);
+    // The event data map of this nesting level is only filled for the first VariantMap receiver
+    VariantMap& eventData = context->GetEventDataMap(false);
+    bool eventDataFilled = false;
+
+    context->BeginSendEvent(this);
+    group->BeginSendEvent();
+
+    // Receivers added during the send are not invoked, the removed ones leave holes
+    const unsigned numReceivers = group->receivers_.Size();
+    // Receivers of the specific handlers of this sender, which skip their non-specific handler of the same kind like SendEvent()
+    PODVector<Object*> specificTyped;
+    PODVector<Object*> specificVariant;
+
+    if (group->numSpecific_)
+    {
+        for (unsigned i = 0; i < numReceivers; ++i)
+        {
+            const TypedEventReceiver entry = group->receivers_[i];
+            if (!entry.receiver_ || (entry.handler_ ? entry.handler_->GetSender() : entry.sender_) != this)
+                continue;
+
+            (entry.handler_ ? specificTyped : specificVariant).Push(entry.receiver_);
+            InvokeTypedEventReceiver(entry, eventType, event, fillEventData, eventData, eventDataFilled);
+
+            // If self has been destroyed as a result of event handling, exit
+            if (self.Expired())
+            {
+                group->EndSendEvent();
+                context->EndSendEvent();
+                return;
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        const TypedEventReceiver entry = group->receivers_[i];
+        if (!entry.receiver_ || (entry.handler_ ? entry.handler_->GetSender() : entry.sender_))
+            continue;
+        if (entry.handler_ ? specificTyped.Contains(entry.receiver_) : specificVariant.Contains(entry.receiver_))
+            continue;
+
+        InvokeTypedEventReceiver(entry, eventType, event, fillEventData, eventData, eventDataFilled);
+
+        // If self has been destroyed as a result of event handling, exit
+        if (self.Expired())
+            break;
+    }
+
+    group->EndSendEvent();
+    context->EndSendEvent();
+}
+
+void Object::InvokeTypedEventReceiver(const TypedEventReceiver& entry, StringHash eventType, const void* event,
+    void (*fillEventData)(const void*, VariantMap&), VariantMap& eventData, bool& eventDataFilled)
+{
+    if (entry.handler_)
+    {
+        entry.handler_->Invoke(event);
+        return;
+    }
+
+    if (!eventDataFilled)
+    {
+        eventData.Clear();
+        fillEventData(event, eventData);
+        eventDataFilled = true;
+    }
+    entry.receiver_->OnEvent(this, eventType, eventData);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     assert(context_);
@@ -484,6 +630,17 @@ bool Object::HasSubscribedToEvent(Object* sender, StringHash eventType) const
         return FindSpecificEventHandler(sender, eventType) != 0;
 }
 
+bool Object::HasSubscribedToTypedEvent(StringHash eventType) const
+{
+    for (PODVector<TypedEventHandler*>::ConstIterator i = typedEventHandlers_.Begin(); i != typedEventHandlers_.End(); ++i)
+    {
+        if ((*i)->GetEventType() == eventType)
+            return true;
+    }
+
+    return false;
+}
+
 const String& Object::GetCategory() const
 {
     assert(context_);
@@ -551,6 +708,17 @@ EventHandler* Object::FindSpecificEventHandler(Object* sender, StringHash eventT
     return 0;
 }
 
+TypedEventHandler* Object::FindTypedEventHandler(Object* sender, StringHash eventType) const
+{
+    for (PODVector<TypedEventHandler*>::ConstIterator i = typedEventHandlers_.Begin(); i != typedEventHandlers_.End(); ++i)
+    {
+        if ((*i)->GetSender() == sender && (*i)->GetEventType() == eventType)
+            return *i;
+    }
+
+    return 0;
+}
+
 void Object::RemoveEventSender(Object* sender)
 {
     EventHandler* handler = eventHandlers_.First();
@@ -592,6 +760,32 @@ HashMap<StringHash, String>& EventNameRegistrar::GetEventNameMap()
     return eventNames_;
 }
 
+/// Return the typed event index map.
+static HashMap<StringHash, unsigned>& GetTypedEventIndexMap()
+{
+    static HashMap<StringHash, unsigned> typedEventIndices_;
+    return typedEventIndices_;
+}
+
+unsigned EventNameRegistrar::RegisterTypedEvent(StringHash eventID)
+{
+    HashMap<StringHash, unsigned>& typedEventIndices = GetTypedEventIndexMap();
+    HashMap<StringHash, unsigned>::ConstIterator it = typedEventIndices.Find(eventID);
+    if (it != typedEventIndices.End())
+        return it->second_;
+
+    const unsigned eventIndex = typedEventIndices.Size();
+    typedEventIndices[eventID] = eventIndex;
+    return eventIndex;
+}
+
+unsigned EventNameRegistrar::GetTypedEventIndex(StringHash eventID)
+{
+    HashMap<StringHash, unsigned>& typedEventIndices = GetTypedEventIndexMap();
+    HashMap<StringHash, unsigned>::ConstIterator it = typedEventIndices.Find(eventID);
+    return it != typedEventIndices.End() ? it->second_ : M_MAX_UNSIGNED;
+}
+
 StringHashRegister& GetEventNameRegister()
 {
     static StringHashRegister eventNameRegister(false /*non thread safe*/);
@@ -34,6 +34,8 @@ namespace Urho3D
 
 class Context;
 class EventHandler;
+class TypedEventHandler;
+struct TypedEventReceiver;
 
 /// Type info.
 class URHO3D_API TypeInfo
@@ -140,6 +142,18 @@ public:
     void SendEvent(StringHash eventType, VariantMap& eventData);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
+    /// Subscribe to a typed event that can be sent by any sender. The handler receives the event structure by reference, without VariantMap. A VariantMap handler of the same event is still invoked after it.
+    template <class T, class E> void SubscribeToTypedEvent(void (T::*function)(const E&));
+    /// Subscribe to a specific sender's typed event.
+    template <class T, class E> void SubscribeToTypedEvent(Object* sender, void (T::*function)(const E&));
+    /// Unsubscribe from a typed event.
+    template <class E> void UnsubscribeFromTypedEvent() { UnsubscribeFromTypedEvent(E::GetEventTypeStatic()); }
+    /// Unsubscribe from a typed event by event type.
+    void UnsubscribeFromTypedEvent(StringHash eventType);
+    /// Unsubscribe from all typed events.
+    void UnsubscribeFromAllTypedEvents();
+    /// Send a typed event to the typed and VariantMap subscribers in subscription order. The event data map is only filled when a VariantMap subscriber is reached.
+    template <class E> void SendTypedEvent(const E& event);
 #if URHO3D_CXX11
     /// Send event with variadic parameter pairs to all subscribers. The parameter pairs is a list of paramID and paramValue separated by comma, one pair after another.
     template <typename... Args> void SendEvent(StringHash eventType, Args... args)
@@ -167,8 +181,13 @@ public:
     /// Return whether has subscribed to a specific sender's event.
     bool HasSubscribedToEvent(Object* sender, StringHash eventType) const;
 
+    /// Return whether has subscribed to a typed event.
+    template <class E> bool HasSubscribedToTypedEvent() const { return HasSubscribedToTypedEvent(E::GetEventTypeStatic()); }
+    /// Return whether has subscribed to a typed event by event type.
+    bool HasSubscribedToTypedEvent(StringHash eventType) const;
+
     /// Return whether has subscribed to any event.
-    bool HasEventHandlers() const { return !eventHandlers_.Empty(); }
+    bool HasEventHandlers() const { return !eventHandlers_.Empty() || !typedEventHandlers_.Empty(); }
 
     /// Template version of returning a subsystem.
     template <class T> T* GetSubsystem() const;
@@ -188,9 +207,22 @@ private:
     EventHandler* FindSpecificEventHandler(Object* sender, StringHash eventType, EventHandler** previous = 0) const;
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Find the typed event handler with specific sender and event type.
+    TypedEventHandler* FindTypedEventHandler(Object* sender, StringHash eventType) const;
+    /// Add a typed event handler. Replace an existing handler for the same sender and event type.
+    void AddTypedEventHandler(TypedEventHandler* handler);
+    /// Remove and delete a typed event handler after the context has removed it from the receivers.
+    void RemoveTypedEventHandler(TypedEventHandler* handler);
+    /// Send a typed event by its typed event index, filling the event data map with the given function for the VariantMap subscribers.
+    void SendTypedEvent(unsigned eventIndex, StringHash eventType, const void* event, void (*fillEventData)(const void*, VariantMap&));
+    /// Invoke a typed event receiver entry, filling the event data map on first use for a VariantMap receiver.
+    void InvokeTypedEventReceiver(const TypedEventReceiver& entry, StringHash eventType, const void* event,
+        void (*fillEventData)(const void*, VariantMap&), VariantMap& eventData, bool& eventDataFilled);
 
     /// Event handlers. Sender is null for non-specific handlers.
     LinkedList<EventHandler> eventHandlers_;
+    /// Typed event handlers.
+    PODVector<TypedEventHandler*> typedEventHandlers_;
 };
 
 template <class T> T* Object::GetSubsystem() const { return static_cast<T*>(GetSubsystem(T::GetTypeStatic())); }
@@ -329,6 +361,75 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Internal helper class for invoking typed event handler functions.
+class URHO3D_API TypedEventHandler
+{
+public:
+    /// Construct with receiver, sender, event type and typed event index.
+    TypedEventHandler(Object* receiver, Object* sender, StringHash eventType, unsigned eventIndex) :
+        receiver_(receiver),
+        sender_(sender),
+        eventType_(eventType),
+        eventIndex_(eventIndex)
+    {
+    }
+
+    /// Destruct.
+    virtual ~TypedEventHandler() { }
+
+    /// Invoke event handler function with a pointer to the event structure.
+    virtual void Invoke(const void* event) = 0;
+
+    /// Return event receiver.
+    Object* GetReceiver() const { return receiver_; }
+
+    /// Return event sender. Null if the handler is non-specific.
+    Object* GetSender() const { return sender_; }
+
+    /// Return event type.
+    StringHash GetEventType() const { return eventType_; }
+
+    /// Return typed event index.
+    unsigned GetEventIndex() const { return eventIndex_; }
+
+protected:
+    /// Event receiver.
+    Object* receiver_;
+    /// Event sender.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Typed event index.
+    unsigned eventIndex_;
+};
+
+/// Template implementation of the typed event handler invoke helper (stores a function pointer of specific class.)
+template <class T, class E> class TypedEventHandlerImpl : public TypedEventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(const E&);
+
+    /// Construct with receiver, sender and function pointer.
+    TypedEventHandlerImpl(T* receiver, Object* sender, HandlerFunctionPtr function) :
+        TypedEventHandler(receiver, sender, E::GetEventTypeStatic(), E::GetTypedEventIndex()),
+        function_(function)
+    {
+        assert(receiver_);
+        assert(function_);
+    }
+
+    /// Invoke event handler function.
+    virtual void Invoke(const void* event)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(*static_cast<const E*>(event));
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
 #if URHO3D_CXX11
 /// Template implementation of the event handler invoke helper (std::function instance).
 class EventHandler11Impl : public EventHandler
@@ -360,6 +461,29 @@ private:
 };
 #endif
 
+template <class T, class E> void Object::SubscribeToTypedEvent(void (T::*function)(const E&))
+{
+    AddTypedEventHandler(new TypedEventHandlerImpl<T, E>(static_cast<T*>(this), 0, function));
+}
+
+template <class T, class E> void Object::SubscribeToTypedEvent(Object* sender, void (T::*function)(const E&))
+{
+    // If a null sender was specified, the event can not be subscribed to
+    if (sender)
+        AddTypedEventHandler(new TypedEventHandlerImpl<T, E>(static_cast<T*>(this), sender, function));
+}
+
+/// Fill the event data map from a typed event structure.
+template <class E> void FillTypedEventData(const void* event, VariantMap& eventData)
+{
+    static_cast<const E*>(event)->FillEventData(eventData);
+}
+
+template <class E> void Object::SendTypedEvent(const E& event)
+{
+    SendTypedEvent(E::GetTypedEventIndex(), E::GetEventTypeStatic(), &event, &FillTypedEventData<E>);
+}
+
 /// Register event names.
 struct URHO3D_API EventNameRegistrar
 {
@@ -369,6 +493,10 @@ struct URHO3D_API EventNameRegistrar
     static const String& GetEventName(StringHash eventID);
     /// Return Event name map.
     static HashMap<StringHash, String>& GetEventNameMap();
+    /// Register a typed event and return its index in the typed event receiver arrays. The same event type always returns the same index.
+    static unsigned RegisterTypedEvent(StringHash eventID);
+    /// Return the index of a typed event, or M_MAX_UNSIGNED if the event type has not been used as a typed event.
+    static unsigned GetTypedEventIndex(StringHash eventID);
 };
 
 /// Get register of event names.
@@ -378,6 +506,10 @@ URHO3D_API StringHashRegister& GetEventNameRegister();
 #define URHO3D_EVENT(eventID, eventName) static const Urho3D::StringHash eventID(Urho3D::EventNameRegistrar::RegisterEventName(#eventName)); namespace eventName
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
 #define URHO3D_PARAM(paramID, paramName) static const Urho3D::StringHash paramID(#paramName)
+/// Declare the static type accessors of a typed event structure. The structure must also define a "void FillEventData(VariantMap& eventData) const" method for the VariantMap subscribers.
+#define URHO3D_TYPEDEVENT(eventID) \
+    static Urho3D::StringHash GetEventTypeStatic() { return eventID; } \
+    static unsigned GetTypedEventIndex() { static const unsigned eventIndex = Urho3D::EventNameRegistrar::RegisterTypedEvent(eventID); return eventIndex; }
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function.
 #define URHO3D_HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
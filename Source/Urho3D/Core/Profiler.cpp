@@ -38,6 +38,10 @@ Profiler::Profiler(Context* context) :
     intervalFrames_(0)
 {
     current_ = root_ = new ProfilerBlock(0, "RunFrame");
+
+    memset(&frameStartAllocations_, 0, sizeof(ContainerAllocations));
+    memset(&frameAllocations_, 0, sizeof(ContainerAllocations));
+    memset(&intervalAllocations_, 0, sizeof(ContainerAllocations));
 }
 
 Profiler::~Profiler()
@@ -53,6 +57,8 @@ void Profiler::BeginFrame()
         EndFrame();
 
     root_->Begin();
+
+    frameStartAllocations_ = GetContainerAllocations();
 }
 
 void Profiler::EndFrame()
@@ -61,12 +67,64 @@ void Profiler::EndFrame()
     ++intervalFrames_;
     root_->EndFrame();
     current_ = root_;
+
+    const ContainerAllocations& allocations = GetContainerAllocations();
+    frameAllocations_.strings_ = allocations.strings_ - frameStartAllocations_.strings_;
+    frameAllocations_.hashBuckets_ = allocations.hashBuckets_ - frameStartAllocations_.hashBuckets_;
+    frameAllocations_.allocatorBlocks_ = allocations.allocatorBlocks_ - frameStartAllocations_.allocatorBlocks_;
+    intervalAllocations_.strings_ += frameAllocations_.strings_;
+    intervalAllocations_.hashBuckets_ += frameAllocations_.hashBuckets_;
+    intervalAllocations_.allocatorBlocks_ += frameAllocations_.allocatorBlocks_;
+
+    for (Vector<ProfilerCounter>::Iterator i = counters_.Begin(); i != counters_.End(); ++i)
+    {
+        i->frameValue_ = i->value_;
+        i->intervalValue_ += i->value_;
+        i->value_ = 0;
+    }
 }
 
 void Profiler::BeginInterval()
 {
     root_->BeginInterval();
     intervalFrames_ = 0;
+    memset(&intervalAllocations_, 0, sizeof(ContainerAllocations));
+
+    for (Vector<ProfilerCounter>::Iterator i = counters_.Begin(); i != counters_.End(); ++i)
+        i->intervalValue_ = 0;
+}
+
+void Profiler::AddCounter(const char* name, unsigned value)
+{
+    if (!Thread::IsMainThread())
+        return;
+
+    for (Vector<ProfilerCounter>::Iterator i = counters_.Begin(); i != counters_.End(); ++i)
+    {
+        if (i->name_ == name)
+        {
+            i->value_ += value;
+            return;
+        }
+    }
+
+    ProfilerCounter counter;
+    counter.name_ = name;
+    counter.value_ = value;
+    counter.frameValue_ = 0;
+    counter.intervalValue_ = 0;
+    counters_.Push(counter);
+}
+
+unsigned Profiler::GetFrameCounter(const char* name) const
+{
+    for (Vector<ProfilerCounter>::ConstIterator i = counters_.Begin(); i != counters_.End(); ++i)
+    {
+        if (i->name_ == name)
+            return i->frameValue_;
+    }
+
+    return 0;
 }
 
 const String& Profiler::PrintData(bool showUnused, bool showTotal, unsigned maxDepth) const
@@ -86,6 +144,25 @@ const String& Profiler::PrintData(bool showUnused, bool showTotal, unsigned maxD
 
     PrintData(root_, output, 0, maxDepth, showUnused, showTotal);
 
+    // Container allocations per frame in the interval
+    const unsigned frames = intervalFrames_ ? intervalFrames_ : 1;
+    char line[256];
+    sprintf(line, "\nAllocations/frame : strings %u hashbuckets %u allocatorblocks %u\n", intervalAllocations_.strings_ / frames,
+        intervalAllocations_.hashBuckets_ / frames, intervalAllocations_.allocatorBlocks_ / frames);
+    output += String(line);
+
+    // Named counters per frame in the interval
+    if (!counters_.Empty())
+    {
+        output += "Counters/frame :";
+        for (Vector<ProfilerCounter>::ConstIterator i = counters_.Begin(); i != counters_.End(); ++i)
+        {
+            sprintf(line, " %s %u", i->name_.CString(), i->intervalValue_ / frames);
+            output += String(line);
+        }
+        output += "\n";
+    }
+
     return output;
 }
 
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/Allocator.h"
 #include "../Container/Str.h"
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
@@ -186,6 +187,19 @@ public:
     unsigned totalCount_;
 };
 
+/// FromBones : named counter of the profiler, for example lock contentions.
+struct ProfilerCounter
+{
+    /// Counter name.
+    String name_;
+    /// Value on current frame.
+    unsigned value_;
+    /// Value on the previous frame.
+    unsigned frameValue_;
+    /// Value during current profiler interval.
+    unsigned intervalValue_;
+};
+
 /// Hierarchical performance profiler subsystem.
 class URHO3D_API Profiler : public Object
 {
@@ -225,6 +239,8 @@ public:
     void EndFrame();
     /// Begin a new interval.
     void BeginInterval();
+    /// FromBones : Add to a named counter on current frame. Can be called only from the main thread.
+    void AddCounter(const char* name, unsigned value);
 
     /// Return profiling data as text output. This method is not thread-safe.
     const String& PrintData(bool showUnused = false, bool showTotal = false, unsigned maxDepth = M_MAX_UNSIGNED) const;
@@ -232,6 +248,12 @@ public:
     const ProfilerBlock* GetCurrentBlock() { return current_; }
     /// Return the root profiling block.
     const ProfilerBlock* GetRootBlock() { return root_; }
+    /// FromBones : return the container allocations of the last frame.
+    const ContainerAllocations& GetFrameAllocations() const { return frameAllocations_; }
+    /// FromBones : return the value of a named counter on the previous frame.
+    unsigned GetFrameCounter(const char* name) const;
+    /// FromBones : return the named counters.
+    const Vector<ProfilerCounter>& GetCounters() const { return counters_; }
 
 protected:
     /// Return profiling data as text output for a specified profiling block.
@@ -243,6 +265,14 @@ protected:
     ProfilerBlock* root_;
     /// Frames in the current interval.
     unsigned intervalFrames_;
+    /// FromBones : container allocation counters at the beginning of the frame.
+    ContainerAllocations frameStartAllocations_;
+    /// FromBones : container allocations of the last frame.
+    ContainerAllocations frameAllocations_;
+    /// FromBones : container allocations in the current interval.
+    ContainerAllocations intervalAllocations_;
+    /// FromBones : named counters.
+    Vector<ProfilerCounter> counters_;
 };
 
 /// Helper class for automatically beginning and ending a profiling block
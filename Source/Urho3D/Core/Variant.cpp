@@ -30,6 +30,9 @@
 namespace Urho3D
 {
 
+static_assert(sizeof(String) <= sizeof(VariantValue) && sizeof(ResourceRef) <= sizeof(VariantValue) && sizeof(VariantMap) <= sizeof(VariantValue),
+    "String, ResourceRef and VariantMap must fit in the variant value");
+
 String ResourceRef::ToString() const
 {
     String str(type_.Value());
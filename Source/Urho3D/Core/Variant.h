@@ -112,6 +112,12 @@ typedef Vector<String> StringVector;
 /// Map of variants.
 typedef HashMap<StringHash, Variant> VariantMap;
 
+/// FromBones : small-map mode of the variant maps. Event data and attribute sets usually hold a few pairs : reserve their nodes in one block.
+template <> struct HashMapSmallSize<StringHash, Variant>
+{
+    static const unsigned SIZE = 8;
+};
+
 /// Typed resource reference.
 struct URHO3D_API ResourceRef
 {
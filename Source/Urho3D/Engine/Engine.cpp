@@ -297,6 +297,7 @@ bool Engine::Initialize(const VariantMap& parameters)
 
         if (GetParameter(parameters, EP_SOUND, true).GetBool())
         {
+            GetSubsystem<Audio>()->SetMixThread(GetParameter(parameters, EP_SOUND_MIX_THREAD, false).GetBool());
             GetSubsystem<Audio>()->SetMode(
                 GetParameter(parameters, EP_SOUND_BUFFER, 100).GetInt(),
                 GetParameter(parameters, EP_SOUND_MIX_RATE, 44100).GetInt(),
@@ -657,10 +658,10 @@ void Engine::DumpResources(bool dumpFileName)
         URHO3D_LOGRAW("Used resources:\n");
         for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups.Begin(); i != resourceGroups.End(); ++i)
         {
-            const HashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
+            const FlatHashMap<StringHash, SharedPtr<Resource> >& resources = i->second_.resources_;
             if (dumpFileName)
             {
-                for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
+                for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = resources.Begin(); j != resources.End(); ++j)
                     URHO3D_LOGRAW(j->second_->GetName() + "\n");
             }
         }
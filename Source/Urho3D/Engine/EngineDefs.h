@@ -57,6 +57,7 @@ static const String EP_SOUND = "Sound";
 static const String EP_SOUND_BUFFER = "SoundBuffer";
 static const String EP_SOUND_INTERPOLATION = "SoundInterpolation";
 static const String EP_SOUND_MIX_RATE = "SoundMixRate";
+static const String EP_SOUND_MIX_THREAD = "SoundMixThread";
 static const String EP_SOUND_STEREO = "SoundStereo";
 static const String EP_TEXTURE_ANISOTROPY = "TextureAnisotropy";
 static const String EP_TEXTURE_FILTER_MODE = "TextureFilterMode";
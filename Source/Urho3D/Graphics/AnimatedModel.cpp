@@ -135,6 +135,15 @@ bool AnimatedModel::Load(Deserializer& source, bool setInstanceDefault, bool app
     return success;
 }
 
+bool AnimatedModel::LoadValues(const PODVector<unsigned>& attributeIndices, const Variant* values, bool setInstanceDefault)
+{
+    loading_ = true;
+    bool success = Component::LoadValues(attributeIndices, values, setInstanceDefault);
+    loading_ = false;
+
+    return success;
+}
+
 bool AnimatedModel::LoadXML(const XMLElement& source, bool setInstanceDefault, bool applyAttr)
 {
     loading_ = true;
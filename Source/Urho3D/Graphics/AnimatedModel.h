@@ -49,6 +49,8 @@ public:
 
     /// Load from binary data. Return true if successful.
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false, bool applyAttr = true);
+    /// FromBones : load from attribute values decoded beforehand. Return true if successful.
+    virtual bool LoadValues(const PODVector<unsigned>& attributeIndices, const Variant* values, bool setInstanceDefault = false);
     /// Load from XML data. Return true if successful.
     virtual bool LoadXML(const XMLElement& source, bool setInstanceDefault = false, bool applyAttr = true);
     /// Load from JSON data. Return true if successful.
@@ -27,6 +27,12 @@
 namespace Urho3D
 {
 
+class Camera;
+class RenderSurface;
+class Scene;
+class Texture;
+class View;
+
 /// New screen mode set.
 URHO3D_EVENT(E_SCREENMODE, ScreenMode)
 {
@@ -76,6 +82,26 @@ URHO3D_EVENT(E_BEGINVIEWUPDATE, BeginViewUpdate)
     URHO3D_PARAM(P_CAMERA, Camera);                // Camera pointer
 }
 
+/// Typed update of a view started, sent by Renderer as E_BEGINVIEWUPDATE.
+struct URHO3D_API BeginViewUpdateEvent
+{
+    URHO3D_TYPEDEVENT(E_BEGINVIEWUPDATE)
+
+    /// Fill the event data for the VariantMap subscribers.
+    void FillEventData(VariantMap& eventData) const;
+
+    /// View.
+    View* view_;
+    /// Texture.
+    Texture* texture_;
+    /// Render surface.
+    RenderSurface* surface_;
+    /// Scene.
+    Scene* scene_;
+    /// Camera.
+    Camera* camera_;
+};
+
 /// Update of a view ended.
 URHO3D_EVENT(E_ENDVIEWUPDATE, EndViewUpdate)
 {
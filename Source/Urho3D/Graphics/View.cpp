@@ -582,7 +582,8 @@ void View::Update(const FrameInfo& frame)
 
     using namespace BeginViewUpdate;
 
-    SendViewEvent(E_BEGINVIEWUPDATE);
+    BeginViewUpdateEvent beginViewUpdate = { this, renderTarget_ ? renderTarget_->GetParentTexture() : 0, renderTarget_, scene_, cullCamera_ };
+    renderer_->SendTypedEvent(beginViewUpdate);
 
     int maxSortedInstances = renderer_->GetMaxSortedInstances();
 
@@ -3355,6 +3356,17 @@ RenderSurface* View::GetRenderSurfaceFromTexture(Texture* texture, CubeMapFace f
         return 0;
 }
 
+void BeginViewUpdateEvent::FillEventData(VariantMap& eventData) const
+{
+    using namespace BeginViewUpdate;
+
+    eventData[P_VIEW] = view_;
+    eventData[P_SURFACE] = surface_;
+    eventData[P_TEXTURE] = texture_;
+    eventData[P_SCENE] = scene_;
+    eventData[P_CAMERA] = camera_;
+}
+
 void View::SendViewEvent(StringHash eventType)
 {
     using namespace BeginViewRender;
@@ -0,0 +1,644 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifdef URHO3D_THREADING
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Timer.h"
+#include "../IO/AsyncFileReader.h"
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+
+#if defined(__linux__) && !defined(__ANDROID__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URHO3D_IO_URING
+#endif
+#endif
+
+#ifdef URHO3D_IO_URING
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+#ifdef URHO3D_IO_URING
+/// Number of entries of the io_uring submission queue, which is also the maximum number of reads in flight.
+static const unsigned RING_ENTRIES = 64;
+
+/// Thread waiting for the io_uring completions.
+class AsyncFileReaderRingThread : public Thread
+{
+public:
+    /// Construct.
+    AsyncFileReaderRingThread(AsyncFileReader* reader) :
+        reader_(reader)
+    {
+    }
+
+    /// Process the completions until shut down.
+    virtual void ThreadFunction()
+    {
+        reader_->ProcessCompletions();
+    }
+
+private:
+    /// Asynchronous file reader.
+    AsyncFileReader* reader_;
+};
+
+/// io_uring and its mapped queues.
+struct AsyncFileReaderRing
+{
+    /// io_uring file descriptor.
+    int ringHandle_;
+    /// Mapped submission queue ring.
+    void* sqRing_;
+    /// Size of the mapped submission queue ring.
+    size_t sqRingSize_;
+    /// Mapped completion queue ring, same as the submission queue ring when mapped together.
+    void* cqRing_;
+    /// Size of the mapped completion queue ring.
+    size_t cqRingSize_;
+    /// Mapped submission queue entries.
+    io_uring_sqe* sqes_;
+    /// Size of the mapped submission queue entries.
+    size_t sqesSize_;
+    /// Submission queue head, advanced by the kernel.
+    unsigned* sqHead_;
+    /// Submission queue tail.
+    unsigned* sqTail_;
+    /// Submission queue index mask.
+    unsigned sqMask_;
+    /// Submission queue entry indices.
+    unsigned* sqArray_;
+    /// Number of submission queue entries.
+    unsigned sqEntries_;
+    /// Completion queue head.
+    unsigned* cqHead_;
+    /// Completion queue tail, advanced by the kernel.
+    unsigned* cqTail_;
+    /// Completion queue index mask.
+    unsigned cqMask_;
+    /// Completion queue entries.
+    io_uring_cqe* cqes_;
+    /// Mutex for the submissions.
+    Mutex mutex_;
+    /// Number of reads submitted and not completed yet.
+    unsigned numInFlight_;
+    /// Requests waiting for a free submission queue entry.
+    List<AsyncReadRequest*> waiting_;
+    /// Completion thread.
+    AsyncFileReaderRingThread* thread_;
+};
+
+static int SetupRing(unsigned entries, io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int EnterRing(int ringHandle, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ringHandle, toSubmit, minComplete, flags, (void*)0, (size_t)0);
+}
+#endif
+
+AsyncFileReaderWorker::AsyncFileReaderWorker(AsyncFileReader* reader) :
+    reader_(reader)
+{
+}
+
+void AsyncFileReaderWorker::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        // Sleep until a request is queued
+        if (!reader_->ReadNextRequest())
+            wakeCondition_.Wait();
+    }
+}
+
+void AsyncFileReaderWorker::StopReading()
+{
+    shouldRun_ = false;
+    wakeCondition_.Set();
+    Stop();
+}
+
+AsyncFileReader::AsyncFileReader(Context* context) :
+    context_(context),
+    numThreads_(2),
+    numPending_(0),
+    started_(false),
+    waitingIdle_(false),
+    ring_(0)
+{
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    // Finish the reads in flight, as the kernel or the reading threads would write to the requests.
+    // Read the queued requests in this thread, then sleep until the ones being read complete
+    while (ReadNextRequest())
+    {
+    }
+
+    bool waitIdle = false;
+    {
+        MutexLock lock(queueMutex_);
+        if (numPending_)
+        {
+            waitingIdle_ = true;
+            waitIdle = true;
+        }
+    }
+
+    if (waitIdle)
+        idleCondition_.Wait();
+
+    for (unsigned i = 0; i < workers_.Size(); ++i)
+        workers_[i]->StopReading();
+    workers_.Clear();
+#ifdef URHO3D_IO_URING
+    ShutdownRing();
+#endif
+}
+
+bool AsyncFileReader::Read(AsyncReadRequest* request)
+{
+    if (!request || request->fileName_.Empty())
+        return false;
+
+    request->data_.Reset();
+    request->bytesRead_ = 0;
+    request->success_ = false;
+    request->completed_ = false;
+
+    {
+        MutexLock lock(queueMutex_);
+        ++numPending_;
+
+        // Prefer io_uring, otherwise start the reading threads
+        if (!started_)
+        {
+            started_ = true;
+#ifdef URHO3D_IO_URING
+            if (!InitializeRing())
+#endif
+            {
+                Vector<SharedPtr<AsyncFileReaderWorker> > stoppedWorkers;
+                UpdateWorkers(stoppedWorkers);
+            }
+        }
+
+        if (!ring_)
+        {
+            request->queued_ = true;
+            queue_.Push(request);
+
+            // Wake up all the idle reading threads, the ones finding the queue empty wait again
+            for (unsigned i = 0; i < workers_.Size(); ++i)
+                workers_[i]->Wake();
+            return true;
+        }
+    }
+
+#ifdef URHO3D_IO_URING
+    if (!SubmitRequest(request))
+        CompleteRequest(request, false);
+#endif
+
+    return true;
+}
+
+SharedPtr<AsyncReadRequest> AsyncFileReader::Read(const String& fileName, unsigned offset, unsigned size,
+    void (*callback)(AsyncReadRequest*), void* aux)
+{
+    SharedPtr<AsyncReadRequest> request(new AsyncReadRequest());
+    request->fileName_ = fileName;
+    request->offset_ = offset;
+    request->size_ = size;
+    request->callback_ = callback;
+    request->aux_ = aux;
+
+    if (!Read(request))
+        request.Reset();
+
+    return request;
+}
+
+void AsyncFileReader::Wait(AsyncReadRequest* request)
+{
+    if (!request || request->completed_)
+        return;
+
+    // If no reading thread has claimed the request yet, read it in this thread rather than wait for one
+    Condition* condition = 0;
+    {
+        MutexLock lock(queueMutex_);
+        if (request->completed_)
+            return;
+
+        if (!request->queued_)
+        {
+            condition = new Condition();
+            request->completeCondition_ = condition;
+        }
+        else
+        {
+            queue_.Erase(queue_.Find(request));
+            request->queued_ = false;
+        }
+    }
+
+    if (!condition)
+    {
+        ReadRequest(request);
+        return;
+    }
+
+    // Sleep until CompleteRequest() sets the condition. It does so while holding the queue mutex, so the condition can be deleted once the mutex is acquired
+    condition->Wait();
+    {
+        MutexLock lock(queueMutex_);
+        request->completeCondition_ = 0;
+    }
+    delete condition;
+}
+
+void AsyncFileReader::SetNumThreads(unsigned num)
+{
+    Vector<SharedPtr<AsyncFileReaderWorker> > stoppedWorkers;
+
+    {
+        MutexLock lock(queueMutex_);
+
+        numThreads_ = Max(num, 1U);
+        if (started_ && !ring_)
+            UpdateWorkers(stoppedWorkers);
+    }
+
+    // Stop outside the lock, as a stopping thread may need it to finish the request it is reading
+    for (unsigned i = 0; i < stoppedWorkers.Size(); ++i)
+        stoppedWorkers[i]->StopReading();
+}
+
+unsigned AsyncFileReader::GetNumPendingRequests() const
+{
+    MutexLock lock(queueMutex_);
+    return numPending_;
+}
+
+bool AsyncFileReader::ReadNextRequest()
+{
+    AsyncReadRequest* request = 0;
+    {
+        MutexLock lock(queueMutex_);
+        if (!queue_.Empty())
+        {
+            request = queue_.Front();
+            request->queued_ = false;
+            queue_.PopFront();
+        }
+    }
+
+    if (!request)
+        return false;
+
+    ReadRequest(request);
+    return true;
+}
+
+void AsyncFileReader::ReadRequest(AsyncReadRequest* request)
+{
+    File file(context_, request->fileName_);
+    if (!file.IsOpen())
+    {
+        CompleteRequest(request, false);
+        return;
+    }
+
+    const unsigned fileSize = file.GetSize();
+    if (request->offset_ > fileSize)
+    {
+        URHO3D_LOGERROR("Read offset beyond the end of file " + request->fileName_);
+        CompleteRequest(request, false);
+        return;
+    }
+
+    if (request->size_ == M_MAX_UNSIGNED)
+        request->size_ = fileSize - request->offset_;
+    request->data_ = new unsigned char[Max(request->size_, 1U)];
+
+    file.Seek(request->offset_);
+    request->bytesRead_ = file.Read(request->data_.Get(), request->size_);
+    CompleteRequest(request, request->bytesRead_ == request->size_);
+}
+
+void AsyncFileReader::CompleteRequest(AsyncReadRequest* request, bool success)
+{
+    request->success_ = success;
+    if (request->callback_)
+        request->callback_(request);
+
+    // The request may be released as soon as it is completed, so it is not accessed after the mutex is unlocked
+    MutexLock lock(queueMutex_);
+    --numPending_;
+    request->completed_ = true;
+    if (request->completeCondition_)
+        request->completeCondition_->Set();
+    if (!numPending_ && waitingIdle_)
+        idleCondition_.Set();
+}
+
+void AsyncFileReader::UpdateWorkers(Vector<SharedPtr<AsyncFileReaderWorker> >& stoppedWorkers)
+{
+    while (workers_.Size() > numThreads_)
+    {
+        stoppedWorkers.Push(workers_.Back());
+        workers_.Pop();
+    }
+
+    while (workers_.Size() < numThreads_)
+    {
+        SharedPtr<AsyncFileReaderWorker> worker(new AsyncFileReaderWorker(this));
+        if (!worker->Run())
+        {
+            URHO3D_LOGERROR("Could not start asynchronous file reader thread");
+            break;
+        }
+
+        workers_.Push(worker);
+    }
+}
+
+#ifdef URHO3D_IO_URING
+bool AsyncFileReader::InitializeRing()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    // Not available on old kernels or when forbidden by a sandbox, the reading threads are used instead
+    int ringHandle = SetupRing(RING_ENTRIES, &params);
+    if (ringHandle < 0)
+        return false;
+
+    AsyncFileReaderRing* ring = new AsyncFileReaderRing();
+    ring->ringHandle_ = ringHandle;
+    ring->sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ring->sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+
+    const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+        ring->sqRingSize_ = ring->cqRingSize_ = Max(ring->sqRingSize_, ring->cqRingSize_);
+
+    ring->sqRing_ = mmap(0, ring->sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_SQ_RING);
+    ring->cqRing_ = singleMap ? ring->sqRing_ :
+        mmap(0, ring->cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_CQ_RING);
+    ring->sqes_ = (io_uring_sqe*)mmap(0, ring->sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_SQES);
+
+    if (ring->sqRing_ == MAP_FAILED || ring->cqRing_ == MAP_FAILED || ring->sqes_ == MAP_FAILED)
+    {
+        if (ring->sqRing_ != MAP_FAILED)
+            munmap(ring->sqRing_, ring->sqRingSize_);
+        if (!singleMap && ring->cqRing_ != MAP_FAILED)
+            munmap(ring->cqRing_, ring->cqRingSize_);
+        if (ring->sqes_ != MAP_FAILED)
+            munmap(ring->sqes_, ring->sqesSize_);
+        close(ringHandle);
+        delete ring;
+        return false;
+    }
+
+    unsigned char* sqRing = (unsigned char*)ring->sqRing_;
+    unsigned char* cqRing = (unsigned char*)ring->cqRing_;
+    ring->sqHead_ = (unsigned*)(sqRing + params.sq_off.head);
+    ring->sqTail_ = (unsigned*)(sqRing + params.sq_off.tail);
+    ring->sqMask_ = *(unsigned*)(sqRing + params.sq_off.ring_mask);
+    ring->sqArray_ = (unsigned*)(sqRing + params.sq_off.array);
+    ring->sqEntries_ = params.sq_entries;
+    ring->cqHead_ = (unsigned*)(cqRing + params.cq_off.head);
+    ring->cqTail_ = (unsigned*)(cqRing + params.cq_off.tail);
+    ring->cqMask_ = *(unsigned*)(cqRing + params.cq_off.ring_mask);
+    ring->cqes_ = (io_uring_cqe*)(cqRing + params.cq_off.cqes);
+    ring->numInFlight_ = 0;
+
+    ring_ = ring;
+    ring->thread_ = new AsyncFileReaderRingThread(this);
+    if (!ring->thread_->Run())
+    {
+        delete ring->thread_;
+        ring->thread_ = 0;
+        ShutdownRing();
+        return false;
+    }
+
+    URHO3D_LOGDEBUG("Asynchronous file reads use io_uring");
+    return true;
+}
+
+void AsyncFileReader::ShutdownRing()
+{
+    AsyncFileReaderRing* ring = ring_;
+    if (!ring)
+        return;
+
+    if (ring->thread_)
+    {
+        // Wake up the completion thread with a no-op that tells it to exit
+        {
+            MutexLock lock(ring->mutex_);
+            const unsigned tail = *ring->sqTail_;
+            const unsigned index = tail & ring->sqMask_;
+            io_uring_sqe* sqe = &ring->sqes_[index];
+            memset(sqe, 0, sizeof(io_uring_sqe));
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = 0;
+            ring->sqArray_[index] = index;
+            __atomic_store_n(ring->sqTail_, tail + 1, __ATOMIC_RELEASE);
+            EnterRing(ring->ringHandle_, tail + 1 - __atomic_load_n(ring->sqHead_, __ATOMIC_ACQUIRE), 0, 0);
+        }
+
+        ring->thread_->Stop();
+        delete ring->thread_;
+    }
+
+    munmap(ring->sqes_, ring->sqesSize_);
+    if (ring->cqRing_ != ring->sqRing_)
+        munmap(ring->cqRing_, ring->cqRingSize_);
+    munmap(ring->sqRing_, ring->sqRingSize_);
+    close(ring->ringHandle_);
+
+    delete ring;
+    ring_ = 0;
+}
+
+bool AsyncFileReader::SubmitRequest(AsyncReadRequest* request)
+{
+    int fileHandle = open(GetNativePath(request->fileName_).CString(), O_RDONLY | O_CLOEXEC);
+    if (fileHandle < 0)
+    {
+        URHO3D_LOGERROR("Could not open file " + request->fileName_);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fileHandle, &fileStat) || (unsigned long long)request->offset_ > (unsigned long long)fileStat.st_size)
+    {
+        URHO3D_LOGERROR("Read offset beyond the end of file " + request->fileName_);
+        close(fileHandle);
+        return false;
+    }
+
+    if (request->size_ == M_MAX_UNSIGNED)
+        request->size_ = (unsigned)Min((unsigned long long)fileStat.st_size - request->offset_, (unsigned long long)(M_MAX_UNSIGNED - 1));
+    request->data_ = new unsigned char[Max(request->size_, 1U)];
+
+    if (!request->size_)
+    {
+        close(fileHandle);
+        CompleteRequest(request, true);
+        return true;
+    }
+
+    request->fileHandle_ = fileHandle;
+
+    MutexLock lock(ring_->mutex_);
+    if (ring_->numInFlight_ < ring_->sqEntries_)
+    {
+        ++ring_->numInFlight_;
+        SubmitRead(request);
+    }
+    else
+        ring_->waiting_.Push(request);
+
+    return true;
+}
+
+void AsyncFileReader::SubmitRead(AsyncReadRequest* request)
+{
+    AsyncFileReaderRing* ring = ring_;
+
+    // Only the submitting thread writes the tail, the kernel advances the head as it consumes the entries
+    const unsigned tail = *ring->sqTail_;
+    const unsigned index = tail & ring->sqMask_;
+    io_uring_sqe* sqe = &ring->sqes_[index];
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = request->fileHandle_;
+    sqe->addr = (unsigned long long)(size_t)(request->data_.Get() + request->bytesRead_);
+    sqe->len = request->size_ - request->bytesRead_;
+    sqe->off = (unsigned long long)request->offset_ + request->bytesRead_;
+    sqe->user_data = (unsigned long long)(size_t)request;
+    ring->sqArray_[index] = index;
+    __atomic_store_n(ring->sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+    // Submit also the entries left by a previous interrupted call
+    EnterRing(ring->ringHandle_, tail + 1 - __atomic_load_n(ring->sqHead_, __ATOMIC_ACQUIRE), 0, 0);
+}
+
+void AsyncFileReader::ProcessCompletions()
+{
+    AsyncFileReaderRing* ring = ring_;
+
+    for (;;)
+    {
+        if (EnterRing(ring->ringHandle_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+        {
+            URHO3D_LOGERRORF("Waiting for io_uring completions failed with error %d", errno);
+            Time::Sleep(1);
+        }
+
+        bool shutDown = false;
+        unsigned head = *ring->cqHead_;
+        const unsigned tail = __atomic_load_n(ring->cqTail_, __ATOMIC_ACQUIRE);
+
+        while (head != tail)
+        {
+            const io_uring_cqe* cqe = &ring->cqes_[head & ring->cqMask_];
+            AsyncReadRequest* request = (AsyncReadRequest*)(size_t)cqe->user_data;
+            const int result = cqe->res;
+
+            // Free the completion entry before the request may be submitted again
+            ++head;
+            __atomic_store_n(ring->cqHead_, head, __ATOMIC_RELEASE);
+
+            if (!request)
+            {
+                shutDown = true;
+                continue;
+            }
+
+            if (result > 0)
+                request->bytesRead_ += (unsigned)result;
+
+            // Continue a partial or interrupted read
+            if ((result > 0 && request->bytesRead_ < request->size_) || result == -EINTR || result == -EAGAIN)
+            {
+                MutexLock lock(ring->mutex_);
+                SubmitRead(request);
+                continue;
+            }
+
+            close(request->fileHandle_);
+            request->fileHandle_ = -1;
+
+            {
+                MutexLock lock(ring->mutex_);
+                if (ring->waiting_.Empty())
+                    --ring->numInFlight_;
+                else
+                {
+                    SubmitRead(ring->waiting_.Front());
+                    ring->waiting_.PopFront();
+                }
+            }
+
+            // On errors, including reads not supported by older kernels, read with the blocking functions instead, which log the errors
+            if (result < 0)
+                ReadRequest(request);
+            else
+                CompleteRequest(request, request->bytesRead_ == request->size_);
+        }
+
+        if (shutDown)
+            break;
+    }
+}
+#endif
+
+}
+
+#endif
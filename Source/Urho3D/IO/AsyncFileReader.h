@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/ArrayPtr.h"
+#include "../Container/List.h"
+#include "../Container/Ptr.h"
+#include "../Container/RefCounted.h"
+#include "../Container/Str.h"
+#include "../Core/Condition.h"
+#include "../Core/Mutex.h"
+#include "../Core/Thread.h"
+
+namespace Urho3D
+{
+
+class AsyncFileReader;
+class Context;
+struct AsyncFileReaderRing;
+
+/// FromBones : asynchronous read of a filesystem file to memory.
+class URHO3D_API AsyncReadRequest : public RefCounted
+{
+public:
+    /// Construct.
+    AsyncReadRequest() :
+        offset_(0),
+        size_(M_MAX_UNSIGNED),
+        callback_(0),
+        aux_(0),
+        bytesRead_(0),
+        success_(false),
+        completed_(false),
+        fileHandle_(-1),
+        queued_(false),
+        completeCondition_(0)
+    {
+    }
+
+    /// Name of the file in the filesystem.
+    String fileName_;
+    /// Offset of the data to read from the beginning of the file.
+    unsigned offset_;
+    /// Number of bytes to read, M_MAX_UNSIGNED to read until the end of the file. Replaced by the actual number of bytes to read once reading starts.
+    unsigned size_;
+    /// Function called from the reading thread when the request completes, before the completed flag is set.
+    void (*callback_)(AsyncReadRequest* request);
+    /// Arbitrary data for the callback.
+    void* aux_;
+    /// Data read. Allocated by the reader.
+    SharedArrayPtr<unsigned char> data_;
+    /// Number of bytes read.
+    unsigned bytesRead_;
+    /// Whether the requested bytes were read.
+    bool success_;
+    /// Whether the request has completed, successfully or not.
+    volatile bool completed_;
+
+private:
+    friend class AsyncFileReader;
+
+    /// Operating system file descriptor while reading with io_uring.
+    int fileHandle_;
+    /// Whether waiting for a reading thread.
+    bool queued_;
+    /// Condition of the thread waiting for the completion in Wait(), null if none. Protected by the queue mutex.
+    Condition* completeCondition_;
+};
+
+/// FromBones : thread of the asynchronous file reader when io_uring is not available.
+class AsyncFileReaderWorker : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    AsyncFileReaderWorker(AsyncFileReader* reader);
+
+    /// Read the queued requests.
+    virtual void ThreadFunction();
+    /// Wake up the thread if it is waiting for requests.
+    void Wake() { wakeCondition_.Set(); }
+    /// Stop the thread after the request it is reading, waking it up if it is waiting.
+    void StopReading();
+
+private:
+    /// Asynchronous file reader.
+    AsyncFileReader* reader_;
+    /// Condition set when requests are queued or the thread should stop.
+    Condition wakeCondition_;
+};
+
+/// FromBones : reader of filesystem files in the background, so that many reads can be in flight while the calling threads do other work. Owned by FileSystem.
+/** On Linux, the reads are submitted to an io_uring and a single thread waits for their completion. Elsewhere, or when io_uring can not be used,
+    a pool of threads reads the queued requests with blocking reads. The requests must be kept referenced until completed.
+  */
+class URHO3D_API AsyncFileReader : public RefCounted
+{
+public:
+    /// Construct.
+    AsyncFileReader(Context* context);
+    /// Destruct. Wait for the reads in flight.
+    ~AsyncFileReader();
+
+    /// Queue a read request that is not in progress. Return false if the request is invalid. Can be called from any thread.
+    bool Read(AsyncReadRequest* request);
+    /// Queue the read of a file range and return the request. Return null if the read can not be queued. Can be called from any thread.
+    SharedPtr<AsyncReadRequest> Read(const String& fileName, unsigned offset = 0, unsigned size = M_MAX_UNSIGNED,
+        void (*callback)(AsyncReadRequest*) = 0, void* aux = 0);
+    /// Wait for a request to complete. A request still waiting for a reading thread is read in the calling thread. Only one thread at a time may wait for the same request.
+    void Wait(AsyncReadRequest* request);
+    /// Set number of reading threads when io_uring is not used. Default 2.
+    void SetNumThreads(unsigned num);
+
+    /// Return number of reading threads when io_uring is not used.
+    unsigned GetNumThreads() const { return numThreads_; }
+    /// Return number of requests not completed yet.
+    unsigned GetNumPendingRequests() const;
+    /// Return whether reads are submitted to an io_uring. Decided on the first read.
+    bool IsUsingIOUring() const { return ring_ != 0; }
+
+    /// Read the next queued request in the calling thread. Return false if there was none. Called from the reading threads.
+    bool ReadNextRequest();
+
+private:
+    /// Read a request with blocking reads in the calling thread.
+    void ReadRequest(AsyncReadRequest* request);
+    /// Mark a request completed and call its callback.
+    void CompleteRequest(AsyncReadRequest* request, bool success);
+    /// Start the missing reading threads, and move the ones exceeding the number of threads to the stopped threads. The queue mutex must be held.
+    void UpdateWorkers(Vector<SharedPtr<AsyncFileReaderWorker> >& stoppedWorkers);
+    /// Create the io_uring and its completion thread. Return true if successful.
+    bool InitializeRing();
+    /// Wait for the reads in flight and destroy the io_uring.
+    void ShutdownRing();
+    /// Open a request's file and submit its read to the io_uring. Return false if the request can not be read with io_uring.
+    bool SubmitRequest(AsyncReadRequest* request);
+    /// Submit the read of the remaining bytes of a request. The ring mutex must be held.
+    void SubmitRead(AsyncReadRequest* request);
+    /// Wait for and process the io_uring completions until shut down. Called from the completion thread.
+    void ProcessCompletions();
+
+    friend class AsyncFileReaderRingThread;
+
+    /// Execution context.
+    Context* context_;
+    /// Mutex for the request queue, the pending count and the reading threads.
+    mutable Mutex queueMutex_;
+    /// Requests waiting for a reading thread.
+    List<AsyncReadRequest*> queue_;
+    /// Reading threads.
+    Vector<SharedPtr<AsyncFileReaderWorker> > workers_;
+    /// Number of reading threads.
+    unsigned numThreads_;
+    /// Number of requests not completed yet.
+    unsigned numPending_;
+    /// Whether the first read has chosen between io_uring and the reading threads.
+    bool started_;
+    /// Condition set when the last pending request completes while the destructor waits.
+    Condition idleCondition_;
+    /// Whether the destructor waits for the pending requests.
+    bool waitingIdle_;
+    /// io_uring state, null if not used.
+    AsyncFileReaderRing* ring_;
+};
+
+}
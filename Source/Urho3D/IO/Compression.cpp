@@ -55,6 +55,42 @@ unsigned DecompressData(void* dest, const void* src, unsigned destSize)
         return (unsigned)LZ4_decompress_fast((const char*)src, (char*)dest, destSize);
 }
 
+unsigned CompressDataWithDictionary(void* dest, const void* src, unsigned srcSize, const void* dictionary, unsigned dictionarySize)
+{
+    if (!dest || !src || !srcSize)
+        return 0;
+    if (!dictionary || !dictionarySize)
+        return CompressData(dest, src, srcSize);
+
+    LZ4_streamHC_t* stream = LZ4_createStreamHC();
+    if (!stream)
+        return 0;
+
+    // Same compression level as CompressData()
+    LZ4_resetStreamHC(stream, 0);
+    LZ4_loadDictHC(stream, (const char*)dictionary, dictionarySize);
+    int destSize = LZ4_compress_HC_continue(stream, (const char*)src, (char*)dest, srcSize, LZ4_compressBound(srcSize));
+    LZ4_freeStreamHC(stream);
+
+    return destSize > 0 ? (unsigned)destSize : 0;
+}
+
+unsigned DecompressDataWithDictionary(void* dest, unsigned destSize, const void* src, unsigned srcSize, const void* dictionary, unsigned dictionarySize)
+{
+    if (!dest || !src || !destSize || !srcSize)
+        return 0;
+
+    // Only the end of the dictionary is within the window of the compressor
+    if (dictionarySize > MAX_COMPRESSION_DICTIONARY_SIZE)
+    {
+        dictionary = (const unsigned char*)dictionary + dictionarySize - MAX_COMPRESSION_DICTIONARY_SIZE;
+        dictionarySize = MAX_COMPRESSION_DICTIONARY_SIZE;
+    }
+
+    int size = LZ4_decompress_safe_usingDict((const char*)src, (char*)dest, srcSize, destSize, (const char*)dictionary, dictionary ? dictionarySize : 0);
+    return size == (int)destSize ? destSize : 0;
+}
+
 bool CompressStream(Serializer& dest, Deserializer& src)
 {
     unsigned srcSize = src.GetSize() - src.GetPosition();
@@ -35,12 +35,19 @@ class Deserializer;
 class Serializer;
 class VectorBuffer;
 
+/// FromBones : Maximum useful size of a compression dictionary, the LZ4 window size.
+static const unsigned MAX_COMPRESSION_DICTIONARY_SIZE = 65536;
+
 /// Estimate and return worst case LZ4 compressed output size in bytes for given input size.
 URHO3D_API unsigned EstimateCompressBound(unsigned srcSize);
 /// Compress data using the LZ4 algorithm and return the compressed data size. The needed destination buffer worst-case size is given by EstimateCompressBound().
 URHO3D_API unsigned CompressData(void* dest, const void* src, unsigned srcSize);
 /// Uncompress data using the LZ4 algorithm. The uncompressed data size must be known. Return the number of compressed data bytes consumed.
 URHO3D_API unsigned DecompressData(void* dest, const void* src, unsigned destSize);
+/// FromBones : Compress data using the LZ4 algorithm with a dictionary of content similar to the source, and return the compressed data size. Only the last MAX_COMPRESSION_DICTIONARY_SIZE bytes of the dictionary are used. The needed destination buffer worst-case size is given by EstimateCompressBound().
+URHO3D_API unsigned CompressDataWithDictionary(void* dest, const void* src, unsigned srcSize, const void* dictionary, unsigned dictionarySize);
+/// FromBones : Uncompress data compressed by CompressDataWithDictionary() using the same dictionary. The uncompressed data size must be known. Return the uncompressed data size, or zero if the compressed data is invalid.
+URHO3D_API unsigned DecompressDataWithDictionary(void* dest, unsigned destSize, const void* src, unsigned srcSize, const void* dictionary, unsigned dictionarySize);
 /// Compress a source stream (from current position to the end) to the destination stream using the LZ4 algorithm. Return true on success.
 URHO3D_API bool CompressStream(Serializer& dest, Deserializer& src);
 /// Decompress a compressed source stream produced using CompressStream() to the destination stream. Return true on success.
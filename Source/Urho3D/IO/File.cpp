@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Profiler.h"
+#include "../IO/Compression.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -78,7 +79,11 @@ File::File(Context* context) :
     checksum_(0),
     compressed_(false),
     readSyncNeeded_(false),
-    writeSyncNeeded_(false)
+    writeSyncNeeded_(false),
+    mappedData_(0),
+    blockSize_(0),
+    blockIndex_(M_MAX_UNSIGNED),
+    dictionary_(0)
 {
 }
 
@@ -95,7 +100,11 @@ File::File(Context* context, const String& fileName, FileMode mode) :
     checksum_(0),
     compressed_(false),
     readSyncNeeded_(false),
-    writeSyncNeeded_(false)
+    writeSyncNeeded_(false),
+    mappedData_(0),
+    blockSize_(0),
+    blockIndex_(M_MAX_UNSIGNED),
+    dictionary_(0)
 {
     Open(fileName, mode);
 }
@@ -113,7 +122,11 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
     checksum_(0),
     compressed_(false),
     readSyncNeeded_(false),
-    writeSyncNeeded_(false)
+    writeSyncNeeded_(false),
+    mappedData_(0),
+    blockSize_(0),
+    blockIndex_(M_MAX_UNSIGNED),
+    dictionary_(0)
 {
     Open(package, fileName);
 }
@@ -137,21 +150,106 @@ bool File::Open(PackageFile* package, const String& fileName)
     if (!entry)
         return false;
 
-    bool success = OpenInternal(package->GetName(), FILE_READ, true);
-    if (!success)
+    // Read a memory mapped package directly without opening the package file
+    const unsigned char* mappedData = package->GetEntryData(entry);
+    if (mappedData)
     {
-        URHO3D_LOGERROR("Could not open package file " + fileName);
-        return false;
+        Close();
+
+        mode_ = FILE_READ;
+        position_ = 0;
+        compressed_ = false;
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
+        package_ = package;
+        mappedData_ = mappedData;
+    }
+    else
+    {
+        bool success = OpenInternal(package->GetName(), FILE_READ, true);
+        if (!success)
+        {
+            URHO3D_LOGERROR("Could not open package file " + fileName);
+            return false;
+        }
     }
 
     fileName_ = fileName;
     offset_ = entry->offset_;
     checksum_ = entry->checksum_;
     size_ = entry->size_;
-    compressed_ = package->IsCompressed();
+    compressed_ = entry->compression_ == PACKAGE_COMPRESSION_LZ4_STREAM;
+
+    if (entry->compression_ == PACKAGE_COMPRESSION_LZ4_BLOCKS || entry->compression_ == PACKAGE_COMPRESSION_LZ4_DICTIONARY)
+    {
+        if (entry->compression_ == PACKAGE_COMPRESSION_LZ4_DICTIONARY)
+        {
+            package_ = package;
+            dictionary_ = &package->GetDictionary();
+        }
+
+        // Read the block table at the beginning of the package entry's data
+        blockSize_ = package->GetBlockSize();
+        blockOffsets_.Resize((size_ + blockSize_ - 1) / blockSize_ + 1);
+
+        const unsigned tableSize = blockOffsets_.Size() * sizeof(unsigned);
+        bool success = tableSize <= entry->packedSize_;
+        if (success)
+        {
+            if (mappedData_)
+                memcpy(&blockOffsets_[0], mappedData_, tableSize);
+            else
+            {
+                SeekInternal(offset_);
+                success = ReadInternal(&blockOffsets_[0], tableSize);
+            }
+        }
 
-    // Seek to beginning of package entry's file data
-    SeekInternal(offset_);
+        for (unsigned i = 0; success && i < blockOffsets_.Size() - 1; ++i)
+            success = blockOffsets_[i] <= blockOffsets_[i + 1] && blockOffsets_[i + 1] - blockOffsets_[i] <= (unsigned)LZ4_compressBound(blockSize_);
+        if (!success || blockOffsets_.Front() < tableSize || blockOffsets_.Back() > entry->packedSize_)
+        {
+            URHO3D_LOGERROR("Invalid block table in package file entry " + fileName);
+            Close();
+            return false;
+        }
+    }
+    else if (!mappedData_)
+    {
+        // Seek to beginning of package entry's file data
+        SeekInternal(offset_);
+    }
+
+    return true;
+}
+
+bool File::Open(const String& fileName, const SharedArrayPtr<unsigned char>& data, unsigned size, PackageFile* package)
+{
+    if (!data)
+        return false;
+
+    Close();
+
+    fileName_ = fileName;
+    mode_ = FILE_READ;
+    position_ = 0;
+    size_ = size;
+    offset_ = 0;
+    checksum_ = 0;
+    if (package)
+    {
+        const PackageEntry* entry = package->GetEntry(fileName);
+        if (entry && entry->compression_ == PACKAGE_COMPRESSION_NONE && entry->size_ == size)
+        {
+            offset_ = entry->offset_;
+            checksum_ = entry->checksum_;
+        }
+    }
+    compressed_ = false;
+    readSyncNeeded_ = false;
+    writeSyncNeeded_ = false;
+    memoryData_ = data;
+    mappedData_ = data.Get();
     return true;
 }
 
@@ -174,6 +272,39 @@ unsigned File::Read(void* dest, unsigned size)
     if (!size)
         return 0;
 
+    if (!blockOffsets_.Empty())
+    {
+        unsigned sizeLeft = size;
+        unsigned char* destPtr = (unsigned char*)dest;
+
+        while (sizeLeft)
+        {
+            // Blocks are compressed independently, so any block can be decompressed on demand
+            const unsigned index = position_ / blockSize_;
+            if (index != blockIndex_ && !ReadBlock(index))
+            {
+                URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                return size - sizeLeft;
+            }
+
+            const unsigned blockOffset = position_ - index * blockSize_;
+            unsigned copySize = Min(readBufferSize_ - blockOffset, sizeLeft);
+            memcpy(destPtr, readBuffer_.Get() + blockOffset, copySize);
+            destPtr += copySize;
+            sizeLeft -= copySize;
+            position_ += copySize;
+        }
+
+        return size;
+    }
+
+    if (mappedData_)
+    {
+        memcpy(dest, mappedData_ + position_, size);
+        position_ += size;
+        return size;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_ && !compressed_)
     {
@@ -282,6 +413,13 @@ unsigned File::Seek(unsigned position)
     if (mode_ == FILE_READ && position > size_)
         position = size_;
 
+    // Memory mapped and block compressed package entries seek without touching the file
+    if (mappedData_ || !blockOffsets_.Empty())
+    {
+        position_ = position;
+        return position_;
+    }
+
     if (compressed_)
     {
         // Start over from the beginning
@@ -357,9 +495,9 @@ unsigned File::GetChecksum()
     if (offset_ || checksum_)
         return checksum_;
 #ifdef __ANDROID__
-    if ((!handle_ && !assetHandle_) || mode_ == FILE_WRITE)
+    if ((!handle_ && !assetHandle_ && !memoryData_) || mode_ == FILE_WRITE)
 #else
-    if (!handle_ || mode_ == FILE_WRITE)
+    if ((!handle_ && !memoryData_) || mode_ == FILE_WRITE)
 #endif
         return 0;
 
@@ -393,11 +531,20 @@ void File::Close()
 
     readBuffer_.Reset();
     inputBuffer_.Reset();
+    blockOffsets_.Clear();
+    blockIndex_ = M_MAX_UNSIGNED;
+    dictionary_ = 0;
+    package_.Reset();
+    memoryData_.Reset();
 
-    if (handle_)
+    if (handle_ || mappedData_)
     {
-        fclose((FILE*)handle_);
-        handle_ = 0;
+        if (handle_)
+        {
+            fclose((FILE*)handle_);
+            handle_ = 0;
+        }
+        mappedData_ = 0;
         position_ = 0;
         size_ = 0;
         offset_ = 0;
@@ -419,9 +566,9 @@ void File::SetName(const String& name)
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || mappedData_ != 0 || assetHandle_ != 0;
 #else
-    return handle_ != 0;
+    return handle_ != 0 || mappedData_ != 0;
 #endif
 }
 
@@ -550,4 +697,45 @@ void File::SeekInternal(unsigned newPosition)
         fseek((FILE*)handle_, newPosition, SEEK_SET);
 }
 
+bool File::ReadBlock(unsigned index)
+{
+    const unsigned packedOffset = blockOffsets_[index];
+    const unsigned packedSize = blockOffsets_[index + 1] - packedOffset;
+    const unsigned unpackedSize = Min(size_ - index * blockSize_, blockSize_);
+
+    if (!readBuffer_)
+        readBuffer_ = new unsigned char[blockSize_];
+
+    const unsigned char* src = 0;
+    if (mappedData_)
+        src = mappedData_ + packedOffset;
+    else
+    {
+        if (!inputBuffer_)
+            inputBuffer_ = new unsigned char[LZ4_compressBound(blockSize_)];
+
+        SeekInternal(offset_ + packedOffset);
+        if (!ReadInternal(inputBuffer_.Get(), packedSize))
+            return false;
+        src = inputBuffer_.Get();
+    }
+
+    blockIndex_ = M_MAX_UNSIGNED;
+
+    // Blocks that did not shrink are stored uncompressed
+    if (packedSize == unpackedSize)
+        memcpy(readBuffer_.Get(), src, unpackedSize);
+    else if (dictionary_)
+    {
+        if (!DecompressDataWithDictionary(readBuffer_.Get(), unpackedSize, src, packedSize, &dictionary_->Front(), dictionary_->Size()))
+            return false;
+    }
+    else if (LZ4_decompress_safe((const char*)src, (char*)readBuffer_.Get(), (int)packedSize, (int)unpackedSize) != (int)unpackedSize)
+        return false;
+
+    blockIndex_ = index;
+    readBufferSize_ = unpackedSize;
+    return true;
+}
+
 }
@@ -88,6 +88,9 @@ public:
     bool Open(const String& fileName, FileMode mode = FILE_READ);
     /// Open from within a package file. Return true if successful.
     bool Open(PackageFile* package, const String& fileName);
+    /// FromBones : Open for reading data already read to memory, for example by AsyncFileReader. The data is kept referenced while open. Return true if successful.
+    /// When the data is the uncompressed entry fileName of a package, the file reports the entry's checksum and is packaged, like when opened from the package.
+    bool Open(const String& fileName, const SharedArrayPtr<unsigned char>& data, unsigned size, PackageFile* package = 0);
     /// Close the file.
     void Close();
     /// Flush any buffered output to the file.
@@ -107,6 +110,9 @@ public:
     /// Return whether the file originates from a package.
     bool IsPackaged() const { return offset_ != 0; }
 
+    /// FromBones : Return the file contents when read from an uncompressed entry of a memory mapped package or from memory, or null otherwise. A MemoryBuffer can read them without copying.
+    const unsigned char* GetMappedData() const { return blockOffsets_.Empty() ? mappedData_ : 0; }
+
 private:
     /// Open file internally using either C standard IO functions or SDL RWops for Android asset files. Return true if successful.
     bool OpenInternal(const String& fileName, FileMode mode, bool fromPackage = false);
@@ -114,6 +120,8 @@ private:
     bool ReadInternal(void* dest, unsigned size);
     /// Seek in file internally using either C standard IO functions or SDL RWops for Android asset files.
     void SeekInternal(unsigned newPosition);
+    /// FromBones : Decompress a block of a version 2 compressed package entry to the read buffer. Return true if successful.
+    bool ReadBlock(unsigned index);
 
     /// File name.
     String fileName_;
@@ -143,6 +151,20 @@ private:
     bool readSyncNeeded_;
     /// Synchronization needed before write -flag.
     bool writeSyncNeeded_;
+    /// FromBones : Package kept alive while reading from its memory mapping or with its compression dictionary.
+    SharedPtr<PackageFile> package_;
+    /// FromBones : Stored data of the package entry in the memory mapped package or data read to memory, or null.
+    const unsigned char* mappedData_;
+    /// FromBones : Data read to memory, kept referenced while open.
+    SharedArrayPtr<unsigned char> memoryData_;
+    /// FromBones : Offsets of the compressed blocks from the start of the package entry followed by the end offset. Empty unless reading a version 2 compressed package entry.
+    PODVector<unsigned> blockOffsets_;
+    /// FromBones : Uncompressed size of the compressed blocks.
+    unsigned blockSize_;
+    /// FromBones : Index of the block in the read buffer.
+    unsigned blockIndex_;
+    /// FromBones : Compression dictionary of the package entry, or null.
+    const PODVector<unsigned char>* dictionary_;
 };
 
 }
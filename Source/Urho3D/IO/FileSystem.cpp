@@ -27,6 +27,7 @@
 #include "../Core/CoreEvents.h"
 #include "../Core/Thread.h"
 #include "../Engine/EngineEvents.h"
+#include "../IO/AsyncFileReader.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/IOEvents.h"
@@ -290,6 +291,11 @@ FileSystem::FileSystem(Context* context) :
 {
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(FileSystem, HandleBeginFrame));
 
+#ifdef URHO3D_THREADING
+    // Its threads start on the first read
+    asyncFileReader_ = new AsyncFileReader(context_);
+#endif
+
     // Subscribe to console commands
     SetExecuteConsoleCommands(true);
 }
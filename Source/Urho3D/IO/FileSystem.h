@@ -30,6 +30,7 @@ namespace Urho3D
 {
 
 class AsyncExecRequest;
+class AsyncFileReader;
 
 /// Return files.
 static const unsigned SCAN_FILES = 0x1;
@@ -103,6 +104,8 @@ public:
     String GetAppPreferencesDir(const String& org, const String& app) const;
     /// Return path of temporary directory. Path always ends with a forward slash.
     String GetTemporaryDir() const;
+    /// FromBones : Return the asynchronous file reader. Null when threading is not supported.
+    AsyncFileReader* GetAsyncFileReader() const { return asyncFileReader_; }
 
 private:
     /// Scan directory, called internally.
@@ -121,6 +124,8 @@ private:
     unsigned nextAsyncExecID_;
     /// Flag for executing engine console commands as OS-specific system command. Default to true.
     bool executeConsoleCommands_;
+    /// FromBones : Asynchronous file reader.
+    SharedPtr<AsyncFileReader> asyncFileReader_;
 };
 
 /// Split a full path to path, filename and extension. The extension will be converted to lowercase by default.
@@ -22,10 +22,20 @@
 
 #include "../Precompiled.h"
 
+#include "../IO/Compression.h"
 #include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/PackageFile.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -34,7 +44,11 @@ PackageFile::PackageFile(Context* context) :
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
-    compressed_(false)
+    compressed_(false),
+    version_(1),
+    blockSize_(0),
+    mappedData_(0),
+    mappedSize_(0)
 {
 }
 
@@ -43,17 +57,29 @@ PackageFile::PackageFile(Context* context, const String& fileName, unsigned star
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
-    compressed_(false)
+    compressed_(false),
+    version_(1),
+    blockSize_(0),
+    mappedData_(0),
+    mappedSize_(0)
 {
     Open(fileName, startOffset);
 }
 
 PackageFile::~PackageFile()
 {
+    Unmap();
 }
 
 bool PackageFile::Open(const String& fileName, unsigned startOffset)
 {
+    Unmap();
+
+    // Forget the format of a previously opened package
+    version_ = 1;
+    blockSize_ = 0;
+    dictionary_.Clear();
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -61,7 +87,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     // Check ID, then read the directory
     file->Seek(startOffset);
     String id = file->ReadFileID();
-    if (id != "UPAK" && id != "ULZ4")
+    if (id != "UPAK" && id != "ULZ4" && id != "UPK2")
     {
         // If start offset has not been explicitly specified, also try to read package size from the end of file
         // to know how much we must rewind to find the package start
@@ -78,7 +104,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
             }
         }
 
-        if (id != "UPAK" && id != "ULZ4")
+        if (id != "UPAK" && id != "ULZ4" && id != "UPK2")
         {
             URHO3D_LOGERROR(fileName + " is not a valid package file");
             return false;
@@ -90,6 +116,16 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     totalSize_ = file->GetSize();
     compressed_ = id == "ULZ4";
 
+    if (id == "UPK2")
+    {
+        version_ = PACKAGE_VERSION2;
+        if (!ReadIndexVersion2(*file, startOffset))
+            return false;
+
+        Map();
+        return true;
+    }
+
     unsigned numFiles = file->ReadUInt();
     checksum_ = file->ReadUInt();
 
@@ -100,6 +136,8 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
         newEntry.offset_ = file->ReadUInt() + startOffset;
         totalDataSize_ += (newEntry.size_ = file->ReadUInt());
         newEntry.checksum_ = file->ReadUInt();
+        newEntry.packedSize_ = compressed_ ? 0 : newEntry.size_;
+        newEntry.compression_ = compressed_ ? PACKAGE_COMPRESSION_LZ4_STREAM : PACKAGE_COMPRESSION_NONE;
         if (!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_)
         {
             URHO3D_LOGERROR("File entry " + entryName + " outside package file");
@@ -155,4 +193,130 @@ const PackageEntry* PackageFile::GetEntry(const String& fileName) const
     return 0;
 }
 
+bool PackageFile::ReadIndexVersion2(File& file, unsigned startOffset)
+{
+    unsigned numFiles = file.ReadUInt();
+    checksum_ = file.ReadUInt();
+    blockSize_ = file.ReadUInt();
+
+    unsigned dictionarySize = file.ReadUInt();
+    if (dictionarySize > MAX_COMPRESSION_DICTIONARY_SIZE)
+    {
+        URHO3D_LOGERROR("Invalid compression dictionary in package file " + fileName_);
+        return false;
+    }
+    dictionary_.Resize(dictionarySize);
+    if (dictionarySize && file.Read(&dictionary_[0], dictionarySize) != dictionarySize)
+    {
+        URHO3D_LOGERROR("Could not read compression dictionary of package file " + fileName_);
+        return false;
+    }
+
+    // The index is sorted by name hash. The entries are still stored by name for GetEntries() and the case-insensitive fallback
+    for (unsigned i = 0; i < numFiles; ++i)
+    {
+        unsigned nameHash = file.ReadUInt();
+        String entryName = file.ReadString();
+        PackageEntry newEntry;
+        newEntry.offset_ = file.ReadUInt() + startOffset;
+        totalDataSize_ += (newEntry.size_ = file.ReadUInt());
+        newEntry.packedSize_ = file.ReadUInt();
+        newEntry.checksum_ = file.ReadUInt();
+        newEntry.compression_ = (PackageCompression)file.ReadUByte();
+
+        if (StringHash(entryName).Value() != nameHash)
+        {
+            URHO3D_LOGERROR("File entry " + entryName + " has a wrong name hash");
+            return false;
+        }
+        if (newEntry.offset_ + newEntry.packedSize_ > totalSize_ || newEntry.offset_ + newEntry.packedSize_ < newEntry.offset_)
+        {
+            URHO3D_LOGERROR("File entry " + entryName + " outside package file");
+            return false;
+        }
+        if (newEntry.compression_ == PACKAGE_COMPRESSION_LZ4_BLOCKS || newEntry.compression_ == PACKAGE_COMPRESSION_LZ4_DICTIONARY)
+        {
+            if (!blockSize_)
+            {
+                URHO3D_LOGERROR("File entry " + entryName + " is compressed but the package has no block size");
+                return false;
+            }
+            if (newEntry.compression_ == PACKAGE_COMPRESSION_LZ4_DICTIONARY && dictionary_.Empty())
+            {
+                URHO3D_LOGERROR("File entry " + entryName + " is compressed with a dictionary but the package has none");
+                return false;
+            }
+            compressed_ = true;
+        }
+        else if (newEntry.compression_ != PACKAGE_COMPRESSION_NONE || newEntry.packedSize_ != newEntry.size_)
+        {
+            URHO3D_LOGERROR("File entry " + entryName + " has an unsupported compression");
+            return false;
+        }
+
+        entries_[entryName] = newEntry;
+    }
+
+    return true;
+}
+
+void PackageFile::Map()
+{
+#ifdef __ANDROID__
+    // Android assets can not be mapped, read through the file instead
+    if (URHO3D_IS_ASSET(fileName_))
+        return;
+#endif
+
+    void* data = 0;
+
+#if defined(_WIN32)
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName_).CString(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, 0);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        // The view keeps the mapping alive once the handles are closed
+        HANDLE mappingHandle = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+        if (mappingHandle)
+        {
+            data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+    }
+#elif !defined(__EMSCRIPTEN__)
+    int fd = open(GetNativePath(fileName_).CString(), O_RDONLY);
+    if (fd >= 0)
+    {
+        data = mmap(0, totalSize_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+            data = 0;
+        close(fd);
+    }
+#endif
+
+    if (data)
+    {
+        mappedData_ = static_cast<const unsigned char*>(data);
+        mappedSize_ = totalSize_;
+    }
+    else
+        URHO3D_LOGDEBUG("Could not memory map package file " + fileName_ + ", reading from the file instead");
+}
+
+void PackageFile::Unmap()
+{
+    if (!mappedData_)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mappedData_);
+#elif !defined(__EMSCRIPTEN__)
+    munmap(const_cast<unsigned char*>(mappedData_), mappedSize_);
+#endif
+
+    mappedData_ = 0;
+    mappedSize_ = 0;
+}
+
 }
@@ -27,6 +27,21 @@
 namespace Urho3D
 {
 
+class File;
+
+/// FromBones : Compression of a package file entry.
+enum PackageCompression
+{
+    /// Stored as is.
+    PACKAGE_COMPRESSION_NONE = 0,
+    /// LZ4 blocks read sequentially, used by all the entries of a version 1 compressed package.
+    PACKAGE_COMPRESSION_LZ4_STREAM,
+    /// LZ4 blocks indexed by a block table for random access, used by version 2 packages.
+    PACKAGE_COMPRESSION_LZ4_BLOCKS,
+    /// LZ4 blocks indexed by a block table and compressed with the dictionary of the package, used by version 2 packages.
+    PACKAGE_COMPRESSION_LZ4_DICTIONARY
+};
+
 /// %File entry within the package file.
 struct PackageEntry
 {
@@ -36,9 +51,19 @@ struct PackageEntry
     unsigned size_;
     /// File checksum.
     unsigned checksum_;
+    /// FromBones : Size of the stored data including the block table, equal to size_ when not compressed. Zero when unknown (version 1 compressed package).
+    unsigned packedSize_;
+    /// FromBones : Compression of the stored data.
+    PackageCompression compression_;
 };
 
+/// FromBones : Package format version 2, with an index sorted by name hash, aligned entries and per-entry compression.
+static const unsigned PACKAGE_VERSION2 = 2;
+
 /// Stores files of a directory tree sequentially for convenient access.
+/** FromBones : Version 2 packages are memory mapped when possible. The uncompressed entries are then read without system calls and can be accessed directly with GetEntryData(),
+    and the compressed entries are split into independently compressed blocks so that they can be seeked.
+  */
 class URHO3D_API PackageFile : public Object
 {
     URHO3D_OBJECT(PackageFile, Object);
@@ -82,10 +107,32 @@ public:
     /// Return whether the files are compressed.
     bool IsCompressed() const { return compressed_; }
 
+    /// FromBones : Return the package format version.
+    unsigned GetVersion() const { return version_; }
+
+    /// FromBones : Return the uncompressed size of the blocks of the compressed entries in a version 2 package.
+    unsigned GetBlockSize() const { return blockSize_; }
+
+    /// FromBones : Return the compression dictionary shared by the entries of a version 2 package, or an empty buffer if none.
+    const PODVector<unsigned char>& GetDictionary() const { return dictionary_; }
+
+    /// FromBones : Return whether the package is memory mapped.
+    bool IsMapped() const { return mappedData_ != 0; }
+
+    /// FromBones : Return the stored data of an entry when the package is memory mapped, or null otherwise. The data is compressed if the entry is.
+    const unsigned char* GetEntryData(const PackageEntry* entry) const { return mappedData_ && entry ? mappedData_ + entry->offset_ : 0; }
+
     /// Return list of file names in the package.
     const Vector<String> GetEntryNames() const { return entries_.Keys(); }
 
 private:
+    /// FromBones : Read the version 2 header and index. The file must be positioned after the ID.
+    bool ReadIndexVersion2(File& file, unsigned startOffset);
+    /// FromBones : Memory map the package file.
+    void Map();
+    /// FromBones : Unmap the package file.
+    void Unmap();
+
     /// File entries.
     HashMap<String, PackageEntry> entries_;
     /// File name.
@@ -100,6 +147,16 @@ private:
     unsigned checksum_;
     /// Compressed flag.
     bool compressed_;
+    /// FromBones : Package format version.
+    unsigned version_;
+    /// FromBones : Uncompressed block size of the compressed entries (version 2.)
+    unsigned blockSize_;
+    /// FromBones : Compression dictionary (version 2.)
+    PODVector<unsigned char> dictionary_;
+    /// FromBones : Memory mapped package file, or null.
+    const unsigned char* mappedData_;
+    /// FromBones : Size of the memory mapped package file.
+    unsigned mappedSize_;
 };
 
 }
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../Navigation/CrowdAgent.h"
@@ -45,12 +46,29 @@ extern const char* NAVIGATION_CATEGORY;
 
 static const unsigned DEFAULT_MAX_AGENTS = 512;
 static const float DEFAULT_MAX_AGENT_RADIUS = 0.f;
+static const int DEFAULT_PATH_ITERATIONS = 100;
+static const float DEFAULT_PATH_ITERATIONS_PER_AGENT = 0.25f;
+/// Minimum number of active agents per work item.
+static const int MIN_AGENTS_PER_TASK = 16;
+/// Number of work items per thread, to balance the agents whose update costs more.
+static const int TASK_RANGES_PER_THREAD = 2;
 
 void CrowdAgentUpdateCallback(dtCrowdAgent* ag, float dt)
 {
     static_cast<CrowdAgent*>(ag->params.userData)->OnCrowdUpdate(ag, dt);
 }
 
+void CrowdParallelFor(dtCrowd* crowd, int pass, int count, void* userData)
+{
+    static_cast<CrowdManager*>(userData)->ParallelFor(pass, count);
+}
+
+static void RunCrowdTask(const WorkItem* item, unsigned threadIndex)
+{
+    const CrowdTask* task = reinterpret_cast<const CrowdTask*>(item->aux_);
+    task->crowd_->updateRange(task->pass_, task->begin_, task->end_, (int)threadIndex);
+}
+
 CrowdManager::CrowdManager(Context* context) :
     Component(context),
     crowd_(0),
@@ -58,7 +76,11 @@ CrowdManager::CrowdManager(Context* context) :
     maxAgents_(DEFAULT_MAX_AGENTS),
     maxAgentRadius_(DEFAULT_MAX_AGENT_RADIUS),
     numQueryFilterTypes_(0),
-    numObstacleAvoidanceTypes_(0)
+    numObstacleAvoidanceTypes_(0),
+    numCrowdThreads_(1),
+    pathIterations_(DEFAULT_PATH_ITERATIONS),
+    pathIterationsPerAgent_(DEFAULT_PATH_ITERATIONS_PER_AGENT),
+    multiThreaded_(false)
 {
     // The actual buffer is allocated inside dtCrowd, we only track the number of "slots" being configured explicitly
     numAreas_.Reserve(DT_CROWD_MAX_QUERY_FILTER_TYPE);
@@ -83,6 +105,10 @@ void CrowdManager::RegisterObject(Context* context)
         Variant::emptyVariantVector, AM_DEFAULT);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Obstacle Avoidance Types", GetObstacleAvoidanceTypesAttr, SetObstacleAvoidanceTypesAttr,
         VariantVector, Variant::emptyVariantVector, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Multi Threaded", IsMultiThreaded, SetMultiThreaded, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Path Iterations", GetPathIterations, SetPathIterations, int, DEFAULT_PATH_ITERATIONS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Path Iterations Per Agent", GetPathIterationsPerAgent, SetPathIterationsPerAgent, float,
+        DEFAULT_PATH_ITERATIONS_PER_AGENT, AM_DEFAULT);
 }
 
 void CrowdManager::ApplyAttributes()
@@ -292,6 +318,9 @@ void CrowdManager::SetIncludeFlags(unsigned queryFilterType, unsigned short flag
     dtQueryFilter* filter = const_cast<dtQueryFilter*>(GetDetourQueryFilter(queryFilterType));
     if (filter)
     {
+        // The path corridors found by the navigation mesh with this filter are not valid anymore
+        if (navigationMesh_)
+            navigationMesh_->ClearPathCache();
         filter->setIncludeFlags(flags);
         if (numQueryFilterTypes_ < queryFilterType + 1)
             numQueryFilterTypes_ = queryFilterType + 1;
@@ -304,6 +333,8 @@ void CrowdManager::SetExcludeFlags(unsigned queryFilterType, unsigned short flag
     dtQueryFilter* filter = const_cast<dtQueryFilter*>(GetDetourQueryFilter(queryFilterType));
     if (filter)
     {
+        if (navigationMesh_)
+            navigationMesh_->ClearPathCache();
         filter->setExcludeFlags(flags);
         if (numQueryFilterTypes_ < queryFilterType + 1)
             numQueryFilterTypes_ = queryFilterType + 1;
@@ -316,6 +347,8 @@ void CrowdManager::SetAreaCost(unsigned queryFilterType, unsigned areaID, float
     dtQueryFilter* filter = const_cast<dtQueryFilter*>(GetDetourQueryFilter(queryFilterType));
     if (filter && areaID < DT_MAX_AREAS)
     {
+        if (navigationMesh_)
+            navigationMesh_->ClearPathCache();
         filter->setAreaCost((int)areaID, cost);
         if (numQueryFilterTypes_ < queryFilterType + 1)
             numQueryFilterTypes_ = queryFilterType + 1;
@@ -366,6 +399,28 @@ void CrowdManager::SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, co
     }
 }
 
+void CrowdManager::SetMultiThreaded(bool enable)
+{
+    if (enable == multiThreaded_)
+        return;
+
+    multiThreaded_ = enable;
+    SetupCrowdThreads();
+    MarkNetworkUpdate();
+}
+
+void CrowdManager::SetPathIterations(int iterations)
+{
+    pathIterations_ = Max(iterations, 1);
+    MarkNetworkUpdate();
+}
+
+void CrowdManager::SetPathIterationsPerAgent(float iterations)
+{
+    pathIterationsPerAgent_ = Max(iterations, 0.0f);
+    MarkNetworkUpdate();
+}
+
 Vector3 CrowdManager::FindNearestPoint(const Vector3& point, int queryFilterType, dtPolyRef* nearestRef)
 {
     if (nearestRef)
@@ -568,6 +623,7 @@ bool CrowdManager::CreateCrowd()
         URHO3D_LOGERROR("Could not initialize DetourCrowd");
         return false;
     }
+    SetupCrowdThreads();
 
     if (recreate)
     {
@@ -658,9 +714,69 @@ void CrowdManager::Update(float delta)
 {
     assert(crowd_ && navigationMesh_);
     URHO3D_PROFILE(UpdateCrowd);
+
+    // The work queue threads may have been created after the crowd
+    if (multiThreaded_)
+    {
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (queue && queue->GetNumThreads() + 1 != numCrowdThreads_)
+            SetupCrowdThreads();
+    }
+
+    // Share out more path finding iterations when there are many agents waiting for their paths
+    int numActiveAgents = 0;
+    for (int i = 0; i < crowd_->getAgentCount(); ++i)
+    {
+        if (crowd_->getAgent(i)->active)
+            ++numActiveAgents;
+    }
+    crowd_->setMaxPathIterations(Max(pathIterations_, (int)(pathIterationsPerAgent_ * numActiveAgents)));
+
     crowd_->update(delta, 0);
 }
 
+void CrowdManager::SetupCrowdThreads()
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    numCrowdThreads_ = multiThreaded_ && queue ? queue->GetNumThreads() + 1 : 1;
+
+    if (crowd_ && !crowd_->setParallelFor(numCrowdThreads_ > 1 ? CrowdParallelFor : 0, this, (int)numCrowdThreads_))
+        URHO3D_LOGERROR("Could not allocate the DetourCrowd thread queries");
+}
+
+void CrowdManager::ParallelFor(int pass, int count)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    const int numRanges = Min(count / MIN_AGENTS_PER_TASK, (int)numCrowdThreads_ * TASK_RANGES_PER_THREAD);
+
+    if (!queue || numRanges <= 1)
+    {
+        crowd_->updateRange(pass, 0, count, 0);
+        return;
+    }
+
+    tasks_.Resize((unsigned)numRanges);
+
+    int begin = 0;
+    for (int i = 0; i < numRanges; ++i)
+    {
+        CrowdTask& range = tasks_[i];
+        range.crowd_ = crowd_;
+        range.pass_ = pass;
+        range.begin_ = begin;
+        range.end_ = i < numRanges - 1 ? count * (i + 1) / numRanges : count;
+        begin = range.end_;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = RunCrowdTask;
+        item->aux_ = &range;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
 const dtCrowdAgent* CrowdManager::GetDetourCrowdAgent(int agent) const
 {
     return crowd_ ? crowd_->getAgent(agent) : 0;
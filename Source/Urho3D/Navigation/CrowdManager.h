@@ -55,12 +55,26 @@ struct CrowdObstacleAvoidanceParams
     unsigned char adaptiveDepth;    ///< adaptive
 };
 
+/// FromBones : range of crowd agents updated in one work item.
+struct CrowdTask
+{
+    /// Detour crowd.
+    dtCrowd* crowd_;
+    /// Update pass.
+    int pass_;
+    /// First active agent.
+    int begin_;
+    /// Active agent after the last one.
+    int end_;
+};
+
 /// Crowd manager scene component. Should be added only to the root scene node.
 class URHO3D_API CrowdManager : public Component
 {
     URHO3D_OBJECT(CrowdManager, Component);
 
     friend class CrowdAgent;
+    friend void CrowdParallelFor(dtCrowd* crowd, int pass, int count, void* userData);
 
 public:
     /// Construct.
@@ -101,6 +115,12 @@ public:
     void SetObstacleAvoidanceTypesAttr(const VariantVector& value);
     /// Set the params for the specified obstacle avoidance type.
     void SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, const CrowdObstacleAvoidanceParams& params);
+    /// FromBones : set whether to update the agents on the work queue threads. The agent update callbacks stay in the main thread. Default false.
+    void SetMultiThreaded(bool enable);
+    /// FromBones : set the minimum number of path finding iterations per update. Default 100.
+    void SetPathIterations(int iterations);
+    /// FromBones : set the path finding iterations per update for each active agent, used when more than the minimum. Default 0.25.
+    void SetPathIterationsPerAgent(float iterations);
 
     /// Get all the crowd agent components in the specified node hierarchy. If the node is not specified then use scene node. When inCrowdFilter is set to true then only get agents that are in the crowd.
     PODVector<CrowdAgent*> GetAgents(Node* node = 0, bool inCrowdFilter = true) const;
@@ -149,6 +169,12 @@ public:
     VariantVector GetObstacleAvoidanceTypesAttr() const;
     /// Get the params for the specified obstacle avoidance type.
     const CrowdObstacleAvoidanceParams& GetObstacleAvoidanceParams(unsigned obstacleAvoidanceType) const;
+    /// Return whether updates the agents on the work queue threads.
+    bool IsMultiThreaded() const { return multiThreaded_; }
+    /// Return the minimum number of path finding iterations per update.
+    int GetPathIterations() const { return pathIterations_; }
+    /// Return the path finding iterations per update for each active agent.
+    float GetPathIterationsPerAgent() const { return pathIterationsPerAgent_; }
 
 protected:
     /// Create and initialized internal Detour crowd object. When it is a recreate, it preserves the configuration and attempts to re-add existing agents in the previous crowd back to the newly created crowd.
@@ -170,6 +196,10 @@ protected:
 
     /// Get the internal detour crowd component.
     dtCrowd* GetCrowd() const { return crowd_; }
+    /// FromBones : set the number of threads the crowd updates the agents with.
+    void SetupCrowdThreads();
+    /// FromBones : run an update pass of the crowd over the active agents in the work queue.
+    void ParallelFor(int pass, int count);
 
 private:
     /// Handle the scene subsystem update event.
@@ -195,6 +225,16 @@ private:
     PODVector<unsigned> numAreas_;
     /// Number of obstacle avoidance types configured in the crowd. Limit to DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS.
     unsigned numObstacleAvoidanceTypes_;
+    /// Agent ranges of the running update pass.
+    PODVector<CrowdTask> tasks_;
+    /// Number of threads the crowd was set up with.
+    unsigned numCrowdThreads_;
+    /// Minimum path finding iterations per update.
+    int pathIterations_;
+    /// Path finding iterations per update for each active agent.
+    float pathIterationsPerAgent_;
+    /// Multithreaded update flag.
+    bool multiThreaded_;
 };
 
 }
@@ -85,8 +85,6 @@ public:
     bool GetDrawObstacles() const { return drawObstacles_; }
 
 protected:
-    struct TileCacheData;
-
     /// Subscribe to events when assigned to a scene.
     virtual void OnSceneSet(Scene* scene);
     /// Trigger the tile cache to make updates to the nav mesh if necessary.
@@ -99,8 +97,12 @@ protected:
     /// Used by Obstacle class to remove itself from the tile cache, if 'silent' an event will not be raised.
     void RemoveObstacle(Obstacle*, bool silent = false);
 
-    /// Build one tile of the navigation mesh. Return true if successful.
-    int BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData*);
+    /// FromBones : Create the build data of a tile and collect its geometry. Called in the main thread.
+    virtual NavBuildData* PrepareTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// FromBones : Rasterize a prepared tile and compress its layers. Can be called from a worker thread, so must only access the build data. Return true if successful.
+    virtual bool ProcessTile(NavBuildData* build) const;
+    /// FromBones : Replace the layers of the tile in the tile cache by the processed ones, build their navigation mesh tiles and send the tile rebuild event. Called in the main thread. Return true if successful.
+    virtual bool CommitTile(NavBuildData* build);
     /// Off-mesh connections to be rebuilt in the mesh processor.
     PODVector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
@@ -124,6 +126,8 @@ private:
     unsigned maxLayers_;
     /// Debug draw Obstacles.
     bool drawObstacles_;
+    /// FromBones : whether the tile cache has processed all the obstacle changes.
+    bool tileCacheUpToDate_;
 };
 
 }
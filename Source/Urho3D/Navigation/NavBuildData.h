@@ -31,7 +31,9 @@ class rcContext;
 struct dtTileCacheContourSet;
 struct dtTileCachePolyMesh;
 struct dtTileCacheAlloc;
+struct dtTileCacheCompressor;
 struct rcCompactHeightfield;
+struct rcConfig;
 struct rcContourSet;
 struct rcHeightfield;
 struct rcHeightfieldLayerSet;
@@ -50,6 +52,15 @@ struct URHO3D_API NavAreaStub
     unsigned char areaID_;
 };
 
+/// FromBones : compressed tile cache layer.
+struct NavTileCacheLayer
+{
+    /// Layer data.
+    unsigned char* data_;
+    /// Layer data size.
+    int dataSize_;
+};
+
 /// Navigation build data.
 struct URHO3D_API NavBuildData
 {
@@ -60,6 +71,18 @@ struct URHO3D_API NavBuildData
 
     /// World-space bounding box of the navigation mesh tile.
     BoundingBox worldBoundingBox_;
+    /// FromBones : tile X coordinate.
+    int tileX_;
+    /// FromBones : tile Z coordinate.
+    int tileZ_;
+    /// FromBones : tile bounding box relative to the navigation mesh root node.
+    BoundingBox tileBoundingBox_;
+    /// FromBones : Recast configuration of the tile, copied from the navigation mesh when the build is prepared.
+    rcConfig* config_;
+    /// FromBones : heightfield partition type.
+    int partitionType_;
+    /// FromBones : whether the tile has been processed successfully.
+    bool processed_;
     /// Vertices from geometries.
     PODVector<Vector3> vertices_;
     /// Triangle indices from geometries.
@@ -97,6 +120,16 @@ struct SimpleNavBuildData : public NavBuildData
     rcPolyMesh* polyMesh_;
     /// Recast detail poly mesh.
     rcPolyMeshDetail* polyMeshDetail_;
+    /// FromBones : navigation agent height.
+    float agentHeight_;
+    /// FromBones : navigation agent radius.
+    float agentRadius_;
+    /// FromBones : navigation agent max vertical climb.
+    float agentMaxClimb_;
+    /// FromBones : Detour tile data, owned until added to the navigation mesh.
+    unsigned char* navData_;
+    /// FromBones : Detour tile data size.
+    int navDataSize_;
 };
 
 struct DynamicNavBuildData : public NavBuildData
@@ -114,6 +147,10 @@ struct DynamicNavBuildData : public NavBuildData
     rcHeightfieldLayerSet* heightFieldLayers_;
     /// Allocator from DynamicNavigationMesh instance.
     dtTileCacheAlloc* alloc_;
+    /// FromBones : compressor from DynamicNavigationMesh instance, used to compress the layers.
+    dtTileCacheCompressor* compressor_;
+    /// FromBones : compressed layers, owned until added to the tile cache.
+    PODVector<NavTileCacheLayer> layers_;
 };
 
 }
@@ -0,0 +1,313 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Navigation/NavPathData.h"
+
+#include <cstring>
+#include <Detour/DetourNavMesh.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static void PushOpenTile(PODVector<NavTileGraphOpenTile>& heap, const NavTileGraphOpenTile& tile)
+{
+    heap.Push(tile);
+
+    unsigned i = heap.Size() - 1;
+    while (i > 0)
+    {
+        const unsigned parent = (i - 1) / 2;
+        if (heap[parent].total_ <= heap[i].total_)
+            break;
+        Swap(heap[parent], heap[i]);
+        i = parent;
+    }
+}
+
+static NavTileGraphOpenTile PopOpenTile(PODVector<NavTileGraphOpenTile>& heap)
+{
+    const NavTileGraphOpenTile top = heap.Front();
+    heap.Front() = heap.Back();
+    heap.Pop();
+
+    unsigned i = 0;
+    for (;;)
+    {
+        const unsigned left = i * 2 + 1;
+        const unsigned right = left + 1;
+        unsigned smallest = i;
+        if (left < heap.Size() && heap[left].total_ < heap[smallest].total_)
+            smallest = left;
+        if (right < heap.Size() && heap[right].total_ < heap[smallest].total_)
+            smallest = right;
+        if (smallest == i)
+            break;
+        Swap(heap[smallest], heap[i]);
+        i = smallest;
+    }
+
+    return top;
+}
+
+NavPathCache::NavPathCache() :
+    maxSize_(0),
+    useCounter_(0)
+{
+}
+
+void NavPathCache::SetMaxSize(unsigned size)
+{
+    MutexLock lock(mutex_);
+
+    maxSize_ = size;
+    while (entries_.Size() > maxSize_)
+        RemoveOldest();
+}
+
+int NavPathCache::Find(const NavPathCacheKey& key, const dtNavMesh* navMesh, dtPolyRef* dest, int maxPolys)
+{
+    MutexLock lock(mutex_);
+
+    HashMap<NavPathCacheKey, NavPathCacheEntry>::Iterator i = entries_.Find(key);
+    if (i == entries_.End())
+        return 0;
+
+    // The polygons of the rebuilt tiles are not valid anymore
+    const PODVector<dtPolyRef>& polys = i->second_.polys_;
+    for (unsigned j = 0; j < polys.Size(); ++j)
+    {
+        if (!navMesh->isValidPolyRef(polys[j]))
+        {
+            entries_.Erase(i);
+            return 0;
+        }
+    }
+
+    const int numPolys = Min((int)polys.Size(), maxPolys);
+    memcpy(dest, &polys[0], numPolys * sizeof(dtPolyRef));
+    i->second_.lastUse_ = ++useCounter_;
+    return numPolys;
+}
+
+void NavPathCache::Store(const NavPathCacheKey& key, const dtPolyRef* polys, int numPolys)
+{
+    if (numPolys <= 0)
+        return;
+
+    MutexLock lock(mutex_);
+
+    if (!maxSize_)
+        return;
+
+    if (entries_.Size() >= maxSize_ && !entries_.Contains(key))
+        RemoveOldest();
+
+    NavPathCacheEntry& entry = entries_[key];
+    entry.polys_.Resize((unsigned)numPolys);
+    memcpy(&entry.polys_[0], polys, numPolys * sizeof(dtPolyRef));
+    entry.lastUse_ = ++useCounter_;
+}
+
+void NavPathCache::Clear()
+{
+    MutexLock lock(mutex_);
+
+    entries_.Clear();
+}
+
+unsigned NavPathCache::GetSize() const
+{
+    MutexLock lock(mutex_);
+
+    return entries_.Size();
+}
+
+void NavPathCache::RemoveOldest()
+{
+    HashMap<NavPathCacheKey, NavPathCacheEntry>::Iterator oldest = entries_.End();
+    for (HashMap<NavPathCacheKey, NavPathCacheEntry>::Iterator i = entries_.Begin(); i != entries_.End(); ++i)
+    {
+        // Compare the ages, the use counter may wrap around
+        if (oldest == entries_.End() || useCounter_ - i->second_.lastUse_ > useCounter_ - oldest->second_.lastUse_)
+            oldest = i;
+    }
+
+    if (oldest != entries_.End())
+        entries_.Erase(oldest);
+}
+
+void NavTileGraph::Build(const dtNavMesh* navMesh)
+{
+    Clear();
+
+    if (!navMesh)
+        return;
+
+    const int maxTiles = navMesh->getMaxTiles();
+    nodes_.Resize((unsigned)maxTiles);
+
+    for (int i = 0; i < maxTiles; ++i)
+    {
+        NavTileGraphNode& node = nodes_[i];
+        node.firstLink_ = links_.Size();
+        node.numLinks_ = 0;
+
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile->header)
+        {
+            node.center_ = Vector3::ZERO;
+            continue;
+        }
+
+        node.center_ = (Vector3(tile->header->bmin) + Vector3(tile->header->bmax)) * 0.5f;
+
+        // Link to each neighbour tile through the first polygon found connected to it
+        for (int j = 0; j < tile->header->polyCount; ++j)
+        {
+            const dtPoly* poly = &tile->polys[j];
+            for (unsigned k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+            {
+                const dtPolyRef ref = tile->links[k].ref;
+                const unsigned neighbour = ref ? navMesh->decodePolyIdTile(ref) : (unsigned)i;
+                if (neighbour == (unsigned)i)
+                    continue;
+
+                bool linked = false;
+                for (unsigned l = node.firstLink_; l < links_.Size(); ++l)
+                {
+                    if (links_[l].to_ == neighbour)
+                    {
+                        linked = true;
+                        break;
+                    }
+                }
+                if (linked)
+                    continue;
+
+                const dtMeshTile* portalTile = 0;
+                const dtPoly* portalPoly = 0;
+                navMesh->getTileAndPolyByRefUnsafe(ref, &portalTile, &portalPoly);
+
+                NavTileGraphLink link;
+                link.from_ = (unsigned)i;
+                link.to_ = neighbour;
+                link.portalRef_ = ref;
+                link.portalPosition_ = Vector3::ZERO;
+                for (unsigned l = 0; l < portalPoly->vertCount; ++l)
+                    link.portalPosition_ += Vector3(&portalTile->verts[portalPoly->verts[l] * 3]);
+                link.portalPosition_ /= (float)portalPoly->vertCount;
+                link.cost_ = 0.0f;
+                links_.Push(link);
+                ++node.numLinks_;
+            }
+        }
+    }
+
+    // The centers of all the tiles are known now
+    for (unsigned i = 0; i < links_.Size(); ++i)
+        links_[i].cost_ = (nodes_[links_[i].to_].center_ - nodes_[links_[i].from_].center_).Length();
+}
+
+void NavTileGraph::Clear()
+{
+    nodes_.Clear();
+    links_.Clear();
+}
+
+bool NavTileGraph::FindPath(unsigned startTile, unsigned endTile, NavTileGraphSearch& search, PODVector<unsigned>& dest) const
+{
+    dest.Clear();
+
+    if (startTile >= nodes_.Size() || endTile >= nodes_.Size())
+        return false;
+
+    // Reset the search data when the graph size has changed or the search counter wraps around
+    if (search.costs_.Size() != nodes_.Size() || !++search.searchId_)
+    {
+        search.costs_.Resize(nodes_.Size());
+        search.parentLinks_.Resize(nodes_.Size());
+        search.searchIds_.Resize(nodes_.Size());
+        for (unsigned i = 0; i < search.searchIds_.Size(); ++i)
+            search.searchIds_[i] = 0;
+        search.searchId_ = 1;
+    }
+
+    const unsigned searchId = search.searchId_;
+    const Vector3& endCenter = nodes_[endTile].center_;
+
+    search.open_.Clear();
+    search.costs_[startTile] = 0.0f;
+    search.parentLinks_[startTile] = M_MAX_UNSIGNED;
+    search.searchIds_[startTile] = searchId;
+
+    NavTileGraphOpenTile start;
+    start.tile_ = startTile;
+    start.total_ = (endCenter - nodes_[startTile].center_).Length();
+    PushOpenTile(search.open_, start);
+
+    while (!search.open_.Empty())
+    {
+        const NavTileGraphOpenTile current = PopOpenTile(search.open_);
+        const unsigned tile = current.tile_;
+        const float cost = search.costs_[tile];
+
+        if (tile == endTile)
+        {
+            for (unsigned link = search.parentLinks_[tile]; link != M_MAX_UNSIGNED; link = search.parentLinks_[links_[link].from_])
+                dest.Push(link);
+            for (unsigned i = 0; i < dest.Size() / 2; ++i)
+                Swap(dest[i], dest[dest.Size() - 1 - i]);
+            return true;
+        }
+
+        // Skip the tiles found again with a lower cost since they were opened
+        if (current.total_ > cost + (endCenter - nodes_[tile].center_).Length() + M_EPSILON)
+            continue;
+
+        const NavTileGraphNode& node = nodes_[tile];
+        for (unsigned i = node.firstLink_; i < node.firstLink_ + node.numLinks_; ++i)
+        {
+            const NavTileGraphLink& link = links_[i];
+            const float newCost = cost + link.cost_;
+            if (search.searchIds_[link.to_] == searchId && search.costs_[link.to_] <= newCost)
+                continue;
+
+            search.costs_[link.to_] = newCost;
+            search.parentLinks_[link.to_] = i;
+            search.searchIds_[link.to_] = searchId;
+
+            NavTileGraphOpenTile next;
+            next.tile_ = link.to_;
+            next.total_ = newCost + (endCenter - nodes_[link.to_].center_).Length();
+            PushOpenTile(search.open_, next);
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Core/Mutex.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/Vector3.h"
+
+#ifdef DT_POLYREF64
+typedef uint64_t dtPolyRef;
+#else
+typedef unsigned int dtPolyRef;
+#endif
+
+class dtNavMesh;
+class dtQueryFilter;
+
+namespace Urho3D
+{
+
+/// FromBones : navigation area copied for the path queries running in the worker threads.
+struct NavPathArea
+{
+    /// World-space bounding box.
+    BoundingBox bounds_;
+    /// World-space position of the area node.
+    Vector3 position_;
+    /// Area ID.
+    unsigned char areaID_;
+};
+
+/// FromBones : key of a cached path corridor.
+struct NavPathCacheKey
+{
+    /// Construct undefined.
+    NavPathCacheKey()
+    {
+    }
+
+    /// Construct with polygons and query filter.
+    NavPathCacheKey(dtPolyRef startRef, dtPolyRef endRef, const dtQueryFilter* filter) :
+        startRef_(startRef),
+        endRef_(endRef),
+        filter_(filter)
+    {
+    }
+
+    /// Test for equality with another key.
+    bool operator ==(const NavPathCacheKey& rhs) const
+    {
+        return startRef_ == rhs.startRef_ && endRef_ == rhs.endRef_ && filter_ == rhs.filter_;
+    }
+
+    /// Return hash value for HashMap.
+    unsigned ToHash() const
+    {
+        return ((unsigned)startRef_ * 31 + (unsigned)endRef_) * 31 + MakeHash(static_cast<const void*>(filter_));
+    }
+
+    /// Start polygon.
+    dtPolyRef startRef_;
+    /// End polygon.
+    dtPolyRef endRef_;
+    /// Query filter.
+    const dtQueryFilter* filter_;
+};
+
+/// FromBones : cached path corridor.
+struct NavPathCacheEntry
+{
+    /// Polygons of the corridor.
+    PODVector<dtPolyRef> polys_;
+    /// Use counter value when last found or stored.
+    unsigned lastUse_;
+};
+
+/// FromBones : cache of the recently found path corridors, shared by the threads running path queries.
+class NavPathCache
+{
+public:
+    /// Construct.
+    NavPathCache();
+
+    /// Set the maximum number of corridors. 0 disables the cache.
+    void SetMaxSize(unsigned size);
+    /// Copy the corridor found between the polygons with the query filter to dest, if its polygons are still in the navigation mesh. Return the number of polygons or 0 if not found.
+    int Find(const NavPathCacheKey& key, const dtNavMesh* navMesh, dtPolyRef* dest, int maxPolys);
+    /// Store a corridor, replacing the least recently used one when full.
+    void Store(const NavPathCacheKey& key, const dtPolyRef* polys, int numPolys);
+    /// Remove all the corridors.
+    void Clear();
+
+    /// Return the maximum number of corridors.
+    unsigned GetMaxSize() const { return maxSize_; }
+    /// Return the number of corridors.
+    unsigned GetSize() const;
+
+private:
+    /// Remove the least recently used corridor. Called with the mutex acquired.
+    void RemoveOldest();
+
+    /// Corridors.
+    HashMap<NavPathCacheKey, NavPathCacheEntry> entries_;
+    /// Mutex for the threads running path queries.
+    mutable Mutex mutex_;
+    /// Maximum number of corridors.
+    unsigned maxSize_;
+    /// Use counter.
+    unsigned useCounter_;
+};
+
+/// FromBones : link from a tile to a neighbour tile of the tile graph.
+struct NavTileGraphLink
+{
+    /// Tile index of the link origin.
+    unsigned from_;
+    /// Tile index of the neighbour tile.
+    unsigned to_;
+    /// Polygon of the neighbour tile reached through the link.
+    dtPolyRef portalRef_;
+    /// Center of the portal polygon.
+    Vector3 portalPosition_;
+    /// Distance between the tile centers.
+    float cost_;
+};
+
+/// FromBones : tile of the tile graph.
+struct NavTileGraphNode
+{
+    /// Center of the tile bounding box.
+    Vector3 center_;
+    /// Index of the first link.
+    unsigned firstLink_;
+    /// Number of links.
+    unsigned numLinks_;
+};
+
+/// FromBones : open tile of a tile graph search.
+struct NavTileGraphOpenTile
+{
+    /// Tile index.
+    unsigned tile_;
+    /// Estimated total cost through the tile.
+    float total_;
+};
+
+/// FromBones : temporary data of a tile graph search. One per thread.
+struct NavTileGraphSearch
+{
+    /// Construct.
+    NavTileGraphSearch() :
+        searchId_(0)
+    {
+    }
+
+    /// Cost from the start tile.
+    PODVector<float> costs_;
+    /// Link the tiles were reached through.
+    PODVector<unsigned> parentLinks_;
+    /// Search that last set the cost and link of each tile, so that they need not be cleared between searches.
+    PODVector<unsigned> searchIds_;
+    /// Open tiles as a binary heap.
+    PODVector<NavTileGraphOpenTile> open_;
+    /// Current search.
+    unsigned searchId_;
+};
+
+/// FromBones : abstract graph of the navigation mesh tiles connected by their polygons, for the hierarchical path queries.
+class NavTileGraph
+{
+public:
+    /// Build from the tiles of a navigation mesh.
+    void Build(const dtNavMesh* navMesh);
+    /// Remove all the tiles.
+    void Clear();
+    /// Find the links of the shortest path between two tiles. Can be called from several threads with their own search data. Return true if found.
+    bool FindPath(unsigned startTile, unsigned endTile, NavTileGraphSearch& search, PODVector<unsigned>& dest) const;
+
+    /// Return a link.
+    const NavTileGraphLink& GetLink(unsigned index) const { return links_[index]; }
+    /// Return whether is empty.
+    bool IsEmpty() const { return links_.Empty(); }
+
+private:
+    /// Tiles indexed by their index in the navigation mesh.
+    PODVector<NavTileGraphNode> nodes_;
+    /// Links of all the tiles.
+    PODVector<NavTileGraphLink> links_;
+};
+
+}
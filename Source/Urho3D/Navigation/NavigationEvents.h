@@ -43,6 +43,13 @@ URHO3D_EVENT(E_NAVIGATION_AREA_REBUILT, NavigationAreaRebuilt)
     URHO3D_PARAM(P_BOUNDSMAX, BoundsMax); // Vector3
 }
 
+/// FromBones : Asynchronous rebuilds of navigation mesh completed, all their tiles have been replaced.
+URHO3D_EVENT(E_NAVIGATION_ASYNC_REBUILT, NavigationAsyncRebuilt)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+}
+
 /// Crowd agent formation.
 URHO3D_EVENT(E_CROWD_AGENT_FORMATION, CrowdAgentFormation)
 {
@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -37,6 +39,7 @@
 #include "../Navigation/DynamicNavigationMesh.h"
 #include "../Navigation/NavArea.h"
 #include "../Navigation/NavBuildData.h"
+#include "../Navigation/NavPathData.h"
 #include "../Navigation/Navigable.h"
 #include "../Navigation/NavigationEvents.h"
 #include "../Navigation/NavigationMesh.h"
@@ -46,6 +49,7 @@
 #include "../Physics/CollisionShape.h"
 #endif
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -80,8 +84,12 @@ static const float DEFAULT_EDGE_MAX_LENGTH = 12.0f;
 static const float DEFAULT_EDGE_MAX_ERROR = 1.3f;
 static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
+static const unsigned DEFAULT_PATH_CACHE_SIZE = 256;
+static const int DEFAULT_HIERARCHICAL_PATH_DISTANCE = 0;
 
 static const int MAX_POLYS = 2048;
+/// Number of polygons searched back to cut the loops when joining the segments of a hierarchical path.
+static const int MAX_LOOP_SEARCH = 32;
 
 
 /// Temporary data for finding a path.
@@ -95,8 +103,68 @@ struct FindPathData
     Vector3 pathPoints_[MAX_POLYS];
     // Flags on the path.
     unsigned char pathFlags_[MAX_POLYS];
+    // Temporary data for searching the tile graph.
+    NavTileGraphSearch tileGraphSearch_;
+    // Tile graph links on the path.
+    PODVector<unsigned> tileGraphPath_;
 };
 
+static void StorePathPoints(PODVector<NavigationPathPoint>& dest, const FindPathData* data, int numPathPoints,
+    const Matrix3x4& transform, const PODVector<NavPathArea>& areas)
+{
+    // Transform path result back to world space
+    for (int i = 0; i < numPathPoints; ++i)
+    {
+        NavigationPathPoint pt;
+        pt.position_ = transform * data->pathPoints_[i];
+        pt.flag_ = (NavigationPathPointFlag)data->pathFlags_[i];
+
+        // Walk through all NavAreas and find nearest
+        unsigned char nearestNavAreaID = 0;       // 0 is the default nav area ID
+        float nearestDistance = M_LARGE_VALUE;
+        for (unsigned j = 0; j < areas.Size(); j++)
+        {
+            const NavPathArea& area = areas[j];
+            if (area.bounds_.IsInside(pt.position_) == INSIDE)
+            {
+                float distance = (area.position_ - pt.position_).LengthSquared();
+                if (distance < nearestDistance)
+                {
+                    nearestDistance = distance;
+                    nearestNavAreaID = area.areaID_;
+                }
+            }
+        }
+        pt.areaID_ = nearestNavAreaID;
+
+        dest.Push(pt);
+    }
+}
+
+void ProcessTileWork(const WorkItem* item, unsigned threadIndex)
+{
+    const NavigationMesh* mesh = reinterpret_cast<const NavigationMesh*>(item->aux_);
+    NavBuildData* build = reinterpret_cast<NavBuildData*>(item->start_);
+    build->processed_ = mesh->ProcessTile(build);
+}
+
+void FindPathWork(const WorkItem* item, unsigned threadIndex)
+{
+    const NavigationMesh* mesh = reinterpret_cast<const NavigationMesh*>(item->aux_);
+    NavigationPathQuery* query = reinterpret_cast<NavigationPathQuery*>(item->start_);
+    mesh->RunPathQuery(query, threadIndex);
+}
+
+NavigationPathQuery::NavigationPathQuery() :
+    filter_(0),
+    completed_(false)
+{
+}
+
+NavigationPathQuery::~NavigationPathQuery()
+{
+}
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(0),
@@ -122,8 +190,13 @@ NavigationMesh::NavigationMesh(Context* context) :
     partitionType_(NAVMESH_PARTITION_WATERSHED),
     keepInterResults_(false),
     drawOffMeshConnections_(false),
-    drawNavAreas_(false)
+    drawNavAreas_(false),
+    pathCache_(new NavPathCache()),
+    tileGraph_(new NavTileGraph()),
+    hierarchicalPathDistance_(DEFAULT_HIERARCHICAL_PATH_DISTANCE),
+    tileGraphDirty_(true)
 {
+    pathCache_->SetMaxSize(DEFAULT_PATH_CACHE_SIZE);
 }
 
 NavigationMesh::~NavigationMesh()
@@ -157,6 +230,9 @@ void NavigationMesh::RegisterObject(Context* context)
         NAVMESH_PARTITION_WATERSHED, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw OffMeshConnections", GetDrawOffMeshConnections, SetDrawOffMeshConnections, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw NavAreas", GetDrawNavAreas, SetDrawNavAreas, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Path Cache Size", GetPathCacheSize, SetPathCacheSize, unsigned, DEFAULT_PATH_CACHE_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Hierarchical Path Distance", GetHierarchicalPathDistance, SetHierarchicalPathDistance, int,
+        DEFAULT_HIERARCHICAL_PATH_DISTANCE, AM_DEFAULT);
 }
 
 void NavigationMesh::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -398,16 +474,7 @@ bool NavigationMesh::Build()
         }
 
         // Build each tile
-        unsigned numTiles = 0;
-
-        for (int z = 0; z < numTilesZ_; ++z)
-        {
-            for (int x = 0; x < numTilesX_; ++x)
-            {
-                if (BuildTile(geometryList, x, z))
-                    ++numTiles;
-            }
-        }
+        unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, IntVector2(numTilesX_ - 1, numTilesZ_ - 1));
 
         URHO3D_LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
 
@@ -440,6 +507,9 @@ bool NavigationMesh::Build(const BoundingBox& boundingBox)
     if (!node_->GetWorldScale().Equals(Vector3::ONE))
         URHO3D_LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
 
+    // Replace the tiles of the asynchronous rebuilds first, so that they do not overwrite these ones
+    CompleteAsyncBuild();
+
     BoundingBox localSpaceBox = boundingBox.Transformed(node_->GetWorldTransform().Inverse());
 
     float tileEdgeLength = (float)tileSize_ * cellSize_;
@@ -452,21 +522,78 @@ bool NavigationMesh::Build(const BoundingBox& boundingBox)
     int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
     int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
 
-    unsigned numTiles = 0;
+    unsigned numTiles = BuildTiles(geometryList, IntVector2(sx, sz), IntVector2(ex, ez));
+
+    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
+    return true;
+}
+
+bool NavigationMesh::BuildAsync(const BoundingBox& boundingBox)
+{
+    URHO3D_PROFILE(BuildNavigationMeshAsync);
+
+    if (!node_)
+        return false;
+
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Navigation mesh must first be built fully before it can be partially rebuilt");
+        return false;
+    }
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    Scene* scene = GetScene();
+    if (!queue || !queue->GetNumThreads() || !scene)
+    {
+        // Without worker threads or scene updates, rebuild now
+        if (!Build(boundingBox))
+            return false;
+
+        using namespace NavigationAsyncRebuilt;
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = node_;
+        eventData[P_MESH] = this;
+        SendEvent(E_NAVIGATION_ASYNC_REBUILT, eventData);
+        return true;
+    }
+
+    BoundingBox localSpaceBox = boundingBox.Transformed(node_->GetWorldTransform().Inverse());
+
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+
+    Vector<NavigationGeometryInfo> geometryList;
+    CollectGeometries(geometryList);
+
+    int sx = Clamp((int)((localSpaceBox.min_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
+    int sz = Clamp((int)((localSpaceBox.min_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
+    int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
+    int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
 
+    // The geometry is collected now, only the processing of the tiles runs in the worker threads. The items are not taken
+    // from the pool, as the pooled items are recycled once completed
     for (int z = sz; z <= ez; ++z)
     {
         for (int x = sx; x <= ex; ++x)
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
+            SharedPtr<WorkItem> item(new WorkItem());
+            item->priority_ = 0;
+            item->workFunction_ = ProcessTileWork;
+            item->start_ = PrepareTile(geometryList, x, z);
+            item->aux_ = this;
+            queue->AddWorkItem(item);
+            asyncBuildItems_.Push(item);
         }
     }
 
-    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
+    SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(NavigationMesh, HandleAsyncBuildUpdate));
     return true;
 }
 
+void NavigationMesh::CompleteAsyncBuild()
+{
+    FinishAsyncBuild(true);
+}
+
 Vector3 NavigationMesh::FindNearestPoint(const Vector3& point, const Vector3& extents, const dtQueryFilter* filter,
     dtPolyRef* nearestRef)
 {
@@ -533,71 +660,122 @@ void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, const Vector
     if (!InitializeQuery())
         return;
 
+    UpdateTileGraph();
+
     // Navigation data is in local space. Transform path points from world to local
     const Matrix3x4& transform = node_->GetWorldTransform();
     Matrix3x4 inverse = transform.Inverse();
 
-    Vector3 localStart = inverse * start;
-    Vector3 localEnd = inverse * end;
-
-    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.Get();
-    dtPolyRef startRef;
-    dtPolyRef endRef;
-    navMeshQuery_->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, 0);
-    navMeshQuery_->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, 0);
-
-    if (!startRef || !endRef)
+    const int numPathPoints = QueryPath(navMeshQuery_, pathData_.Get(), inverse * start, inverse * end, extents,
+        filter ? filter : queryFilter_.Get());
+    if (!numPathPoints)
         return;
 
-    int numPolys = 0;
-    int numPathPoints = 0;
+    PODVector<NavPathArea> areas;
+    CollectPathAreas(areas);
+    StorePathPoints(dest, pathData_.Get(), numPathPoints, transform, areas);
+}
 
-    navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData_->polys_, &numPolys,
-        MAX_POLYS);
-    if (!numPolys)
-        return;
+SharedPtr<NavigationPathQuery> NavigationMesh::FindPathAsync(const Vector3& start, const Vector3& end, const Vector3& extents,
+    const dtQueryFilter* filter)
+{
+    if (!InitializeQuery())
+        return SharedPtr<NavigationPathQuery>();
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    const unsigned numThreads = queue ? queue->GetNumThreads() + 1 : 1;
+
+    UpdateTileGraph();
+    if (!InitializePathThreads(numThreads))
+        return SharedPtr<NavigationPathQuery>();
+
+    // The transform and the areas are copied now, only the Detour queries run in the worker threads
+    SharedPtr<NavigationPathQuery> query(new NavigationPathQuery());
+    query->start_ = start;
+    query->end_ = end;
+    query->extents_ = extents;
+    query->filter_ = filter ? filter : queryFilter_.Get();
+    query->transform_ = node_->GetWorldTransform();
+    CollectPathAreas(query->areas_);
+
+    // Without worker threads, search the path now
+    if (numThreads == 1)
+    {
+        RunPathQuery(query, 0);
+        return query;
+    }
 
-    Vector3 actualLocalEnd = localEnd;
+    // Forget the queries completed first
+    unsigned numCompleted = 0;
+    while (numCompleted < pathQueries_.Size() && pathQueries_[numCompleted]->item_->completed_)
+        ++numCompleted;
+    if (numCompleted)
+        pathQueries_.Erase(0, numCompleted);
+
+    // The items are not taken from the pool, as the pooled items are recycled once completed
+    SharedPtr<WorkItem> item(new WorkItem());
+    item->priority_ = 0;
+    item->workFunction_ = FindPathWork;
+    item->start_ = query.Get();
+    item->aux_ = this;
+    query->item_ = item;
+    pathQueries_.Push(query);
+    queue->AddWorkItem(item);
+
+    return query;
+}
 
-    // If full path was not found, clamp end point to the end polygon
-    if (pathData_->polys_[numPolys - 1] != endRef)
-        navMeshQuery_->closestPointOnPoly(pathData_->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, 0);
+void NavigationMesh::CompletePathQueries()
+{
+    if (pathQueries_.Empty())
+        return;
 
-    navMeshQuery_->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData_->polys_, numPolys,
-        &pathData_->pathPoints_[0].x_, pathData_->pathFlags_, pathData_->pathPolys_, &numPathPoints, MAX_POLYS);
+    URHO3D_PROFILE(CompletePathQueries);
 
-    // Transform path result back to world space
-    for (int i = 0; i < numPathPoints; ++i)
+    // Search the paths no thread has taken yet now, wait for the others
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    for (unsigned i = 0; i < pathQueries_.Size(); ++i)
     {
-        NavigationPathPoint pt;
-        pt.position_ = transform * pathData_->pathPoints_[i];
-        pt.flag_ = (NavigationPathPointFlag)pathData_->pathFlags_[i];
+        NavigationPathQuery* query = pathQueries_[i];
+        WorkItem* item = query->item_;
+        if (item->completed_)
+            continue;
 
-        // Walk through all NavAreas and find nearest
-        unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
-        float nearestDistance = M_LARGE_VALUE;
-        for (unsigned j = 0; j < areas_.Size(); j++)
+        if (queue && queue->RemoveWorkItem(query->item_))
+            RunPathQuery(query, 0);
+        else
         {
-            NavArea* area = areas_[j].Get();
-            if (area && area->IsEnabledEffective())
-            {
-                BoundingBox bb = area->GetWorldBoundingBox();
-                if (bb.IsInside(pt.position_) == INSIDE)
-                {
-                    Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
-                    float distance = (areaWorldCenter - pt.position_).LengthSquared();
-                    if (distance < nearestDistance)
-                    {
-                        nearestDistance = distance;
-                        nearestNavAreaID = area->GetAreaID();
-                    }
-                }
-            }
+            while (!item->completed_)
+                Time::Sleep(0);
         }
-        pt.areaID_ = (unsigned char)nearestNavAreaID;
-
-        dest.Push(pt);
     }
+
+    pathQueries_.Clear();
+}
+
+void NavigationMesh::SetPathCacheSize(unsigned size)
+{
+    pathCache_->SetMaxSize(size);
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::ClearPathCache()
+{
+    // The queries in progress could store the corridors found with the previous filter settings
+    CompletePathQueries();
+    pathCache_->Clear();
+}
+
+void NavigationMesh::SetHierarchicalPathDistance(int distance)
+{
+    CompletePathQueries();
+    hierarchicalPathDistance_ = Max(distance, 0);
+    MarkNetworkUpdate();
+}
+
+unsigned NavigationMesh::GetPathCacheSize() const
+{
+    return pathCache_->GetMaxSize();
 }
 
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
@@ -723,6 +901,9 @@ void NavigationMesh::DrawDebugGeometry(bool depthTest)
 
 void NavigationMesh::SetAreaCost(unsigned areaID, float cost)
 {
+    // The path queries in progress read the default filter, and the cached corridors were found with the previous cost
+    ClearPathCache();
+
     if (queryFilter_)
         queryFilter_->setAreaCost((int)areaID, cost);
 }
@@ -1145,12 +1326,74 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
 {
     URHO3D_PROFILE(BuildNavigationMeshTile);
 
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), 0, 0);
+    UniquePtr<NavBuildData> build(PrepareTile(geometryList, x, z));
+    build->processed_ = ProcessTile(build.Get());
+    return CommitTile(build.Get());
+}
+
+unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
+{
+    // Collect the geometry of the tiles in the main thread
+    PODVector<NavBuildData*> builds;
+    for (int z = from.y_; z <= to.y_; ++z)
+    {
+        for (int x = from.x_; x <= to.x_; ++x)
+            builds.Push(PrepareTile(geometryList, x, z));
+    }
+
+    // Rasterize the tiles and build their meshes in the worker threads
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads() && builds.Size() > 1)
+    {
+        URHO3D_PROFILE(ProcessNavigationMeshTiles);
+
+        for (unsigned i = 0; i < builds.Size(); ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = ProcessTileWork;
+            item->start_ = builds[i];
+            item->aux_ = this;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        for (unsigned i = 0; i < builds.Size(); ++i)
+            builds[i]->processed_ = ProcessTile(builds[i]);
+    }
+
+    // Add the tiles to the navigation mesh in the main thread
+    unsigned numTiles = 0;
+    for (unsigned i = 0; i < builds.Size(); ++i)
+    {
+        if (CommitTile(builds[i]))
+            ++numTiles;
+        delete builds[i];
+    }
+
+    return numTiles;
+}
 
+NavBuildData* NavigationMesh::PrepareTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z)
+{
+    SimpleNavBuildData* build = new SimpleNavBuildData();
+    build->agentHeight_ = agentHeight_;
+    build->agentRadius_ = agentRadius_;
+    build->agentMaxClimb_ = agentMaxClimb_;
+    PrepareTileBuild(build, geometryList, x, z);
+    return build;
+}
+
+void NavigationMesh::PrepareTileBuild(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList, int x, int z)
+{
     float tileEdgeLength = (float)tileSize_ * cellSize_;
 
-    BoundingBox tileBoundingBox(Vector3(
+    build->tileX_ = x;
+    build->tileZ_ = z;
+    build->tileBoundingBox_ = BoundingBox(Vector3(
             boundingBox_.min_.x_ + tileEdgeLength * (float)x,
             boundingBox_.min_.y_,
             boundingBox_.min_.z_ + tileEdgeLength * (float)z
@@ -1160,10 +1403,9 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
             boundingBox_.max_.y_,
             boundingBox_.min_.z_ + tileEdgeLength * (float)(z + 1)
         ));
+    build->partitionType_ = partitionType_;
 
-    SimpleNavBuildData build;
-
-    rcConfig cfg;
+    rcConfig& cfg = *build->config_;
     memset(&cfg, 0, sizeof cfg);
     cfg.cs = cellSize_;
     cfg.ch = cellHeight_;
@@ -1183,15 +1425,23 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     cfg.detailSampleDist = detailSampleDistance_ < 0.9f ? 0.0f : cellSize_ * detailSampleDistance_;
     cfg.detailSampleMaxError = cellHeight_ * detailSampleMaxError_;
 
-    rcVcopy(cfg.bmin, &tileBoundingBox.min_.x_);
-    rcVcopy(cfg.bmax, &tileBoundingBox.max_.x_);
+    rcVcopy(cfg.bmin, &build->tileBoundingBox_.min_.x_);
+    rcVcopy(cfg.bmax, &build->tileBoundingBox_.max_.x_);
     cfg.bmin[0] -= cfg.borderSize * cfg.cs;
     cfg.bmin[2] -= cfg.borderSize * cfg.cs;
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    GetTileGeometry(build, geometryList, expandedBox);
+}
+
+bool NavigationMesh::ProcessTile(NavBuildData* tileBuild) const
+{
+    URHO3D_PROFILE(BuildNavigationMeshTile);
+
+    SimpleNavBuildData& build = *static_cast<SimpleNavBuildData*>(tileBuild);
+    const rcConfig& cfg = *build.config_;
 
     if (build.vertices_.Empty() || build.indices_.Empty())
         return true; // Nothing to do
@@ -1246,7 +1496,7 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         rcMarkBoxArea(build.ctx_, &build.navAreas_[i].bounds_.min_.x_, &build.navAreas_[i].bounds_.max_.x_,
             build.navAreas_[i].areaID_, *build.compactHeightField_);
 
-    if (this->partitionType_ == NAVMESH_PARTITION_WATERSHED)
+    if (build.partitionType_ == NAVMESH_PARTITION_WATERSHED)
     {
         if (!rcBuildDistanceField(build.ctx_, *build.compactHeightField_))
         {
@@ -1315,9 +1565,6 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
             build.polyMesh_->flags[i] = 0x1;
     }
 
-    unsigned char* navData = 0;
-    int navDataSize = 0;
-
     dtNavMeshCreateParams params;
     memset(&params, 0, sizeof params);
     params.verts = build.polyMesh_->verts;
@@ -1332,11 +1579,11 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     params.detailVertsCount = build.polyMeshDetail_->nverts;
     params.detailTris = build.polyMeshDetail_->tris;
     params.detailTriCount = build.polyMeshDetail_->ntris;
-    params.walkableHeight = agentHeight_;
-    params.walkableRadius = agentRadius_;
-    params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
+    params.walkableHeight = build.agentHeight_;
+    params.walkableRadius = build.agentRadius_;
+    params.walkableClimb = build.agentMaxClimb_;
+    params.tileX = build.tileX_;
+    params.tileY = build.tileZ_;
     rcVcopy(params.bmin, build.polyMesh_->bmin);
     rcVcopy(params.bmax, build.polyMesh_->bmax);
     params.cs = cfg.cs;
@@ -1354,17 +1601,38 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         params.offMeshConDir = &build.offMeshDir_[0];
     }
 
-    if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+    if (!dtCreateNavMeshData(&params, &build.navData_, &build.navDataSize_))
     {
         URHO3D_LOGERROR("Could not build navigation mesh tile data");
         return false;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, 0)))
-    {
-        URHO3D_LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
+    return true;
+}
+
+bool NavigationMesh::CommitTile(NavBuildData* tileBuild)
+{
+    SimpleNavBuildData& build = *static_cast<SimpleNavBuildData*>(tileBuild);
+
+    PrepareTileChange();
+
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(build.tileX_, build.tileZ_, 0), 0, 0);
+
+    if (!build.processed_)
         return false;
+
+    if (build.navData_)
+    {
+        if (dtStatusFailed(navMesh_->addTile(build.navData_, build.navDataSize_, DT_TILE_FREE_DATA, 0, 0)))
+        {
+            URHO3D_LOGERROR("Failed to add navigation mesh tile");
+            return false;
+        }
+
+        // The navigation mesh owns the data now
+        build.navData_ = 0;
+        build.navDataSize_ = 0;
     }
 
     // Send a notification of the rebuild of this tile to anyone interested
@@ -1373,13 +1641,84 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
         eventData[P_MESH] = this;
-        eventData[P_BOUNDSMIN] = Variant(tileBoundingBox.min_);
-        eventData[P_BOUNDSMAX] = Variant(tileBoundingBox.max_);
+        eventData[P_BOUNDSMIN] = Variant(build.tileBoundingBox_.min_);
+        eventData[P_BOUNDSMAX] = Variant(build.tileBoundingBox_.max_);
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
     return true;
 }
 
+void NavigationMesh::FinishAsyncBuild(bool commit)
+{
+    if (asyncBuildItems_.Empty())
+        return;
+
+    URHO3D_PROFILE(FinishNavigationMeshAsync);
+
+    // Process the tiles no thread has taken yet now, wait for the others
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    for (unsigned i = 0; i < asyncBuildItems_.Size(); ++i)
+    {
+        WorkItem* item = asyncBuildItems_[i];
+        NavBuildData* build = reinterpret_cast<NavBuildData*>(item->start_);
+        if (queue && queue->RemoveWorkItem(asyncBuildItems_[i]))
+        {
+            if (commit)
+                build->processed_ = ProcessTile(build);
+        }
+        else
+        {
+            while (!item->completed_)
+                Time::Sleep(0);
+        }
+
+        if (commit && navMesh_)
+            CommitTile(build);
+        delete build;
+    }
+
+    asyncBuildItems_.Clear();
+    UnsubscribeFromEvent(E_SCENEUPDATE);
+
+    if (commit)
+    {
+        using namespace NavigationAsyncRebuilt;
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = node_;
+        eventData[P_MESH] = this;
+        SendEvent(E_NAVIGATION_ASYNC_REBUILT, eventData);
+    }
+}
+
+void NavigationMesh::HandleAsyncBuildUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // Replace the completed tiles in order, so that the tiles queued twice keep their latest build
+    unsigned numCompleted = 0;
+    while (numCompleted < asyncBuildItems_.Size() && asyncBuildItems_[numCompleted]->completed_)
+    {
+        NavBuildData* build = reinterpret_cast<NavBuildData*>(asyncBuildItems_[numCompleted]->start_);
+        if (navMesh_)
+            CommitTile(build);
+        delete build;
+        ++numCompleted;
+    }
+
+    if (!numCompleted)
+        return;
+
+    asyncBuildItems_.Erase(0, numCompleted);
+    if (asyncBuildItems_.Empty())
+    {
+        UnsubscribeFromEvent(E_SCENEUPDATE);
+
+        using namespace NavigationAsyncRebuilt;
+        VariantMap& eventData = GetContext()->GetEventDataMap();
+        eventData[P_NODE] = node_;
+        eventData[P_MESH] = this;
+        SendEvent(E_NAVIGATION_ASYNC_REBUILT, eventData);
+    }
+}
+
 bool NavigationMesh::InitializeQuery()
 {
     if (!navMesh_ || !node_)
@@ -1404,8 +1743,223 @@ bool NavigationMesh::InitializeQuery()
     return true;
 }
 
+bool NavigationMesh::InitializePathThreads(unsigned numThreads)
+{
+    if (pathThreadQueries_.Size() >= numThreads)
+        return true;
+
+    // The queries in progress read the thread data
+    CompletePathQueries();
+
+    for (unsigned i = pathThreadQueries_.Size(); i < numThreads; ++i)
+    {
+        if (!i)
+        {
+            pathThreadQueries_.Push(navMeshQuery_);
+            pathThreadData_.Push(pathData_.Get());
+            continue;
+        }
+
+        dtNavMeshQuery* query = dtAllocNavMeshQuery();
+        if (!query || dtStatusFailed(query->init(navMesh_, MAX_POLYS)))
+        {
+            dtFreeNavMeshQuery(query);
+            URHO3D_LOGERROR("Could not create navigation mesh query");
+            return false;
+        }
+
+        pathThreadQueries_.Push(query);
+        pathThreadData_.Push(new FindPathData());
+    }
+
+    return true;
+}
+
+void NavigationMesh::ReleasePathThreads()
+{
+    CompletePathQueries();
+
+    // The first ones are the query and data of the main thread
+    for (unsigned i = 1; i < pathThreadQueries_.Size(); ++i)
+    {
+        dtFreeNavMeshQuery(pathThreadQueries_[i]);
+        delete pathThreadData_[i];
+    }
+
+    pathThreadQueries_.Clear();
+    pathThreadData_.Clear();
+}
+
+void NavigationMesh::PrepareTileChange()
+{
+    CompletePathQueries();
+    tileGraphDirty_ = true;
+}
+
+void NavigationMesh::UpdateTileGraph()
+{
+    if (!tileGraphDirty_ || hierarchicalPathDistance_ <= 0 || !navMesh_)
+        return;
+
+    URHO3D_PROFILE(BuildNavigationTileGraph);
+
+    // The queries in progress read the tile graph
+    CompletePathQueries();
+    tileGraph_->Build(navMesh_);
+    tileGraphDirty_ = false;
+}
+
+void NavigationMesh::CollectPathAreas(PODVector<NavPathArea>& dest) const
+{
+    dest.Clear();
+
+    for (unsigned i = 0; i < areas_.Size(); ++i)
+    {
+        NavArea* area = areas_[i].Get();
+        if (area && area->IsEnabledEffective())
+        {
+            NavPathArea pathArea;
+            pathArea.bounds_ = area->GetWorldBoundingBox();
+            pathArea.position_ = area->GetNode()->GetWorldPosition();
+            pathArea.areaID_ = (unsigned char)area->GetAreaID();
+            dest.Push(pathArea);
+        }
+    }
+}
+
+int NavigationMesh::QueryPath(dtNavMeshQuery* query, FindPathData* data, const Vector3& localStart, const Vector3& localEnd,
+    const Vector3& extents, const dtQueryFilter* filter) const
+{
+    dtPolyRef startRef;
+    dtPolyRef endRef;
+    query->findNearestPoly(&localStart.x_, &extents.x_, filter, &startRef, 0);
+    query->findNearestPoly(&localEnd.x_, &extents.x_, filter, &endRef, 0);
+
+    if (!startRef || !endRef)
+        return 0;
+
+    // Reuse the corridor found between the same polygons. Otherwise search the distant polygons through the tile graph first
+    const bool useCache = pathCache_->GetMaxSize() != 0;
+    const NavPathCacheKey key(startRef, endRef, filter);
+    int numPolys = useCache ? pathCache_->Find(key, navMesh_, data->polys_, MAX_POLYS) : 0;
+    if (!numPolys)
+    {
+        if (hierarchicalPathDistance_ > 0)
+            numPolys = FindHierarchicalCorridor(query, data, startRef, endRef, localStart, localEnd, extents, filter);
+        if (!numPolys)
+            query->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, filter, data->polys_, &numPolys, MAX_POLYS);
+        if (!numPolys)
+            return 0;
+        if (useCache)
+            pathCache_->Store(key, data->polys_, numPolys);
+    }
+
+    Vector3 actualLocalEnd = localEnd;
+
+    // If full path was not found, clamp end point to the end polygon
+    if (data->polys_[numPolys - 1] != endRef)
+        query->closestPointOnPoly(data->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, 0);
+
+    int numPathPoints = 0;
+    query->findStraightPath(&localStart.x_, &actualLocalEnd.x_, data->polys_, numPolys,
+        &data->pathPoints_[0].x_, data->pathFlags_, data->pathPolys_, &numPathPoints, MAX_POLYS);
+
+    return numPathPoints;
+}
+
+int NavigationMesh::FindHierarchicalCorridor(dtNavMeshQuery* query, FindPathData* data, dtPolyRef startRef, dtPolyRef endRef,
+    const Vector3& localStart, const Vector3& localEnd, const Vector3& extents, const dtQueryFilter* filter) const
+{
+    const dtMeshTile* startTile = 0;
+    const dtMeshTile* endTile = 0;
+    const dtPoly* poly = 0;
+    navMesh_->getTileAndPolyByRefUnsafe(startRef, &startTile, &poly);
+    navMesh_->getTileAndPolyByRefUnsafe(endRef, &endTile, &poly);
+
+    const int distance = Max(Abs(startTile->header->x - endTile->header->x), Abs(startTile->header->y - endTile->header->y));
+    if (distance <= hierarchicalPathDistance_)
+        return 0;
+
+    PODVector<unsigned>& links = data->tileGraphPath_;
+    if (!tileGraph_->FindPath(navMesh_->decodePolyIdTile(startRef), navMesh_->decodePolyIdTile(endRef), data->tileGraphSearch_, links))
+        return 0;
+
+    // Search the corridor between the portals every few tiles along the tile path. The segments are searched in the path
+    // polygons buffer, which is only used after the corridor is complete
+    const unsigned step = (unsigned)Max(hierarchicalPathDistance_ / 2, 1);
+    dtPolyRef fromRef = startRef;
+    Vector3 fromPos = localStart;
+    int numPolys = 0;
+
+    for (unsigned i = step - 1; ; i += step)
+    {
+        dtPolyRef toRef = endRef;
+        Vector3 toPos = localEnd;
+        if (i < links.Size())
+        {
+            const NavTileGraphLink& link = tileGraph_->GetLink(links[i]);
+            toRef = link.portalRef_;
+            toPos = link.portalPosition_;
+
+            // The portal polygon is replaced when the tile cache rebuilds its tile
+            if (!navMesh_->isValidPolyRef(toRef))
+                query->findNearestPoly(&link.portalPosition_.x_, &extents.x_, filter, &toRef, &toPos.x_);
+            if (!toRef)
+                return 0;
+        }
+
+        int numSegmentPolys = 0;
+        query->findPath(fromRef, toRef, &fromPos.x_, &toPos.x_, filter, data->pathPolys_, &numSegmentPolys, MAX_POLYS);
+        if (!numSegmentPolys || data->pathPolys_[numSegmentPolys - 1] != toRef)
+            return 0;
+
+        // Join the segments at the portal polygons, cutting the loops where a segment turns back
+        for (int j = numPolys ? 1 : 0; j < numSegmentPolys && numPolys < MAX_POLYS; ++j)
+        {
+            const dtPolyRef ref = data->pathPolys_[j];
+            const int minIndex = Max(numPolys - MAX_LOOP_SEARCH, 0);
+            int k = numPolys - 1;
+            while (k >= minIndex && data->polys_[k] != ref)
+                --k;
+
+            if (k >= minIndex)
+                numPolys = k + 1;
+            else
+                data->polys_[numPolys++] = ref;
+        }
+
+        if (toRef == endRef || numPolys >= MAX_POLYS)
+            break;
+
+        fromRef = toRef;
+        fromPos = toPos;
+    }
+
+    return numPolys;
+}
+
+void NavigationMesh::RunPathQuery(NavigationPathQuery* query, unsigned threadIndex) const
+{
+    const Matrix3x4 inverse = query->transform_.Inverse();
+    FindPathData* data = pathThreadData_[threadIndex];
+
+    const int numPathPoints = QueryPath(pathThreadQueries_[threadIndex], data, inverse * query->start_, inverse * query->end_,
+        query->extents_, query->filter_);
+    StorePathPoints(query->path_, data, numPathPoints, query->transform_, query->areas_);
+    query->completed_ = true;
+}
+
 void NavigationMesh::ReleaseNavigationMesh()
 {
+    // Discard the asynchronous rebuilds, their tiles belong to the released navigation mesh
+    FinishAsyncBuild(false);
+
+    // Complete the path queries, then release their thread data, the corridors and the tile graph of the released navigation mesh
+    ReleasePathThreads();
+    pathCache_->Clear();
+    tileGraph_->Clear();
+    tileGraphDirty_ = true;
+
     dtFreeNavMesh(navMesh_);
     navMesh_ = 0;
 
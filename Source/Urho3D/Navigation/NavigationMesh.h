@@ -50,8 +50,12 @@ enum NavmeshPartitionType
 class Geometry;
 class NavArea;
 
+class NavPathCache;
+class NavTileGraph;
 struct FindPathData;
 struct NavBuildData;
+struct NavPathArea;
+struct WorkItem;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -86,12 +90,55 @@ struct URHO3D_API NavigationPathPoint
     unsigned char areaID_;
 };
 
+/// FromBones : path query of a navigation mesh running in the worker threads.
+class URHO3D_API NavigationPathQuery : public RefCounted
+{
+    friend class NavigationMesh;
+
+public:
+    /// Construct.
+    NavigationPathQuery();
+    /// Destruct.
+    virtual ~NavigationPathQuery();
+
+    /// Return whether the path has been searched.
+    bool IsCompleted() const { return completed_; }
+    /// Return the path points once completed, empty if no path was found.
+    const PODVector<NavigationPathPoint>& GetPath() const { return path_; }
+    /// Return world-space start point.
+    const Vector3& GetStart() const { return start_; }
+    /// Return world-space end point.
+    const Vector3& GetEnd() const { return end_; }
+
+private:
+    /// World-space start point.
+    Vector3 start_;
+    /// World-space end point.
+    Vector3 end_;
+    /// Distance off the navigation mesh the points can be.
+    Vector3 extents_;
+    /// Query filter.
+    const dtQueryFilter* filter_;
+    /// World transform of the navigation mesh when the query was made.
+    Matrix3x4 transform_;
+    /// Navigation areas when the query was made.
+    PODVector<NavPathArea> areas_;
+    /// Path points.
+    PODVector<NavigationPathPoint> path_;
+    /// Work item.
+    SharedPtr<WorkItem> item_;
+    /// Completed flag.
+    volatile bool completed_;
+};
+
 /// Navigation mesh component. Collects the navigation geometry from child nodes with the Navigable component and responds to path queries.
 class URHO3D_API NavigationMesh : public Component
 {
     URHO3D_OBJECT(NavigationMesh, Component);
 
     friend class CrowdManager;
+    friend void ProcessTileWork(const WorkItem* item, unsigned threadIndex);
+    friend void FindPathWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -138,6 +185,10 @@ public:
     virtual bool Build();
     /// Rebuild part of the navigation mesh contained by the world-space bounding box. Return true if successful.
     virtual bool Build(const BoundingBox& boundingBox);
+    /// FromBones : Rebuild part of the navigation mesh contained by the world-space bounding box in the worker threads. The tiles are replaced as they complete during the next scene updates, then E_NAVIGATION_ASYNC_REBUILT is sent. Return true if the rebuild was started.
+    bool BuildAsync(const BoundingBox& boundingBox);
+    /// FromBones : Wait for the asynchronous rebuilds in progress and replace their tiles.
+    void CompleteAsyncBuild();
     /// Find the nearest point on the navigation mesh to a given point. Extents specifies how far out from the specified point to check along each axis.
     Vector3 FindNearestPoint
         (const Vector3& point, const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = 0, dtPolyRef* nearestRef = 0);
@@ -151,6 +202,17 @@ public:
     void FindPath
         (PODVector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
             const dtQueryFilter* filter = 0);
+    /// FromBones : Find a path between world space points in the worker threads. The query is completed at the latest before the navigation mesh tiles change. Return null if the navigation mesh is not built.
+    SharedPtr<NavigationPathQuery> FindPathAsync(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
+        const dtQueryFilter* filter = 0);
+    /// FromBones : Wait for the path queries in progress.
+    void CompletePathQueries();
+    /// FromBones : Set the number of path corridors kept to answer the queries between the same polygons with the same filter. 0 disables the cache. Default 256.
+    void SetPathCacheSize(unsigned size);
+    /// FromBones : Remove the cached path corridors. Call after changing a query filter used by the path queries.
+    void ClearPathCache();
+    /// FromBones : Set the distance in tiles beyond which the paths are searched through the tile graph first, then refined between the tile portals on the way. The paths found may be longer than the shortest ones. 0 disables. Default 0.
+    void SetHierarchicalPathDistance(int distance);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = 0, dtPolyRef* randomRef = 0);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -222,6 +284,15 @@ public:
     /// Return whether has been initialized with valid navigation data.
     bool IsInitialized() const { return navMesh_ != 0; }
 
+    /// FromBones : Return whether asynchronous rebuilds are in progress.
+    bool IsBuildingAsync() const { return !asyncBuildItems_.Empty(); }
+
+    /// FromBones : Return the number of path corridors kept.
+    unsigned GetPathCacheSize() const;
+
+    /// FromBones : Return the distance in tiles beyond which the paths are searched through the tile graph first.
+    int GetHierarchicalPathDistance() const { return hierarchicalPathDistance_; }
+
     /// Return local space bounding box of the navigation mesh.
     const BoundingBox& GetBoundingBox() const { return boundingBox_; }
 
@@ -265,9 +336,41 @@ protected:
     /// Add a triangle mesh to the geometry data.
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
     /// Build one tile of the navigation mesh. Return true if successful.
-    virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// FromBones : Build a range of tiles, processing them in the worker threads. Return the number of tiles built.
+    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// FromBones : Create the build data of a tile and collect its geometry. Called in the main thread.
+    virtual NavBuildData* PrepareTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// FromBones : Fill the tile coordinates, configuration and geometry of the build data. Called in the main thread.
+    void PrepareTileBuild(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// FromBones : Run the Recast pipeline of a prepared tile. Can be called from a worker thread, so must only access the build data. Return true if successful.
+    virtual bool ProcessTile(NavBuildData* build) const;
+    /// FromBones : Replace the tile in the navigation mesh by the processed one and send the tile rebuild event. Called in the main thread. Return true if successful.
+    virtual bool CommitTile(NavBuildData* build);
+    /// FromBones : Wait for the asynchronous rebuilds in progress, replacing their tiles or discarding them.
+    void FinishAsyncBuild(bool commit);
+    /// FromBones : Replace the tiles of the completed asynchronous rebuilds.
+    void HandleAsyncBuildUpdate(StringHash eventType, VariantMap& eventData);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
+    /// FromBones : Ensure that each thread has a navigation mesh query for the path queries. Return true if successful.
+    bool InitializePathThreads(unsigned numThreads);
+    /// FromBones : Release the navigation mesh queries of the worker threads.
+    void ReleasePathThreads();
+    /// FromBones : Wait for the path queries in progress and mark the tile graph for rebuild. Called before the navigation mesh tiles change.
+    void PrepareTileChange();
+    /// FromBones : Rebuild the tile graph if the tiles have changed and hierarchical path queries are enabled.
+    void UpdateTileGraph();
+    /// FromBones : Copy the enabled navigation areas for the path queries.
+    void CollectPathAreas(PODVector<NavPathArea>& dest) const;
+    /// FromBones : Find the straight path between local space points with the query and temporary data of a thread. Return the number of path points.
+    int QueryPath(dtNavMeshQuery* query, FindPathData* data, const Vector3& localStart, const Vector3& localEnd,
+        const Vector3& extents, const dtQueryFilter* filter) const;
+    /// FromBones : Find the corridor between distant polygons through the tile graph. Return the number of polygons or 0 if not found.
+    int FindHierarchicalCorridor(dtNavMeshQuery* query, FindPathData* data, dtPolyRef startRef, dtPolyRef endRef,
+        const Vector3& localStart, const Vector3& localEnd, const Vector3& extents, const dtQueryFilter* filter) const;
+    /// FromBones : Run a path query in a thread.
+    void RunPathQuery(NavigationPathQuery* query, unsigned threadIndex) const;
     /// Release the navigation mesh and the query.
     virtual void ReleaseNavigationMesh();
 
@@ -325,6 +428,22 @@ protected:
     bool drawNavAreas_;
     /// NavAreas for this NavMesh
     Vector<WeakPtr<NavArea> > areas_;
+    /// FromBones : work items of the asynchronous rebuilds in progress, in the order their tiles are replaced.
+    Vector<SharedPtr<WorkItem> > asyncBuildItems_;
+    /// FromBones : path queries in progress.
+    Vector<SharedPtr<NavigationPathQuery> > pathQueries_;
+    /// FromBones : navigation mesh queries of the worker threads. The main thread uses the navigation mesh query.
+    PODVector<dtNavMeshQuery*> pathThreadQueries_;
+    /// FromBones : temporary data for finding a path in the worker threads.
+    PODVector<FindPathData*> pathThreadData_;
+    /// FromBones : cached path corridors.
+    UniquePtr<NavPathCache> pathCache_;
+    /// FromBones : tile graph for the hierarchical path queries.
+    UniquePtr<NavTileGraph> tileGraph_;
+    /// FromBones : distance in tiles beyond which the paths are searched through the tile graph first.
+    int hierarchicalPathDistance_;
+    /// FromBones : whether the tiles have changed since the tile graph was built.
+    bool tileGraphDirty_;
 };
 
 /// Register Navigation library objects.
@@ -82,7 +82,11 @@ Connection::Connection(Context* context, bool isClient, const SLNet::AddressOrGU
 	address_(0),
     allowClientObjectControls_(true),
     allowServerObjectControls_(true),
-    preparedCommonServerMessageBuffer_(0)
+    preparedCommonServerMessageBuffer_(0),
+    serverObjectControlBatch_(0),
+    objectControlClientIndex_(M_MAX_UNSIGNED),
+    receivedObjectControlRecords_(0),
+    numReceivedObjectControlRecords_(0)
 {
     sceneState_.connection_ = this;
     port_ = address.systemAddress.GetPort();
@@ -120,6 +124,9 @@ void Connection::ResetObjectControlAndCommands()
     receivedServerObjectControlsBuffer_.Clear();
     if (preparedCommonServerMessageBuffer_)
         preparedCommonServerMessageBuffer_->Clear();
+    receivedObjectControlRecordsBuffer_.Clear();
+    receivedObjectControlRecords_ = 0;
+    numReceivedObjectControlRecords_ = 0;
 
     objCmdOutStamp_ = objCmdOutStampAck_ = 0U;
     objCmdInStamp_ = objCmdInStampAck_ = 0U;
@@ -241,6 +248,41 @@ void Connection::ProcessReceiveObjectControls(int msgID, MemoryBuffer& msg)
     SendEvent(msgID == MSG_SERVEROBJECTCONTROLS ? SERVEROBJECTCONTROLSRECEIVED : CLIENTOBJECTCONTROLSRECEIVED);
 }
 
+/// FromBones Receive Object Control Records : used by ProcessMessage in Client Mode
+void Connection::ProcessReceiveObjectControlRecords(int msgID, MemoryBuffer& msg)
+{
+    if (!allowServerObjectControls_)
+        return;
+
+    if (msg.GetSize()-msg.Tell() <= sizeof(unsigned short))
+        return;
+
+    unsigned short int stamp = msg.ReadUShort();
+    if (CheckStamp(stamp) == -1)
+    {
+        URHO3D_LOGDEBUGF("Connection() - ProcessReceiveObjectControlRecords : t=%d lt=%u DESYNC !", stamp, objectTimeStampReceived_[0]);
+        return;
+    }
+
+    URHO3D_PROFILE(DecodeObjectControls);
+
+    receivedObjectControlRecordsBuffer_.Clear();
+    if (!DecompressStream(receivedObjectControlRecordsBuffer_, msg))
+        return;
+
+    // The records are used in place, no copy
+    receivedObjectControlRecords_ = ObjectControlBatch::DecodeRecords(receivedObjectControlRecordsBuffer_.GetData(),
+                                    receivedObjectControlRecordsBuffer_.GetSize(), numReceivedObjectControlRecords_);
+    if (!receivedObjectControlRecords_)
+    {
+        URHO3D_LOGWARNINGF("Connection() - ProcessReceiveObjectControlRecords : t=%d record layout mismatch (version=%u expected=%u) !",
+                           stamp, receivedObjectControlRecordsBuffer_.GetSize() ? receivedObjectControlRecordsBuffer_.GetData()[0] : 0U, OBJECTCONTROL_RECORD_VERSION);
+        return;
+    }
+
+    SendEvent(SERVEROBJECTCONTROLRECORDSRECEIVED);
+}
+
 // Send the objects controlled By the client : send to the server the new ObjectControls
 // send only one "snapshot" message for the ObjectControls
 void Connection::ProcessSendClientObjectControls()
@@ -301,6 +343,10 @@ void Connection::ProcessSendServerObjectControls()
         }
     }
 
+    // Send Server Object Control Records : use the same TimeStamp than the buffers
+    if (ProcessSendObjectControlRecords(hasServerBuffers))
+        hasServerBuffers = true;
+
     // Send Client Object Controls
     if (allowClientObjectControls_ && preparedClientMessageBuffer_.GetSize())
     {
@@ -324,6 +370,34 @@ void Connection::ProcessSendServerObjectControls()
     }
 }
 
+// Send the shared batch of records : the packet is prepared once per tick by the batch and sent without copy
+bool Connection::ProcessSendObjectControlRecords(bool stampUpdated)
+{
+    if (!allowServerObjectControls_ || !serverObjectControlBatch_ || !peer_)
+        return false;
+
+    URHO3D_PROFILE(SendObjectControlRecords);
+
+    VectorBuffer* packet = serverObjectControlBatch_->GetPacket(objectControlClientIndex_);
+    if (!packet)
+        return false;
+
+    // Set TimeStamp if not already updated with the buffers
+    if (!stampUpdated)
+        objectTimeStamp_++;
+
+    // Fill the reserved header in place, the peer copies the data on Send
+    const unsigned msgID = MSG_SERVEROBJECTCONTROLRECORDS;
+    unsigned char* data = packet->GetModifiableData();
+    data[0] = (unsigned char)ID_USER_PACKET_ENUM;
+    memcpy(data + 1, &msgID, sizeof(unsigned));
+    memcpy(data + 1 + sizeof(unsigned), &objectTimeStamp_, sizeof(unsigned short));
+
+    peer_->Send((const char*)data, (int)packet->GetSize(), HIGH_PRIORITY, UNRELIABLE, (char)0, *address_, false);
+    tempPacketCounter_.y_++;
+    return true;
+}
+
 void Connection::ProcessReceiveObjectCommands(int msgID, MemoryBuffer& msg)
 {
     if (msg.GetSize()-msg.Tell() < 2*sizeof(unsigned short))
@@ -781,6 +855,9 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
     case MSG_CLIENTOBJECTCONTROLS:
         ProcessReceiveObjectControls(msgID, msg);
         break;
+    case MSG_SERVEROBJECTCONTROLRECORDS:
+        ProcessReceiveObjectControlRecords(msgID, msg);
+        break;
     case MSG_OBJECTCOMMANDS:
         ProcessReceiveObjectCommands(msgID, msg);
         break;
@@ -29,6 +29,7 @@
 #include "../Core/Timer.h"
 #include "../Input/Controls.h"
 #include "../IO/VectorBuffer.h"
+#include "../Network/ObjectControlBatch.h"
 #include "../Scene/ReplicationState.h"
 
 namespace SLNet
@@ -137,6 +138,14 @@ public:
     VectorBuffer& GetReceivedClientObjectControlsBuffer() { return receivedClientObjectControlsBuffer_; }
     VectorBuffer& GetReceivedServerObjectControlsBuffer() { return receivedServerObjectControlsBuffer_; }
 
+    /// Set the shared batch of fixed-layout records sent to this client each tick (server side).
+    void SetServerObjectControlBatch(ObjectControlBatch* batch) { serverObjectControlBatch_ = batch; }
+    /// Set the client index used to filter the batch records by client mask. Called by Network.
+    void SetObjectControlClientIndex(unsigned index) { objectControlClientIndex_ = index; }
+    unsigned GetObjectControlClientIndex() const { return objectControlClientIndex_; }
+    /// Return the fixed-layout records received in the last server packet (client side). The records point into the receive buffer and are valid until the next packet.
+    const ObjectControlRecord* GetReceivedObjectControlRecords(unsigned& numRecords) const { numRecords = numReceivedObjectControlRecords_; return receivedObjectControlRecords_; }
+
     unsigned short int GetObjectTimeStamp() const { return objectTimeStamp_; }
     unsigned short int GetObjectTimeStampReceived() const { return objectTimeStampReceived_[0]; }
     unsigned short int GetObjectTimeStampPrevReceived() const { return objectTimeStampReceived_[1]; }
@@ -145,6 +154,9 @@ private:
     void ProcessReceiveObjectControls(int msgID, MemoryBuffer& msg);
     void ProcessSendClientObjectControls();
     void ProcessSendServerObjectControls();
+    /// FromBones : Receive/Send the fixed-layout records
+    void ProcessReceiveObjectControlRecords(int msgID, MemoryBuffer& msg);
+    bool ProcessSendObjectControlRecords(bool stampUpdated);
 
     /// FromBones : Objects TimeStamp
     int CheckStamp(unsigned short int newt);
@@ -159,6 +171,12 @@ private:
     VectorBuffer receivedServerObjectControlsBuffer_;
     bool allowClientObjectControls_, allowServerObjectControls_;
 
+    ObjectControlBatch* serverObjectControlBatch_;
+    unsigned objectControlClientIndex_;
+    VectorBuffer receivedObjectControlRecordsBuffer_;
+    const ObjectControlRecord* receivedObjectControlRecords_;
+    unsigned numReceivedObjectControlRecords_;
+
 /// Object Commands
 
 /// objCmdInStamp_      = input stamp           : stamp reçu (input) en provenance du peer
@@ -203,7 +203,9 @@ Network::Network(Context* context) :
     isServer_(false),
     scene_(0),
     natPunchServerAddress_(0),
-    remoteGUID_(0)
+    remoteGUID_(0),
+    serverObjectControlBatch_(0),
+    objectControlClientIndices_(0)
 {
     // Register Network library object factories
     RegisterNetworkLibrary(context_);
@@ -310,6 +312,7 @@ void Network::Stop()
 	Disconnect(100);
     serverConnection_.Reset();
     clientConnections_.Clear();
+    objectControlClientIndices_ = 0;
 
 	if (natPunchthroughServerClient_)
 	    delete natPunchthroughServerClient_;
@@ -390,6 +393,18 @@ void Network::NewConnectionEstablished(const SLNet::AddressOrGUID& connection)
     // Create a new client connection corresponding to this MessageConnection
     SharedPtr<Connection> newConnection(new Connection(context_, true, connection, rakPeer_));
     newConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+
+    // FromBones : Give the lowest free client index for the object control records filtering
+    for (unsigned index = 0; index < OBJECTCONTROL_MAX_CLIENTS; ++index)
+    {
+        if (!(objectControlClientIndices_ & (1ULL << index)))
+        {
+            objectControlClientIndices_ |= (1ULL << index);
+            newConnection->SetObjectControlClientIndex(index);
+            break;
+        }
+    }
+    newConnection->SetServerObjectControlBatch(serverObjectControlBatch_);
     clientConnections_[connection] = newConnection;
     URHO3D_LOGINFO("Client " + newConnection->ToString() + " connected");
 
@@ -415,6 +430,9 @@ void Network::ClientDisconnected(const SLNet::AddressOrGUID& connection)
         eventData[P_CONNECTION] = connection;
         connection->SendEvent(E_CLIENTDISCONNECTED, eventData);
 
+        if (connection->GetObjectControlClientIndex() < OBJECTCONTROL_MAX_CLIENTS)
+            objectControlClientIndices_ &= ~(1ULL << connection->GetObjectControlClientIndex());
+
         clientConnections_.Erase(i);
     }
 }
@@ -535,6 +553,7 @@ void Network::StopServer()
     URHO3D_PROFILE(StopServer);
 
     clientConnections_.Clear();
+    objectControlClientIndices_ = 0;
     // Provide 300 ms to notify
 	if (rakPeer_)
     	rakPeer_->Shutdown(300);
@@ -648,6 +667,14 @@ void Network::BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrde
     }
 }
 
+void Network::SetServerObjectControlBatch(ObjectControlBatch* batch)
+{
+    serverObjectControlBatch_ = batch;
+
+    for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin(); i != clientConnections_.End(); ++i)
+        i->second_->SetServerObjectControlBatch(batch);
+}
+
 void Network::SetUpdateFps(int fps)
 {
     updateFps_ = Max(fps, 1);
@@ -107,6 +107,10 @@ public:
     SharedPtr<HttpRequest> MakeHttpRequest(const String& url, const String& verb = String::EMPTY, const Vector<String>& headers = Vector<String>(), const String& postData = String::EMPTY);
     /// Ban specific IP addresses.
     void BanAddress(const String& address);
+    /// FromBones : Set the shared batch of object control records sent to all the client connections each network update.
+    void SetServerObjectControlBatch(ObjectControlBatch* batch);
+    /// FromBones : Return the shared batch of object control records.
+    ObjectControlBatch* GetServerObjectControlBatch() const { return serverObjectControlBatch_; }
     /// Return network update FPS.
     int GetUpdateFps() const { return updateFps_; }
 
@@ -195,6 +199,10 @@ private:
     SLNet::RakNetGUID* remoteGUID_;
     /// Local server GUID.
     String guid_;
+    /// FromBones : Shared batch of object control records.
+    ObjectControlBatch* serverObjectControlBatch_;
+    /// FromBones : Client indices in use for the object control records filtering.
+    unsigned long long objectControlClientIndices_;
 };
 
 /// Register Network library objects.
@@ -151,6 +151,8 @@ URHO3D_EVENT(E_NATMASTERCONNECTIONSUCCEEDED, NetworkNatMasterConnectionSucceeded
 /// Frombones : Connection Receives a Packet of ObjectControls
 URHO3D_EVENT(SERVEROBJECTCONTROLSRECEIVED, ServerObjectControlsReceived) { }
 URHO3D_EVENT(CLIENTOBJECTCONTROLSRECEIVED, ClientObjectControlsReceived) { }
+/// Frombones : Connection Receives a Packet of fixed-layout ObjectControl records
+URHO3D_EVENT(SERVEROBJECTCONTROLRECORDSRECEIVED, ServerObjectControlRecordsReceived) { }
 /// Frombones : Connection Receives a Packet of ObjectCommands
 URHO3D_EVENT(OBJECTCOMMANDSRECEIVED, ObjectCommandsReceived) { }
 
@@ -0,0 +1,200 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../IO/Compression.h"
+#include "../IO/Log.h"
+#include "../Network/ObjectControlBatch.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static_assert(sizeof(ObjectControlRecord) == 48, "ObjectControlRecord layout changed, increment OBJECTCONTROL_RECORD_VERSION");
+static_assert(sizeof(ObjectControlRecordHeader) == 4, "ObjectControlRecordHeader must be packed");
+
+ObjectControlBatch::ObjectControlBatch() :
+    commonMask_(OBJECTCONTROL_ALLCLIENTS),
+    filteredPacketsBuilt_(0),
+    commonPacketBuilt_(false),
+    broadcastPacketBuilt_(false),
+    numEncodedPackets_(0)
+{
+}
+
+void ObjectControlBatch::Clear()
+{
+    records_.Clear();
+    clientMasks_.Clear();
+    commonMask_ = OBJECTCONTROL_ALLCLIENTS;
+    commonPacketBuilt_ = false;
+    broadcastPacketBuilt_ = false;
+    filteredPacketsBuilt_ = 0;
+    numEncodedPackets_ = 0;
+}
+
+void ObjectControlBatch::AddRecord(const ObjectControlRecord& record, unsigned long long clientMask)
+{
+    if (!clientMask)
+        return;
+
+    if (records_.Size() >= 0xffff)
+    {
+        URHO3D_LOGWARNING("ObjectControlBatch() - AddRecord : too many records in the batch !");
+        return;
+    }
+
+    records_.Push(record);
+    clientMasks_.Push(clientMask);
+    commonMask_ &= clientMask;
+
+    // The packets are rebuilt on next request
+    commonPacketBuilt_ = false;
+    broadcastPacketBuilt_ = false;
+    filteredPacketsBuilt_ = 0;
+}
+
+VectorBuffer* ObjectControlBatch::GetPacket(unsigned clientIndex)
+{
+    if (records_.Empty())
+        return 0;
+
+    // Connections without an index only receive the records sent to all clients
+    const unsigned long long clientBit = clientIndex < OBJECTCONTROL_MAX_CLIENTS ? (1ULL << clientIndex) : 0ULL;
+
+    if (commonMask_ == OBJECTCONTROL_ALLCLIENTS || (commonMask_ & clientBit))
+    {
+        if (!commonPacketBuilt_)
+            commonPacketBuilt_ = BuildPacket(commonPacket_, OBJECTCONTROL_ALLCLIENTS);
+
+        return commonPacketBuilt_ && commonPacket_.GetSize() ? &commonPacket_ : 0;
+    }
+
+    // The last slot is used by the connections without a client index
+    const unsigned slot = clientBit ? clientIndex : OBJECTCONTROL_MAX_CLIENTS;
+    if (filteredPackets_.Size() <= slot)
+        filteredPackets_.Resize(slot + 1);
+
+    VectorBuffer& packet = filteredPackets_[slot];
+    const bool built = clientBit ? (filteredPacketsBuilt_ & clientBit) != 0 : broadcastPacketBuilt_;
+    if (!built)
+    {
+        if (!BuildPacket(packet, clientBit))
+            packet.Clear();
+
+        if (clientBit)
+            filteredPacketsBuilt_ |= clientBit;
+        else
+            broadcastPacketBuilt_ = true;
+    }
+
+    return packet.GetSize() ? &packet : 0;
+}
+
+bool ObjectControlBatch::BuildPacket(VectorBuffer& packet, unsigned long long clientBit)
+{
+    packet.Clear();
+
+    if (!EncodeRecords(encodeBuffer_, records_.Buffer(), clientMasks_.Buffer(), records_.Size(), clientBit))
+        return true;
+
+    // Same layout as CompressStream() so that the receiver can use DecompressStream() after reading the timestamp
+    const unsigned srcSize = encodeBuffer_.GetSize();
+    compressBuffer_.Resize(EstimateCompressBound(srcSize));
+    const unsigned destSize = CompressData(compressBuffer_.Buffer(), encodeBuffer_.GetData(), srcSize);
+    if (!destSize)
+        return false;
+
+    packet.Resize(OBJECTCONTROL_PACKET_RESERVED);
+    packet.Seek(OBJECTCONTROL_PACKET_RESERVED);
+    packet.WriteUInt(srcSize);
+    packet.WriteUInt(destSize);
+    packet.Write(compressBuffer_.Buffer(), destSize);
+
+    numEncodedPackets_++;
+    return true;
+}
+
+unsigned ObjectControlBatch::EncodeRecords(VectorBuffer& dest, const ObjectControlRecord* records, const unsigned long long* clientMasks, unsigned numRecords, unsigned long long clientBit)
+{
+    dest.Clear();
+
+    if (!numRecords)
+        return 0;
+
+    // Reserve for all the records then shrink to the visible ones
+    dest.Resize(sizeof(ObjectControlRecordHeader) + numRecords * sizeof(ObjectControlRecord));
+
+    unsigned char* data = dest.GetModifiableData();
+    ObjectControlRecord* destRecords = reinterpret_cast<ObjectControlRecord*>(data + sizeof(ObjectControlRecordHeader));
+
+    unsigned numVisibleRecords = 0;
+    if (clientBit == OBJECTCONTROL_ALLCLIENTS)
+    {
+        memcpy(destRecords, records, numRecords * sizeof(ObjectControlRecord));
+        numVisibleRecords = numRecords;
+    }
+    else
+    {
+        for (unsigned i = 0; i < numRecords; ++i)
+        {
+            if ((clientMasks[i] & clientBit) || clientMasks[i] == OBJECTCONTROL_ALLCLIENTS)
+                destRecords[numVisibleRecords++] = records[i];
+        }
+    }
+
+    if (!numVisibleRecords)
+    {
+        dest.Clear();
+        return 0;
+    }
+
+    ObjectControlRecordHeader* header = reinterpret_cast<ObjectControlRecordHeader*>(data);
+    header->version_ = OBJECTCONTROL_RECORD_VERSION;
+    header->recordSize_ = (unsigned char)sizeof(ObjectControlRecord);
+    header->numRecords_ = (unsigned short)numVisibleRecords;
+
+    dest.Resize(sizeof(ObjectControlRecordHeader) + numVisibleRecords * sizeof(ObjectControlRecord));
+    return numVisibleRecords;
+}
+
+const ObjectControlRecord* ObjectControlBatch::DecodeRecords(const unsigned char* data, unsigned size, unsigned& numRecords)
+{
+    numRecords = 0;
+
+    if (!data || size < sizeof(ObjectControlRecordHeader))
+        return 0;
+
+    const ObjectControlRecordHeader* header = reinterpret_cast<const ObjectControlRecordHeader*>(data);
+    if (header->version_ != OBJECTCONTROL_RECORD_VERSION || header->recordSize_ != sizeof(ObjectControlRecord))
+        return 0;
+
+    if (size < sizeof(ObjectControlRecordHeader) + header->numRecords_ * sizeof(ObjectControlRecord))
+        return 0;
+
+    numRecords = header->numRecords_;
+    return reinterpret_cast<const ObjectControlRecord*>(data + sizeof(ObjectControlRecordHeader));
+}
+
+}
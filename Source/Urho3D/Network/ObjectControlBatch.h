@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/// \file
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../IO/VectorBuffer.h"
+#include "../Math/Vector2.h"
+
+namespace Urho3D
+{
+
+/// FromBones : version of the ObjectControlRecord layout. Increment when the record layout changes.
+static const unsigned char OBJECTCONTROL_RECORD_VERSION = 1;
+/// FromBones : maximum number of client connections that can be filtered individually.
+static const unsigned OBJECTCONTROL_MAX_CLIENTS = 64;
+/// FromBones : client mask for records that are sent to all the connections.
+static const unsigned long long OBJECTCONTROL_ALLCLIENTS = 0xffffffffffffffffULL;
+/// FromBones : bytes reserved in front of a prepared packet for the packet id, the message id and the object timestamp.
+static const unsigned OBJECTCONTROL_PACKET_RESERVED = 1 + sizeof(unsigned) + sizeof(unsigned short);
+
+/// FromBones : fixed-layout object control record (node states : buttons, animstate, avatarindex ...).
+/// Written and read as raw bytes, so it must stay a POD with a fixed size.
+struct ObjectControlRecord
+{
+    /// Replicated node ID.
+    unsigned nodeID_;
+    /// Control buttons.
+    unsigned buttons_;
+    /// Animation state hash.
+    unsigned animState_;
+    /// Avatar index.
+    unsigned short avatarIndex_;
+    /// User flags.
+    unsigned short flags_;
+    /// World position.
+    Vector2 position_;
+    /// Linear velocity.
+    Vector2 velocity_;
+    /// Rotation angle in degrees.
+    float rotation_;
+    /// Direction (1 or -1 for the facing side).
+    float direction_;
+    /// User data.
+    unsigned userData_[2];
+};
+
+/// FromBones : header written in front of the records in a packet payload.
+struct ObjectControlRecordHeader
+{
+    /// Record layout version.
+    unsigned char version_;
+    /// Record size in bytes.
+    unsigned char recordSize_;
+    /// Number of records.
+    unsigned short numRecords_;
+};
+
+/// FromBones : per-tick batch of object control records shared by all the server connections.
+/// The records are encoded and compressed once per tick and the resulting packet is shared by all the connections
+/// which see every record. The connections excluded from some records by the client masks get their own filtered packet.
+class URHO3D_API ObjectControlBatch
+{
+public:
+    /// Construct.
+    ObjectControlBatch();
+
+    /// Remove all the records. Call at the beginning of each network tick.
+    void Clear();
+    /// Add a record visible by the connections whose client index bit is set in the mask.
+    void AddRecord(const ObjectControlRecord& record, unsigned long long clientMask = OBJECTCONTROL_ALLCLIENTS);
+
+    /// Return the prepared packet for a client index, with OBJECTCONTROL_PACKET_RESERVED bytes left in front for the connection. The packet is built on first request in the tick. Return null if no records are visible by the client.
+    VectorBuffer* GetPacket(unsigned clientIndex);
+
+    /// Return the number of records.
+    unsigned GetNumRecords() const { return records_.Size(); }
+    /// Return the records.
+    const PODVector<ObjectControlRecord>& GetRecords() const { return records_; }
+    /// Return the client masks of the records.
+    const PODVector<unsigned long long>& GetClientMasks() const { return clientMasks_; }
+    /// Return the number of packets encoded since the last Clear().
+    unsigned GetNumEncodedPackets() const { return numEncodedPackets_; }
+
+    /// Encode the records visible by a client mask in a payload (header and records). Return the number of encoded records.
+    static unsigned EncodeRecords(VectorBuffer& dest, const ObjectControlRecord* records, const unsigned long long* clientMasks, unsigned numRecords, unsigned long long clientBit);
+    /// Validate a decompressed payload and return a view on its records without copy. Return null if the version or the layout does not match.
+    static const ObjectControlRecord* DecodeRecords(const unsigned char* data, unsigned size, unsigned& numRecords);
+
+private:
+    /// Encode and compress the records visible by a client bit in a packet.
+    bool BuildPacket(VectorBuffer& packet, unsigned long long clientBit);
+
+    /// Records.
+    PODVector<ObjectControlRecord> records_;
+    /// Client masks of the records.
+    PODVector<unsigned long long> clientMasks_;
+    /// Client bits set in all the record masks : these connections share the common packet.
+    unsigned long long commonMask_;
+    /// Packet shared by the connections which see all the records.
+    VectorBuffer commonPacket_;
+    /// Filtered packets by client index, the last one is for the connections without a client index.
+    Vector<VectorBuffer> filteredPackets_;
+    /// Filtered packets which are up to date for this tick.
+    unsigned long long filteredPacketsBuilt_;
+    /// Encoding buffer.
+    VectorBuffer encodeBuffer_;
+    /// Compression buffer.
+    PODVector<unsigned char> compressBuffer_;
+    /// Common packet up to date flag.
+    bool commonPacketBuilt_;
+    /// Packet for the connections without a client index up to date flag.
+    bool broadcastPacketBuilt_;
+    /// Number of packets encoded since the last Clear().
+    unsigned numEncodedPackets_;
+};
+
+}
@@ -69,6 +69,8 @@ static const int MSG_CLIENTOBJECTCONTROLS = 0x99;
 static const int MSG_SERVEROBJECTCONTROLS = 0x9A;
 /// FromBones Client->server or server->Client : send Object Commands (execute an order)
 static const int MSG_OBJECTCOMMANDS = 0x9B;
+/// FromBones server->Client : send Object Controls as fixed-layout records (see ObjectControlBatch)
+static const int MSG_SERVEROBJECTCONTROLRECORDS = 0x9C;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
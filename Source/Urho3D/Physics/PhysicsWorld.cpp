@@ -25,6 +25,8 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
 #include "../IO/Log.h"
@@ -39,12 +41,15 @@
 #include "../Scene/SceneEvents.h"
 
 #include <Bullet/BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <Bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
 #include <Bullet/BulletCollision/CollisionShapes/btBoxShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
 #include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 
 extern ContactAddedCallback gContactAddedCallback;
 
@@ -60,6 +65,157 @@ static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
 
 PhysicsWorldConfig PhysicsWorld::config;
 
+#if BT_THREADSAFE
+/// Number of ranges per thread for a parallel loop, to balance the uneven ranges.
+static const int TASK_RANGES_PER_THREAD = 4;
+
+/// Range of a Bullet parallel loop run by the work queue.
+struct PhysicsTask
+{
+    /// Loop body.
+    const btIParallelForBody* forBody_;
+    /// Summing loop body.
+    const btIParallelSumBody* sumBody_;
+    /// First index.
+    int begin_;
+    /// Index after the last one.
+    int end_;
+    /// Sum of the range.
+    btScalar sum_;
+};
+
+/// Bullet task scheduler running the parallel loops on the work queue threads and the main thread.
+class WorkQueueTaskScheduler : public btITaskScheduler
+{
+public:
+    /// Construct.
+    WorkQueueTaskScheduler(WorkQueue* workQueue) :
+        btITaskScheduler("WorkQueue"),
+        workQueue_(workQueue),
+        nextTask_(0),
+        running_(false)
+    {
+        numThreads_ = getMaxNumThreads();
+    }
+
+    /// Return the work queue threads and the main thread.
+    virtual int getMaxNumThreads() const { return Min((int)workQueue_->GetNumThreads() + 1, (int)BT_MAX_THREAD_COUNT); }
+    /// Return the number of threads used.
+    virtual int getNumThreads() const { return numThreads_; }
+    /// Set the number of threads used.
+    virtual void setNumThreads(int numThreads) { numThreads_ = Clamp(numThreads, 1, getMaxNumThreads()); }
+
+    /// Run a loop in ranges and wait for its completion.
+    virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+    {
+        if (!Split(iBegin, iEnd, grainSize, &body, 0))
+            body.forLoop(iBegin, iEnd);
+    }
+
+    /// Run a summing loop in ranges and return the sum after its completion.
+    virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+    {
+        if (!Split(iBegin, iEnd, grainSize, 0, &body))
+            return body.sumLoop(iBegin, iEnd);
+
+        btScalar sum = 0.0f;
+        for (unsigned i = 0; i < tasks_.Size(); ++i)
+            sum += tasks_[i].sum_;
+        return sum;
+    }
+
+    /// Run the ranges not taken yet by the other threads.
+    void RunTasks()
+    {
+        for (;;)
+        {
+            unsigned index;
+            {
+                MutexLock lock(taskMutex_);
+                index = nextTask_++;
+            }
+            if (index >= tasks_.Size())
+                break;
+
+            PhysicsTask& task = tasks_[index];
+            if (task.forBody_)
+                task.forBody_->forLoop(task.begin_, task.end_);
+            else
+                task.sum_ = task.sumBody_->sumLoop(task.begin_, task.end_);
+        }
+    }
+
+private:
+    /// Run the ranges of a loop on the work queue. Return false if the loop must run on the calling thread.
+    bool Split(int iBegin, int iEnd, int grainSize, const btIParallelForBody* forBody, const btIParallelSumBody* sumBody)
+    {
+        // The work queue is driven by the main thread only, and a loop nested in a running one stays on its thread
+        const int count = iEnd - iBegin;
+        const int numRanges = Min(count / Max(grainSize, 1), numThreads_ * TASK_RANGES_PER_THREAD);
+        if (numThreads_ <= 1 || numRanges <= 1 || !Thread::IsMainThread() || running_)
+            return false;
+
+        tasks_.Resize(numRanges);
+
+        int begin = iBegin;
+        for (int i = 0; i < numRanges; ++i)
+        {
+            PhysicsTask& task = tasks_[i];
+            task.forBody_ = forBody;
+            task.sumBody_ = sumBody;
+            task.begin_ = begin;
+            task.end_ = i < numRanges - 1 ? iBegin + count * (i + 1) / numRanges : iEnd;
+            task.sum_ = 0.0f;
+            begin = task.end_;
+        }
+        nextTask_ = 0;
+
+        // The ranges are taken by one work item per helper thread and by the main thread, so that no more than the
+        // set number of threads run the loop even when the work queue has more threads
+        const int numItems = Min(numThreads_, numRanges) - 1;
+        for (int i = 0; i < numItems; ++i)
+        {
+            SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = RunPhysicsTasks;
+            item->aux_ = this;
+            workQueue_->AddWorkItem(item);
+        }
+
+        running_ = true;
+        RunTasks();
+        workQueue_->Complete(M_MAX_UNSIGNED);
+        running_ = false;
+
+        return true;
+    }
+
+    /// Work item function running the ranges of a loop.
+    static void RunPhysicsTasks(const WorkItem* item, unsigned threadIndex)
+    {
+        reinterpret_cast<WorkQueueTaskScheduler*>(item->aux_)->RunTasks();
+    }
+
+    /// Work queue.
+    WorkQueue* workQueue_;
+    /// Number of threads used.
+    int numThreads_;
+    /// Ranges of the loop being run.
+    PODVector<PhysicsTask> tasks_;
+    /// Index of the next range to run.
+    unsigned nextTask_;
+    /// Mutex for taking the ranges.
+    Mutex taskMutex_;
+    /// Whether a loop is being run on the work queue.
+    bool running_;
+};
+
+/// Task scheduler shared by the multithreaded worlds.
+static WorkQueueTaskScheduler* taskScheduler = 0;
+/// Number of multithreaded worlds.
+static unsigned numTaskSchedulerUsers = 0;
+#endif
+
 static bool CompareRaycastResults(const PhysicsRaycastResult& lhs, const PhysicsRaycastResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -139,10 +295,43 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     else
         collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
-    collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
-    broadphase_ = new btDbvtBroadphase();
-    solver_ = new btSequentialImpulseConstraintSolver();
-    world_ = new btDiscreteDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+    WorkQueue* workQueue = GetSubsystem<WorkQueue>();
+    if (PhysicsWorld::config.multiThreaded_ && workQueue && workQueue->GetNumThreads())
+    {
+#if BT_THREADSAFE
+        // The scheduler must be set on the main thread before creating the multithreaded objects, which size their per thread data from it
+        if (!numTaskSchedulerUsers++)
+        {
+            taskScheduler = new WorkQueueTaskScheduler(workQueue);
+            btSetTaskScheduler(taskScheduler);
+        }
+
+        // Any work queue thread may run the loops, so the per thread data is sized for all of them. Then the number of
+        // threads running a loop at the same time is limited. It is shared by the multithreaded worlds, the last created one sets it
+        const int maxThreads = taskScheduler->getMaxNumThreads();
+        taskScheduler->setNumThreads(maxThreads);
+        btConstraintSolverPoolMt* solverPool = new btConstraintSolverPoolMt(maxThreads);
+        collisionDispatcher_ = new btCollisionDispatcherMt(collisionConfiguration_);
+        broadphase_ = new btDbvtBroadphase();
+        solver_ = solverPool;
+        solverMt_ = new btSequentialImpulseConstraintSolverMt();
+        world_ = new btDiscreteDynamicsWorldMt(collisionDispatcher_.Get(), broadphase_.Get(), solverPool, solverMt_.Get(), collisionConfiguration_);
+        if (PhysicsWorld::config.numThreads_)
+            taskScheduler->setNumThreads((int)PhysicsWorld::config.numThreads_);
+
+        URHO3D_LOGINFOF("PhysicsWorld() - multithreaded world with %d threads", taskScheduler->getNumThreads());
+#else
+        URHO3D_LOGWARNING("PhysicsWorld() - Bullet is not built thread safe, using the single threaded world");
+#endif
+    }
+
+    if (!world_)
+    {
+        collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
+        broadphase_ = new btDbvtBroadphase();
+        solver_ = new btSequentialImpulseConstraintSolver();
+        world_ = new btDiscreteDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+    }
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
@@ -168,11 +357,25 @@ PhysicsWorld::~PhysicsWorld()
             (*i)->ReleaseShape();
     }
 
+#if BT_THREADSAFE
+    const bool multiThreaded = solverMt_.Get() != 0;
+#endif
+
     world_.Reset();
+    solverMt_.Reset();
     solver_.Reset();
     broadphase_.Reset();
     collisionDispatcher_.Reset();
 
+#if BT_THREADSAFE
+    if (multiThreaded && !--numTaskSchedulerUsers)
+    {
+        btSetTaskScheduler(0);
+        delete taskScheduler;
+        taskScheduler = 0;
+    }
+#endif
+
     // Delete configuration only if it was the default created by PhysicsWorld
     if (!PhysicsWorld::config.collisionConfig_)
         delete collisionConfiguration_;
@@ -116,12 +116,18 @@ struct ManifoldPair
 struct PhysicsWorldConfig
 {
     PhysicsWorldConfig() :
-        collisionConfig_(0)
+        collisionConfig_(0),
+        multiThreaded_(false),
+        numThreads_(0)
     {
     }
 
     /// Override for the collision configuration (default btDefaultCollisionConfiguration).
     btCollisionConfiguration* collisionConfig_;
+    /// FromBones : use the multithreaded Bullet world, which runs the narrowphase, the island solving and the body integration on the work queue threads. Requires Bullet built thread safe (URHO3D_PHYSICS_MT). Default false.
+    bool multiThreaded_;
+    /// FromBones : number of threads of the multithreaded world, including the main thread. 0 uses all the work queue threads. Default 0.
+    unsigned numThreads_;
 };
 
 static const float DEFAULT_MAX_NETWORK_ANGULAR_VELOCITY = 100.0f;
@@ -306,6 +312,8 @@ private:
     UniquePtr<btBroadphaseInterface> broadphase_;
     /// Bullet constraint solver.
     UniquePtr<btConstraintSolver> solver_;
+    /// Bullet constraint solver of the large islands in the multithreaded world.
+    UniquePtr<btConstraintSolver> solverMt_;
     /// Bullet physics world.
     UniquePtr<btDiscreteDynamicsWorld> world_;
     /// Extra weak pointer to scene to allow for cleanup in case the world is destroyed before other components.
@@ -25,8 +25,13 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../IO/AsyncFileReader.h"
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
+#include "../IO/PackageFile.h"
 #include "../Resource/BackgroundLoader.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
@@ -36,76 +41,181 @@
 namespace Urho3D
 {
 
+/// Maximum number of resource files read ahead and not used yet.
+static const unsigned MAX_READ_AHEAD = 16;
+/// Number of pending resources examined for reading ahead.
+static const unsigned MAX_READ_AHEAD_SCAN = 2 * MAX_READ_AHEAD;
+
+BackgroundLoaderWorker::BackgroundLoaderWorker(BackgroundLoader* loader) :
+    loader_(loader)
+{
+}
+
+void BackgroundLoaderWorker::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        if (!loader_->LoadNextResource())
+            Time::Sleep(5);
+    }
+}
+
 BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
-    owner_(owner)
+    owner_(owner),
+    numThreads_(Max(GetNumLogicalCPUs(), 2U) - 1),
+    numReadAhead_(0)
 {
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
+    // Stop the loading threads before clearing the queue they work on
+    workers_.Clear();
+    Stop();
+
     MutexLock lock(backgroundLoadMutex_);
 
+    // The files read ahead are written to their requests until completed
+    FileSystem* fileSystem = owner_->GetSubsystem<FileSystem>();
+    AsyncFileReader* reader = fileSystem ? fileSystem->GetAsyncFileReader() : 0;
+    if (reader)
+    {
+        for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
+             i != backgroundLoadQueue_.End(); ++i)
+            reader->Wait(i->second_.readRequest_);
+    }
+
     backgroundLoadQueue_.Clear();
+    pendingQueue_.Clear();
 }
 
 void BackgroundLoader::ThreadFunction()
 {
     while (shouldRun_)
     {
-        backgroundLoadMutex_.Acquire();
+        if (!LoadNextResource())
+            Time::Sleep(5);
+    }
+}
+
+void BackgroundLoader::SetNumThreads(unsigned num)
+{
+    numThreads_ = Max(num, 1U);
 
-        // Search for a queued resource that has not been loaded yet
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-        while (i != backgroundLoadQueue_.End())
+    // Otherwise the workers start along with the background loader thread
+    if (IsStarted())
+        UpdateWorkers();
+}
+
+bool BackgroundLoader::LoadNextResource()
+{
+    BackgroundLoadItem* item = 0;
+
+    backgroundLoadMutex_.Acquire();
+
+    // Claim the first pending resource that is still queued, the others have already been claimed or finished
+    while (!pendingQueue_.Empty())
+    {
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(pendingQueue_.Front());
+        pendingQueue_.PopFront();
+
+        if (i != backgroundLoadQueue_.End() && i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
         {
-            if (i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
+            item = &i->second_;
+            // We can be sure that the item is not removed from the queue as long as it is in the
+            // "queued" or "loading" state, and no other thread claims it once it is loading
+            item->resource_->SetAsyncLoadState(ASYNC_LOADING);
+            break;
         }
+    }
 
-        if (i == backgroundLoadQueue_.End())
+    // Keep reading ahead while this resource loads
+    if (item)
+        ReadAhead();
+
+    backgroundLoadMutex_.Release();
+
+    if (!item)
+        return false;
+
+    LoadResource(*item);
+    return true;
+}
+
+void BackgroundLoader::LoadResource(BackgroundLoadItem& item)
+{
+    Resource* resource = item.resource_;
+
+    bool success = false;
+    SharedPtr<File> file;
+
+    // Use the file read ahead if possible, which is usually complete by now
+    AsyncReadRequest* request = item.readRequest_;
+    if (request)
+    {
+        FileSystem* fileSystem = owner_->GetSubsystem<FileSystem>();
+        fileSystem->GetAsyncFileReader()->Wait(request);
+        if (request->success_)
         {
-            // No resources to load found
-            backgroundLoadMutex_.Release();
-            Time::Sleep(5);
+            file = new File(owner_->GetContext());
+            if (!file->Open(resource->GetName(), request->data_, request->bytesRead_, item.readPackage_))
+                file.Reset();
         }
-        else
+    }
+
+    if (!file)
+        file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
+    if (file)
+        success = resource->BeginLoad(*file);
+
+    // Process dependencies now
+    // Need to lock the queue again when manipulating other entries
+    Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
+    MutexLock lock(backgroundLoadMutex_);
+    if (request)
+    {
+        item.readRequest_.Reset();
+        item.readPackage_.Reset();
+        --numReadAhead_;
+    }
+
+    if (item.dependents_.Size())
+    {
+        for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item.dependents_.Begin();
+             i != item.dependents_.End(); ++i)
         {
-            BackgroundLoadItem& item = i->second_;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
+            HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
+            if (j != backgroundLoadQueue_.End())
+                j->second_.dependencies_.Erase(key);
+        }
 
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
+        item.dependents_.Clear();
+    }
 
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.Size())
-            {
-                for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item.dependents_.Begin();
-                     i != item.dependents_.End(); ++i)
-                {
-                    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
-                    if (j != backgroundLoadQueue_.End())
-                        j->second_.dependencies_.Erase(key);
-                }
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+}
 
-                item.dependents_.Clear();
-            }
+void BackgroundLoader::UpdateWorkers()
+{
+    const unsigned numWorkers = numThreads_ - 1;
+
+    while (workers_.Size() > numWorkers)
+    {
+        // A stopping worker first finishes the resource it is loading
+        workers_.Back()->Stop();
+        workers_.Pop();
+    }
 
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
+    while (workers_.Size() < numWorkers)
+    {
+        SharedPtr<BackgroundLoaderWorker> worker(new BackgroundLoaderWorker(this));
+        if (!worker->Run())
+        {
+            URHO3D_LOGERROR("Could not start background loader worker thread");
+            break;
         }
+
+        workers_.Push(worker);
     }
 }
 
@@ -122,6 +232,7 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
 
     BackgroundLoadItem& item = backgroundLoadQueue_[key];
     item.sendEventOnFailure_ = sendEventOnFailure;
+    item.readAhead_ = false;
 
     // Make sure the pointer is non-null and is a Resource subclass
     item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
@@ -163,9 +274,20 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
                        " requested for a background loaded resource but was not in the background load queue");
     }
 
-    // Start the background loader thread now
+    // Load the dependencies first, as the resources depending on them can not be finished before
+    if (item.dependents_.Size())
+        pendingQueue_.PushFront(key);
+    else
+        pendingQueue_.Push(key);
+
+    ReadAhead();
+
+    // Start the background loader thread and the workers now
     if (!IsStarted())
+    {
         Run();
+        UpdateWorkers();
+    }
 
     return true;
 }
@@ -179,8 +301,16 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
     if (i != backgroundLoadQueue_.End())
     {
+        // If no loading thread has claimed the resource yet, load it in this thread rather than wait for one
+        bool loadNow = i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED;
+        if (loadNow)
+            i->second_.resource_->SetAsyncLoadState(ASYNC_LOADING);
+
         backgroundLoadMutex_.Release();
 
+        if (loadNow)
+            LoadResource(i->second_);
+
         {
             Resource* resource = i->second_.resource_;
             HiresTimer waitTimer;
@@ -250,6 +380,28 @@ void BackgroundLoader::FinishResources(int maxMs)
     }
 }
 
+void BackgroundLoader::ReadAhead()
+{
+    unsigned numScanned = 0;
+    for (List<Pair<StringHash, StringHash> >::ConstIterator i = pendingQueue_.Begin();
+         i != pendingQueue_.End() && numReadAhead_ < MAX_READ_AHEAD && numScanned < MAX_READ_AHEAD_SCAN; ++i, ++numScanned)
+    {
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
+        if (j == backgroundLoadQueue_.End())
+            continue;
+
+        BackgroundLoadItem& item = j->second_;
+        if (item.readAhead_ || item.resource_->GetAsyncLoadState() != ASYNC_QUEUED)
+            continue;
+
+        // Files in compressed or memory mapped packages are not read ahead
+        item.readAhead_ = true;
+        item.readRequest_ = owner_->ReadFileAsync(item.resource_->GetName(), 0, 0, &item.readPackage_);
+        if (item.readRequest_)
+            ++numReadAhead_;
+    }
+}
+
 unsigned BackgroundLoader::GetNumQueuedResources() const
 {
     MutexLock lock(backgroundLoadMutex_);
@@ -24,6 +24,7 @@
 
 #include "../Container/HashMap.h"
 #include "../Container/HashSet.h"
+#include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Container/Ptr.h"
 #include "../Container/RefCounted.h"
@@ -33,6 +34,9 @@
 namespace Urho3D
 {
 
+class AsyncReadRequest;
+class BackgroundLoader;
+class PackageFile;
 class Resource;
 class ResourceCache;
 
@@ -47,9 +51,34 @@ struct BackgroundLoadItem
     HashSet<Pair<StringHash, StringHash> > dependents_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
+    /// FromBones : Read of the resource file started ahead of the loading, or null.
+    SharedPtr<AsyncReadRequest> readRequest_;
+    /// FromBones : Package of the resource file read ahead, or null if read from a resource directory.
+    SharedPtr<PackageFile> readPackage_;
+    /// FromBones : Whether reading the resource file ahead has been attempted.
+    bool readAhead_;
+};
+
+/// FromBones : additional resource loading thread sharing the load queue of a background loader.
+class BackgroundLoaderWorker : public RefCounted, public Thread
+{
+public:
+    /// Construct.
+    BackgroundLoaderWorker(BackgroundLoader* loader);
+
+    /// Resource background loading loop.
+    virtual void ThreadFunction();
+
+private:
+    /// Background loader.
+    BackgroundLoader* loader_;
 };
 
 /// Background loader of resources. Owned by the ResourceCache.
+/** FromBones : BeginLoad() runs on a pool of loading threads : the background loader thread itself and additional workers.
+    The resources queued as dependencies of a resource being loaded are loaded first, since the finishing of the resources depending on them waits for them.
+    The files of the next resources in the queue are read ahead with the asynchronous file reader, so that their reads overlap with the loading of the previous ones.
+  */
 class BackgroundLoader : public RefCounted, public Thread
 {
 public:
@@ -69,10 +98,23 @@ public:
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
 
+    /// FromBones : Set number of loading threads, including the background loader thread. Default is the number of logical CPUs minus one for the main thread.
+    void SetNumThreads(unsigned num);
+    /// FromBones : Claim the next queued resource and call its BeginLoad(). Return false if there was no resource to load. Called from the loading threads.
+    bool LoadNextResource();
+
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
+    /// FromBones : Return number of loading threads, including the background loader thread.
+    unsigned GetNumThreads() const { return numThreads_; }
 
 private:
+    /// FromBones : Load a resource claimed by the calling thread and release the items waiting for it. The item must be in the loading state.
+    void LoadResource(BackgroundLoadItem& item);
+    /// FromBones : Start or stop the additional workers to match the number of threads.
+    void UpdateWorkers();
+    /// FromBones : Start reading ahead the files of the next pending resources. The queue mutex must be held.
+    void ReadAhead();
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
 
@@ -82,6 +124,14 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// FromBones : Keys of the resources waiting for a loading thread, dependencies first. May contain keys already claimed or finished, which are skipped.
+    List<Pair<StringHash, StringHash> > pendingQueue_;
+    /// FromBones : Additional loading threads.
+    Vector<SharedPtr<BackgroundLoaderWorker> > workers_;
+    /// FromBones : Number of loading threads, including the background loader thread.
+    unsigned numThreads_;
+    /// FromBones : Number of files read ahead and not used yet by their resource.
+    unsigned numReadAhead_;
 };
 
 }
@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -41,6 +43,10 @@
 #include <webp/mux.h>
 #endif
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 #ifndef MAKEFOURCC
@@ -88,6 +94,28 @@ static const unsigned DDS_DXGI_FORMAT_BC2_UNORM_SRGB = 75;
 static const unsigned DDS_DXGI_FORMAT_BC3_UNORM = 77;
 static const unsigned DDS_DXGI_FORMAT_BC3_UNORM_SRGB = 78;
 
+// KTX2 Vulkan formats
+static const unsigned KTX2_VK_FORMAT_R8_UNORM = 9;
+static const unsigned KTX2_VK_FORMAT_R8G8_UNORM = 16;
+static const unsigned KTX2_VK_FORMAT_R8G8B8_UNORM = 23;
+static const unsigned KTX2_VK_FORMAT_R8G8B8A8_UNORM = 37;
+static const unsigned KTX2_VK_FORMAT_R8G8B8A8_SRGB = 43;
+static const unsigned KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+static const unsigned KTX2_VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+static const unsigned KTX2_VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+static const unsigned KTX2_VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+static const unsigned KTX2_VK_FORMAT_BC2_UNORM_BLOCK = 135;
+static const unsigned KTX2_VK_FORMAT_BC2_SRGB_BLOCK = 136;
+static const unsigned KTX2_VK_FORMAT_BC3_UNORM_BLOCK = 137;
+static const unsigned KTX2_VK_FORMAT_BC3_SRGB_BLOCK = 138;
+static const unsigned KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147;
+static const unsigned KTX2_VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK = 148;
+static const unsigned KTX2_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK = 151;
+static const unsigned KTX2_VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK = 152;
+
+// Minimum number of output pixels to split a mip level calculation over the worker threads
+static const int MIP_LEVEL_THREADED_PIXELS = 256 * 256;
+
 namespace Urho3D
 {
 
@@ -262,6 +290,7 @@ Image::Image(Context* context) :
     cubemap_(false),
     array_(false),
     sRGB_(false),
+    loadedLevels_(false),
     compressedFormat_(CF_NONE)
 {
 }
@@ -537,6 +566,9 @@ bool Image::BeginLoad(Deserializer& source)
     }
     else if (fileID == "\253KTX")
     {
+        if (source.ReadFileID() == " 20\273")
+            return LoadKTX2(source);
+
         source.Seek(12);
 
         unsigned endianness = source.ReadUInt();
@@ -857,6 +889,219 @@ bool Image::BeginLoad(Deserializer& source)
     return true;
 }
 
+bool Image::LoadKTX2(Deserializer& source)
+{
+    source.Seek(12);
+
+    unsigned vkFormat = source.ReadUInt();
+    /* unsigned typeSize = */ source.ReadUInt();
+    unsigned width = source.ReadUInt();
+    unsigned height = source.ReadUInt();
+    unsigned depth = source.ReadUInt();
+    unsigned layers = source.ReadUInt();
+    unsigned faces = source.ReadUInt();
+    unsigned mipmaps = source.ReadUInt();
+    unsigned supercompression = source.ReadUInt();
+
+    // Skip the data format descriptor, key/value data and supercompression data indices
+    source.Seek(source.GetPosition() + 4 * sizeof(unsigned) + 2 * sizeof(unsigned long long));
+
+    if (depth > 1 || layers > 1 || faces > 1)
+    {
+        URHO3D_LOGERROR("3D, array or cube KTX2 files not supported");
+        return false;
+    }
+
+    if (supercompression != 0)
+    {
+        URHO3D_LOGERROR("Supercompressed KTX2 files not supported");
+        return false;
+    }
+
+    if (!width || !height || width > (unsigned)M_MAX_INT || height > (unsigned)M_MAX_INT)
+    {
+        URHO3D_LOGERROR("Invalid KTX2 image size");
+        return false;
+    }
+
+    // Zero levels means that the mip levels should be generated on load
+    if (mipmaps == 0)
+        mipmaps = 1;
+    if (mipmaps > LogBaseTwo(Max(width, height)) + 1)
+    {
+        URHO3D_LOGERROR("Invalid KTX2 mipmap level count");
+        return false;
+    }
+
+    CompressedFormat format = CF_NONE;
+    unsigned components = 0;
+    bool sRGB = false;
+
+    switch (vkFormat)
+    {
+    case KTX2_VK_FORMAT_R8_UNORM:
+        components = 1;
+        break;
+
+    case KTX2_VK_FORMAT_R8G8_UNORM:
+        components = 2;
+        break;
+
+    case KTX2_VK_FORMAT_R8G8B8_UNORM:
+        components = 3;
+        break;
+
+    case KTX2_VK_FORMAT_R8G8B8A8_SRGB:
+        sRGB = true;
+        // Fall through
+    case KTX2_VK_FORMAT_R8G8B8A8_UNORM:
+        components = 4;
+        break;
+
+    case KTX2_VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case KTX2_VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        sRGB = true;
+        // Fall through
+    case KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case KTX2_VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        format = CF_DXT1;
+        components = 4;
+        break;
+
+    case KTX2_VK_FORMAT_BC2_SRGB_BLOCK:
+        sRGB = true;
+        // Fall through
+    case KTX2_VK_FORMAT_BC2_UNORM_BLOCK:
+        format = CF_DXT3;
+        components = 4;
+        break;
+
+    case KTX2_VK_FORMAT_BC3_SRGB_BLOCK:
+        sRGB = true;
+        // Fall through
+    case KTX2_VK_FORMAT_BC3_UNORM_BLOCK:
+        format = CF_DXT5;
+        components = 4;
+        break;
+
+    case KTX2_VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        sRGB = true;
+        // Fall through
+    case KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        format = CF_ETC2_RGB;
+        components = 3;
+        break;
+
+    case KTX2_VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        sRGB = true;
+        // Fall through
+    case KTX2_VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        format = CF_ETC2_RGBA;
+        components = 4;
+        break;
+
+    default:
+        URHO3D_LOGERROR("Unsupported texture format in KTX2 file");
+        return false;
+    }
+
+    // The level index starts from the largest level, while the level data is stored from the smallest. Each level must have
+    // the exact size of its dimensions, with the same block sizes as GetCompressedLevel()
+    const unsigned blockSize = (format == CF_DXT1 || format == CF_ETC2_RGB) ? 8 : 16;
+    PODVector<unsigned> levelOffsets(mipmaps);
+    PODVector<unsigned> levelSizes(mipmaps);
+    unsigned long long totalSize = 0;
+    unsigned levelWidth = width;
+    unsigned levelHeight = height;
+    for (unsigned i = 0; i < mipmaps; ++i)
+    {
+        unsigned long long offset = source.ReadUInt64();
+        unsigned long long size = source.ReadUInt64();
+        /* unsigned long long uncompressedSize = */ source.ReadUInt64();
+
+        if (offset + size > source.GetSize())
+        {
+            URHO3D_LOGERROR("KTX2 mipmap level data size exceeds file size");
+            return false;
+        }
+
+        const unsigned long long levelSize = format != CF_NONE ?
+            (unsigned long long)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize :
+            (unsigned long long)levelWidth * levelHeight * components;
+        if (size != levelSize)
+        {
+            URHO3D_LOGERROR("KTX2 mipmap level data size does not match the image size");
+            return false;
+        }
+
+        levelOffsets[i] = (unsigned)offset;
+        levelSizes[i] = (unsigned)size;
+        totalSize += size;
+        if (totalSize > M_MAX_UNSIGNED)
+        {
+            URHO3D_LOGERROR("KTX2 image data size too large");
+            return false;
+        }
+
+        levelWidth = Max(levelWidth / 2, 1U);
+        levelHeight = Max(levelHeight / 2, 1U);
+    }
+
+    const unsigned dataSize = (unsigned)totalSize;
+    loadedLevels_ = false;
+
+    if (format != CF_NONE)
+    {
+        data_ = new unsigned char[dataSize];
+        width_ = width;
+        height_ = height;
+        depth_ = 1;
+        components_ = components;
+        compressedFormat_ = format;
+        numCompressedLevels_ = mipmaps;
+        sRGB_ = sRGB;
+        nextLevel_.Reset();
+
+        unsigned dataOffset = 0;
+        for (unsigned i = 0; i < mipmaps; ++i)
+        {
+            source.Seek(levelOffsets[i]);
+            source.Read(&data_[dataOffset], levelSizes[i]);
+            dataOffset += levelSizes[i];
+        }
+
+        SetMemoryUse(dataSize);
+        return true;
+    }
+
+    // Uncompressed levels are tightly packed. Read them directly to the mip level chain, so that the textures can upload them without calculating the levels
+    Image* level = this;
+    levelWidth = width;
+    levelHeight = height;
+    nextLevel_.Reset();
+
+    for (unsigned i = 0; i < mipmaps; ++i)
+    {
+        if (i > 0)
+        {
+            level->nextLevel_ = new Image(context_);
+            level = level->nextLevel_;
+        }
+
+        level->SetSize((int)levelWidth, (int)levelHeight, components);
+        level->sRGB_ = sRGB;
+        source.Seek(levelOffsets[i]);
+        source.Read(level->data_.Get(), levelSizes[i]);
+
+        levelWidth = Max(levelWidth / 2, 1U);
+        levelHeight = Max(levelHeight / 2, 1U);
+    }
+
+    // Keep the loaded levels when the texture precalculates the rest
+    loadedLevels_ = mipmaps > 1;
+    return true;
+}
+
 bool Image::Save(Serializer& dest) const
 {
     URHO3D_PROFILE(SaveImage);
@@ -925,6 +1170,7 @@ bool Image::SetSize(int width, int height, int depth, unsigned components)
     compressedFormat_ = CF_NONE;
     numCompressedLevels_ = 0;
     nextLevel_.Reset();
+    loadedLevels_ = false;
 
     SetMemoryUse(width * height * depth * components);
     return true;
@@ -1040,6 +1286,263 @@ bool Image::LoadColorLUT(Deserializer& source)
     return true;
 }
 
+/// Reverse the order of the pixels of a row in place.
+static void FlipRowHorizontal(unsigned char* row, int width, unsigned components)
+{
+    unsigned char* left = row;
+    unsigned char* right = row + (width - 1) * components;
+
+#ifdef URHO3D_SSE
+    // Swap 16 bytes from both ends, reversing the pixels inside the registers
+    if (components != 3)
+    {
+        unsigned pixelsPerRegister = 16 / components;
+        while (right - left >= 32 - (int)components)
+        {
+            unsigned char* rightBlock = right + components - 16;
+            __m128i leftPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left));
+            __m128i rightPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rightBlock));
+
+            // Reverse the 32-bit pixels, then the 16-bit and 8-bit pixels inside them
+            leftPixels = _mm_shuffle_epi32(leftPixels, _MM_SHUFFLE(0, 1, 2, 3));
+            rightPixels = _mm_shuffle_epi32(rightPixels, _MM_SHUFFLE(0, 1, 2, 3));
+            if (components < 4)
+            {
+                leftPixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(leftPixels, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+                rightPixels = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rightPixels, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            }
+            if (components < 2)
+            {
+                leftPixels = _mm_or_si128(_mm_slli_epi16(leftPixels, 8), _mm_srli_epi16(leftPixels, 8));
+                rightPixels = _mm_or_si128(_mm_slli_epi16(rightPixels, 8), _mm_srli_epi16(rightPixels, 8));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(left), rightPixels);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rightBlock), leftPixels);
+            left += pixelsPerRegister * components;
+            right -= pixelsPerRegister * components;
+        }
+    }
+#endif
+
+    while (left < right)
+    {
+        for (unsigned c = 0; c < components; ++c)
+            Swap(left[c], right[c]);
+        left += components;
+        right -= components;
+    }
+}
+
+/// Number of fractional bits of the resampling weights.
+static const int RESAMPLE_WEIGHT_BITS = 14;
+
+/// Source pixel contributions of the destination pixels of a resampled row or column.
+struct ResampleWeights
+{
+    /// First contribution of each destination pixel, followed by the end of the last one. The contributions of a destination pixel are padded to an even count.
+    PODVector<unsigned> start_;
+    /// Source pixel index of the contributions.
+    PODVector<int> source_;
+    /// Weight of the contributions. The weights of a destination pixel add up to 1 << RESAMPLE_WEIGHT_BITS.
+    PODVector<short> weight_;
+
+    /// Calculate the weights. Use bilinear filtering when enlarging and the average of the covered source pixels when reducing.
+    void Define(int sourceSize, int destSize)
+    {
+        const int one = 1 << RESAMPLE_WEIGHT_BITS;
+        float scale = (float)sourceSize / (float)destSize;
+
+        start_.Clear();
+        source_.Clear();
+        weight_.Clear();
+
+        for (int i = 0; i < destSize; ++i)
+        {
+            start_.Push(source_.Size());
+
+            if (scale <= 1.0f)
+            {
+                // Pixel centers are aligned
+                float pos = Clamp(((float)i + 0.5f) * scale - 0.5f, 0.0f, (float)(sourceSize - 1));
+                int first = (int)pos;
+                int second = Min(first + 1, sourceSize - 1);
+                short secondWeight = (short)((pos - (float)first) * one + 0.5f);
+                source_.Push(first);
+                weight_.Push((short)(one - secondWeight));
+                source_.Push(second);
+                weight_.Push(secondWeight);
+            }
+            else
+            {
+                float begin = (float)i * scale;
+                float end = Min((float)(i + 1) * scale, (float)sourceSize);
+                int first = (int)begin;
+                int last = Min((int)ceilf(end), sourceSize) - 1;
+                int total = 0;
+                unsigned largest = source_.Size();
+
+                for (int j = first; j <= last; ++j)
+                {
+                    float coverage = Min(end, (float)(j + 1)) - Max(begin, (float)j);
+                    short weight = (short)(coverage / scale * one + 0.5f);
+                    if (weight_.Size() > largest && weight > weight_[largest])
+                        largest = weight_.Size();
+                    source_.Push(j);
+                    weight_.Push(weight);
+                    total += weight;
+                }
+
+                // Put the rounding error on the largest weight so that the weights add up to one exactly
+                weight_[largest] += (short)(one - total);
+
+                if ((source_.Size() - start_.Back()) & 1)
+                {
+                    source_.Push(last);
+                    weight_.Push(0);
+                }
+            }
+        }
+
+        start_.Push(source_.Size());
+    }
+};
+
+/// Resample the rows of an image horizontally.
+static void ResampleRows(const unsigned char* src, unsigned char* dest, int sourceWidth, int destWidth, int rows, unsigned components,
+    const ResampleWeights& weights)
+{
+    const int round = 1 << (RESAMPLE_WEIGHT_BITS - 1);
+
+    for (int y = 0; y < rows; ++y)
+    {
+        const unsigned char* srcRow = src + y * sourceWidth * components;
+        unsigned char* destRow = dest + y * destWidth * components;
+
+        for (int x = 0; x < destWidth; ++x)
+        {
+            unsigned begin = weights.start_[x];
+            unsigned end = weights.start_[x + 1];
+
+#ifdef URHO3D_SSE
+            if (components == 4)
+            {
+                // Multiply and add two source pixels at a time, with their channels interleaved
+                const __m128i zero = _mm_setzero_si128();
+                __m128i sum = _mm_set1_epi32(round);
+                for (unsigned i = begin; i < end; i += 2)
+                {
+                    __m128i first = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(srcRow + weights.source_[i] * 4));
+                    __m128i second = _mm_cvtsi32_si128(*reinterpret_cast<const int*>(srcRow + weights.source_[i + 1] * 4));
+                    __m128i pixels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(first, zero), _mm_unpacklo_epi8(second, zero));
+                    __m128i weight = _mm_set1_epi32((int)(unsigned short)weights.weight_[i] | ((int)weights.weight_[i + 1] << 16));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, weight));
+                }
+
+                sum = _mm_srai_epi32(sum, RESAMPLE_WEIGHT_BITS);
+                sum = _mm_packus_epi16(_mm_packs_epi32(sum, zero), zero);
+                *reinterpret_cast<int*>(destRow + x * 4) = _mm_cvtsi128_si32(sum);
+                continue;
+            }
+#endif
+
+            for (unsigned c = 0; c < components; ++c)
+            {
+                int sum = round;
+                for (unsigned i = begin; i < end; ++i)
+                    sum += srcRow[weights.source_[i] * components + c] * weights.weight_[i];
+                destRow[x * components + c] = (unsigned char)(sum >> RESAMPLE_WEIGHT_BITS);
+            }
+        }
+    }
+}
+
+/// Resample the columns of an image vertically.
+static void ResampleColumns(const unsigned char* src, unsigned char* dest, unsigned rowSize, int destHeight, const ResampleWeights& weights)
+{
+    const int round = 1 << (RESAMPLE_WEIGHT_BITS - 1);
+
+    for (int y = 0; y < destHeight; ++y)
+    {
+        unsigned begin = weights.start_[y];
+        unsigned end = weights.start_[y + 1];
+        unsigned char* destRow = dest + y * rowSize;
+        unsigned x = 0;
+
+#ifdef URHO3D_SSE
+        // Multiply and add 8 bytes of two source rows at a time, with the rows interleaved
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 8 <= rowSize; x += 8)
+        {
+            __m128i sumLow = _mm_set1_epi32(round);
+            __m128i sumHigh = sumLow;
+            for (unsigned i = begin; i < end; i += 2)
+            {
+                __m128i first = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + weights.source_[i] * rowSize + x)), zero);
+                __m128i second = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + weights.source_[i + 1] * rowSize + x)), zero);
+                __m128i weight = _mm_set1_epi32((int)(unsigned short)weights.weight_[i] | ((int)weights.weight_[i + 1] << 16));
+                sumLow = _mm_add_epi32(sumLow, _mm_madd_epi16(_mm_unpacklo_epi16(first, second), weight));
+                sumHigh = _mm_add_epi32(sumHigh, _mm_madd_epi16(_mm_unpackhi_epi16(first, second), weight));
+            }
+
+            __m128i sum = _mm_packs_epi32(_mm_srai_epi32(sumLow, RESAMPLE_WEIGHT_BITS), _mm_srai_epi32(sumHigh, RESAMPLE_WEIGHT_BITS));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(destRow + x), _mm_packus_epi16(sum, zero));
+        }
+#endif
+
+        for (; x < rowSize; ++x)
+        {
+            int sum = round;
+            for (unsigned i = begin; i < end; ++i)
+                sum += src[weights.source_[i] * rowSize + x] * weights.weight_[i];
+            destRow[x] = (unsigned char)(sum >> RESAMPLE_WEIGHT_BITS);
+        }
+    }
+}
+
+/// Multiply the color channels of RGBA pixels by alpha, rounded to nearest.
+static void PremultiplyPixels(unsigned char* pixels, unsigned numPixels)
+{
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i half = _mm_set1_epi16(128);
+
+    for (; i + 4 <= numPixels; i += 4)
+    {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+        __m128i result[2];
+
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            __m128i color = j ? _mm_unpackhi_epi8(data, zero) : _mm_unpacklo_epi8(data, zero);
+            // Broadcast the alpha of both pixels, and multiply the alpha itself by 255 to keep it
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_or_si128(_mm_andnot_si128(alphaMask, alpha), alphaOne);
+            // (x + (x >> 8)) >> 8 with x = c * a + 128 divides by 255 with rounding
+            __m128i product = _mm_add_epi16(_mm_mullo_epi16(color, alpha), half);
+            result[j] = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), _mm_packus_epi16(result[0], result[1]));
+    }
+#endif
+
+    for (; i < numPixels; ++i)
+    {
+        unsigned char* pixel = pixels + i * 4;
+        unsigned alpha = pixel[3];
+        for (unsigned c = 0; c < 3; ++c)
+        {
+            unsigned product = pixel[c] * alpha + 128;
+            pixel[c] = (unsigned char)((product + (product >> 8)) >> 8);
+        }
+    }
+}
+
 bool Image::FlipHorizontal()
 {
     if (!data_)
@@ -1053,19 +1556,10 @@ bool Image::FlipHorizontal()
 
     if (!IsCompressed())
     {
-        SharedArrayPtr<unsigned char> newData(new unsigned char[width_ * height_ * components_]);
         unsigned rowSize = width_ * components_;
 
         for (int y = 0; y < height_; ++y)
-        {
-            for (int x = 0; x < width_; ++x)
-            {
-                for (unsigned c = 0; c < components_; ++c)
-                    newData[y * rowSize + x * components_ + c] = data_[y * rowSize + (width_ - x - 1) * components_ + c];
-            }
-        }
-
-        data_ = newData;
+            FlipRowHorizontal(&data_[y * rowSize], width_, components_);
     }
     else
     {
@@ -1093,7 +1587,7 @@ bool Image::FlipHorizontal()
                 for (unsigned x = 0; x < level.rowSize_; x += level.blockSize_)
                 {
                     unsigned char* src = level.data_ + y * level.rowSize_ + (level.rowSize_ - level.blockSize_ - x);
-                    unsigned char* dest = newData.Get() + y * level.rowSize_ + x;
+                    unsigned char* dest = newData.Get() + dataOffset + y * level.rowSize_ + x;
                     FlipBlockHorizontal(dest, src, compressedFormat_);
                 }
             }
@@ -1120,13 +1614,18 @@ bool Image::FlipVertical()
 
     if (!IsCompressed())
     {
-        SharedArrayPtr<unsigned char> newData(new unsigned char[width_ * height_ * components_]);
+        // Swap the rows in place
         unsigned rowSize = width_ * components_;
+        SharedArrayPtr<unsigned char> rowData(new unsigned char[rowSize]);
 
-        for (int y = 0; y < height_; ++y)
-            memcpy(&newData[(height_ - y - 1) * rowSize], &data_[y * rowSize], rowSize);
-
-        data_ = newData;
+        for (int y = 0; y < height_ / 2; ++y)
+        {
+            unsigned char* upper = &data_[y * rowSize];
+            unsigned char* lower = &data_[(height_ - y - 1) * rowSize];
+            memcpy(rowData.Get(), upper, rowSize);
+            memcpy(upper, lower, rowSize);
+            memcpy(lower, rowData.Get(), rowSize);
+        }
     }
     else
     {
@@ -1186,44 +1685,60 @@ bool Image::Resize(int width, int height)
     if (!data_ || width <= 0 || height <= 0)
         return false;
 
-    /// \todo Reducing image size does not sample all needed pixels
-    SharedArrayPtr<unsigned char> newData(new unsigned char[width * height * components_]);
-    for (int y = 0; y < height; ++y)
+    if (width == width_ && height == height_)
+        return true;
+
+    // Resample the rows, then the columns of the resampled rows
+    SharedArrayPtr<unsigned char> newData = data_;
+    ResampleWeights weights;
+
+    if (width != width_)
     {
-        for (int x = 0; x < width; ++x)
-        {
-            // Calculate float coordinates between 0 - 1 for resampling
-            float xF = (width_ > 1) ? (float)x / (float)(width - 1) : 0.0f;
-            float yF = (height_ > 1) ? (float)y / (float)(height - 1) : 0.0f;
-            unsigned uintColor = GetPixelBilinear(xF, yF).ToUInt();
-            unsigned char* dest = newData + (y * width + x) * components_;
-            unsigned char* src = (unsigned char*)&uintColor;
+        weights.Define(width_, width);
+        newData = new unsigned char[width * height_ * components_];
+        ResampleRows(data_, newData, width_, width, height_, components_, weights);
+    }
 
-            switch (components_)
-            {
-            case 4:
-                dest[3] = src[3];
-                // Fall through
-            case 3:
-                dest[2] = src[2];
-                // Fall through
-            case 2:
-                dest[1] = src[1];
-                // Fall through
-            default:
-                dest[0] = src[0];
-                break;
-            }
-        }
+    if (height != height_)
+    {
+        SharedArrayPtr<unsigned char> rowsData = newData;
+        weights.Define(height_, height);
+        newData = new unsigned char[width * height * components_];
+        ResampleColumns(rowsData, newData, width * components_, height, weights);
     }
 
     width_ = width;
     height_ = height;
     data_ = newData;
+    nextLevel_.Reset();
     SetMemoryUse(width * height * depth_ * components_);
     return true;
 }
 
+bool Image::PremultiplyAlpha()
+{
+    URHO3D_PROFILE(PremultiplyImageAlpha);
+
+    if (!data_)
+        return false;
+
+    if (IsCompressed())
+    {
+        URHO3D_LOGERROR("PremultiplyAlpha not supported for compressed images");
+        return false;
+    }
+
+    if (components_ != 4)
+    {
+        URHO3D_LOGERROR("PremultiplyAlpha is only supported for RGBA images");
+        return false;
+    }
+
+    PremultiplyPixels(data_, (unsigned)(width_ * height_ * depth_));
+    nextLevel_.Reset();
+    return true;
+}
+
 void Image::Clear(const Color& color)
 {
     ClearInt(color.ToUInt());
@@ -1600,6 +2115,152 @@ Color Image::GetPixelTrilinear(float x, float y, float z) const
     return colorNear.Lerp(colorFar, zF);
 }
 
+/// Source and destination of a 2D mip level calculation split over work items.
+struct MipLevelRows
+{
+    /// Source level pixel data.
+    const unsigned char* pixelDataIn_;
+    /// Destination level pixel data.
+    unsigned char* pixelDataOut_;
+    /// Source level width.
+    int width_;
+    /// Destination level width.
+    int widthOut_;
+    /// Number of color components.
+    unsigned components_;
+};
+
+#ifdef URHO3D_SSE
+/// Average 2x2 blocks of 4-component pixels, 4 destination pixels at a time. Return the number of destination pixels calculated.
+static int CalculateMipRowSSE(const unsigned char* inUpper, const unsigned char* inLower, unsigned char* out, int widthOut)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+
+    for (; x + 4 <= widthOut; x += 4)
+    {
+        __m128i upper0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inUpper + x * 8));
+        __m128i upper1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inUpper + x * 8 + 16));
+        __m128i lower0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inLower + x * 8));
+        __m128i lower1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inLower + x * 8 + 16));
+
+        // Widen to 16 bits and add the rows, each register then holds the column sums of 2 source pixels
+        __m128i sum0 = _mm_add_epi16(_mm_unpacklo_epi8(upper0, zero), _mm_unpacklo_epi8(lower0, zero));
+        __m128i sum1 = _mm_add_epi16(_mm_unpackhi_epi8(upper0, zero), _mm_unpackhi_epi8(lower0, zero));
+        __m128i sum2 = _mm_add_epi16(_mm_unpacklo_epi8(upper1, zero), _mm_unpacklo_epi8(lower1, zero));
+        __m128i sum3 = _mm_add_epi16(_mm_unpackhi_epi8(upper1, zero), _mm_unpackhi_epi8(lower1, zero));
+
+        // Add the horizontally adjacent pixels and divide by 4, same truncation as the scalar path
+        __m128i out0 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum0, sum1), _mm_unpackhi_epi64(sum0, sum1)), 2);
+        __m128i out1 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum2, sum3), _mm_unpackhi_epi64(sum2, sum3)), 2);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(out0, out1));
+    }
+
+    return x;
+}
+#endif
+
+/// Calculate a range of rows of a 2D mip level by averaging 2x2 blocks.
+static void CalculateMipRows(const unsigned char* pixelDataIn, unsigned char* pixelDataOut, int width, int widthOut, unsigned components,
+    int yBegin, int yEnd)
+{
+    switch (components)
+    {
+    case 1:
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            const unsigned char* inUpper = &pixelDataIn[(y * 2) * width];
+            const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width];
+            unsigned char* out = &pixelDataOut[y * widthOut];
+
+            for (int x = 0; x < widthOut; ++x)
+            {
+                out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 1] +
+                                          inLower[x * 2] + inLower[x * 2 + 1]) >> 2);
+            }
+        }
+        break;
+
+    case 2:
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            const unsigned char* inUpper = &pixelDataIn[(y * 2) * width * 2];
+            const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width * 2];
+            unsigned char* out = &pixelDataOut[y * widthOut * 2];
+
+            for (int x = 0; x < widthOut * 2; x += 2)
+            {
+                out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 2] +
+                                          inLower[x * 2] + inLower[x * 2 + 2]) >> 2);
+                out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 3] +
+                                              inLower[x * 2 + 1] + inLower[x * 2 + 3]) >> 2);
+            }
+        }
+        break;
+
+    case 3:
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            const unsigned char* inUpper = &pixelDataIn[(y * 2) * width * 3];
+            const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width * 3];
+            unsigned char* out = &pixelDataOut[y * widthOut * 3];
+
+            for (int x = 0; x < widthOut * 3; x += 3)
+            {
+                out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 3] +
+                                          inLower[x * 2] + inLower[x * 2 + 3]) >> 2);
+                out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 4] +
+                                              inLower[x * 2 + 1] + inLower[x * 2 + 4]) >> 2);
+                out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 5] +
+                                              inLower[x * 2 + 2] + inLower[x * 2 + 5]) >> 2);
+            }
+        }
+        break;
+
+    case 4:
+        for (int y = yBegin; y < yEnd; ++y)
+        {
+            const unsigned char* inUpper = &pixelDataIn[(y * 2) * width * 4];
+            const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width * 4];
+            unsigned char* out = &pixelDataOut[y * widthOut * 4];
+            int x = 0;
+
+#ifdef URHO3D_SSE
+            x = CalculateMipRowSSE(inUpper, inLower, out, widthOut) * 4;
+#endif
+
+            for (; x < widthOut * 4; x += 4)
+            {
+                out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 4] +
+                                          inLower[x * 2] + inLower[x * 2 + 4]) >> 2);
+                out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 5] +
+                                              inLower[x * 2 + 1] + inLower[x * 2 + 5]) >> 2);
+                out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 6] +
+                                              inLower[x * 2 + 2] + inLower[x * 2 + 6]) >> 2);
+                out[x + 3] = (unsigned char)(((unsigned)inUpper[x * 2 + 3] + inUpper[x * 2 + 7] +
+                                              inLower[x * 2 + 3] + inLower[x * 2 + 7]) >> 2);
+            }
+        }
+        break;
+
+    default:
+        assert(false);  // Should never reach here
+        break;
+    }
+}
+
+/// Calculate a range of rows of a 2D mip level in a work item.
+static void CalculateMipRowsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const MipLevelRows* rows = reinterpret_cast<const MipLevelRows*>(item->aux_);
+    unsigned rowSize = (unsigned)rows->widthOut_ * rows->components_;
+    int yBegin = (int)((reinterpret_cast<unsigned char*>(item->start_) - rows->pixelDataOut_) / rowSize);
+    int yEnd = (int)((reinterpret_cast<unsigned char*>(item->end_) - rows->pixelDataOut_) / rowSize);
+
+    CalculateMipRows(rows->pixelDataIn_, rows->pixelDataOut_, rows->width_, rows->widthOut_, rows->components_, yBegin, yEnd);
+}
+
 SharedPtr<Image> Image::GetNextLevel() const
 {
     if (IsCompressed())
@@ -1688,84 +2349,38 @@ SharedPtr<Image> Image::GetNextLevel() const
     // 2D case
     else if (depth_ == 1)
     {
-        switch (components_)
-        {
-        case 1:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_];
-                unsigned char* out = &pixelDataOut[y * widthOut];
-
-                for (int x = 0; x < widthOut; ++x)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 1] +
-                                              inLower[x * 2] + inLower[x * 2 + 1]) >> 2);
-                }
-            }
-            break;
-
-        case 2:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 2];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 2];
-                unsigned char* out = &pixelDataOut[y * widthOut * 2];
-
-                for (int x = 0; x < widthOut * 2; x += 2)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 2] +
-                                              inLower[x * 2] + inLower[x * 2 + 2]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 3] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 3]) >> 2);
-                }
-            }
-            break;
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
 
-        case 3:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 3];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 3];
-                unsigned char* out = &pixelDataOut[y * widthOut * 3];
-
-                for (int x = 0; x < widthOut * 3; x += 3)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 3] +
-                                              inLower[x * 2] + inLower[x * 2 + 3]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 4] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 5]) >> 2);
-                }
-            }
-            break;
-
-        case 4:
-            for (int y = 0; y < heightOut; ++y)
+        // Split large levels by rows over the worker threads. Work items can only be queued from the main thread
+        if (widthOut * heightOut >= MIP_LEVEL_THREADED_PIXELS && queue && queue->GetNumThreads() && Thread::IsMainThread() &&
+            !queue->IsCompleting())
+        {
+            MipLevelRows rows;
+            rows.pixelDataIn_ = pixelDataIn;
+            rows.pixelDataOut_ = pixelDataOut;
+            rows.width_ = width_;
+            rows.widthOut_ = widthOut;
+            rows.components_ = components_;
+
+            int numWorkItems = (int)queue->GetNumThreads() + 1; // Worker threads + main thread
+            int rowsPerItem = (heightOut + numWorkItems - 1) / numWorkItems;
+            unsigned rowSize = (unsigned)widthOut * components_;
+
+            for (int y = 0; y < heightOut; y += rowsPerItem)
             {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 4];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 4];
-                unsigned char* out = &pixelDataOut[y * widthOut * 4];
-
-                for (int x = 0; x < widthOut * 4; x += 4)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 4] +
-                                              inLower[x * 2] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 5]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 6] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 6]) >> 2);
-                    out[x + 3] = (unsigned char)(((unsigned)inUpper[x * 2 + 3] + inUpper[x * 2 + 7] +
-                                                  inLower[x * 2 + 3] + inLower[x * 2 + 7]) >> 2);
-                }
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = CalculateMipRowsWork;
+                item->aux_ = &rows;
+                item->start_ = pixelDataOut + y * rowSize;
+                item->end_ = pixelDataOut + Min(y + rowsPerItem, heightOut) * rowSize;
+                queue->AddWorkItem(item);
             }
-            break;
 
-        default:
-            assert(false);  // Should never reach here
-            break;
+            queue->Complete(M_MAX_UNSIGNED);
         }
+        else
+            CalculateMipRows(pixelDataIn, pixelDataOut, width_, widthOut, components_, 0, heightOut);
     }
     // 3D case
     else
@@ -1928,38 +2543,80 @@ SharedPtr<Image> Image::ConvertToRGBA() const
 
     const unsigned char* src = data_;
     unsigned char* dest = ret->GetData();
+    unsigned numPixels = static_cast<unsigned>(width_ * height_ * depth_);
+    unsigned i = 0;
 
     switch (components_)
     {
     case 1:
-        for (unsigned i = 0; i < static_cast<unsigned>(width_ * height_ * depth_); ++i)
+#ifdef URHO3D_SSE
+        // Interleave the luminance twice with itself and once with the opaque alpha, 16 pixels at a time
+        for (; i + 16 <= numPixels; i += 16)
         {
-            unsigned char pixel = *src++;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = 255;
+            const __m128i opaque = _mm_set1_epi8(-1);
+            __m128i lum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i lumLumLow = _mm_unpacklo_epi8(lum, lum);
+            __m128i lumAlphaLow = _mm_unpacklo_epi8(lum, opaque);
+            __m128i lumLumHigh = _mm_unpackhi_epi8(lum, lum);
+            __m128i lumAlphaHigh = _mm_unpackhi_epi8(lum, opaque);
+            __m128i* out = reinterpret_cast<__m128i*>(dest + i * 4);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(lumLumLow, lumAlphaLow));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lumLumLow, lumAlphaLow));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(lumLumHigh, lumAlphaHigh));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(lumLumHigh, lumAlphaHigh));
+        }
+#endif
+        for (; i < numPixels; ++i)
+        {
+            unsigned char pixel = src[i];
+            dest[i * 4] = pixel;
+            dest[i * 4 + 1] = pixel;
+            dest[i * 4 + 2] = pixel;
+            dest[i * 4 + 3] = 255;
         }
         break;
 
     case 2:
-        for (unsigned i = 0; i < static_cast<unsigned>(width_ * height_ * depth_); ++i)
+#ifdef URHO3D_SSE
+        // Interleave the duplicated luminance with the luminance-alpha pairs, 8 pixels at a time
+        for (; i + 8 <= numPixels; i += 8)
+        {
+            __m128i lumAlpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            __m128i lum = _mm_and_si128(lumAlpha, _mm_set1_epi16(0xff));
+            __m128i lumLum = _mm_or_si128(lum, _mm_slli_epi16(lum, 8));
+            __m128i* out = reinterpret_cast<__m128i*>(dest + i * 4);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(lumLum, lumAlpha));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lumLum, lumAlpha));
+        }
+#endif
+        for (; i < numPixels; ++i)
         {
-            unsigned char pixel = *src++;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = pixel;
-            *dest++ = *src++;
+            unsigned char pixel = src[i * 2];
+            dest[i * 4] = pixel;
+            dest[i * 4 + 1] = pixel;
+            dest[i * 4 + 2] = pixel;
+            dest[i * 4 + 3] = src[i * 2 + 1];
         }
         break;
 
     case 3:
-        for (unsigned i = 0; i < static_cast<unsigned>(width_ * height_ * depth_); ++i)
+#ifdef URHO3D_SSE
+        // Load each pixel as 32 bits and replace the byte of the next pixel with the opaque alpha, 4 pixels at a time.
+        // The last pixel is converted separately, as loading it would read past the data
+        for (; i + 5 <= numPixels; i += 4)
         {
-            *dest++ = *src++;
-            *dest++ = *src++;
-            *dest++ = *src++;
-            *dest++ = 255;
+            const unsigned char* in = src + i * 3;
+            __m128i pixels = _mm_set_epi32(*reinterpret_cast<const int*>(in + 9), *reinterpret_cast<const int*>(in + 6),
+                *reinterpret_cast<const int*>(in + 3), *reinterpret_cast<const int*>(in));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_or_si128(pixels, _mm_set1_epi32((int)0xff000000)));
+        }
+#endif
+        for (; i < numPixels; ++i)
+        {
+            dest[i * 4] = src[i * 3];
+            dest[i * 4 + 1] = src[i * 3 + 1];
+            dest[i * 4 + 2] = src[i * 3 + 2];
+            dest[i * 4 + 3] = 255;
         }
         break;
 
@@ -1971,6 +2628,69 @@ SharedPtr<Image> Image::ConvertToRGBA() const
     return ret;
 }
 
+SharedPtr<Image> Image::ConvertToRGB() const
+{
+    if (IsCompressed())
+    {
+        URHO3D_LOGERROR("Can not convert compressed image to RGB");
+        return SharedPtr<Image>();
+    }
+    if (components_ < 1 || components_ > 4)
+    {
+        URHO3D_LOGERROR("Illegal number of image components for conversion to RGB");
+        return SharedPtr<Image>();
+    }
+    if (!data_)
+    {
+        URHO3D_LOGERROR("Can not convert image without data to RGB");
+        return SharedPtr<Image>();
+    }
+
+    // Already RGB?
+    if (components_ == 3)
+        return SharedPtr<Image>(const_cast<Image*>(this));
+
+    SharedPtr<Image> ret(new Image(context_));
+    ret->SetSize(width_, height_, depth_, 3);
+
+    const unsigned char* src = data_;
+    unsigned char* dest = ret->GetData();
+    unsigned numPixels = static_cast<unsigned>(width_ * height_ * depth_);
+    unsigned i = 0;
+
+    switch (components_)
+    {
+    case 1:
+    case 2:
+        for (; i < numPixels; ++i)
+        {
+            unsigned char pixel = src[i * components_];
+            dest[i * 3] = pixel;
+            dest[i * 3 + 1] = pixel;
+            dest[i * 3 + 2] = pixel;
+        }
+        break;
+
+    case 4:
+        // Store each pixel as 32 bits, the alpha byte is overwritten by the next pixel. The last pixel is converted separately
+        for (; i + 1 < numPixels; ++i)
+            memcpy(dest + i * 3, src + i * 4, 4);
+        for (; i < numPixels; ++i)
+        {
+            dest[i * 3] = src[i * 4];
+            dest[i * 3 + 1] = src[i * 4 + 1];
+            dest[i * 3 + 2] = src[i * 4 + 2];
+        }
+        break;
+
+    default:
+        assert(false);  // Should never reach here
+        break;
+    }
+
+    return ret;
+}
+
 CompressedLevel Image::GetCompressedLevel(unsigned index) const
 {
     CompressedLevel level;
@@ -2287,23 +3007,25 @@ void Image::PrecalculateLevels()
 
     URHO3D_PROFILE(PrecalculateImageMipLevels);
 
-    nextLevel_.Reset();
+    // Continue from the last level loaded from a KTX2 file. Other levels may be stale after editing the pixels, calculate them again
+    if (!loadedLevels_)
+        nextLevel_.Reset();
 
-    if (width_ > 1 || height_ > 1)
+    Image* current = this;
+    while (current->nextLevel_)
+        current = current->nextLevel_;
+
+    while (current && (current->width_ > 1 || current->height_ > 1))
     {
-        SharedPtr<Image> current = GetNextLevel();
-        nextLevel_ = current;
-        while (current && (current->width_ > 1 || current->height_ > 1))
-        {
-            current->nextLevel_ = current->GetNextLevel();
-            current = current->nextLevel_;
-        }
+        current->nextLevel_ = current->GetNextLevel();
+        current = current->nextLevel_;
     }
 }
 
 void Image::CleanupLevels()
 {
     nextLevel_.Reset();
+    loadedLevels_ = false;
 }
 
 void Image::GetLevels(PODVector<Image*>& levels)
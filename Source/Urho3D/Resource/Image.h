@@ -129,8 +129,10 @@ public:
     bool FlipHorizontal();
     /// Flip image vertically. Return true if successful.
     bool FlipVertical();
-    /// Resize image by bilinear resampling. Return true if successful.
+    /// Resize image by bilinear resampling when enlarging and by averaging the covered pixels when reducing. Return true if successful.
     bool Resize(int width, int height);
+    /// Multiply the color channels by alpha. Only uncompressed RGBA images are supported. Return true if successful.
+    bool PremultiplyAlpha();
     /// Clear the image with a color.
     void Clear(const Color& color);
     /// Clear the image with an integer color. R component is in the 8 lowest bits.
@@ -197,6 +199,8 @@ public:
     SharedPtr<Image> GetNextSibling() const { return nextSibling_;  }
     /// Return image converted to 4-component (RGBA) to circumvent modern rendering API's not supporting e.g. the luminance-alpha format.
     SharedPtr<Image> ConvertToRGBA() const;
+    /// Return image converted to 3-component (RGB), discarding alpha.
+    SharedPtr<Image> ConvertToRGB() const;
     /// Return a compressed mip level.
     CompressedLevel GetCompressedLevel(unsigned index) const;
     /// Return subimage from the image by the defined rect or null if failed. 3D images are not supported. You must free the subimage yourself.
@@ -217,6 +221,8 @@ public:
     void GetLevels(PODVector<const Image*>& levels) const;
 
 private:
+    /// Load a KTX2 file, after its identifier has been read. Return true if successful.
+    bool LoadKTX2(Deserializer& source);
     /// Decode an image using stb_image.
     static unsigned char* GetImageData(Deserializer& source, int& width, int& height, unsigned& components);
     /// Free an image file's pixel data.
@@ -238,6 +244,8 @@ private:
     bool array_;
     /// Data is sRGB.
     bool sRGB_;
+    /// FromBones : whether the mip levels were loaded from a KTX2 file and are kept by PrecalculateLevels().
+    bool loadedLevels_;
     /// Compressed format.
     CompressedFormat compressedFormat_;
     /// Pixel data.
@@ -77,6 +77,8 @@ public:
     void SetMemoryUse(unsigned size);
     /// Reset last used timer.
     void ResetUseTimer();
+    /// FromBones : Set the resource cache frame number of the last use. Called by ResourceCache.
+    void SetLastUseFrame(unsigned frame) { lastUseFrame_ = frame; }
     /// Set the asynchronous loading state. Called by ResourceCache. Resources in the middle of asynchronous loading are not normally returned to user.
     void SetAsyncLoadState(AsyncLoadState newState);
 
@@ -91,6 +93,8 @@ public:
 
     /// Return time since last use in milliseconds. If referred to elsewhere than in the resource cache, returns always zero.
     unsigned GetUseTimer();
+    /// FromBones : Return the resource cache frame number of the last use.
+    unsigned GetLastUseFrame() const { return lastUseFrame_; }
 
     /// Return the asynchronous loading state.
     AsyncLoadState GetAsyncLoadState() const { return asyncLoadState_; }
@@ -104,6 +108,8 @@ private:
     Timer useTimer_;
     /// Memory use in bytes.
     unsigned memoryUse_;
+    /// FromBones : Resource cache frame number of the last use.
+    unsigned lastUseFrame_;
     /// Asynchronous loading state.
     AsyncLoadState asyncLoadState_;
 };
@@ -26,6 +26,7 @@
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
+#include "../IO/AsyncFileReader.h"
 #include "../IO/FileSystem.h"
 #include "../IO/FileWatcher.h"
 #include "../IO/Log.h"
@@ -37,6 +38,7 @@
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 #include "../Resource/XMLFile.h"
+#include "../Container/Sort.h"
 
 #include "../DebugNew.h"
 
@@ -67,14 +69,47 @@ static const char* checkDirs[] =
 
 static const SharedPtr<Resource> noResource;
 
+/// FromBones : resource that can be released to respect the memory budget.
+struct EvictionCandidate
+{
+    /// Name hash.
+    StringHash nameHash_;
+    /// Frame number of the last use.
+    unsigned lastUseFrame_;
+    /// Memory use.
+    unsigned memoryUse_;
+};
+
+static inline unsigned long long GetLookupKey(StringHash type, StringHash nameHash)
+{
+    return ((unsigned long long)type.Value() << 32) | nameHash.Value();
+}
+
+static inline unsigned GetLookupShardIndex(unsigned long long key)
+{
+    const unsigned hash = (unsigned)(key >> 32) ^ (unsigned)key;
+    return (hash ^ (hash >> 16)) & (NUM_RESOURCE_LOOKUP_SHARDS - 1);
+}
+
+static bool CompareEvictionCandidates(const EvictionCandidate& lhs, const EvictionCandidate& rhs)
+{
+    return lhs.lastUseFrame_ < rhs.lastUseFrame_;
+}
+
 ResourceCache::ResourceCache(Context* context) :
     Object(context),
     autoReloadResources_(false),
     returnFailedResources_(false),
     searchPackagesFirst_(true),
     isRouting_(false),
-    finishBackgroundResourcesMs_(5)
+    finishBackgroundResourcesMs_(5),
+    useFrame_(0),
+    lookupEpoch_(0),
+    numLookups_(0),
+    numLookupContentions_(0)
 {
+    numLookupScopes_[0] = numLookupScopes_[1] = 0;
+
     // Register Resource library object factories
     RegisterResourceLibrary(context_);
 
@@ -174,9 +209,7 @@ bool ResourceCache::AddManualResource(Resource* resource)
         return false;
     }
 
-    resource->ResetUseTimer();
-    resourceGroups_[resource->GetType()].resources_[resource->GetNameHash()] = resource;
-    UpdateResourceGroup(resource->GetType());
+    StoreResource(resource);
     return true;
 }
 
@@ -253,6 +286,7 @@ void ResourceCache::ReleaseResource(StringHash type, const String& name, bool fo
     // If other references exist, do not release, unless forced
     if ((existingRes.Refs() == 1 && existingRes.WeakRefs() == 0) || force)
     {
+        RetireResource(existingRes);
         resourceGroups_[type].resources_.Erase(nameHash);
         UpdateResourceGroup(type);
     }
@@ -265,13 +299,14 @@ void ResourceCache::ReleaseResources(StringHash type, bool force)
     HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i != resourceGroups_.End())
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End();)
         {
-            HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+            FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
             // If other references exist, do not release, unless forced
             if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
             {
+                RetireResource(current->second_);
                 i->second_.resources_.Erase(current);
                 released = true;
             }
@@ -289,15 +324,16 @@ void ResourceCache::ReleaseResources(StringHash type, const String& partialName,
     HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i != resourceGroups_.End())
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End();)
         {
-            HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+            FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
             if (current->second_->GetName().Contains(partialName))
             {
                 // If other references exist, do not release, unless forced
                 if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                 {
+                    RetireResource(current->second_);
                     i->second_.resources_.Erase(current);
                     released = true;
                 }
@@ -321,15 +357,16 @@ void ResourceCache::ReleaseResources(const String& partialName, bool force)
         {
             bool released = false;
 
-            for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+            for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
                  j != i->second_.resources_.End();)
             {
-                HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+                FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
                 if (current->second_->GetName().Contains(partialName))
                 {
                     // If other references exist, do not release, unless forced
                     if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                     {
+                        RetireResource(current->second_);
                         i->second_.resources_.Erase(current);
                         released = true;
                     }
@@ -352,13 +389,14 @@ void ResourceCache::ReleaseAllResources(bool force)
         {
             bool released = false;
 
-            for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
+            for (FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
                  j != i->second_.resources_.End();)
             {
-                HashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
+                FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator current = j++;
                 // If other references exist, do not release, unless forced
                 if ((current->second_.Refs() == 1 && current->second_.WeakRefs() == 0) || force)
                 {
+                    RetireResource(current->second_);
                     i->second_.resources_.Erase(current);
                     released = true;
                 }
@@ -384,6 +422,7 @@ bool ResourceCache::ReloadResource(Resource* resource)
     if (success)
     {
         resource->ResetUseTimer();
+        resource->SetLastUseFrame(useFrame_);
         UpdateResourceGroup(resource->GetType());
         resource->SendEvent(E_RELOADFINISHED);
         return true;
@@ -398,8 +437,9 @@ bool ResourceCache::ReloadResource(Resource* resource)
 void ResourceCache::ReloadResourceWithDependencies(const String& fileName)
 {
     StringHash fileNameHash(fileName);
-    // If the filename is a resource we keep track of, reload it
-    const SharedPtr<Resource>& resource = FindResource(fileNameHash);
+    // If the filename is a resource we keep track of, reload it. Hold a copy: reloading may add resources
+    // to the group, which moves the FlatHashMap values the returned reference points to
+    SharedPtr<Resource> resource = FindResource(fileNameHash);
     if (resource)
     {
         URHO3D_LOGDEBUG("Reloading changed resource " + fileName);
@@ -559,6 +599,47 @@ Resource* ResourceCache::GetExistingResource(StringHash type, const String& name
     return existing;
 }
 
+Resource* ResourceCache::LookupResource(StringHash type, const String& nameIn)
+{
+    String name = SanitateResourceName(nameIn);
+    if (name.Empty())
+        return 0;
+
+    return LookupResource(type, StringHash(name));
+}
+
+Resource* ResourceCache::LookupResource(StringHash type, StringHash nameHash)
+{
+    const unsigned long long key = GetLookupKey(type, nameHash);
+    ResourceLookupShard& shard = lookupShards_[GetLookupShardIndex(key)];
+
+    if (!shard.mutex_.TryAcquire())
+    {
+        shard.mutex_.Acquire();
+        ++shard.numContentions_;
+    }
+
+    ++shard.numLookups_;
+    HashMap<unsigned long long, Resource*>::ConstIterator i = shard.resources_.Find(key);
+    Resource* resource = i != shard.resources_.End() ? i->second_ : 0;
+
+    shard.mutex_.Release();
+    return resource;
+}
+
+unsigned ResourceCache::BeginLookupScope()
+{
+    MutexLock lock(lookupScopeMutex_);
+    ++numLookupScopes_[lookupEpoch_];
+    return lookupEpoch_;
+}
+
+void ResourceCache::EndLookupScope(unsigned epoch)
+{
+    MutexLock lock(lookupScopeMutex_);
+    --numLookupScopes_[epoch];
+}
+
 Resource* ResourceCache::GetResourceByHash(const StringHash& type, const StringHash& hashname)
 {
 #ifdef URHO3D_THREADING
@@ -639,9 +720,7 @@ Resource* ResourceCache::GetResource(StringHash type, const String& nameIn, bool
     }
 
     // Store to cache
-    resource->ResetUseTimer();
-    resourceGroups_[type].resources_[nameHash] = resource;
-    UpdateResourceGroup(type);
+    StoreResource(resource);
 
     return resource;
 }
@@ -666,6 +745,110 @@ bool ResourceCache::BackgroundLoadResource(StringHash type, const String& nameIn
 #endif
 }
 
+SharedPtr<AsyncReadRequest> ResourceCache::ReadFileAsync(const String& nameIn, void (*callback)(AsyncReadRequest*), void* aux, SharedPtr<PackageFile>* package)
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    AsyncFileReader* reader = fileSystem ? fileSystem->GetAsyncFileReader() : 0;
+    if (!reader)
+        return SharedPtr<AsyncReadRequest>();
+
+    String fileName;
+    unsigned offset = 0;
+    unsigned size = M_MAX_UNSIGNED;
+    if (package)
+        package->Reset();
+
+    {
+        MutexLock lock(resourceMutex_);
+
+        // Search the same way as GetFile()
+        String name = SanitateResourceName(nameIn);
+        if (!isRouting_)
+        {
+            isRouting_ = true;
+            for (unsigned i = 0; i < resourceRouters_.Size(); ++i)
+                resourceRouters_[i]->Route(name, RESOURCE_GETFILE);
+            isRouting_ = false;
+        }
+
+        if (name.Empty())
+            return SharedPtr<AsyncReadRequest>();
+
+        for (unsigned pass = 0; pass < 2 && fileName.Empty(); ++pass)
+        {
+            if ((pass == 0) == searchPackagesFirst_)
+            {
+                for (unsigned i = 0; i < packages_.Size(); ++i)
+                {
+                    const PackageEntry* entry = packages_[i]->GetEntry(name);
+                    if (!entry)
+                        continue;
+
+                    // Memory mapped packages are read without system calls, and compressed entries need decompression
+                    if (packages_[i]->IsMapped() || entry->compression_ != PACKAGE_COMPRESSION_NONE)
+                        return SharedPtr<AsyncReadRequest>();
+
+                    fileName = packages_[i]->GetName();
+                    offset = entry->offset_;
+                    size = entry->size_;
+                    if (package)
+                        *package = packages_[i];
+                    break;
+                }
+            }
+            else
+            {
+                for (unsigned i = 0; i < resourceDirs_.Size(); ++i)
+                {
+                    if (fileSystem->FileExists(resourceDirs_[i] + name))
+                    {
+                        fileName = resourceDirs_[i] + name;
+                        break;
+                    }
+                }
+
+                // Fallback using absolute path
+                if (fileName.Empty() && fileSystem->FileExists(name))
+                    fileName = name;
+            }
+        }
+    }
+
+    if (fileName.Empty())
+        return SharedPtr<AsyncReadRequest>();
+
+    return reader->Read(fileName, offset, size, callback, aux);
+}
+
+Resource* ResourceCache::RequestResource(StringHash type, const String& nameIn, bool sendEventOnFailure)
+{
+#ifdef URHO3D_THREADING
+    String name = SanitateResourceName(nameIn);
+
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Attempted to request resource " + name + " from outside the main thread");
+        return 0;
+    }
+
+    // If empty name, return null pointer immediately
+    if (name.Empty())
+        return 0;
+
+    // Unlike GetResource(), do not wait for a resource being background loaded
+    StringHash nameHash(name);
+    const SharedPtr<Resource>& existing = FindResource(type, nameHash);
+    if (existing)
+        return existing;
+
+    backgroundLoader_->QueueResource(type, name, sendEventOnFailure, 0);
+    return 0;
+#else
+    // When threading not supported, fall back to synchronous loading
+    return GetResource(type, nameIn, sendEventOnFailure);
+#endif
+}
+
 SharedPtr<Resource> ResourceCache::GetTempResource(StringHash type, const String& nameIn, bool sendEventOnFailure)
 {
     String name = SanitateResourceName(nameIn);
@@ -728,13 +911,29 @@ unsigned ResourceCache::GetNumBackgroundLoadResources() const
 #endif
 }
 
+void ResourceCache::SetNumBackgroundLoadThreads(unsigned num)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumThreads(num);
+#endif
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumThreads();
+#else
+    return 0;
+#endif
+}
+
 void ResourceCache::GetResources(PODVector<Resource*>& result, StringHash type) const
 {
     result.Clear();
     HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
     if (i != resourceGroups_.End())
     {
-        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = i->second_.resources_.Begin();
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = i->second_.resources_.Begin();
              j != i->second_.resources_.End(); ++j)
             result.Push(j->second_);
     }
@@ -785,6 +984,18 @@ unsigned long long ResourceCache::GetMemoryUse(StringHash type) const
     return i != resourceGroups_.End() ? i->second_.memoryUse_ : 0;
 }
 
+unsigned ResourceCache::GetNumEvictedResources(StringHash type) const
+{
+    HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    return i != resourceGroups_.End() ? i->second_.numEvicted_ : 0;
+}
+
+unsigned ResourceCache::GetNumReloadedResources(StringHash type) const
+{
+    HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Find(type);
+    return i != resourceGroups_.End() ? i->second_.numReloaded_ : 0;
+}
+
 unsigned long long ResourceCache::GetTotalMemoryUse() const
 {
     unsigned long long total = 0;
@@ -943,7 +1154,7 @@ String ResourceCache::PrintMemoryUsage() const
         else
             average = 0;
         unsigned long long largest = 0;
-        for (HashMap<StringHash, SharedPtr<Resource> >::ConstIterator resIt = cit->second_.resources_.Begin(); resIt != cit->second_.resources_.End(); ++resIt)
+        for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator resIt = cit->second_.resources_.Begin(); resIt != cit->second_.resources_.End(); ++resIt)
         {
             if (resIt->second_->GetMemoryUse() > largest)
                 largest = resIt->second_->GetMemoryUse();
@@ -990,10 +1201,12 @@ const SharedPtr<Resource>& ResourceCache::FindResource(StringHash type, StringHa
     HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Find(type);
     if (i == resourceGroups_.End())
         return noResource;
-    HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
+    FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
     if (j == i->second_.resources_.End())
         return noResource;
 
+    // FromBones : any lookup counts as a use for the memory budget
+    j->second_->SetLastUseFrame(useFrame_);
     return j->second_;
 }
 
@@ -1003,7 +1216,7 @@ const SharedPtr<Resource>& ResourceCache::FindResource(StringHash nameHash)
 
     for (HashMap<StringHash, ResourceGroup>::Iterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
     {
-        HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
+        FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Find(nameHash);
         if (j != i->second_.resources_.End())
             return j->second_;
     }
@@ -1023,12 +1236,13 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
         // We do not know the actual resource type, so search all type containers
         for (HashMap<StringHash, ResourceGroup>::Iterator j = resourceGroups_.Begin(); j != resourceGroups_.End(); ++j)
         {
-            HashMap<StringHash, SharedPtr<Resource> >::Iterator k = j->second_.resources_.Find(nameHash);
+            FlatHashMap<StringHash, SharedPtr<Resource> >::Iterator k = j->second_.resources_.Find(nameHash);
             if (k != j->second_.resources_.End())
             {
                 // If other references exist, do not release, unless forced
                 if ((k->second_.Refs() == 1 && k->second_.WeakRefs() == 0) || force)
                 {
+                    RetireResource(k->second_);
                     j->second_.resources_.Erase(k);
                     affectedGroups.Insert(j->first_);
                 }
@@ -1047,37 +1261,123 @@ void ResourceCache::UpdateResourceGroup(StringHash type)
     if (i == resourceGroups_.End())
         return;
 
-    for (;;)
-    {
-        unsigned totalSize = 0;
-        unsigned oldestTimer = 0;
-        HashMap<StringHash, SharedPtr<Resource> >::Iterator oldestResource = i->second_.resources_.End();
+    ResourceGroup& group = i->second_;
+    unsigned long long totalSize = 0;
+    for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = group.resources_.Begin(); j != group.resources_.End(); ++j)
+        totalSize += j->second_->GetMemoryUse();
 
-        for (HashMap<StringHash, SharedPtr<Resource> >::Iterator j = i->second_.resources_.Begin();
-             j != i->second_.resources_.End(); ++j)
+    group.memoryUse_ = totalSize;
+    if (!group.memoryBudget_ || group.memoryUse_ <= group.memoryBudget_)
+        return;
+
+    // FromBones : release the least recently used resources first. Resources in use elsewhere or used during this frame,
+    // for example just loaded and not yet referred to by the caller, can not be released
+    PODVector<EvictionCandidate> candidates;
+    for (FlatHashMap<StringHash, SharedPtr<Resource> >::ConstIterator j = group.resources_.Begin(); j != group.resources_.End(); ++j)
+    {
+        const Resource* resource = j->second_;
+        if (j->second_.Refs() == 1 && resource->GetLastUseFrame() != useFrame_)
         {
-            totalSize += j->second_->GetMemoryUse();
-            unsigned useTimer = j->second_->GetUseTimer();
-            if (useTimer > oldestTimer)
-            {
-                oldestTimer = useTimer;
-                oldestResource = j;
-            }
+            EvictionCandidate candidate;
+            candidate.nameHash_ = j->first_;
+            candidate.lastUseFrame_ = resource->GetLastUseFrame();
+            candidate.memoryUse_ = resource->GetMemoryUse();
+            candidates.Push(candidate);
         }
+    }
+
+    Sort(candidates.Begin(), candidates.End(), CompareEvictionCandidates);
+
+    for (unsigned j = 0; j < candidates.Size() && group.memoryUse_ > group.memoryBudget_; ++j)
+    {
+        const EvictionCandidate& candidate = candidates[j];
+        URHO3D_LOGDEBUG("Resource group " + context_->GetTypeName(type) + " over memory budget, releasing resource " +
+                 group.resources_[candidate.nameHash_]->GetName());
+
+        RetireResource(group.resources_[candidate.nameHash_]);
+        group.resources_.Erase(candidate.nameHash_);
+        group.evictedResources_.Insert(candidate.nameHash_);
+        group.memoryUse_ -= candidate.memoryUse_;
+        ++group.numEvicted_;
+    }
+}
+
+void ResourceCache::StoreResource(Resource* resource)
+{
+    resource->ResetUseTimer();
+    resource->SetLastUseFrame(useFrame_);
 
-        i->second_.memoryUse_ = totalSize;
+    ResourceGroup& group = resourceGroups_[resource->GetType()];
+    SharedPtr<Resource>& stored = group.resources_[resource->GetNameHash()];
+    if (stored && stored != resource)
+        RetireResource(stored);
+    stored = resource;
+    PublishResource(resource);
+    if (group.evictedResources_.Erase(resource->GetNameHash()))
+        ++group.numReloaded_;
 
-        // If memory budget defined and is exceeded, remove the oldest resource and loop again
-        // (resources in use always return a zero timer and can not be removed)
-        if (i->second_.memoryBudget_ && i->second_.memoryUse_ > i->second_.memoryBudget_ &&
-            oldestResource != i->second_.resources_.End())
+    UpdateResourceGroup(resource->GetType());
+}
+
+void ResourceCache::PublishResource(Resource* resource)
+{
+    const unsigned long long key = GetLookupKey(resource->GetType(), resource->GetNameHash());
+    ResourceLookupShard& shard = lookupShards_[GetLookupShardIndex(key)];
+
+    MutexLock lock(shard.mutex_);
+    shard.resources_[key] = resource;
+}
+
+void ResourceCache::RetireResource(Resource* resource)
+{
+    const unsigned long long key = GetLookupKey(resource->GetType(), resource->GetNameHash());
+    ResourceLookupShard& shard = lookupShards_[GetLookupShardIndex(key)];
+
+    {
+        MutexLock lock(shard.mutex_);
+        HashMap<unsigned long long, Resource*>::Iterator i = shard.resources_.Find(key);
+        if (i != shard.resources_.End() && i->second_ == resource)
+            shard.resources_.Erase(i);
+    }
+
+    // The resource is no more found by the new lookups. Keep it alive only if lookups in progress may use it
+    MutexLock lock(lookupScopeMutex_);
+    if (numLookupScopes_[0] || numLookupScopes_[1])
+        retiredResources_[lookupEpoch_].Push(SharedPtr<Resource>(resource));
+}
+
+void ResourceCache::UpdateLookupTable()
+{
+    // Release the resources retired during the previous epoch once its lookup scopes have ended, then begin a new epoch
+    Vector<SharedPtr<Resource> > releasedResources;
+    {
+        MutexLock lock(lookupScopeMutex_);
+        const unsigned previousEpoch = lookupEpoch_ ^ 1;
+        if (!numLookupScopes_[previousEpoch])
         {
-            URHO3D_LOGDEBUG("Resource group " + oldestResource->second_->GetTypeName() + " over memory budget, releasing resource " +
-                     oldestResource->second_->GetName());
-            i->second_.resources_.Erase(oldestResource);
+            releasedResources.Swap(retiredResources_[previousEpoch]);
+            lookupEpoch_ = previousEpoch;
         }
-        else
-            break;
+    }
+    releasedResources.Clear();
+
+    numLookups_ = 0;
+    numLookupContentions_ = 0;
+    for (unsigned i = 0; i < NUM_RESOURCE_LOOKUP_SHARDS; ++i)
+    {
+        ResourceLookupShard& shard = lookupShards_[i];
+        MutexLock lock(shard.mutex_);
+        numLookups_ += shard.numLookups_;
+        numLookupContentions_ += shard.numContentions_;
+        shard.numLookups_ = 0;
+        shard.numContentions_ = 0;
+    }
+
+    Profiler* profiler = GetSubsystem<Profiler>();
+    if (profiler)
+    {
+        profiler->AddCounter("ResourceLookups", numLookups_);
+        profiler->AddCounter("ResourceLookupContentions", numLookupContentions_);
     }
 }
 
@@ -1107,6 +1407,16 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
         backgroundLoader_->FinishResources(finishBackgroundResourcesMs_);
     }
 #endif
+
+    UpdateLookupTable();
+
+    // FromBones : start a new frame of resource use, then release the least recently used resources of the groups over budget
+    ++useFrame_;
+    for (HashMap<StringHash, ResourceGroup>::ConstIterator i = resourceGroups_.Begin(); i != resourceGroups_.End(); ++i)
+    {
+        if (i->second_.memoryBudget_)
+            UpdateResourceGroup(i->first_);
+    }
 }
 
 File* ResourceCache::SearchResourceDirs(const String& nameIn)
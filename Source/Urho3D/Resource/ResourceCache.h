@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
@@ -31,6 +32,7 @@
 namespace Urho3D
 {
 
+class AsyncReadRequest;
 class BackgroundLoader;
 class FileWatcher;
 class PackageFile;
@@ -44,7 +46,9 @@ struct ResourceGroup
     /// Construct with defaults.
     ResourceGroup() :
         memoryBudget_(0),
-        memoryUse_(0)
+        memoryUse_(0),
+        numEvicted_(0),
+        numReloaded_(0)
     {
     }
 
@@ -53,7 +57,36 @@ struct ResourceGroup
     /// Current memory use.
     unsigned long long memoryUse_;
     /// Resources.
-    HashMap<StringHash, SharedPtr<Resource> > resources_;
+    FlatHashMap<StringHash, SharedPtr<Resource> > resources_;
+    /// FromBones : Name hashes of the resources evicted to respect the memory budget and not loaded again since.
+    HashSet<StringHash> evictedResources_;
+    /// FromBones : Number of resources evicted to respect the memory budget.
+    unsigned numEvicted_;
+    /// FromBones : Number of evicted resources loaded again.
+    unsigned numReloaded_;
+};
+
+/// FromBones : Number of shards of the resource lookup table, power of two.
+static const unsigned NUM_RESOURCE_LOOKUP_SHARDS = 16;
+
+/// FromBones : shard of the loaded resources lookup table, for the threads other than the main thread.
+struct ResourceLookupShard
+{
+    /// Construct with defaults.
+    ResourceLookupShard() :
+        numLookups_(0),
+        numContentions_(0)
+    {
+    }
+
+    /// Mutex for the resources and the counters.
+    Mutex mutex_;
+    /// Resources by type and name hash.
+    HashMap<unsigned long long, Resource*> resources_;
+    /// Number of lookups since the last frame.
+    unsigned numLookups_;
+    /// Number of lookups since the last frame that waited for another thread.
+    unsigned numContentions_;
 };
 
 /// Resource request types.
@@ -117,6 +150,8 @@ public:
     /// Reload a resource based on filename. Causes also reload of dependent resources if necessary.
     void ReloadResourceWithDependencies(const String& fileName);
     /// Set memory budget for a specific resource type, default 0 is unlimited.
+    /** FromBones : checked every frame. The least recently used resources not referred to outside the cache and not used during the current frame are released first.
+      */
     void SetMemoryBudget(StringHash type, unsigned long long budget);
     /// Enable or disable automatic reloading of resources as files are modified. Default false.
     void SetAutoReloadResources(bool enable);
@@ -128,6 +163,8 @@ public:
 
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
+    /// FromBones : Set number of threads calling BeginLoad() on the background loaded resources. Default is the number of logical CPUs minus one for the main thread. Call only from the main thread.
+    void SetNumBackgroundLoadThreads(unsigned num);
 
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
@@ -144,12 +181,32 @@ public:
     SharedPtr<Resource> GetTempResource(StringHash type, const String& name, bool sendEventOnFailure = true);
     /// Background load a resource. An event will be sent when complete. Return true if successfully stored to the load queue, false if eg. already exists. Can be called from outside the main thread.
     bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = 0);
+    /// FromBones : Start reading a resource file to memory with the asynchronous file reader of FileSystem and return the request. Can be called from outside the main thread.
+    /** Return null if the file is not found, or when it is better opened with GetFile(), such as a compressed or memory mapped package entry.
+        When the file is a package entry and package is not null, the package is returned in it, to open the data read with File::Open(name, data, size, package).
+      */
+    SharedPtr<AsyncReadRequest> ReadFileAsync(const String& name, void (*callback)(AsyncReadRequest*) = 0, void* aux = 0, SharedPtr<PackageFile>* package = 0);
+    /// FromBones : Return a loaded resource, or queue its background loading and return null, for example when it was released to respect the memory budget. An event will be sent when loaded. Can be called only from the main thread.
+    Resource* RequestResource(StringHash type, const String& name, bool sendEventOnFailure = true);
     /// Return number of pending background-loaded resources.
     unsigned GetNumBackgroundLoadResources() const;
+    /// FromBones : Return number of threads calling BeginLoad() on the background loaded resources.
+    unsigned GetNumBackgroundLoadThreads() const;
     /// Return all loaded resources of a specific type.
     void GetResources(PODVector<Resource*>& result, StringHash type) const;
     /// Return an already loaded resource of specific type & name, or null if not found. Will not load if does not exist.
     Resource* GetExistingResource(StringHash type, const String& name);
+    /// FromBones : Return an already loaded resource of specific type & name, or null if not found. Will not load if does not exist. Can be called from any thread.
+    /** Outside the main thread the returned resource stays valid only inside the ResourceLookupScope enclosing the call, and should be only read.
+        The lookup does not count as a use for the memory budget.
+      */
+    Resource* LookupResource(StringHash type, const String& name);
+    /// FromBones : Return an already loaded resource of specific type & name hash, or null if not found. Can be called from any thread.
+    Resource* LookupResource(StringHash type, StringHash nameHash);
+    /// FromBones : Begin a scope where the resources looked up from outside the main thread are not released. Return the scope epoch. Called by ResourceLookupScope.
+    unsigned BeginLookupScope();
+    /// FromBones : End a scope where the resources looked up from outside the main thread are not released. Called by ResourceLookupScope.
+    void EndLookupScope(unsigned epoch);
 
     /// Return all loaded resources.
     const HashMap<StringHash, ResourceGroup>& GetAllResources() const { return resourceGroups_; }
@@ -166,12 +223,16 @@ public:
     template <class T> T* GetResource(const String& name, bool sendEventOnFailure = true);
     /// Template version of returning an existing resource by name.
     template <class T> T* GetExistingResource(const String& name);
+    /// FromBones : Template version of returning an existing resource by name from any thread.
+    template <class T> T* LookupResource(const String& name);
     /// Template version of loading a resource without storing it to the cache.
     template <class T> SharedPtr<T> GetTempResource(const String& name, bool sendEventOnFailure = true);
     /// Template version of releasing a resource by name.
     template <class T> void ReleaseResource(const String& name, bool force = false);
     /// Template version of queueing a resource background load.
     template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = 0);
+    /// FromBones : Template version of returning a loaded resource or queueing its background loading.
+    template <class T> T* RequestResource(const String& name, bool sendEventOnFailure = true);
     /// Template version of returning loaded resources of a specific type.
     template <class T> void GetResources(PODVector<T*>& result) const;
     /// Return whether a file exists in the resource directories or package files. Does not check manually added in-memory resources.
@@ -182,6 +243,16 @@ public:
     unsigned long long GetMemoryUse(StringHash type) const;
     /// Return total memory use for all resources.
     unsigned long long GetTotalMemoryUse() const;
+    /// FromBones : Return number of resources of a type released to respect the memory budget.
+    unsigned GetNumEvictedResources(StringHash type) const;
+    /// FromBones : Return number of resources of a type loaded again after being released to respect the memory budget.
+    unsigned GetNumReloadedResources(StringHash type) const;
+    /// FromBones : Return the frame number used for the least recently used order of the resources.
+    unsigned GetUseFrame() const { return useFrame_; }
+    /// FromBones : Return number of resource lookups on the previous frame. Also reported to the profiler as ResourceLookups.
+    unsigned GetNumLookups() const { return numLookups_; }
+    /// FromBones : Return number of resource lookups on the previous frame that waited for another thread. Also reported to the profiler as ResourceLookupContentions.
+    unsigned GetNumLookupContentions() const { return numLookupContentions_; }
     /// Return full absolute file name of resource if possible, or empty if not found.
     String GetResourceFileName(const String& name) const;
 
@@ -215,14 +286,22 @@ public:
     String PrintMemoryUsage() const;
 
 private:
-    /// Find a resource.
+    /// Find a resource. The returned reference is invalidated by adding or removing resources of the group, copy it to hold the resource across such changes.
     const SharedPtr<Resource>& FindResource(StringHash type, StringHash nameHash);
-    /// Find a resource by name only. Searches all type groups.
+    /// Find a resource by name only. Searches all type groups. The returned reference is invalidated like with FindResource(type, nameHash).
     const SharedPtr<Resource>& FindResource(StringHash nameHash);
     /// Release resources loaded from a package file.
     void ReleasePackageResources(PackageFile* package, bool force = false);
     /// Update a resource group. Recalculate memory use and release resources if over memory budget.
     void UpdateResourceGroup(StringHash type);
+    /// FromBones : Store a loaded resource to its group.
+    void StoreResource(Resource* resource);
+    /// FromBones : Add a resource stored to its group to the lookup table.
+    void PublishResource(Resource* resource);
+    /// FromBones : Remove a resource about to be removed from its group from the lookup table, and delay its release until the lookup scopes using it have ended.
+    void RetireResource(Resource* resource);
+    /// FromBones : Release the retired resources no more used in lookup scopes and collect the lookup counters.
+    void UpdateLookupTable();
     /// Handle begin frame event. Automatic resource reloads and the finalization of background loaded resources are processed here.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Search FileSystem for file.
@@ -256,6 +335,51 @@ private:
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
     int finishBackgroundResourcesMs_;
+    /// FromBones : Frame number for the least recently used order of the resources.
+    unsigned useFrame_;
+    /// FromBones : Lookup table shards.
+    ResourceLookupShard lookupShards_[NUM_RESOURCE_LOOKUP_SHARDS];
+    /// FromBones : Mutex for the lookup scope counts.
+    Mutex lookupScopeMutex_;
+    /// FromBones : Number of lookup scopes in progress per epoch.
+    unsigned numLookupScopes_[2];
+    /// FromBones : Current lookup scope epoch.
+    unsigned lookupEpoch_;
+    /// FromBones : Resources removed from the cache per epoch, released when the lookup scopes of their epoch have ended.
+    Vector<SharedPtr<Resource> > retiredResources_[2];
+    /// FromBones : Number of resource lookups on the previous frame.
+    unsigned numLookups_;
+    /// FromBones : Number of resource lookups on the previous frame that waited for another thread.
+    unsigned numLookupContentions_;
+};
+
+/// FromBones : Scope where the resources looked up from outside the main thread with ResourceCache::LookupResource() are not released.
+class URHO3D_API ResourceLookupScope
+{
+public:
+    /// Construct and begin the scope.
+    ResourceLookupScope(ResourceCache* cache) :
+        cache_(cache),
+        epoch_(cache->BeginLookupScope())
+    {
+    }
+
+    /// Destruct. End the scope.
+    ~ResourceLookupScope()
+    {
+        cache_->EndLookupScope(epoch_);
+    }
+
+private:
+    /// Prevent copy construction.
+    ResourceLookupScope(const ResourceLookupScope& rhs);
+    /// Prevent assignment.
+    ResourceLookupScope& operator =(const ResourceLookupScope& rhs);
+
+    /// Resource cache.
+    ResourceCache* cache_;
+    /// Epoch of the scope.
+    unsigned epoch_;
 };
 
 template <class T> T* ResourceCache::GetExistingResource(const String& name)
@@ -264,6 +388,12 @@ template <class T> T* ResourceCache::GetExistingResource(const String& name)
     return static_cast<T*>(GetExistingResource(type, name));
 }
 
+template <class T> T* ResourceCache::LookupResource(const String& name)
+{
+    StringHash type = T::GetTypeStatic();
+    return static_cast<T*>(LookupResource(type, name));
+}
+
 template <class T> T* ResourceCache::GetResourceByHash(const StringHash& hashname)
 {
     return static_cast<T*>(GetResourceByHash(T::GetTypeStatic(), hashname));
@@ -294,6 +424,12 @@ template <class T> bool ResourceCache::BackgroundLoadResource(const String& name
     return BackgroundLoadResource(type, name, sendEventOnFailure, caller);
 }
 
+template <class T> T* ResourceCache::RequestResource(const String& name, bool sendEventOnFailure)
+{
+    StringHash type = T::GetTypeStatic();
+    return static_cast<T*>(RequestResource(type, name, sendEventOnFailure));
+}
+
 template <class T> void ResourceCache::GetResources(PODVector<T*>& result) const
 {
     PODVector<Resource*>& resources = reinterpret_cast<PODVector<Resource*>&>(result);
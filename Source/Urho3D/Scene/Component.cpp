@@ -56,6 +56,7 @@ Component::Component(Context* context) :
     Animatable(context),
     node_(0),
     id_(0),
+    poolIndex_(M_MAX_UNSIGNED),
     networkUpdate_(false),
     enabled_(true),
     changeModeEnabled_(true)
@@ -141,6 +141,8 @@ protected:
     Node* node_;
     /// Unique ID within the scene.
     unsigned id_;
+    /// FromBones : index in the scene component pool of its type.
+    unsigned poolIndex_;
     /// Network update queued flag.
     bool networkUpdate_;
     /// Enabled flag.
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+struct SceneUpdateEvent;
+
 /// Bitmask for using the scene update event.
 static const unsigned char USE_UPDATE = 0x1;
 /// Bitmask for using the scene post-update event.
@@ -86,7 +88,7 @@ private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(const SceneUpdateEvent& event);
     /// Handle scene post-update event.
     void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
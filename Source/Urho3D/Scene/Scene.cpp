@@ -25,9 +25,11 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
 #include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
@@ -88,13 +90,13 @@ Scene::~Scene()
 	if (localNodes_.Size())
 	{
 		URHO3D_LOGINFOF("~Scene() ... %u Local Nodes", localNodes_.Size());
-		for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+		for (FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
 			if (i->second_) i->second_->ResetScene();
 	}
 	if (replicatedNodes_.Size())
 	{
 		URHO3D_LOGINFOF("~Scene() ... %u Replicate Nodes", replicatedNodes_.Size());
-		for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+		for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
 			if (i->second_) i->second_->ResetScene();
 	}
 
@@ -139,8 +141,12 @@ bool Scene::Load(Deserializer& source, bool setInstanceDefault, bool applyAttr)
 
     StopAsyncLoading();
 
-    // Check ID
-    if (source.ReadFileID() != "USCN")
+    // Check ID. FromBones : also accept the snapshot files
+    String fileID = source.ReadFileID();
+    if (fileID == "USNP")
+        return LoadSnapshotData(source, setInstanceDefault, applyAttr);
+
+    if (fileID != "USCN")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid scene file");
         return false;
@@ -232,7 +238,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -328,6 +334,627 @@ bool Scene::SaveJSON(Serializer& dest, const String& indentation) const
         return false;
 }
 
+/// FromBones : snapshot file format version.
+static const unsigned SNAPSHOT_VERSION = 2;
+/// FromBones : number of objects decoded by a task. Small enough to start creating the objects early and to keep the decoded values in cache.
+static const unsigned SNAPSHOT_OBJECTS_PER_TASK = 512;
+
+/// FromBones : attribute layout of an object type in a snapshot file.
+struct SceneSnapshotType
+{
+    /// Type name.
+    String typeName_;
+    /// Type name hash.
+    StringHash type_;
+    /// Whether is a node type.
+    bool isNode_;
+    /// Whether the objects are saved whole with Component::Save, because their attributes differ from the registered ones of the type, like script instances. No values are decoded then.
+    bool serialized_;
+    /// Attribute names, used to find the attributes when loading.
+    Vector<String> names_;
+    /// Value types.
+    PODVector<VariantType> valueTypes_;
+    /// Attribute indices of the values in the registered attributes of the type.
+    PODVector<unsigned> attributeIndices_;
+};
+
+/// FromBones : node or component in a snapshot file, in the order of Node::Save.
+struct SceneSnapshotObject
+{
+    /// Type index.
+    unsigned typeIndex_;
+    /// Node or component ID.
+    unsigned id_;
+    /// Number of components, nodes only.
+    unsigned numComponents_;
+    /// Number of child nodes, nodes only.
+    unsigned numChildren_;
+    /// Offset of the attribute block in the data.
+    unsigned dataOffset_;
+    /// Size of the attribute block.
+    unsigned dataSize_;
+    /// Index of the first decoded value.
+    unsigned valueOffset_;
+};
+
+struct SceneSnapshot;
+
+/// FromBones : range of snapshot objects to decode on a worker thread.
+struct SceneSnapshotDecodeTask
+{
+    /// Snapshot.
+    SceneSnapshot* snapshot_;
+    /// First object index.
+    unsigned begin_;
+    /// Object index after the last one.
+    unsigned end_;
+    /// Whether all the objects were decoded.
+    bool success_;
+};
+
+/// FromBones : content of a snapshot file being loaded or saved.
+struct SceneSnapshot
+{
+    /// Construct.
+    SceneSnapshot() :
+        nextTask_(0),
+        numDecoded_(0),
+        threaded_(false)
+    {
+    }
+
+    /// Object types.
+    Vector<SceneSnapshotType> types_;
+    /// Type indices by type name hash, when saving.
+    HashMap<StringHash, unsigned> typeIndices_;
+    /// Indices of the serialized types by type name hash, when saving.
+    HashMap<StringHash, unsigned> serializedTypeIndices_;
+    /// Objects.
+    PODVector<SceneSnapshotObject> objects_;
+    /// Attribute blocks of all the objects.
+    PODVector<unsigned char> data_;
+    /// Decoded attribute values of all the objects.
+    Vector<Variant> values_;
+    /// Decode tasks.
+    PODVector<SceneSnapshotDecodeTask> tasks_;
+    /// Work items of the decode tasks not completed yet when decoding on the worker threads.
+    Vector<SharedPtr<WorkItem> > workItems_;
+    /// Index of the next decode task to check.
+    unsigned nextTask_;
+    /// Number of objects decoded and checked.
+    unsigned numDecoded_;
+    /// Whether the tasks run on the worker threads. Otherwise they run when their objects are needed.
+    bool threaded_;
+};
+
+static unsigned GetSnapshotTypeIndex(SceneSnapshot& snapshot, const Serializable* object, bool isNode)
+{
+    // The shared layout only fits objects with the registered attributes of their type. The others, like script instances with
+    // attributes of their script class, are saved whole
+    const Vector<AttributeInfo>* attributes = object->GetAttributes();
+    const bool serialized = !isNode && attributes != object->GetContext()->GetAttributes(object->GetType());
+    HashMap<StringHash, unsigned>& typeIndices = serialized ? snapshot.serializedTypeIndices_ : snapshot.typeIndices_;
+    HashMap<StringHash, unsigned>::ConstIterator i = typeIndices.Find(object->GetType());
+    if (i != typeIndices.End())
+        return i->second_;
+
+    const unsigned index = snapshot.types_.Size();
+    typeIndices[object->GetType()] = index;
+    snapshot.types_.Resize(index + 1);
+
+    SceneSnapshotType& type = snapshot.types_.Back();
+    type.typeName_ = object->GetTypeName();
+    type.type_ = object->GetType();
+    type.isNode_ = isNode;
+    type.serialized_ = serialized;
+
+    // Same attributes as Serializable::Save
+    if (attributes && !serialized)
+    {
+        for (unsigned j = 0; j < attributes->Size(); ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (!(attr.mode_ & AM_FILE) || (attr.mode_ & AM_FILEREADONLY) == AM_FILEREADONLY)
+                continue;
+
+            type.names_.Push(attr.name_);
+            type.valueTypes_.Push(attr.type_);
+            type.attributeIndices_.Push(j);
+        }
+    }
+
+    return index;
+}
+
+static bool WriteSnapshotValues(SceneSnapshot& snapshot, VectorBuffer& dest, const Serializable* object, unsigned typeIndex,
+    unsigned& size)
+{
+    const SceneSnapshotType& type = snapshot.types_[typeIndex];
+    const Vector<AttributeInfo>* attributes = object->GetAttributes();
+    const unsigned begin = dest.GetSize();
+    Variant value;
+
+    if (type.serialized_)
+    {
+        if (!static_cast<const Component*>(object)->Save(dest))
+        {
+            URHO3D_LOGERROR("Could not save " + object->GetTypeName() + ", writing to stream failed");
+            return false;
+        }
+
+        size = dest.GetSize() - begin;
+        return true;
+    }
+
+    for (unsigned i = 0; i < type.attributeIndices_.Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(type.attributeIndices_[i]);
+        object->OnGetAttribute(attr, value);
+
+        // The layout is shared by all the objects of the type, the value must have the layout type
+        if (value.GetType() != attr.type_)
+            value = attr.defaultValue_;
+
+        if (!dest.WriteVariantData(value))
+        {
+            URHO3D_LOGERROR("Could not save " + object->GetTypeName() + ", writing to stream failed");
+            return false;
+        }
+    }
+
+    size = dest.GetSize() - begin;
+    return true;
+}
+
+static bool WriteSnapshotNode(SceneSnapshot& snapshot, VectorBuffer& structure, VectorBuffer& data, const Node* node,
+    unsigned& numObjects)
+{
+    // Write the node record with its attribute block size, then its components and children as in Node::Save
+    const unsigned typeIndex = GetSnapshotTypeIndex(snapshot, node, true);
+    unsigned size;
+    if (!WriteSnapshotValues(snapshot, data, node, typeIndex, size))
+        return false;
+
+    const Vector<SharedPtr<Component> >& components = node->GetComponents();
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    unsigned numComponents = 0;
+    for (unsigned i = 0; i < components.Size(); ++i)
+    {
+        if (!components[i]->IsTemporary() && !dynamic_cast<const UnknownComponent*>(components[i].Get()))
+            ++numComponents;
+    }
+
+    structure.WriteVLE(typeIndex);
+    structure.WriteUInt(node->GetID());
+    structure.WriteVLE(size);
+    structure.WriteVLE(numComponents);
+    structure.WriteVLE(node->GetNumPersistentChildren());
+    ++numObjects;
+
+    for (unsigned i = 0; i < components.Size(); ++i)
+    {
+        const Component* component = components[i];
+        if (component->IsTemporary())
+            continue;
+        if (dynamic_cast<const UnknownComponent*>(component))
+        {
+            URHO3D_LOGWARNINGF("Skipping unknown component %u, snapshots only store registered component types", component->GetID());
+            continue;
+        }
+
+        const unsigned compTypeIndex = GetSnapshotTypeIndex(snapshot, component, false);
+        if (!WriteSnapshotValues(snapshot, data, component, compTypeIndex, size))
+            return false;
+
+        structure.WriteVLE(compTypeIndex);
+        structure.WriteUInt(component->GetID());
+        structure.WriteVLE(size);
+        ++numObjects;
+    }
+
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        if (!children[i]->IsTemporary() && !WriteSnapshotNode(snapshot, structure, data, children[i], numObjects))
+            return false;
+    }
+
+    return true;
+}
+
+static bool DecodeSnapshotObjects(SceneSnapshot& snapshot, unsigned begin, unsigned end)
+{
+    for (unsigned i = begin; i < end; ++i)
+    {
+        const SceneSnapshotObject& object = snapshot.objects_[i];
+        const PODVector<VariantType>& valueTypes = snapshot.types_[object.typeIndex_].valueTypes_;
+        MemoryBuffer source(snapshot.data_.Buffer() + object.dataOffset_, object.dataSize_);
+        Variant* values = snapshot.values_.Buffer() + object.valueOffset_;
+
+        for (unsigned j = 0; j < valueTypes.Size(); ++j)
+        {
+            if (source.IsEof())
+                return false;
+            values[j] = source.ReadVariant(valueTypes[j]);
+        }
+    }
+
+    return true;
+}
+
+static void DecodeSnapshotObjectsWork(const WorkItem* item, unsigned threadIndex)
+{
+    SceneSnapshotDecodeTask* task = reinterpret_cast<SceneSnapshotDecodeTask*>(item->aux_);
+    task->success_ = DecodeSnapshotObjects(*task->snapshot_, task->begin_, task->end_);
+}
+
+static void ReleaseSnapshotValuesWork(const WorkItem* item, unsigned threadIndex)
+{
+    reinterpret_cast<SceneSnapshot*>(item->aux_)->values_.Clear();
+}
+
+static bool WaitSnapshotObjects(SceneSnapshot& snapshot, WorkQueue* queue, unsigned numObjects)
+{
+    while (snapshot.numDecoded_ < numObjects)
+    {
+        // Use the tasks completed by the worker threads, then help with the remaining ones when reaching one still in progress
+        if (!snapshot.workItems_.Empty() && !snapshot.workItems_[snapshot.nextTask_]->completed_)
+        {
+            queue->Complete(M_MAX_UNSIGNED);
+            snapshot.workItems_.Clear();
+        }
+
+        SceneSnapshotDecodeTask& task = snapshot.tasks_[snapshot.nextTask_];
+        if (!snapshot.threaded_)
+            task.success_ = DecodeSnapshotObjects(snapshot, task.begin_, task.end_);
+
+        if (!task.success_)
+        {
+            // Do not leave the worker threads using the snapshot
+            if (!snapshot.workItems_.Empty())
+            {
+                queue->Complete(M_MAX_UNSIGNED);
+                snapshot.workItems_.Clear();
+            }
+            return false;
+        }
+
+        snapshot.numDecoded_ = task.end_;
+        ++snapshot.nextTask_;
+    }
+
+    return true;
+}
+
+bool Scene::LoadSnapshot(Deserializer& source, bool setInstanceDefault, bool applyAttr)
+{
+    URHO3D_PROFILE(LoadSceneSnapshot);
+
+    StopAsyncLoading();
+
+    // Check ID
+    if (source.ReadFileID() != "USNP")
+    {
+        URHO3D_LOGERROR(source.GetName() + " is not a valid scene snapshot file");
+        return false;
+    }
+
+    return LoadSnapshotData(source, setInstanceDefault, applyAttr);
+}
+
+bool Scene::LoadSnapshotData(Deserializer& source, bool setInstanceDefault, bool applyAttr)
+{
+    unsigned version = source.ReadUInt();
+    if (version != SNAPSHOT_VERSION)
+    {
+        URHO3D_LOGERRORF("%s has unsupported scene snapshot version %u", source.GetName().CString(), version);
+        return false;
+    }
+
+    URHO3D_LOGINFO("Loading scene snapshot from " + source.GetName());
+
+    SceneSnapshot snapshot;
+
+    // Read the attribute layouts and find the attributes of the registered types
+    unsigned numTypes = source.ReadVLE();
+    snapshot.types_.Resize(numTypes);
+    for (unsigned i = 0; i < numTypes; ++i)
+    {
+        SceneSnapshotType& type = snapshot.types_[i];
+        type.typeName_ = source.ReadString();
+        type.type_ = StringHash(type.typeName_);
+        type.isNode_ = source.ReadBool();
+        type.serialized_ = source.ReadBool();
+        if (type.serialized_ && type.isNode_)
+        {
+            URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot types");
+            return false;
+        }
+
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(type.type_);
+        unsigned numValues = source.ReadVLE();
+        if (numValues > source.GetSize())
+        {
+            URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot types");
+            return false;
+        }
+
+        type.valueTypes_.Resize(numValues);
+        type.attributeIndices_.Resize(numValues);
+        for (unsigned j = 0; j < numValues; ++j)
+        {
+            String name = source.ReadString();
+            type.valueTypes_[j] = (VariantType)source.ReadUByte();
+            type.attributeIndices_[j] = M_MAX_UNSIGNED;
+
+            if (attributes)
+            {
+                for (unsigned k = 0; k < attributes->Size(); ++k)
+                {
+                    const AttributeInfo& attr = attributes->At(k);
+                    if (attr.name_ == name && attr.type_ == type.valueTypes_[j] && (attr.mode_ & AM_FILE))
+                    {
+                        type.attributeIndices_[j] = k;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Read the objects, count their values and IDs to preallocate the storage
+    unsigned numObjects = source.ReadVLE();
+    if (!numObjects || numObjects > source.GetSize())
+    {
+        URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot objects");
+        return false;
+    }
+
+    snapshot.objects_.Resize(numObjects);
+    unsigned dataSize = 0;
+    unsigned numValues = 0;
+    unsigned numReplicatedNodes = 0, numLocalNodes = 0;
+    unsigned numReplicatedComponents = 0, numLocalComponents = 0;
+    // Check the hierarchy at the same time, so that the objects can be created while the values are decoded
+    PODVector<unsigned> childrenLeft;
+    unsigned componentsLeft = 0;
+    for (unsigned i = 0; i < numObjects; ++i)
+    {
+        SceneSnapshotObject& object = snapshot.objects_[i];
+        object.typeIndex_ = source.ReadVLE();
+        object.id_ = source.ReadUInt();
+        object.dataSize_ = source.ReadVLE();
+        object.dataOffset_ = dataSize;
+        object.valueOffset_ = numValues;
+        object.numComponents_ = object.numChildren_ = 0;
+
+        if (object.typeIndex_ >= numTypes)
+        {
+            URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot objects");
+            return false;
+        }
+
+        const SceneSnapshotType& type = snapshot.types_[object.typeIndex_];
+        if (type.isNode_)
+        {
+            while (!childrenLeft.Empty() && !childrenLeft.Back())
+                childrenLeft.Pop();
+            if (componentsLeft || (i && childrenLeft.Empty()))
+            {
+                URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot hierarchy");
+                return false;
+            }
+            if (i)
+                --childrenLeft.Back();
+
+            object.numComponents_ = componentsLeft = source.ReadVLE();
+            object.numChildren_ = source.ReadVLE();
+            childrenLeft.Push(object.numChildren_);
+            ++(object.id_ < FIRST_LOCAL_ID ? numReplicatedNodes : numLocalNodes);
+        }
+        else
+        {
+            if (!componentsLeft)
+            {
+                URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot hierarchy");
+                return false;
+            }
+
+            --componentsLeft;
+            ++(object.id_ < FIRST_LOCAL_ID ? numReplicatedComponents : numLocalComponents);
+        }
+
+        dataSize += object.dataSize_;
+        numValues += type.valueTypes_.Size();
+    }
+
+    while (!childrenLeft.Empty() && !childrenLeft.Back())
+        childrenLeft.Pop();
+    if (componentsLeft || !childrenLeft.Empty() || source.ReadUInt() != dataSize)
+    {
+        URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot data");
+        return false;
+    }
+
+    snapshot.data_.Resize(dataSize);
+    if (dataSize && source.Read(&snapshot.data_[0], dataSize) != dataSize)
+    {
+        URHO3D_LOGERROR(source.GetName() + " has truncated scene snapshot data");
+        return false;
+    }
+    snapshot.values_.Resize(numValues);
+
+    // Start decoding the attribute values on the worker threads. Without them, decode each task just before its objects are created
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    const unsigned numTasks = (numObjects + SNAPSHOT_OBJECTS_PER_TASK - 1) / SNAPSHOT_OBJECTS_PER_TASK;
+    snapshot.threaded_ = numTasks > 1 && queue && queue->GetNumThreads() && Thread::IsMainThread() && !queue->IsCompleting();
+
+    snapshot.tasks_.Resize(numTasks);
+    for (unsigned i = 0; i < numTasks; ++i)
+    {
+        SceneSnapshotDecodeTask& task = snapshot.tasks_[i];
+        task.snapshot_ = &snapshot;
+        task.begin_ = i * SNAPSHOT_OBJECTS_PER_TASK;
+        task.end_ = Min(task.begin_ + SNAPSHOT_OBJECTS_PER_TASK, numObjects);
+        task.success_ = false;
+    }
+
+    if (snapshot.threaded_)
+    {
+        snapshot.workItems_.Resize(numTasks);
+        for (unsigned i = 0; i < numTasks; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = DecodeSnapshotObjectsWork;
+            item->aux_ = &snapshot.tasks_[i];
+            queue->AddWorkItem(item);
+            snapshot.workItems_[i] = item;
+        }
+    }
+
+    Clear();
+
+    // Preallocate the ID maps, then create and register the objects in the order of Node::Load as their values get decoded
+    replicatedNodes_.Reserve(replicatedNodes_.Size() + numReplicatedNodes);
+    localNodes_.Reserve(localNodes_.Size() + numLocalNodes);
+    replicatedComponents_.Reserve(replicatedComponents_.Size() + numReplicatedComponents);
+    localComponents_.Reserve(localComponents_.Size() + numLocalComponents);
+
+    SceneResolver resolver;
+    PODVector<Pair<Node*, unsigned> > parents;
+    unsigned index = 0;
+
+    while (index < numObjects)
+    {
+        const SceneSnapshotObject& nodeObject = snapshot.objects_[index];
+        const SceneSnapshotType& nodeType = snapshot.types_[nodeObject.typeIndex_];
+        if (!WaitSnapshotObjects(snapshot, queue, index + 1 + nodeObject.numComponents_))
+        {
+            URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot attributes");
+            return false;
+        }
+
+        Node* node = this;
+        if (index)
+        {
+            // Find the parent with children left to create
+            while (!parents.Back().second_)
+                parents.Pop();
+
+            --parents.Back().second_;
+            node = parents.Back().first_->CreateChild(nodeObject.id_, nodeObject.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL);
+        }
+
+        // The root ID is not applied, only stored for resolving possible references
+        resolver.AddNode(nodeObject.id_, node);
+        node->components_.Reserve(nodeObject.numComponents_);
+        node->children_.Reserve(nodeObject.numChildren_);
+        node->LoadValues(nodeType.attributeIndices_, snapshot.values_.Buffer() + nodeObject.valueOffset_, setInstanceDefault);
+        ++index;
+
+        for (unsigned i = 0; i < nodeObject.numComponents_; ++i, ++index)
+        {
+            const SceneSnapshotObject& compObject = snapshot.objects_[index];
+            const SceneSnapshotType& compType = snapshot.types_[compObject.typeIndex_];
+            Component* newComponent = node->SafeCreateComponent(compType.typeName_, compType.type_,
+                compObject.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, compObject.id_);
+            if (!newComponent)
+                continue;
+
+            resolver.AddComponent(compObject.id_, newComponent);
+            if (compType.serialized_)
+            {
+                // Load the whole component after its type and ID like Node::Load
+                MemoryBuffer compBuffer(snapshot.data_.Buffer() + compObject.dataOffset_, compObject.dataSize_);
+                compBuffer.ReadStringHash();
+                compBuffer.ReadUInt();
+                if (!newComponent->Load(compBuffer, setInstanceDefault))
+                {
+                    URHO3D_LOGERROR(source.GetName() + " has corrupted scene snapshot attributes");
+                    if (snapshot.threaded_)
+                        queue->Complete(M_MAX_UNSIGNED);
+                    return false;
+                }
+            }
+            else
+                newComponent->LoadValues(compType.attributeIndices_, snapshot.values_.Buffer() + compObject.valueOffset_,
+                    setInstanceDefault);
+        }
+
+        parents.Push(MakePair(node, nodeObject.numChildren_));
+    }
+
+    // Release the decoded values on a worker thread while resolving the references
+    if (snapshot.threaded_)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ReleaseSnapshotValuesWork;
+        item->aux_ = &snapshot;
+        queue->AddWorkItem(item);
+    }
+
+    resolver.Resolve();
+    if (applyAttr)
+        ApplyAttributes();
+
+    if (snapshot.threaded_)
+        queue->Complete(M_MAX_UNSIGNED);
+
+    FinishLoading(&source);
+    return true;
+}
+
+bool Scene::SaveSnapshot(Serializer& dest) const
+{
+    URHO3D_PROFILE(SaveSceneSnapshot);
+
+    SceneSnapshot snapshot;
+    VectorBuffer structure;
+    VectorBuffer data;
+    unsigned numObjects = 0;
+    if (!WriteSnapshotNode(snapshot, structure, data, this, numObjects))
+        return false;
+
+    if (!dest.WriteFileID("USNP"))
+    {
+        URHO3D_LOGERROR("Could not save scene snapshot, writing to stream failed");
+        return false;
+    }
+
+    Deserializer* ptr = dynamic_cast<Deserializer*>(&dest);
+    if (ptr)
+        URHO3D_LOGINFO("Saving scene snapshot to " + ptr->GetName());
+
+    dest.WriteUInt(SNAPSHOT_VERSION);
+    dest.WriteVLE(snapshot.types_.Size());
+    for (unsigned i = 0; i < snapshot.types_.Size(); ++i)
+    {
+        const SceneSnapshotType& type = snapshot.types_[i];
+        dest.WriteString(type.typeName_);
+        dest.WriteBool(type.isNode_);
+        dest.WriteBool(type.serialized_);
+        dest.WriteVLE(type.valueTypes_.Size());
+        for (unsigned j = 0; j < type.valueTypes_.Size(); ++j)
+        {
+            dest.WriteString(type.names_[j]);
+            dest.WriteUByte((unsigned char)type.valueTypes_[j]);
+        }
+    }
+
+    dest.WriteVLE(numObjects);
+    dest.Write(structure.GetData(), structure.GetSize());
+    dest.WriteUInt(data.GetSize());
+    if (dest.Write(data.GetData(), data.GetSize()) != data.GetSize())
+    {
+        URHO3D_LOGERROR("Could not save scene snapshot, writing to stream failed");
+        return false;
+    }
+
+    FinishSaving(&dest);
+    return true;
+}
+
 bool Scene::LoadAsync(File* file, LoadMode mode)
 {
     if (!file)
@@ -739,12 +1366,12 @@ Node* Scene::GetNode(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         return i != replicatedNodes_.End() ? i->second_ : 0;
     }
     else
     {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
         return i != localNodes_.End() ? i->second_ : 0;
     }
 }
@@ -766,12 +1393,12 @@ Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         return i != replicatedComponents_.End() ? i->second_ : 0;
     }
     else
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
         return i != localComponents_.End() ? i->second_ : 0;
     }
 }
@@ -789,6 +1416,14 @@ const String& Scene::GetVarName(StringHash hash) const
     return i != varNames_.End() ? i->second_ : String::EMPTY;
 }
 
+void SceneUpdateEvent::FillEventData(VariantMap& eventData) const
+{
+    using namespace SceneUpdate;
+
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
 void Scene::Update(float timeStep)
 {
     if (asyncLoading_)
@@ -807,15 +1442,16 @@ void Scene::Update(float timeStep)
     if (timeStep < M_EPSILON)
         URHO3D_LOGWARNINGF("Scene() - Update ... timeStep=%f timeScale=%f ...", timeStep, timeScale_);
 
+    // Update variable timestep logic
+    SceneUpdateEvent sceneUpdate = { this, timeStep };
+    SendTypedEvent(sceneUpdate);
+
     using namespace SceneUpdate;
 
     VariantMap& eventData = GetEventDataMap();
     eventData[P_SCENE] = this;
     eventData[P_TIMESTEP] = timeStep;
 
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
-
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
@@ -939,8 +1575,8 @@ void Scene::ReserveNodeID(unsigned nodeid)
 
 bool Scene::IsNodeReserved(unsigned id) const
 {
-    const HashMap<unsigned, Node*>& reservednodes = id < FIRST_LOCAL_ID ? replicatedNodes_ : localNodes_;
-    HashMap<unsigned, Node*>::ConstIterator it = reservednodes.Find(id);
+    const FlatHashMap<unsigned, Node*>& reservednodes = id < FIRST_LOCAL_ID ? replicatedNodes_ : localNodes_;
+    FlatHashMap<unsigned, Node*>::ConstIterator it = reservednodes.Find(id);
 
     if (it == reservednodes.End())
         return false;
@@ -1063,7 +1699,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ && i->second_ != node)
         {
             URHO3D_LOGWARNING("Overwriting node with ID " + String(id));
@@ -1077,7 +1713,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ && i->second_ != node)
         {
             URHO3D_LOGWARNING("Overwriting node with ID " + String(id));
@@ -1164,7 +1800,7 @@ void Scene::NodeRemoved(Node* node)
 //    {
 //        if (mode == REPLICATED)
 //        {
-//            HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
+//            FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
 //            if (i != replicatedNodes_.End() && i->second_ != node)
 //                URHO3D_LOGWARNING("Scene() - NodeIDChanged : REPLICATED Mode with Overwriting node ID " + String(newFirstNodeID));
 //
@@ -1181,7 +1817,7 @@ void Scene::NodeRemoved(Node* node)
 //        }
 //        else
 //        {
-//            HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
+//            FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
 //            if (i != localNodes_.End() && i->second_ != node)
 //                URHO3D_LOGWARNING("Scene() - NodeIDChanged : LOCAL Mode with Overwriting node ID " + String(newFirstNodeID));
 //
@@ -1204,7 +1840,7 @@ void Scene::NodeRemoved(Node* node)
 ////                MarkReplicationDirty(node);
 //            }
 //
-//            HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
+//            FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
 //            if (i != localNodes_.End() && i->second_ != node)
 //                URHO3D_LOGWARNING("Scene() - NodeIDChanged : REPLICATED To LOCAL Mode with Overwriting node ID " + String(newFirstNodeID));
 //
@@ -1215,7 +1851,7 @@ void Scene::NodeRemoved(Node* node)
 //        {
 //            if (id > 0) localNodes_.Erase(id);
 //
-//            HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
+//            FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
 //            if (i != replicatedNodes_.End() && i->second_ != node)
 //                URHO3D_LOGWARNING("Scene() - NodeIDChanged : LOCAL To REPLICATED Mode with Overwriting node ID " + String(newFirstNodeID));
 //
@@ -1262,7 +1898,7 @@ void Scene::NodeIDChanged(Node* node, unsigned newFirstNodeID, unsigned newFirst
     {
         if (oldmode == REPLICATED)
         {
-            HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
+            FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
 
             if (i != replicatedNodes_.End())
             {
@@ -1292,7 +1928,7 @@ void Scene::NodeIDChanged(Node* node, unsigned newFirstNodeID, unsigned newFirst
         }
         else
         {
-            HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
+            FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
 
             if (i != localNodes_.End())
             {
@@ -1326,7 +1962,7 @@ void Scene::NodeIDChanged(Node* node, unsigned newFirstNodeID, unsigned newFirst
                 CleanNetworkReplication(node);
             }
 
-            HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
+            FlatHashMap<unsigned, Node*>::Iterator i = localNodes_.Find(newFirstNodeID);
             if (i != localNodes_.End())
             {
                 Node*& refnode = i->second_;
@@ -1350,7 +1986,7 @@ void Scene::NodeIDChanged(Node* node, unsigned newFirstNodeID, unsigned newFirst
                 localNodes_.Erase(oldid);
             }
 
-            HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
+            FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(newFirstNodeID);
             if (i != replicatedNodes_.End())
             {
                 Node*& refnode = i->second_;
@@ -1468,7 +2104,7 @@ void Scene::ComponentAdded(Component* component)
 
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             URHO3D_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1479,7 +2115,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             URHO3D_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1489,6 +2125,8 @@ void Scene::ComponentAdded(Component* component)
         localComponents_[id] = component;
     }
 
+    AddToComponentPool(component);
+
     component->OnSceneSet(this);
 }
 
@@ -1503,10 +2141,69 @@ void Scene::ComponentRemoved(Component* component)
     else
         localComponents_.Erase(id);
 
+    RemoveFromComponentPool(component);
+
     component->SetID(0);
     component->OnSceneSet(0);
 }
 
+const PODVector<Component*>& Scene::GetComponentsByType(StringHash type) const
+{
+    static const PODVector<Component*> noComponents;
+
+    HashMap<StringHash, unsigned>::ConstIterator i = componentPoolIndices_.Find(type);
+    return i != componentPoolIndices_.End() ? componentPools_[i->second_].components_ : noComponents;
+}
+
+void Scene::AddToComponentPool(Component* component)
+{
+    const StringHash type = component->GetType();
+
+    unsigned poolIndex;
+    HashMap<StringHash, unsigned>::ConstIterator i = componentPoolIndices_.Find(type);
+    if (i != componentPoolIndices_.End())
+    {
+        poolIndex = i->second_;
+    }
+    else
+    {
+        poolIndex = componentPools_.Size();
+        componentPools_.Resize(poolIndex + 1);
+        componentPools_[poolIndex].typeInfo_ = component->GetTypeInfo();
+        componentPoolIndices_[type] = poolIndex;
+    }
+
+    PODVector<Component*>& components = componentPools_[poolIndex].components_;
+
+    // The pool index may be stale if the component has belonged to another scene
+    if (component->poolIndex_ < components.Size() && components[component->poolIndex_] == component)
+        return;
+
+    component->poolIndex_ = components.Size();
+    components.Push(component);
+}
+
+void Scene::RemoveFromComponentPool(Component* component)
+{
+    HashMap<StringHash, unsigned>::ConstIterator i = componentPoolIndices_.Find(component->GetType());
+    if (i == componentPoolIndices_.End())
+        return;
+
+    PODVector<Component*>& components = componentPools_[i->second_].components_;
+
+    const unsigned index = component->poolIndex_;
+    if (index >= components.Size() || components[index] != component)
+        return;
+
+    // Move the last component in the hole
+    Component* last = components.Back();
+    components[index] = last;
+    last->poolIndex_ = index;
+    components.Pop();
+
+    component->poolIndex_ = M_MAX_UNSIGNED;
+}
+
 void Scene::SetVarNamesAttr(const String& value)
 {
     Vector<String> varNames = value.Split(';');
@@ -1571,11 +2268,11 @@ void Scene::CleanupConnection(Connection* connection, bool cleanReplication)
 
     if (cleanReplication)
     {
-        for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+        for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
             if (i->second_)
                 i->second_->CleanupConnection(connection);
 
-        for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         {
             if (!i->second_)
                 continue;
@@ -1600,11 +2297,11 @@ void Scene::CleanupNetwork()
     URHO3D_LOGINFOF("Scene() - CleanupNetwork ... ");
 
 	if (replicatedNodes_.Size())
-		for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+		for (FlatHashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
 			if (i->second_) i->second_->CleanupReplicationStates();
 
 	if (replicatedComponents_.Size())
-		for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+		for (FlatHashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
 			if (i->second_) i->second_->CleanupReplicationStates();
 
 	CleanupReplicationStates();
@@ -2084,7 +2781,7 @@ void Scene::DumpNodes(CreateMode mode) const
     if (mode == REPLICATED)
     {
         URHO3D_LOGINFOF("Scene() - DumpNodes : REPLICATED ....");
-        for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        for (FlatHashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         {
             Node* node = i->second_;
             if (!node)
@@ -2096,7 +2793,7 @@ void Scene::DumpNodes(CreateMode mode) const
             for (Vector<SharedPtr<Component> >::ConstIterator j = components.Begin(); j != components.End(); ++j)
                 URHO3D_LOGINFOF(" ---> Component=%s(%u)", j->Get()->GetTypeName().CString(), j->Get()->GetID());
         }
-//        for (HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+//        for (FlatHashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
 //        {
 //            Component* component = i->second_;
 //            if (!component)
@@ -2108,7 +2805,7 @@ void Scene::DumpNodes(CreateMode mode) const
     else
     {
         URHO3D_LOGINFOF("Scene() - DumpNodes : LOCAL ....");
-        for (HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+        for (FlatHashMap<unsigned, Node*>::ConstIterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         {
             Node* node = i->second_;
             if (!node)
@@ -2120,7 +2817,7 @@ void Scene::DumpNodes(CreateMode mode) const
             for (Vector<SharedPtr<Component> >::ConstIterator j = components.Begin(); j != components.End(); ++j)
                 URHO3D_LOGINFOF(" ---> Component=%s(%u)", j->Get()->GetTypeName().CString(), j->Get()->GetID());
         }
-//        for (HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Begin(); i != localComponents_.End(); ++i)
+//        for (FlatHashMap<unsigned, Component*>::ConstIterator i = localComponents_.Begin(); i != localComponents_.End(); ++i)
 //        {
 //            Component* component = i->second_;
 //            if (!component)
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/FlatHashMap.h"
 #include "../Container/HashSet.h"
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
@@ -91,6 +92,21 @@ struct AsyncProgress
     unsigned totalNodes_;
 };
 
+/// FromBones : components of one type in the scene, stored contiguously for the per-type passes.
+struct SceneComponentPool
+{
+    /// Construct.
+    SceneComponentPool() :
+        typeInfo_(0)
+    {
+    }
+
+    /// Component type info.
+    const TypeInfo* typeInfo_;
+    /// Components.
+    PODVector<Component*> components_;
+};
+
 /// Root scene node, represents the whole scene.
 class URHO3D_API Scene : public Node
 {
@@ -129,6 +145,12 @@ public:
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
     /// Save to a JSON file. Return true if successful.
     bool SaveJSON(Serializer& dest, const String& indentation = "\t") const;
+    /// FromBones : load from a binary snapshot file. Removes all existing child nodes and components first. Return true if successful.
+    /** The attribute values are decoded on the worker threads, the nodes and components are created and registered on the main thread.
+      */
+    bool LoadSnapshot(Deserializer& source, bool setInstanceDefault = false, bool applyAttr = true);
+    /// FromBones : save to a binary snapshot file, with one attribute layout per object type. Return true if successful.
+    bool SaveSnapshot(Serializer& dest) const;
     /// Load from a binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsync(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
     /// Load from an XML file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
@@ -181,6 +203,12 @@ public:
     Component* GetComponent(unsigned id) const;
     /// Get nodes with specific tag from the whole scene, return false if empty.
     bool GetNodesWithTag(PODVector<Node*>& dest, const String& tag)  const;
+    /// FromBones : return the components of a type in the whole scene, stored contiguously. Derived types are not included. The order is unspecified and changes when components are removed.
+    const PODVector<Component*>& GetComponentsByType(StringHash type) const;
+    /// FromBones : return the component pools of the whole scene, one per component type.
+    const Vector<SceneComponentPool>& GetComponentPools() const { return componentPools_; }
+    /// FromBones : call a function for each component of a type, or derived from it, in the whole scene, without walking the nodes. The function must not add or remove components.
+    template <class T, class F> void ForEach(F function) const;
 
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
@@ -313,6 +341,8 @@ private:
     void UpdateAsyncLoading();
     /// Finish asynchronous loading.
     void FinishAsyncLoading();
+    /// FromBones : load the content of a binary snapshot file, after the file ID.
+    bool LoadSnapshotData(Deserializer& source, bool setInstanceDefault, bool applyAttr);
     /// Finish loading. Sets the scene filename and checksum.
     void FinishLoading(Deserializer* source);
     /// Finish saving. Sets the scene filename and checksum.
@@ -323,15 +353,23 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    /// FromBones : add a component to the pool of its type.
+    void AddToComponentPool(Component* component);
+    /// FromBones : remove a component from the pool of its type. The last component of the pool takes its place.
+    void RemoveFromComponentPool(Component* component);
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    FlatHashMap<unsigned, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    FlatHashMap<unsigned, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    FlatHashMap<unsigned, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
+    FlatHashMap<unsigned, Component*> localComponents_;
+    /// FromBones : component pools.
+    Vector<SceneComponentPool> componentPools_;
+    /// FromBones : component pool indices by component type.
+    HashMap<StringHash, unsigned> componentPoolIndices_;
     /// Cached tagged nodes by tag.
     HashMap<StringHash, PODVector<Node*> > taggedNodes_;
     /// Asynchronous loading progress.
@@ -382,6 +420,22 @@ private:
     bool threadedUpdate_;
 };
 
+template <class T, class F> void Scene::ForEach(F function) const
+{
+    const TypeInfo* typeInfo = T::GetTypeInfoStatic();
+
+    for (Vector<SceneComponentPool>::ConstIterator i = componentPools_.Begin(); i != componentPools_.End(); ++i)
+    {
+        if (!i->typeInfo_->IsTypeOf(typeInfo))
+            continue;
+
+        Component* const* components = i->components_.Buffer();
+        const unsigned numComponents = i->components_.Size();
+        for (unsigned j = 0; j < numComponents; ++j)
+            function(static_cast<T*>(components[j]));
+    }
+}
+
 /// Register Scene library objects.
 void URHO3D_API RegisterSceneLibrary(Context* context);
 
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -34,6 +36,20 @@ URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed variable timestep scene update, sent by Scene as E_SCENEUPDATE.
+struct URHO3D_API SceneUpdateEvent
+{
+    URHO3D_TYPEDEVENT(E_SCENEUPDATE)
+
+    /// Fill the event data for the VariantMap subscribers.
+    void FillEventData(VariantMap& eventData) const;
+
+    /// Scene.
+    Scene* scene_;
+    /// Time step.
+    float timeStep_;
+};
+
 /// Scene subsystem update.
 URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -307,6 +307,32 @@ bool Serializable::Load(Deserializer& source, bool setInstanceDefault, bool appl
     return true;
 }
 
+bool Serializable::LoadValues(const PODVector<unsigned>& attributeIndices, const Variant* values, bool setInstanceDefault)
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return true;
+
+    for (unsigned i = 0; i < attributeIndices.Size(); ++i)
+    {
+        const unsigned index = attributeIndices[i];
+        if (index >= attributes->Size())
+            continue;
+
+        // The indices come from the registered attributes of the type, skip if this instance has other ones
+        const AttributeInfo& attr = attributes->At(index);
+        if (!(attr.mode_ & AM_FILE) || attr.type_ != values[i].GetType())
+            continue;
+
+        OnSetAttribute(attr, values[i]);
+
+        if (setInstanceDefault)
+            SetInstanceDefault(attr.name_, values[i]);
+    }
+
+    return true;
+}
+
 bool Serializable::Save(Serializer& dest) const
 {
     const Vector<AttributeInfo>* attributes = GetAttributes();
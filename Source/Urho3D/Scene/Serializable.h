@@ -61,6 +61,8 @@ public:
     virtual const Vector<AttributeInfo>* GetNetworkAttributes() const;
     /// Load from binary data. When setInstanceDefault is set to true, after setting the attribute value, store the value as instance's default value. Return true if successful.
     virtual bool Load(Deserializer& source, bool setInstanceDefault = false, bool applyAttr = true);
+    /// FromBones : load from attribute values decoded beforehand, value i going to the attribute at attributeIndices[i]. M_MAX_UNSIGNED skips the value. Return true if successful.
+    virtual bool LoadValues(const PODVector<unsigned>& attributeIndices, const Variant* values, bool setInstanceDefault = false);
     /// Save as binary data. Return true if successful.
     virtual bool Save(Serializer& dest) const;
     /// Load from XML data. When setInstanceDefault is set to true, after setting the attribute value, store the value as instance's default value. Return true if successful.
@@ -24,8 +24,12 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Graphics.h"
+#include "../Graphics/GraphicsEvents.h"
 #include "../Graphics/Renderer.h"
 #include "../IO/Log.h"
 #include "../Scene/Scene.h"
@@ -50,6 +54,26 @@ extern const char* SUBSYSTEM_CATEGORY;
 static const Vector2 DEFAULT_GRAVITY(0.0f, -9.81f);
 static const int DEFAULT_VELOCITY_ITERATIONS = 8;
 static const int DEFAULT_POSITION_ITERATIONS = 3;
+static const int DEFAULT_FPS = 60;
+static const int DEFAULT_MAX_SUBSTEPS = -1;
+/// Number of ranges per thread for a Box2D task, to balance the islands of uneven sizes.
+static const int TASK_RANGES_PER_THREAD = 4;
+
+static bool HasContactReceivers(Context* context, Node* node, StringHash eventType)
+{
+    const HashSet<Object*>* group = context->GetEventReceivers(node, eventType);
+    if (group && !group->Empty())
+        return true;
+
+    group = context->GetEventReceivers(eventType);
+    return group && !group->Empty();
+}
+
+static void RunPhysicsTask2D(const WorkItem* item, unsigned threadIndex)
+{
+    const PhysicsTask2D* task = reinterpret_cast<const PhysicsTask2D*>(item->aux_);
+    task->function_(task->begin_, task->end_, (int32)threadIndex, task->userData_);
+}
 
 PhysicsWorld2D::PhysicsWorld2D(Context* context) :
     Component(context),
@@ -59,6 +83,15 @@ PhysicsWorld2D::PhysicsWorld2D(Context* context) :
     debugRenderer_(0),
     physicsStepping_(false),
     applyingTransforms_(false),
+    multiThreaded_(false),
+    fps_(DEFAULT_FPS),
+    maxSubSteps_(DEFAULT_MAX_SUBSTEPS),
+    timeAcc_(0.0f),
+    interpolation_(true),
+    asyncStep_(false),
+    pendingSteps_(0),
+    pendingTimeStep_(0.0f),
+    writeBackOrderDirty_(true),
     updateEnabled_(true)
 {
     // Set default debug draw flags
@@ -80,6 +113,8 @@ PhysicsWorld2D::PhysicsWorld2D(Context* context) :
 
 PhysicsWorld2D::~PhysicsWorld2D()
 {
+    CompleteAsyncStep();
+
     for (unsigned i = 0; i < rigidBodies_.Size(); ++i)
         if (rigidBodies_[i])
             rigidBodies_[i]->ReleaseBody();
@@ -104,6 +139,11 @@ void PhysicsWorld2D::RegisterObject(Context* context)
         AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Position Iterations", GetPositionIterations, SetPositionIterations, int, DEFAULT_POSITION_ITERATIONS,
         AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Multi Threaded", IsMultiThreaded, SetMultiThreaded, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Physics FPS", GetFps, SetFps, int, DEFAULT_FPS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Substeps", GetMaxSubSteps, SetMaxSubSteps, int, DEFAULT_MAX_SUBSTEPS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Interpolation", GetInterpolation, SetInterpolation, bool, true, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Async Step", IsAsyncStep, SetAsyncStep, bool, false, AM_DEFAULT);
 }
 
 void PhysicsWorld2D::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -169,21 +209,6 @@ void PhysicsWorld2D::DrawDebug(CollisionShape2D* shape, DebugRenderer* debug, bo
 //    endContactInfos_.Push(ContactInfo(contact));
 //}
 
-static b2Fixture* mapFixture;
-static b2Fixture* otherFixture;
-static CollisionShape2D* mapShape;
-static CollisionShape2D* otherShape;
-static int ishapeA;
-static int ishapeB;
-static int ishapeNext;
-static int zPlatform;
-static int zBody;
-static float normaly;
-static float normalx;
-static float shapenormaly;
-static int pointid;
-static bool isFluid;
-
 static void* WALLCOLLIDER = (void*)1;
 static void* PLATEFORMCOLLIDER = (void*)2;
 static void* WATERCOLLIDER = (void*)3;
@@ -194,14 +219,14 @@ void PhysicsWorld2D::BeginContact(b2Contact* contact)
     if (!physicsStepping_)
         return;
 
-    mapFixture = contact->GetFixtureA();
-    otherFixture = contact->GetFixtureB();
+    b2Fixture* mapFixture = contact->GetFixtureA();
+    b2Fixture* otherFixture = contact->GetFixtureB();
 
     if (!mapFixture || !otherFixture)
         return;
 
-    mapShape = (CollisionShape2D*)(mapFixture->GetUserData());
-    otherShape     = (CollisionShape2D*)(otherFixture->GetUserData());
+    CollisionShape2D* mapShape = (CollisionShape2D*)(mapFixture->GetUserData());
+    CollisionShape2D* otherShape = (CollisionShape2D*)(otherFixture->GetUserData());
 
     if (!mapShape || !otherShape)
 		return;
@@ -248,6 +273,7 @@ void PhysicsWorld2D::BeginContact(b2Contact* contact)
         }
     }
 
+    int ishapeA, ishapeB;
     if (swapBodies)
     {
 //        URHO3D_LOGINFOF("... swapBodies ...");
@@ -264,7 +290,7 @@ void PhysicsWorld2D::BeginContact(b2Contact* contact)
         ishapeB = contact->GetChildIndexB();
     }
 
-    isFluid = mapShape->GetColliderInfo() == WATERCOLLIDER;
+    const bool isFluid = mapShape->GetColliderInfo() == WATERCOLLIDER;
 
     if (otherShape->IsTrigger() && !isFluid)
     {
@@ -274,8 +300,9 @@ void PhysicsWorld2D::BeginContact(b2Contact* contact)
         return;
     }
 
-    zPlatform = mapShape->GetViewZ() + (mapShape->GetColliderInfo() == PLATEFORMCOLLIDER ? -1 : 0);
-    zBody = otherShape->GetViewZ();
+    const int zPlatform = mapShape->GetViewZ() + (mapShape->GetColliderInfo() == PLATEFORMCOLLIDER ? -1 : 0);
+    const int zBody = otherShape->GetViewZ();
+    float normalx, normaly;
 
     /// platform above otherbody : desactive contact
     if (zPlatform > zBody)
@@ -339,7 +366,7 @@ void PhysicsWorld2D::BeginContact(b2Contact* contact)
         normaly = wManifold.normal.y;
     }
 
-    pointid = 0;
+    int pointid = 0;
 
     if (zPlatform < zBody)
     {
@@ -354,7 +381,7 @@ void PhysicsWorld2D::BeginContact(b2Contact* contact)
         {
             b2Body* platformb2Body = mapFixture->GetBody();
             b2Body* otherb2Body = otherFixture->GetBody();
-			shapenormaly = 1.f;
+			float shapenormaly = 1.f;
 
             /// check if outside the shape
             if (mapFixture->GetShape()->GetType() == b2Shape::e_chain)
@@ -555,63 +582,228 @@ void PhysicsWorld2D::DrawTransform(const b2Transform& xf)
     debugRenderer_->AddLine(Vector3(p1.x, p1.y, 0.0f), Vector3(p2.x, p2.y, 0.0f), Color::GREEN, debugDepthTest_);
 }
 
+int32 PhysicsWorld2D::GetThreadCount()
+{
+    // The work queue is driven by the main thread only, an asynchronous step runs its tasks alone
+    if (!Thread::IsMainThread())
+        return 1;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    return queue ? (int32)queue->GetNumThreads() + 1 : 1;
+}
+
+void PhysicsWorld2D::ParallelFor(int32 count, int32 minRange, b2TaskFunction task, void* userData)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    const int numThreads = queue && Thread::IsMainThread() ? (int)queue->GetNumThreads() + 1 : 1;
+    const int numRanges = Min(count / Max(minRange, 1), numThreads * TASK_RANGES_PER_THREAD);
+
+    if (numThreads == 1 || numRanges <= 1)
+    {
+        if (count > 0)
+            task(0, count, 0, userData);
+        return;
+    }
+
+    tasks_.Resize(numRanges);
+
+    int begin = 0;
+    for (int i = 0; i < numRanges; ++i)
+    {
+        PhysicsTask2D& range = tasks_[i];
+        range.function_ = task;
+        range.userData_ = userData;
+        range.begin_ = begin;
+        range.end_ = i < numRanges - 1 ? count * (i + 1) / numRanges : count;
+        begin = range.end_;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = RunPhysicsTask2D;
+        item->aux_ = &range;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+void PhysicsWorld2D::Lock()
+{
+    taskMutex_.Acquire();
+}
+
+void PhysicsWorld2D::Unlock()
+{
+    taskMutex_.Release();
+}
+
 void PhysicsWorld2D::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdatePhysics2D);
 
     using namespace PhysicsPreStep2D;
 
-    beginContactInfos_.Clear();
-    endContactInfos_.Clear();
+    // The steps not run while rendering, if the frame was not rendered, are run now
+    CompleteAsyncStep();
 
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
     VariantMap& eventData = GetEventDataMap();
     eventData[P_WORLD] = this;
-    eventData[P_TIMESTEP] = timeStep;
-    SendEvent(E_PHYSICSPRESTEP2D, eventData);
+
+    if (asyncStep_ && queue && queue->GetNumThreads())
+    {
+        // Write back the state stepped while the previous frame rendered, then send the events of these steps
+        const bool stepped = pendingTimeStep_ > 0.0f;
+        ApplyWorldTransforms();
+
+        if (stepped)
+        {
+            eventData[P_TIMESTEP] = pendingTimeStep_;
+            SendBeginContactEvents();
+            SendEndContactEvents();
+            SendEvent(E_PHYSICSPOSTSTEP2D, eventData);
+        }
+
+        // The pre-step events of the steps run while this frame renders are sent now
+        pendingSteps_ = ConsumeSteps(timeStep, pendingTimeStep_);
+        if (!pendingSteps_)
+            pendingTimeStep_ = 0.0f;
+
+        eventData[P_TIMESTEP] = pendingTimeStep_;
+        for (unsigned i = 0; i < pendingSteps_; ++i)
+            SendEvent(E_PHYSICSPRESTEP2D, eventData);
+
+        return;
+    }
+
+    beginContactInfos_.Clear();
+    endContactInfos_.Clear();
+
+    float stepTimeStep;
+    const unsigned numSteps = ConsumeSteps(timeStep, stepTimeStep);
+
+    eventData[P_TIMESTEP] = stepTimeStep;
+    for (unsigned i = 0; i < numSteps; ++i)
+    {
+        SendEvent(E_PHYSICSPRESTEP2D, eventData);
+        StepWorld(stepTimeStep, i == numSteps - 1);
+    }
+
+    ApplyWorldTransforms();
+
+    if (numSteps)
+    {
+        SendBeginContactEvents();
+        SendEndContactEvents();
+
+        using namespace PhysicsPostStep2D;
+        SendEvent(E_PHYSICSPOSTSTEP2D, eventData);
+    }
+}
+
+unsigned PhysicsWorld2D::ConsumeSteps(float timeStep, float& stepTimeStep)
+{
+    if (maxSubSteps_ < 0)
+    {
+        stepTimeStep = timeStep;
+        timeAcc_ = 0.0f;
+        return 1;
+    }
+
+    stepTimeStep = 1.0f / fps_;
+    unsigned maxSubSteps = (unsigned)(timeStep * fps_) + 1;
+    if (maxSubSteps_ > 0)
+        maxSubSteps = Min(maxSubSteps, (unsigned)maxSubSteps_);
+
+    timeAcc_ += timeStep;
+    unsigned numSteps = 0;
+    while (timeAcc_ >= stepTimeStep && numSteps < maxSubSteps)
+    {
+        timeAcc_ -= stepTimeStep;
+        ++numSteps;
+    }
+
+    // The time beyond the maximum number of steps is dropped, the simulation slows down instead of falling further behind
+    if (timeAcc_ >= stepTimeStep)
+        timeAcc_ -= floorf(timeAcc_ / stepTimeStep) * stepTimeStep;
+
+    return numSteps;
+}
+
+void PhysicsWorld2D::StepWorld(float timeStep, bool lastStep)
+{
+    if (lastStep && interpolation_ && maxSubSteps_ >= 0)
+        StorePreviousTransforms();
 
     physicsStepping_ = true;
     world_->Step(timeStep, velocityIterations_, positionIterations_);
     physicsStepping_ = false;
+}
 
-    // Apply world transforms. Unparented transforms first
-    for (unsigned i = 0; i < rigidBodies_.Size();)
+void PhysicsWorld2D::StorePreviousTransforms()
+{
+    for (b2Body* body = world_->GetBodyList(); body; body = body->GetNext())
     {
-        if (rigidBodies_[i])
-        {
-            rigidBodies_[i]->ApplyWorldTransform();
-            ++i;
-        }
-        else
-        {
-            // Erase possible stale weak pointer
-            rigidBodies_.Erase(i);
-        }
+        RigidBody2D* rigidBody = (RigidBody2D*)body->GetUserData();
+        if (rigidBody && body->GetType() != b2_staticBody)
+            rigidBody->StorePreviousTransform();
     }
+}
 
-    // Apply delayed (parented) world transforms now, if any
-    while (!delayedWorldTransforms_.Empty())
+void PhysicsWorld2D::StartAsyncStep()
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (!pendingSteps_ || asyncStepItem_ || !queue)
+        return;
+
+    beginContactInfos_.Clear();
+    endContactInfos_.Clear();
+
+    // Below the priority of the rendering work, so that waiting for that work does not wait for the step.
+    // The item is not pooled, it stays valid until completed even if the work queue purges it
+    asyncStepItem_ = new WorkItem();
+    asyncStepItem_->priority_ = 0;
+    asyncStepItem_->workFunction_ = RunAsyncStep;
+    asyncStepItem_->aux_ = this;
+    queue->AddWorkItem(asyncStepItem_);
+}
+
+void PhysicsWorld2D::CompleteAsyncStep()
+{
+    if (asyncStepItem_)
     {
-        for (HashMap<RigidBody2D*, DelayedWorldTransform2D>::Iterator i = delayedWorldTransforms_.Begin();
-            i != delayedWorldTransforms_.End();)
+        // Run the steps now if no thread has taken them yet
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (queue && queue->RemoveWorkItem(asyncStepItem_))
+            RunPendingSteps();
+        else
         {
-            const DelayedWorldTransform2D& transform = i->second_;
-
-            // If parent's transform has already been assigned, can proceed
-            if (!delayedWorldTransforms_.Contains(transform.parentRigidBody_))
-            {
-                transform.rigidBody_->ApplyWorldTransform(transform.worldPosition_, transform.worldRotation_);
-                i = delayedWorldTransforms_.Erase(i);
-            }
-            else
-                ++i;
+            while (!asyncStepItem_->completed_)
+                Time::Sleep(0);
         }
+
+        asyncStepItem_.Reset();
     }
+    else if (pendingSteps_)
+    {
+        beginContactInfos_.Clear();
+        endContactInfos_.Clear();
+        RunPendingSteps();
+    }
+}
 
-    SendBeginContactEvents();
-    SendEndContactEvents();
+void PhysicsWorld2D::RunPendingSteps()
+{
+    while (pendingSteps_)
+    {
+        --pendingSteps_;
+        StepWorld(pendingTimeStep_, pendingSteps_ == 0);
+    }
+}
 
-    using namespace PhysicsPostStep2D;
-    SendEvent(E_PHYSICSPOSTSTEP2D, eventData);
+void PhysicsWorld2D::RunAsyncStep(const WorkItem* item, unsigned threadIndex)
+{
+    reinterpret_cast<PhysicsWorld2D*>(item->aux_)->RunPendingSteps();
 }
 
 void PhysicsWorld2D::DrawDebugGeometry()
@@ -708,6 +900,49 @@ void PhysicsWorld2D::SetPositionIterations(int positionIterations)
     positionIterations_ = positionIterations;
 }
 
+void PhysicsWorld2D::SetMultiThreaded(bool enable)
+{
+    if (enable == multiThreaded_)
+        return;
+
+    multiThreaded_ = enable;
+    world_->SetTaskExecutor(enable ? this : 0);
+}
+
+void PhysicsWorld2D::SetFps(int fps)
+{
+    fps_ = Clamp(fps, 1, 1000);
+}
+
+void PhysicsWorld2D::SetMaxSubSteps(int num)
+{
+    // The interpolation starts from the current transforms
+    if (num >= 0 && maxSubSteps_ < 0)
+        StorePreviousTransforms();
+
+    maxSubSteps_ = num;
+}
+
+void PhysicsWorld2D::SetInterpolation(bool enable)
+{
+    if (enable && !interpolation_)
+        StorePreviousTransforms();
+
+    interpolation_ = enable;
+}
+
+void PhysicsWorld2D::SetAsyncStep(bool enable)
+{
+    if (enable == asyncStep_)
+        return;
+
+    // The contact events of the steps already run while rendering are not sent
+    CompleteAsyncStep();
+    pendingTimeStep_ = 0.0f;
+
+    asyncStep_ = enable;
+}
+
 void PhysicsWorld2D::AddRigidBody(RigidBody2D* rigidBody)
 {
     if (!rigidBody)
@@ -718,6 +953,7 @@ void PhysicsWorld2D::AddRigidBody(RigidBody2D* rigidBody)
         return;
 
     rigidBodies_.Push(rigidBodyPtr);
+    writeBackOrderDirty_ = true;
 }
 
 void PhysicsWorld2D::RemoveRigidBody(RigidBody2D* rigidBody)
@@ -727,6 +963,8 @@ void PhysicsWorld2D::RemoveRigidBody(RigidBody2D* rigidBody)
 
     WeakPtr<RigidBody2D> rigidBodyPtr(rigidBody);
     rigidBodies_.Remove(rigidBodyPtr);
+    delayedWorldTransforms_.Erase(rigidBody);
+    writeBackOrderDirty_ = true;
 }
 
 void PhysicsWorld2D::AddDelayedWorldTransform(const DelayedWorldTransform2D& transform)
@@ -734,6 +972,38 @@ void PhysicsWorld2D::AddDelayedWorldTransform(const DelayedWorldTransform2D& tra
     delayedWorldTransforms_[transform.rigidBody_] = transform;
 }
 
+void PhysicsWorld2D::AddContactListener(ContactListener2D* listener, unsigned categoryMask)
+{
+    if (!listener)
+        return;
+
+    for (unsigned i = 0; i < contactListeners_.Size(); ++i)
+    {
+        if (contactListeners_[i].listener_ == listener)
+        {
+            contactListeners_[i].categoryMask_ = categoryMask;
+            return;
+        }
+    }
+
+    ContactListenerEntry2D entry;
+    entry.listener_ = listener;
+    entry.categoryMask_ = categoryMask;
+    contactListeners_.Push(entry);
+}
+
+void PhysicsWorld2D::RemoveContactListener(ContactListener2D* listener)
+{
+    for (unsigned i = 0; i < contactListeners_.Size(); ++i)
+    {
+        if (contactListeners_[i].listener_ == listener)
+        {
+            contactListeners_.Erase(i);
+            return;
+        }
+    }
+}
+
 // Ray cast call back class.
 class RayCastCallback : public b2RayCastCallback
 {
@@ -1054,9 +1324,18 @@ void PhysicsWorld2D::OnSceneSet(Scene* scene)
 {
     // Subscribe to the scene subsystem update, which will trigger the physics simulation step
     if (scene)
+    {
         SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, URHO3D_HANDLER(PhysicsWorld2D, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(E_BEGINRENDERING, URHO3D_HANDLER(PhysicsWorld2D, HandleBeginRendering));
+        SubscribeToEvent(E_ENDRENDERING, URHO3D_HANDLER(PhysicsWorld2D, HandleEndRendering));
+    }
     else
+    {
+        CompleteAsyncStep();
         UnsubscribeFromEvent(E_SCENESUBSYSTEMUPDATE);
+        UnsubscribeFromEvent(E_BEGINRENDERING);
+        UnsubscribeFromEvent(E_ENDRENDERING);
+    }
 }
 
 void PhysicsWorld2D::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
@@ -1068,49 +1347,235 @@ void PhysicsWorld2D::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap
     Update(eventData[P_TIMESTEP].GetFloat());
 }
 
-void PhysicsWorld2D::SendBeginContactEvents()
+void PhysicsWorld2D::HandleBeginRendering(StringHash eventType, VariantMap& eventData)
 {
-    if (beginContactInfos_.Empty())
-        return;
+    // The scene logic is done for this frame, the world is stepped while the frame renders
+    if (asyncStep_)
+        StartAsyncStep();
+}
 
-    using namespace PhysicsBeginContact2D;
-    VariantMap& eventData = GetEventDataMap();
+void PhysicsWorld2D::HandleEndRendering(StringHash eventType, VariantMap& eventData)
+{
+    if (asyncStepItem_)
+    {
+        URHO3D_PROFILE(CompleteAsyncStep2D);
+        CompleteAsyncStep();
+    }
+}
+
+void PhysicsWorld2D::ApplyWorldTransforms()
+{
+    URHO3D_PROFILE(ApplyWorldTransforms2D);
+
+    if (writeBackOrderDirty_)
+        UpdateWriteBackOrder();
+
+    // Reparented nodes make the order outdated, gather again after ordering
+    if (!GatherWorldTransforms())
+    {
+        UpdateWriteBackOrder();
+        GatherWorldTransforms();
+    }
+
+    delayedWorldTransforms_.Clear();
+
+    // The bodies of the parent nodes come first, so that the parent world transforms are already up to date.
+    // Each node gets its local transform at once and is marked dirty once
+    SetApplyingTransforms(true);
+
+    for (unsigned i = 0; i < writeBackBodies_.Size(); ++i)
+    {
+        Node* node = writeBackBodies_[i]->GetNode();
+        const Vector2& worldPosition = writeBackPositions_[i];
+        const float worldRotation = writeBackRotations_[i];
+
+        if (worldPosition == node->GetWorldPosition2D() && worldRotation == node->GetWorldRotation2D())
+            continue;
+
+        Node* parent = node->GetParent();
+        if (!parent || parent == node->GetScene())
+            node->SetTransform2D(worldPosition, worldRotation);
+        else
+            node->SetTransform2D(parent->GetWorldTransform2D().Inverse() * worldPosition, worldRotation - parent->GetWorldRotation2D());
+
+        // An interpolated transform is behind the body, dirtying the node later must not move the body back to it
+        writeBackBodies_[i]->SetNodeTransform(node->GetWorldPosition2D(), node->GetWorldRotation2D());
+    }
+
+    SetApplyingTransforms(false);
+}
+
+bool PhysicsWorld2D::GatherWorldTransforms()
+{
+    writeBackBodies_.Clear();
+    writeBackPositions_.Clear();
+    writeBackRotations_.Clear();
 
-    for (unsigned i = 0; i < beginContactInfos_.Size(); ++i)
+    // Between two fixed steps, the nodes get the transforms interpolated from the previous step to the last one
+    const bool interpolate = interpolation_ && maxSubSteps_ >= 0;
+    const float t = Clamp(timeAcc_ * fps_, 0.0f, 1.0f);
+
+    for (unsigned i = 0; i < writeBackOrder_.Size(); ++i)
     {
-        const ContactInfo& contactInfo = beginContactInfos_[i];
+        RigidBody2D* rigidBody = writeBackOrder_[i].body_;
+        Node* node = rigidBody->GetNode();
+        b2Body* body = rigidBody->GetBody();
+        if (!node || !body)
+            continue;
+
+        if (node->GetParent() != writeBackOrder_[i].parent_)
+            return false;
+
+        if (!body->IsActive())
+            continue;
 
-        eventData[P_CONTACTINFO] = i;
+        // The static bodies follow their node
+        if (body->GetType() == b2_staticBody)
+        {
+            rigidBody->ApplyWorldTransform();
+            continue;
+        }
 
-		if (contactInfo.bodyA_ && contactInfo.bodyA_->GetNode())
-			contactInfo.bodyA_->GetNode()->SendEvent(E_PHYSICSBEGINCONTACT2D, eventData);
-		if (contactInfo.bodyB_ && contactInfo.bodyB_->GetNode())
-			contactInfo.bodyB_->GetNode()->SendEvent(E_PHYSICSBEGINCONTACT2D, eventData);
+        if (!body->IsAwake())
+        {
+            // A body fallen asleep gets its simulated transform once, then is skipped
+            if (!interpolate || !rigidBody->IsInterpolated())
+                continue;
+            rigidBody->StorePreviousTransform();
+        }
+
+        writeBackBodies_.Push(rigidBody);
+
+        HashMap<RigidBody2D*, DelayedWorldTransform2D>::ConstIterator delayed = delayedWorldTransforms_.Empty() ?
+            delayedWorldTransforms_.End() : delayedWorldTransforms_.Find(rigidBody);
+        if (delayed != delayedWorldTransforms_.End())
+        {
+            writeBackPositions_.Push(delayed->second_.worldPosition_);
+            writeBackRotations_.Push(delayed->second_.worldRotation_);
+        }
+        else if (interpolate)
+        {
+            Vector2 position;
+            float rotation;
+            rigidBody->GetInterpolatedTransform(t, position, rotation);
+            writeBackPositions_.Push(position);
+            writeBackRotations_.Push(rotation);
+        }
+        else
+        {
+            const b2Transform& transform = body->GetTransform();
+            writeBackPositions_.Push(Vector2(transform.p.x, transform.p.y));
+            writeBackRotations_.Push(transform.q.GetAngle() * M_RADTODEG);
+        }
     }
+
+    return true;
+}
+
+static bool CompareWriteBackDepth(const WriteBackBody2D& lhs, const WriteBackBody2D& rhs)
+{
+    return lhs.depth_ < rhs.depth_;
+}
+
+void PhysicsWorld2D::UpdateWriteBackOrder()
+{
+    writeBackOrder_.Clear();
+
+    for (unsigned i = 0; i < rigidBodies_.Size();)
+    {
+        RigidBody2D* rigidBody = rigidBodies_[i];
+        if (!rigidBody)
+        {
+            // Erase possible stale weak pointer
+            rigidBodies_.Erase(i);
+            continue;
+        }
+
+        WriteBackBody2D entry;
+        entry.body_ = rigidBody;
+        entry.parent_ = rigidBody->GetNode() ? rigidBody->GetNode()->GetParent() : 0;
+        entry.depth_ = 0;
+        for (Node* parent = entry.parent_; parent; parent = parent->GetParent())
+            ++entry.depth_;
+
+        writeBackOrder_.Push(entry);
+        ++i;
+    }
+
+    Sort(writeBackOrder_.Begin(), writeBackOrder_.End(), CompareWriteBackDepth);
+
+    writeBackOrderDirty_ = false;
+}
+
+void PhysicsWorld2D::SendBeginContactEvents()
+{
+    SendContactEvents(beginContactInfos_, E_PHYSICSBEGINCONTACT2D, true);
 }
 
 void PhysicsWorld2D::SendEndContactEvents()
 {
-    if (endContactInfos_.Empty())
+    SendContactEvents(endContactInfos_, E_PHYSICSENDCONTACT2D, false);
+}
+
+void PhysicsWorld2D::SendContactEvents(const Vector<ContactInfo>& contacts, StringHash eventType, bool begin)
+{
+    if (contacts.Empty())
         return;
 
-    using namespace PhysicsEndContact2D;
+    // The listeners get the contact stream directly
+    for (unsigned i = 0; i < contactListeners_.Size(); ++i)
+    {
+        for (unsigned j = 0; j < contacts.Size() && i < contactListeners_.Size(); ++j)
+        {
+            const ContactInfo& contactInfo = contacts[j];
+            ContactListener2D* listener = contactListeners_[i].listener_;
+            const unsigned categoryMask = contactListeners_[i].categoryMask_;
+
+            if (contactInfo.bodyA_ && contactInfo.shapeA_ && (contactInfo.shapeA_->GetCategoryBits() & categoryMask))
+            {
+                if (begin)
+                    listener->OnBeginContact2D(contactInfo.bodyA_, contactInfo);
+                else
+                    listener->OnEndContact2D(contactInfo.bodyA_, contactInfo);
+            }
+            if (contactInfo.bodyB_ && contactInfo.shapeB_ && (contactInfo.shapeB_->GetCategoryBits() & categoryMask))
+            {
+                if (begin)
+                    listener->OnBeginContact2D(contactInfo.bodyB_, contactInfo);
+                else
+                    listener->OnEndContact2D(contactInfo.bodyB_, contactInfo);
+            }
+        }
+    }
+
+    // The nodes without receivers are skipped, sending an event costs much more than checking them
     VariantMap& eventData = GetEventDataMap();
 
-    for (unsigned i = 0; i < endContactInfos_.Size(); ++i)
+    for (unsigned i = 0; i < contacts.Size(); ++i)
     {
-        const ContactInfo& contactInfo = endContactInfos_[i];
+        const ContactInfo& contactInfo = contacts[i];
 
-        eventData[P_CONTACTINFO] = i;
+        Node* node = contactInfo.bodyA_ ? contactInfo.bodyA_->GetNode() : 0;
+        if (node && HasContactReceivers(context_, node, eventType))
+        {
+            eventData[PhysicsBeginContact2D::P_CONTACTINFO] = i;
+            node->SendEvent(eventType, eventData);
+        }
 
-		if (contactInfo.bodyA_ && contactInfo.bodyA_->GetNode())
-			contactInfo.bodyA_->GetNode()->SendEvent(E_PHYSICSENDCONTACT2D, eventData);
-		if (contactInfo.bodyB_ && contactInfo.bodyB_->GetNode())
-			contactInfo.bodyB_->GetNode()->SendEvent(E_PHYSICSENDCONTACT2D, eventData);
+        node = contactInfo.bodyB_ ? contactInfo.bodyB_->GetNode() : 0;
+        if (node && HasContactReceivers(context_, node, eventType))
+        {
+            eventData[PhysicsBeginContact2D::P_CONTACTINFO] = i;
+            node->SendEvent(eventType, eventData);
+        }
     }
 }
 
-ContactInfo::ContactInfo() { }
+ContactInfo::ContactInfo() :
+    iShapeA_(0),
+    iShapeB_(0)
+{
+}
 
 ContactInfo::ContactInfo(b2Contact* contact)
 {
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Core/Mutex.h"
 #include "../Scene/Component.h"
 
 #include <Box2D/Box2D.h>
@@ -32,6 +33,7 @@ namespace Urho3D
 class Camera;
 class CollisionShape2D;
 class RigidBody2D;
+class WorkItem;
 
 /// Contact info.
 struct ContactInfo
@@ -57,6 +59,28 @@ struct ContactInfo
     Vector2 normal_;
 };
 
+/// FromBones : receiver of the contact stream, called after the physics step without sending events.
+class URHO3D_API ContactListener2D
+{
+public:
+    /// Destruct.
+    virtual ~ContactListener2D() { }
+
+    /// Called when a shape of the body matching the listener category mask begins to touch another shape. The body is the contact body A or B.
+    virtual void OnBeginContact2D(RigidBody2D* body, const ContactInfo& contact) { }
+    /// Called when a shape of the body matching the listener category mask ceases to touch another shape. The body is the contact body A or B.
+    virtual void OnEndContact2D(RigidBody2D* body, const ContactInfo& contact) { }
+};
+
+/// FromBones : contact listener registration.
+struct ContactListenerEntry2D
+{
+    /// Listener.
+    ContactListener2D* listener_;
+    /// Category bits of the shapes whose contacts are reported.
+    unsigned categoryMask_;
+};
+
 /// 2D Physics raycast hit.
 struct URHO3D_API PhysicsRaycastResult2D
 {
@@ -95,8 +119,32 @@ struct DelayedWorldTransform2D
     float worldRotation_;
 };
 
+/// FromBones : rigid body in the transform write-back order.
+struct WriteBackBody2D
+{
+    /// Rigid body.
+    RigidBody2D* body_;
+    /// Parent node when ordered. The order is rebuilt when it changes.
+    Node* parent_;
+    /// Depth of the node in the scene hierarchy when ordered.
+    unsigned depth_;
+};
+
+/// FromBones : range of a Box2D task run by the work queue.
+struct PhysicsTask2D
+{
+    /// Task function.
+    b2TaskExecutor::b2TaskFunction function_;
+    /// Task user data.
+    void* userData_;
+    /// First item.
+    int begin_;
+    /// Item after the last one.
+    int end_;
+};
+
 /// 2D physics simulation world component. Should be added only to the root scene node.
-class URHO3D_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw
+class URHO3D_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw, public b2TaskExecutor
 {
     URHO3D_OBJECT(PhysicsWorld2D, Component);
 
@@ -134,6 +182,16 @@ public:
     /// Draw a point.
     virtual void DrawPoint(const b2Vec2& p, float32 size, const b2Color& color);
 
+    // Implement b2TaskExecutor
+    /// Return the number of threads running the tasks : the work queue threads and the main thread.
+    virtual int32 GetThreadCount();
+    /// Run a task on the work queue threads split in ranges, and wait for its completion.
+    virtual void ParallelFor(int32 count, int32 minRange, b2TaskFunction task, void* userData);
+    /// Lock the mutex shared by the tasks.
+    virtual void Lock();
+    /// Unlock the mutex shared by the tasks.
+    virtual void Unlock();
+
     /// Step the simulation forward.
     void Update(float timeStep);
     /// Add debug geometry to the debug renderer.
@@ -166,12 +224,26 @@ public:
     void SetVelocityIterations(int velocityIterations);
     /// Set position iterations.
     void SetPositionIterations(int positionIterations);
+    /// FromBones : set whether to solve the islands and update the contacts on the work queue threads. The contact events stay ordered as in a single threaded step. Default false.
+    void SetMultiThreaded(bool enable);
+    /// FromBones : set the simulation steps per second of the fixed time step.
+    void SetFps(int fps);
+    /// FromBones : set the maximum number of fixed steps per update. 0 (unlimited) or a positive number use the fixed time step, a negative number steps once with the frame time step. Default -1.
+    void SetMaxSubSteps(int num);
+    /// FromBones : set whether to write the transforms interpolated between the last two fixed steps to the nodes. Default true.
+    void SetInterpolation(bool enable);
+    /// FromBones : set whether to run the steps on a work queue thread while the frame renders. The nodes then show the state stepped during the previous frame. Default false.
+    void SetAsyncStep(bool enable);
     /// Add rigid body.
     void AddRigidBody(RigidBody2D* rigidBody);
     /// Remove rigid body.
     void RemoveRigidBody(RigidBody2D* rigidBody);
     /// Add a delayed world transform assignment. Called by RigidBody2D.
     void AddDelayedWorldTransform(const DelayedWorldTransform2D& transform);
+    /// FromBones : add a contact stream listener, or change its category mask. It is called once for each body of a contact whose shape category bits match the mask. The listener is not owned.
+    void AddContactListener(ContactListener2D* listener, unsigned categoryMask = M_MAX_UNSIGNED);
+    /// FromBones : remove a contact stream listener.
+    void RemoveContactListener(ContactListener2D* listener);
 
     /// Perform a physics world raycast and return all hits.
     void Raycast(PODVector<PhysicsRaycastResult2D>& results, const Vector2& startPoint, const Vector2& endPoint,
@@ -226,11 +298,30 @@ public:
     /// Return position iterations.
     int GetPositionIterations() const { return positionIterations_; }
 
+    /// Return whether steps on the work queue threads.
+    bool IsMultiThreaded() const { return multiThreaded_; }
+
+    /// Return the simulation steps per second.
+    int GetFps() const { return fps_; }
+
+    /// Return the maximum number of fixed steps per update.
+    int GetMaxSubSteps() const { return maxSubSteps_; }
+
+    /// Return whether interpolates the node transforms.
+    bool GetInterpolation() const { return interpolation_; }
+
+    /// Return whether steps while the frame renders.
+    bool IsAsyncStep() const { return asyncStep_; }
+
     /// Return the Box2D physics world.
     b2World* GetWorld() { return world_.Get(); }
 
     const ContactInfo& GetBeginContactInfo(unsigned i) const { return beginContactInfos_[i]; }
     const ContactInfo& GetEndContactInfo(unsigned i) const { return endContactInfos_[i]; }
+    /// FromBones : return the contacts begun during the last step, valid until the next step.
+    const Vector<ContactInfo>& GetBeginContactInfos() const { return beginContactInfos_; }
+    /// FromBones : return the contacts ended during the last step, valid until the next step.
+    const Vector<ContactInfo>& GetEndContactInfos() const { return endContactInfos_; }
 
     /// Set node dirtying to be disregarded.
     void SetApplyingTransforms(bool enable) { applyingTransforms_ = enable; }
@@ -245,10 +336,36 @@ protected:
 private:
     /// Handle the scene subsystem update event, step simulation here.
     void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle the begin rendering event, start the pending steps on a work queue thread.
+    void HandleBeginRendering(StringHash eventType, VariantMap& eventData);
+    /// Handle the end rendering event, wait for the steps run while rendering.
+    void HandleEndRendering(StringHash eventType, VariantMap& eventData);
+    /// Return the fixed time step and the number of steps for an update, and consume their time.
+    unsigned ConsumeSteps(float timeStep, float& stepTimeStep);
+    /// Step the Box2D world once. The transforms before the last step of an update are kept for the interpolation.
+    void StepWorld(float timeStep, bool lastStep);
+    /// Store the body transforms to interpolate from.
+    void StorePreviousTransforms();
+    /// Start the pending steps on a work queue thread.
+    void StartAsyncStep();
+    /// Wait for the steps started on a work queue thread, or run them now if not started.
+    void CompleteAsyncStep();
+    /// Run the pending steps.
+    void RunPendingSteps();
+    /// Run the pending steps of a work item. Called by the work queue.
+    static void RunAsyncStep(const WorkItem* item, unsigned threadIndex);
     /// Send begin contact events.
     void SendBeginContactEvents();
     /// Send end contact events.
     void SendEndContactEvents();
+    /// Write the simulated transforms back to the rigid body nodes.
+    void ApplyWorldTransforms();
+    /// Gather the transforms of the awake rigid bodies in the write-back order. Return false if the order is outdated.
+    bool GatherWorldTransforms();
+    /// Order the rigid bodies for the write-back, the bodies of the parent nodes first.
+    void UpdateWriteBackOrder();
+    /// Report contacts to the contact listeners, then send the contact events to the nodes having receivers.
+    void SendContactEvents(const Vector<ContactInfo>& contacts, StringHash eventType, bool begin);
 
     /// Box2D physics world.
     UniquePtr<b2World> world_;
@@ -272,15 +389,49 @@ private:
     bool physicsStepping_;
     /// Applying transforms.
     bool applyingTransforms_;
+    /// Multithreaded step flag.
+    bool multiThreaded_;
+    /// Simulation steps per second.
+    int fps_;
+    /// Maximum number of fixed steps per update.
+    int maxSubSteps_;
+    /// Time accumulator for the fixed steps.
+    float timeAcc_;
+    /// Interpolation flag.
+    bool interpolation_;
+    /// Asynchronous step flag.
+    bool asyncStep_;
+    /// Steps waiting to be run while the frame renders.
+    unsigned pendingSteps_;
+    /// Time step of the pending steps.
+    float pendingTimeStep_;
+    /// Work item of the steps run while the frame renders.
+    SharedPtr<WorkItem> asyncStepItem_;
+    /// Ranges of the Box2D task being run.
+    PODVector<PhysicsTask2D> tasks_;
+    /// Mutex shared by the Box2D tasks.
+    Mutex taskMutex_;
     /// Rigid bodies.
     Vector<WeakPtr<RigidBody2D> > rigidBodies_;
     /// Delayed (parented) world transform assignments.
     HashMap<RigidBody2D*, DelayedWorldTransform2D> delayedWorldTransforms_;
+    /// Rigid bodies in the transform write-back order.
+    PODVector<WriteBackBody2D> writeBackOrder_;
+    /// Whether the write-back order must be rebuilt.
+    bool writeBackOrderDirty_;
+    /// Rigid bodies gathered for the write-back.
+    PODVector<RigidBody2D*> writeBackBodies_;
+    /// World positions gathered for the write-back.
+    PODVector<Vector2> writeBackPositions_;
+    /// World rotations gathered for the write-back.
+    PODVector<float> writeBackRotations_;
 
     /// Begin contact infos.
     Vector<ContactInfo> beginContactInfos_;
     /// End contact infos.
     Vector<ContactInfo> endContactInfos_;
+    /// Contact stream listeners.
+    PODVector<ContactListenerEntry2D> contactListeners_;
 };
 
 }
@@ -135,7 +135,7 @@ Renderer2D::Renderer2D(Context* context) :
     #endif
     }
 
-    SubscribeToEvent(E_BEGINVIEWUPDATE, URHO3D_HANDLER(Renderer2D, HandleBeginViewUpdate));
+    SubscribeToTypedEvent(&Renderer2D::HandleBeginViewUpdate);
 }
 
 Renderer2D::~Renderer2D()
@@ -550,15 +550,13 @@ SharedPtr<Material> Renderer2D::CreateMaterial(Texture2D* texture, BlendMode ble
     return newMaterial;
 }
 
-void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData)
+void Renderer2D::HandleBeginViewUpdate(const BeginViewUpdateEvent& event)
 {
-    using namespace BeginViewRender;
-
     // Check that we are updating the correct scene
-    if (GetScene() != eventData[P_SCENE].GetPtr())
+    if (GetScene() != event.scene_)
         return;
 
-    Camera* camera = static_cast<Camera*>(eventData[P_CAMERA].GetPtr());
+    Camera* camera = event.camera_;
     if (!camera)
         return;
 
@@ -566,7 +564,7 @@ void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventDa
 
     ViewBatchInfo2D& viewBatchInfo         = viewBatchInfos_[camera];
     currentViewBatchInfo_ = &viewBatchInfo;
-    viewBatchInfo.frame_         = static_cast<View*>(eventData[P_VIEW].GetPtr())->GetFrameInfo();
+    viewBatchInfo.frame_         = event.view_->GetFrameInfo();
     viewBatchInfo.frame_.camera_ = camera;
     viewBatchInfo.frustum_       = &camera->GetFrustum();
     if (camera->IsOrthographic() && camera->GetNode()->GetWorldDirection() == Vector3::FORWARD)
@@ -646,11 +644,60 @@ void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventDa
 //    URHO3D_LOGDEBUGF("Renderer2D this=%u viewupdate for scene=%u camera=%u batches=%u !", this, GetScene(), camera, batches_.Size());
 }
 
+/// FromBones : collect the drawables of the scene pools that the node walk of GetDrawables() would return.
+struct CollectEnabledDrawables
+{
+    /// Construct.
+    CollectEnabledDrawables(PODVector<Drawable2D*>& dest, HashMap<Node*, bool>& enabledParents) :
+        dest_(dest),
+        enabledParents_(enabledParents)
+    {
+    }
+
+    /// Add the drawable if enabled, and if its node and all the parent nodes are enabled.
+    void operator ()(Drawable2D* drawable) const
+    {
+        Node* node = drawable->GetNode();
+        if (!drawable->IsEnabled() || !node->IsEnabled())
+            return;
+
+        if (node->GetParent() && !IsParentEnabled(node->GetParent()))
+            return;
+
+        dest_.Push(drawable);
+    }
+
+    /// Return whether a parent node and all its parents are enabled. The state is cached for the pass, as the drawables mostly share a few parents.
+    bool IsParentEnabled(Node* parent) const
+    {
+        HashMap<Node*, bool>::ConstIterator i = enabledParents_.Find(parent);
+        if (i != enabledParents_.End())
+            return i->second_;
+
+        bool enabled = parent->IsEnabled() && (!parent->GetParent() || IsParentEnabled(parent->GetParent()));
+        enabledParents_[parent] = enabled;
+        return enabled;
+    }
+
+    /// Destination.
+    PODVector<Drawable2D*>& dest_;
+    /// Enabled state of the parent nodes visited in this pass.
+    HashMap<Node*, bool>& enabledParents_;
+};
+
 void Renderer2D::GetDrawables(PODVector<Drawable2D*>& dest, Node* node)
 {
     if (!node || !node->IsEnabled())
         return;
 
+    // FromBones : for the whole scene, iterate the drawable pools instead of walking the nodes
+    if (node == node->GetScene())
+    {
+        HashMap<Node*, bool> enabledParents;
+        static_cast<Scene*>(node)->ForEach<Drawable2D>(CollectEnabledDrawables(dest, enabledParents));
+        return;
+    }
+
     const Vector<SharedPtr<Component> >& components = node->GetComponents();
     for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
     {
@@ -34,6 +34,7 @@ class IndexBuffer;
 class Material;
 class Technique;
 class VertexBuffer;
+struct BeginViewUpdateEvent;
 struct FrameInfo;
 struct SourceBatch2D;
 class Texture2D;
@@ -120,7 +121,7 @@ private:
     /// Create material by texture and blend mode.
     SharedPtr<Material> CreateMaterial(Texture2D* texture, BlendMode blendMode);
     /// Handle view update begin event. Determine Drawable2D's and their batches here.
-    void HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleBeginViewUpdate(const BeginViewUpdateEvent& event);
     /// Get all drawables in node.
     void GetDrawables(PODVector<Drawable2D*>& drawables, Node* node);
     /// Update view batch info.
@@ -51,7 +51,8 @@ static const char* bodyTypeNames[] =
 RigidBody2D::RigidBody2D(Context* context) :
     Component(context),
     useFixtureMass_(true),
-    body_(0)
+    body_(0),
+    previousRotation_(0.0f)
 {
     // Make sure the massData members are zero-initialized.
     massData_.mass = 0.0f;
@@ -536,6 +537,7 @@ void RigidBody2D::CreateBody()
 
     body_ = physicsWorld_->GetWorld()->CreateBody(&bodyDef_);
     body_->SetUserData(this);
+    StorePreviousTransform();
 
     for (unsigned i = 0; i < collisionShapes_.Size(); ++i)
     {
@@ -798,6 +800,32 @@ void RigidBody2D::OnSceneSet(Scene* scene)
 //    }
 }
 
+void RigidBody2D::StorePreviousTransform()
+{
+    if (!body_)
+        return;
+
+    previousPosition_ = ToVector2(body_->GetPosition());
+    previousRotation_ = body_->GetAngle() * M_RADTODEG;
+}
+
+void RigidBody2D::GetInterpolatedTransform(float t, Vector2& position, float& rotation) const
+{
+    position = previousPosition_.Lerp(ToVector2(body_->GetPosition()), t);
+    rotation = Lerp(previousRotation_, body_->GetAngle() * M_RADTODEG, t);
+}
+
+void RigidBody2D::SetNodeTransform(const Vector2& position, float rotation)
+{
+    bodyDef_.position = ToB2Vec2(position);
+    bodyDef_.angle = rotation * M_DEGTORAD;
+}
+
+bool RigidBody2D::IsInterpolated() const
+{
+    return body_ && (previousPosition_ != ToVector2(body_->GetPosition()) || previousRotation_ != body_->GetAngle() * M_RADTODEG);
+}
+
 void RigidBody2D::OnMarkedDirty(Node* node)
 {
     if (physicsWorld_ && physicsWorld_->IsApplyingTransforms())
@@ -822,7 +850,11 @@ void RigidBody2D::OnMarkedDirty(Node* node)
         bodyDef_.position = newPosition;
         bodyDef_.angle = newAngle;
         if (body_)
+        {
             body_->SetTransform(newPosition, newAngle);
+            // A moved body is not interpolated from its former place
+            StorePreviousTransform();
+        }
     }
 //    else
 //    {
@@ -845,7 +877,10 @@ void RigidBody2D::SetBodyPosition(const Vector2& position, float angle)
     bodyDef_.position.y = position.y_;
     bodyDef_.angle = angle * M_DEGTORAD;
     if (body_)
+    {
         body_->SetTransform(bodyDef_.position, bodyDef_.angle);
+        StorePreviousTransform();
+    }
 }
 
 b2Body* RigidBody2D::GetBody() const
@@ -112,6 +112,14 @@ public:
     void ApplyWorldTransform();
     /// Apply specified world position & rotation. Called by PhysicsWorld2D.
     void ApplyWorldTransform(const Vector2& newWorldPosition, float newWorldRotation);
+    /// FromBones : store the body transform before the last step of an update, to interpolate from it. Called by PhysicsWorld2D.
+    void StorePreviousTransform();
+    /// FromBones : return the world transform interpolated from the previous body transform to the current one. Called by PhysicsWorld2D.
+    void GetInterpolatedTransform(float t, Vector2& position, float& rotation) const;
+    /// FromBones : set the world transform written to the node, so that dirtying the node does not move the body to it again. Called by PhysicsWorld2D.
+    void SetNodeTransform(const Vector2& position, float rotation);
+    /// FromBones : return whether the previous body transform differs from the current one.
+    bool IsInterpolated() const;
     /// Add collision shape.
     void AddCollisionShape2D(CollisionShape2D* collisionShape);
     /// Remove collision shape.
@@ -193,6 +201,10 @@ private:
     bool useFixtureMass_;
     /// Box2D body.
     b2Body* body_;
+    /// Body world position before the last step.
+    Vector2 previousPosition_;
+    /// Body world rotation before the last step, not wrapped.
+    float previousRotation_;
     /// Collision shapes.
     Vector<WeakPtr<CollisionShape2D> > collisionShapes_;
     /// Constraints.
@@ -25,9 +25,12 @@
 #include "../Core/Context.h"
 #include "../Graphics/Texture2D.h"
 #include "../IO/Deserializer.h"
+#include "../IO/FileSystem.h"
+#include "../Resource/Image.h"
 #include "../Resource/ResourceCache.h"
 #include "../Urho2D/Drawable2D.h"
 #include "../Urho2D/Sprite2D.h"
+#include "../Urho2D/SpriteAtlas2D.h"
 #include "../Urho2D/SpriteSheet2D.h"
 
 #include "../DebugNew.h"
@@ -61,8 +64,8 @@ bool Sprite2D::BeginLoad(Deserializer& source)
     if (GetName().Empty())
         SetName(source.GetName());
 
-    // Reload
-    if (texture_)
+    // Reload. FromBones : a sprite packed in an atlas page gets a new texture
+    if (texture_ && texture_->GetName() == GetName())
         loadTexture_ = texture_;
     else
     {
@@ -85,6 +88,23 @@ bool Sprite2D::BeginLoad(Deserializer& source)
 
 bool Sprite2D::EndLoad()
 {
+    // FromBones : pack the standalone sprites in the atlas if enabled.
+    // The sprites with a texture parameter file keep their own texture, as the parameters can't apply to a shared page
+    SpriteAtlas2D* atlas = GetSubsystem<SpriteAtlas2D>();
+    if (atlas && atlas->IsEnabled() && loadTexture_ && loadTexture_ != texture_ && loadTexture_->GetLoadImage() &&
+        !GetSubsystem<ResourceCache>()->Exists(ReplaceExtension(GetName(), ".xml")))
+    {
+        if (atlas->AddSprite(this, loadTexture_->GetLoadImage()))
+        {
+            loadTexture_.Reset();
+            return true;
+        }
+    }
+
+    // FromBones : a sprite packed before is reloaded with its own texture
+    if (atlas)
+        atlas->RemoveSprite(this);
+
     // Finish loading of the texture in the main thread
     bool success = false;
     if (loadTexture_ && loadTexture_->EndLoad())
@@ -0,0 +1,334 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/GraphicsEvents.h"
+#include "../Graphics/Texture2D.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+#include "../Urho2D/Sprite2D.h"
+#include "../Urho2D/SpriteAtlas2D.h"
+
+#include <cstdio>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Alignment of the sprites in the pages, so that their rectangles stay exact down to the lowest texture quality level.
+static const int SPRITE_ALIGNMENT = 1 << (MAX_TEXTURE_QUALITY_LEVELS - 1);
+
+static inline int AlignSize(int size)
+{
+    return (size + SPRITE_ALIGNMENT - 1) & ~(SPRITE_ALIGNMENT - 1);
+}
+
+SpriteAtlas2D::SpriteAtlas2D(Context* context) :
+    Object(context),
+    pageSize_(2048),
+    maxSpriteSize_(256),
+    padding_(SPRITE_ALIGNMENT),
+    enabled_(true)
+{
+    SubscribeToEvent(E_BEGINRENDERING, URHO3D_HANDLER(SpriteAtlas2D, HandleBeginRendering));
+}
+
+SpriteAtlas2D::~SpriteAtlas2D()
+{
+}
+
+void SpriteAtlas2D::SetEnabled(bool enable)
+{
+    enabled_ = enable;
+}
+
+void SpriteAtlas2D::SetPageSize(int size)
+{
+    pageSize_ = Max(NextPowerOfTwo((unsigned)Max(size, 64)), 64);
+}
+
+void SpriteAtlas2D::SetMaxSpriteSize(int size)
+{
+    maxSpriteSize_ = Max(size, 1);
+}
+
+void SpriteAtlas2D::SetPadding(int padding)
+{
+    padding_ = AlignSize(Max(padding, 0));
+}
+
+bool SpriteAtlas2D::CanPack(int width, int height) const
+{
+    if (width <= 0 || height <= 0 || width > maxSpriteSize_ || height > maxSpriteSize_)
+        return false;
+
+    return AlignSize(width) + 2 * padding_ <= pageSize_ && AlignSize(height) + 2 * padding_ <= pageSize_;
+}
+
+bool SpriteAtlas2D::AddSprite(Sprite2D* sprite, Image* image)
+{
+    if (!sprite)
+        return false;
+
+    if (PackSprite(sprite, image))
+        return true;
+
+    // The sprite gets its own texture, so its previous area is abandoned
+    RemoveSprite(sprite);
+    return false;
+}
+
+void SpriteAtlas2D::RemoveSprite(Sprite2D* sprite)
+{
+    HashMap<Sprite2D*, SpriteAtlasEntry2D>::Iterator i = sprites_.Find(sprite);
+    if (i == sprites_.End())
+        return;
+
+    // A released sprite is still counted, as its area is not reclaimed
+    if (!i->second_.sprite_.Expired() && i->second_.page_ < pages_.Size())
+        --pages_[i->second_.page_].numSprites_;
+    sprites_.Erase(i);
+}
+
+bool SpriteAtlas2D::PackSprite(Sprite2D* sprite, Image* image)
+{
+    if (!enabled_ || !image || !GetSubsystem<Graphics>())
+        return false;
+
+    if (image->IsCompressed() || image->GetDepth() > 1 || image->IsCubemap() || image->IsArray() || image->IsSRGB() ||
+        !CanPack(image->GetWidth(), image->GetHeight()))
+        return false;
+
+    // The pages are RGBA, convert the other formats. Single channel images are kept as luminance, not alpha
+    SharedPtr<Image> rgbaImage;
+    if (image->GetComponents() != 4)
+    {
+        rgbaImage = image->ConvertToRGBA();
+        if (!rgbaImage)
+            return false;
+        image = rgbaImage;
+    }
+
+    const int width = image->GetWidth();
+    const int height = image->GetHeight();
+    const int allocWidth = AlignSize(width) + 2 * padding_;
+    const int allocHeight = AlignSize(height) + 2 * padding_;
+
+    int x = 0, y = 0;
+    unsigned pageIndex = M_MAX_UNSIGNED;
+
+    // A reloaded sprite of the same size is written into its previous area
+    HashMap<Sprite2D*, SpriteAtlasEntry2D>::Iterator entry = sprites_.Find(sprite);
+    if (entry != sprites_.End() && !entry->second_.sprite_.Expired() && entry->second_.area_.Width() == allocWidth &&
+        entry->second_.area_.Height() == allocHeight)
+    {
+        pageIndex = entry->second_.page_;
+        x = entry->second_.area_.left_;
+        y = entry->second_.area_.top_;
+    }
+    else
+    {
+        // Try the last pages first, the first ones are most likely full
+        for (unsigned i = pages_.Size() - 1; i < pages_.Size(); --i)
+        {
+            if (pages_[i].image_->GetWidth() >= allocWidth && pages_[i].allocator_.Allocate(allocWidth, allocHeight, x, y))
+            {
+                pageIndex = i;
+                break;
+            }
+        }
+
+        if (pageIndex == M_MAX_UNSIGNED)
+        {
+            pageIndex = CreatePage();
+            if (pageIndex == M_MAX_UNSIGNED || !pages_[pageIndex].allocator_.Allocate(allocWidth, allocHeight, x, y))
+                return false;
+        }
+
+        RemoveSprite(sprite);
+        pages_[pageIndex].usedArea_ += (unsigned)(allocWidth * allocHeight);
+        ++pages_[pageIndex].numSprites_;
+
+        SpriteAtlasEntry2D& newEntry = sprites_[sprite];
+        newEntry.sprite_ = sprite;
+        newEntry.page_ = pageIndex;
+        newEntry.area_ = IntRect(x, y, x + allocWidth, y + allocHeight);
+    }
+
+    SpriteAtlasPage2D& page = pages_[pageIndex];
+    CopySprite(page, image, x + padding_, y + padding_, padding_);
+    page.dirty_ = true;
+
+    sprite->SetTexture(page.texture_);
+    sprite->SetRectangle(IntRect(x + padding_, y + padding_, x + padding_ + width, y + padding_ + height));
+    sprite->SetSourceSize(width, height);
+
+    return true;
+}
+
+void SpriteAtlas2D::UpdatePages()
+{
+    for (unsigned i = 0; i < pages_.Size(); ++i)
+    {
+        SpriteAtlasPage2D& page = pages_[i];
+        if (!page.dirty_)
+            continue;
+
+        // The mip levels are generated again from the updated image
+        page.image_->CleanupLevels();
+        if (!page.texture_->SetData(page.image_))
+            URHO3D_LOGERRORF("SpriteAtlas2D() - UpdatePages : failed to upload page %u !", i);
+
+        page.dirty_ = false;
+    }
+}
+
+Texture2D* SpriteAtlas2D::GetPageTexture(unsigned index) const
+{
+    return index < pages_.Size() ? pages_[index].texture_.Get() : 0;
+}
+
+unsigned SpriteAtlas2D::GetNumSprites() const
+{
+    unsigned numSprites = 0;
+    for (unsigned i = 0; i < pages_.Size(); ++i)
+        numSprites += pages_[i].numSprites_;
+
+    return numSprites;
+}
+
+float SpriteAtlas2D::GetPageOccupancy(unsigned index) const
+{
+    if (index >= pages_.Size())
+        return 0.0f;
+
+    const Image* image = pages_[index].image_;
+    return (float)pages_[index].usedArea_ / (float)(image->GetWidth() * image->GetHeight());
+}
+
+float SpriteAtlas2D::GetOccupancy() const
+{
+    unsigned long long usedArea = 0;
+    unsigned long long totalArea = 0;
+    for (unsigned i = 0; i < pages_.Size(); ++i)
+    {
+        const Image* image = pages_[i].image_;
+        usedArea += pages_[i].usedArea_;
+        totalArea += (unsigned long long)(image->GetWidth() * image->GetHeight());
+    }
+
+    return totalArea ? (float)((double)usedArea / (double)totalArea) : 0.0f;
+}
+
+String SpriteAtlas2D::GetInfo() const
+{
+    // Format with sprintf, as String::AppendWithFormat() does not support precision
+    String info;
+    char line[256];
+    sprintf(line, "SpriteAtlas2D : %u pages, %u sprites, occupancy %.1f%%\n", pages_.Size(), GetNumSprites(), GetOccupancy() * 100.0f);
+    info += String(line);
+    for (unsigned i = 0; i < pages_.Size(); ++i)
+    {
+        sprintf(line, " page %u : %dx%d, %u sprites, occupancy %.1f%%\n", i, pages_[i].image_->GetWidth(), pages_[i].image_->GetHeight(),
+            pages_[i].numSprites_, GetPageOccupancy(i) * 100.0f);
+        info += String(line);
+    }
+
+    return info;
+}
+
+unsigned SpriteAtlas2D::CreatePage()
+{
+    SharedPtr<Image> image(new Image(context_));
+    if (!image->SetSize(pageSize_, pageSize_, 4))
+        return M_MAX_UNSIGNED;
+    image->ClearInt(0);
+
+    SharedPtr<Texture2D> texture(new Texture2D(context_));
+    texture->SetName(ToString("SpriteAtlas2D_Page%u", pages_.Size()));
+    texture->SetAddressMode(COORD_U, ADDRESS_CLAMP);
+    texture->SetAddressMode(COORD_V, ADDRESS_CLAMP);
+    if (!texture->SetSize(pageSize_, pageSize_, Graphics::GetRGBAFormat()))
+        return M_MAX_UNSIGNED;
+
+    pages_.Resize(pages_.Size() + 1);
+    SpriteAtlasPage2D& page = pages_.Back();
+    page.image_ = image;
+    page.texture_ = texture;
+    page.allocator_ = AreaAllocator(pageSize_, pageSize_, false);
+    page.numSprites_ = 0;
+    page.usedArea_ = 0;
+    page.dirty_ = true;
+
+    URHO3D_LOGINFOF("SpriteAtlas2D() - CreatePage : page %u size=%dx%d", pages_.Size() - 1, pageSize_, pageSize_);
+
+    return pages_.Size() - 1;
+}
+
+void SpriteAtlas2D::CopySprite(SpriteAtlasPage2D& page, Image* image, int x, int y, int border)
+{
+    const int width = image->GetWidth();
+    const int height = image->GetHeight();
+    const unsigned rowSize = (unsigned)width * 4;
+    const unsigned pageRowSize = (unsigned)page.image_->GetWidth() * 4;
+    const unsigned char* src = image->GetData();
+    unsigned char* pageData = page.image_->GetData();
+
+    // Copy the rows and extrude their first and last pixels into the left and right borders
+    for (int j = 0; j < height; ++j)
+    {
+        unsigned char* dest = pageData + (y + j) * pageRowSize + x * 4;
+        const unsigned char* srcRow = src + j * rowSize;
+        memcpy(dest, srcRow, rowSize);
+
+        const unsigned first = *reinterpret_cast<const unsigned*>(srcRow);
+        const unsigned last = *reinterpret_cast<const unsigned*>(srcRow + rowSize - 4);
+        unsigned* left = reinterpret_cast<unsigned*>(dest) - border;
+        unsigned* right = reinterpret_cast<unsigned*>(dest + rowSize);
+        for (int i = 0; i < border; ++i)
+        {
+            left[i] = first;
+            right[i] = last;
+        }
+    }
+
+    // Repeat the first and last rows with their borders into the top and bottom borders
+    const unsigned borderedRowSize = rowSize + 2 * border * 4;
+    const unsigned char* firstRow = pageData + y * pageRowSize + (x - border) * 4;
+    const unsigned char* lastRow = pageData + (y + height - 1) * pageRowSize + (x - border) * 4;
+    for (int j = 1; j <= border; ++j)
+    {
+        memcpy(pageData + (y - j) * pageRowSize + (x - border) * 4, firstRow, borderedRowSize);
+        memcpy(pageData + (y + height - 1 + j) * pageRowSize + (x - border) * 4, lastRow, borderedRowSize);
+    }
+}
+
+void SpriteAtlas2D::HandleBeginRendering(StringHash eventType, VariantMap& eventData)
+{
+    UpdatePages();
+}
+
+}
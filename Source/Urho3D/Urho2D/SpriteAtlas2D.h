@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Math/AreaAllocator.h"
+
+namespace Urho3D
+{
+
+class Image;
+class Sprite2D;
+class Texture2D;
+
+/// FromBones : page of the sprite atlas.
+struct SpriteAtlasPage2D
+{
+    /// Pixel data, kept to upload the page again when sprites are added.
+    SharedPtr<Image> image_;
+    /// Texture.
+    SharedPtr<Texture2D> texture_;
+    /// Area allocator.
+    AreaAllocator allocator_;
+    /// Number of sprites.
+    unsigned numSprites_;
+    /// Allocated area in pixels, including the sprite borders.
+    unsigned usedArea_;
+    /// Whether the image has changed since the last upload.
+    bool dirty_;
+};
+
+/// FromBones : area of a packed sprite.
+struct SpriteAtlasEntry2D
+{
+    /// Sprite, to detect a released sprite whose address has been reused.
+    WeakPtr<Sprite2D> sprite_;
+    /// Page index.
+    unsigned page_;
+    /// Allocated area in pixels, including the sprite border.
+    IntRect area_;
+};
+
+/// FromBones : runtime sprite atlas subsystem.
+/** When registered, the standalone sprites loaded from images are packed into shared atlas pages instead of getting their own texture,
+    so that Renderer2D can draw the sprites of different images with the same material in one batch.
+    The sprites are surrounded by a border repeating their edge pixels, and are aligned so that they keep exact texture rectangles in the reduced quality mip levels.
+    A reloaded sprite is written into its previous area when its size is unchanged. The areas of the released or resized sprites are not reclaimed.
+  */
+class URHO3D_API SpriteAtlas2D : public Object
+{
+    URHO3D_OBJECT(SpriteAtlas2D, Object);
+
+public:
+    /// Construct.
+    SpriteAtlas2D(Context* context);
+    /// Destruct.
+    virtual ~SpriteAtlas2D();
+
+    /// Set whether to pack the sprites loaded afterwards. Default true.
+    void SetEnabled(bool enable);
+    /// Set the width and height of the pages created afterwards. Default 2048.
+    void SetPageSize(int size);
+    /// Set the largest width or height of the packed sprites. Larger sprites keep their own texture. Default 256.
+    void SetMaxSpriteSize(int size);
+    /// Set the border around the sprites in pixels, rounded up to the sprite alignment. Default 4.
+    void SetPadding(int padding);
+
+    /// Pack a sprite image and make the sprite use its area in the atlas. Return true if successful.
+    bool AddSprite(Sprite2D* sprite, Image* image);
+    /// Forget the area of a sprite that no longer uses the atlas. Called when a packed sprite is reloaded with its own texture.
+    void RemoveSprite(Sprite2D* sprite);
+    /// Upload the pages modified since the last upload. Called automatically before rendering.
+    void UpdatePages();
+
+    /// Return whether packs the loaded sprites.
+    bool IsEnabled() const { return enabled_; }
+    /// Return the page size.
+    int GetPageSize() const { return pageSize_; }
+    /// Return the largest width or height of the packed sprites.
+    int GetMaxSpriteSize() const { return maxSpriteSize_; }
+    /// Return the border around the sprites.
+    int GetPadding() const { return padding_; }
+    /// Return whether a sprite image of this size can be packed.
+    bool CanPack(int width, int height) const;
+
+    /// Return number of pages.
+    unsigned GetNumPages() const { return pages_.Size(); }
+    /// Return the texture of a page.
+    Texture2D* GetPageTexture(unsigned index) const;
+    /// Return number of packed sprites.
+    unsigned GetNumSprites() const;
+    /// Return the allocated fraction of a page, including the sprite borders.
+    float GetPageOccupancy(unsigned index) const;
+    /// Return the allocated fraction of all the pages, including the sprite borders.
+    float GetOccupancy() const;
+    /// Return a summary of the pages and their occupancy.
+    String GetInfo() const;
+
+private:
+    /// Pack a sprite image, reusing the previous area of the sprite if possible. Return true if successful.
+    bool PackSprite(Sprite2D* sprite, Image* image);
+    /// Create a new page. Return its index or M_MAX_UNSIGNED if failed.
+    unsigned CreatePage();
+    /// Copy a sprite image to a page with its border.
+    void CopySprite(SpriteAtlasPage2D& page, Image* image, int x, int y, int border);
+    /// Handle the begin rendering event.
+    void HandleBeginRendering(StringHash eventType, VariantMap& eventData);
+
+    /// Pages.
+    Vector<SpriteAtlasPage2D> pages_;
+    /// Areas of the packed sprites.
+    HashMap<Sprite2D*, SpriteAtlasEntry2D> sprites_;
+    /// Page size.
+    int pageSize_;
+    /// Largest width or height of the packed sprites.
+    int maxSpriteSize_;
+    /// Border around the sprites.
+    int padding_;
+    /// Enabled flag.
+    bool enabled_;
+};
+
+}
@@ -340,6 +340,8 @@ if (IS_URHO3D)
         set (THREADING_DEFAULT TRUE)
     endif ()
     option (URHO3D_THREADING "Enable thread support, on Web platform default to 0, on other platforms default to 1" ${THREADING_DEFAULT})
+    # FromBones : Bullet built thread safe, needed by the multithreaded physics world (PhysicsWorldConfig::multiThreaded_)
+    cmake_dependent_option (URHO3D_PHYSICS_MT "Build Bullet thread safe to allow the multithreaded physics world" FALSE "URHO3D_PHYSICS AND URHO3D_THREADING" FALSE)
     # Structured exception handling and minidumps on MSVC only
     cmake_dependent_option (URHO3D_MINIDUMPS "Enable minidumps on crash (VS only)" TRUE "MSVC" FALSE)
     # By default Windows platform setups main executable as Windows application with WinMain() as entry point
@@ -587,6 +589,10 @@ foreach (OPT URHO3D_ANGELSCRIPT URHO3D_DATABASE URHO3D_FILEWATCHER URHO3D_IK URH
         message ("-- adding definition ${OPT}")
     endif ()
 endforeach ()
+# The Bullet library and the Urho3D library must agree on the Bullet thread safety, the macro is only defined for these two targets
+if (URHO3D_PHYSICS_MT)
+    set (BT_THREADSAFE TRUE)
+endif ()
 
 # TODO: The logic below is earmarked to be moved into SDL's CMakeLists.txt when refactoring the library dependency handling, until then ensure the DirectX package is not being searched again in external projects such as when building LuaJIT library
 if (WIN32 AND NOT CMAKE_PROJECT_NAME MATCHES ^Urho3D-ExternalProject-)